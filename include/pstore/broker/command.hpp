@@ -48,6 +48,7 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstring>
 #include <mutex>
 #include <tuple>
@@ -69,6 +70,7 @@ namespace pstore {
     namespace broker {
 
         class fifo_path;
+        class message_ring;
         class recorder;
         class scavenger;
 
@@ -100,6 +102,9 @@ namespace pstore {
             void thread_entry (fifo_path const & fifo);
 
             void attach_scavenger (std::shared_ptr<scavenger> & scav) { scavenger_.set (scav); }
+            /// Supplies the ring from which large messages announced by a doorbell are read. The
+            /// ring must outlive the command processor's threads.
+            void attach_message_ring (message_ring * const ring) noexcept { ring_ = ring; }
 
             /// Pushes a command onto the end of the command queue. The command is recorded if
             /// `record_file` is not null.
@@ -107,8 +112,16 @@ namespace pstore {
             /// command queue.
             /// \param record_file  If not null, this object is used to record the command.
             void push_command (message_ptr && cmd, recorder * const record_file);
+            /// Pushes a control command (such as a request to exit) onto the command queue. Unlike
+            /// push_command(), this never waits for space in the queue and the command is processed
+            /// ahead of any ordinary commands. Shutdown uses it because it may be running on the
+            /// command thread itself, which is the only consumer of the queue.
+            void push_control_command (message_ptr && cmd);
             void clear_queue ();
 
+            /// Returns counters describing the traffic through the command queue.
+            message_queue_status queue_status () const noexcept { return messages_.status (); }
+
             void scavenge ();
 
             /// \note Public for unit testing.
@@ -148,6 +161,8 @@ namespace pstore {
             std::chrono::seconds delete_threshold_;
 
             atomic_weak_ptr<scavenger> scavenger_;
+            /// The ring which carries large messages. May be null.
+            std::atomic<message_ring *> ring_{nullptr};
 
             message_queue<message_ptr> messages_;
 
@@ -161,6 +176,11 @@ namespace pstore {
             /// The nuber of commit ("GC") commands processed.
             unsigned commits_ = 0;
 
+            /// The minimum time between publications of the queue status on queue_channel.
+            static constexpr std::chrono::seconds queue_status_interval{1};
+            /// Publishes the command queue and message pool counters on queue_channel.
+            void publish_queue_status () const;
+
             auto parse (message_type const & msg) -> std::unique_ptr<broker_command>;
 
             using handler = std::function<void(command_processor *, fifo_path const & fifo,
@@ -171,7 +191,10 @@ namespace pstore {
                 return std::strcmp (std::get<0> (a), std::get<0> (b)) < 0;
             }
 
-            static std::array<command_entry, 6> const commands_;
+            static std::array<command_entry, 7> const commands_;
+
+            /// Executes a single complete command.
+            void dispatch (fifo_path const & fifo, broker_command const & c);
 
             ///@{
             /// Functions responsible for processing each of the commands to which the broker will
@@ -197,6 +220,10 @@ namespace pstore {
 
             /// A simple no-op command.
             virtual void nop (fifo_path const & fifo, broker_command const & c);
+
+            /// Reads the large message announced by a doorbell from the message ring and executes
+            /// it.
+            virtual void ring (fifo_path const & fifo, broker_command const & c);
             ///@}
 
             /// Called to report the receipt of an unknown command verb.
@@ -213,6 +240,9 @@ namespace pstore {
         extern descriptor_condition_variable commits_cv;
         extern channel<descriptor_condition_variable> commits_channel;
 
+        extern descriptor_condition_variable queue_cv;
+        extern channel<descriptor_condition_variable> queue_channel;
+
     } // end namespace broker
 } // end namespace pstore
 
@@ -49,53 +49,77 @@
 /// loop thread -- which is responsible for accepting commands from clients -- command
 /// buffers are recycled when they have been processed. The basic flow is as follows:
 ///
+/// - The pool allocates a fixed number of message buffers when it is constructed.
 /// - The read loop thread draws a message buffer from the pool before beginning an asynchronous
 /// read from the named pipe.
 /// - If the buffer pool is exhausted, then a new command buffer instance is allocated.
 /// - Once the asynchronous read has completed, the message buffer is moved to the command queue.
-/// - The command thread draws
+/// - The command thread draws the buffer from the queue, processes it, and returns it to the pool.
+///   If the pool is already full, the buffer is freed.
+///
+/// The free buffers are held in a lock-free ring so that the read and command threads never
+/// contend for a lock.
 ///
 /// \image html buffer_life_cycle.svg
 
 #ifndef PSTORE_BROKER_MESSAGE_POOL_HPP
 #define PSTORE_BROKER_MESSAGE_POOL_HPP
 
+#include <atomic>
 #include <cassert>
-#include <condition_variable>
-#include <mutex>
-#include <queue>
+#include <cstdint>
 #include <utility>
 
 #include "pstore/broker_intf/message_type.hpp"
+#include "pstore/support/mpmc_ring.hpp"
 
 namespace pstore {
     namespace broker {
 
         class message_pool {
         public:
+            static constexpr std::size_t default_size = 256U;
+
+            /// \param size  The number of message buffers allocated up-front. This is also the
+            ///   maximum number of free buffers that the pool will hold. Must be a power of two.
+            explicit message_pool (std::size_t size = default_size);
+
             void return_to_pool (message_ptr && ptr);
             message_ptr get_from_pool ();
 
+            /// Returns the number of requests which found the pool empty and had to allocate a
+            /// new buffer.
+            std::uint64_t misses () const noexcept {
+                return misses_.load (std::memory_order_relaxed);
+            }
+
         private:
-            std::mutex mut_;
-            std::queue<message_ptr> queue_;
+            mpmc_ring<message_ptr> free_;
+            std::atomic<std::uint64_t> misses_{0U};
         };
 
+        inline message_pool::message_pool (std::size_t const size)
+                : free_{size} {
+            for (std::size_t ctr = 0U; ctr < size; ++ctr) {
+                bool const ok = free_.try_push (std::make_unique<message_type> ());
+                assert (ok);
+                (void) ok;
+            }
+        }
+
         inline void message_pool::return_to_pool (message_ptr && ptr) {
-            std::unique_lock<std::mutex> const lock (mut_);
             assert (ptr.get () != nullptr);
-            queue_.push (std::move (ptr));
+            // If the pool is full, the buffer is simply freed when ptr goes out of scope.
+            message_ptr p = std::move (ptr);
+            free_.try_push (std::move (p));
         }
 
         inline message_ptr message_pool::get_from_pool () {
-            std::unique_lock<std::mutex> lock (mut_);
-            if (queue_.size () == 0) {
-                lock.unlock ();
+            message_ptr res;
+            if (!free_.try_pop (res)) {
+                misses_.fetch_add (1U, std::memory_order_relaxed);
                 return std::make_unique<message_type> ();
             }
-
-            auto res = std::move (queue_.front ());
-            queue_.pop ();
             return res;
         }
 
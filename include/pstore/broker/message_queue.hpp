@@ -42,53 +42,220 @@
 // SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
 //===----------------------------------------------------------------------===//
 /// \file message_queue.hpp
+/// \brief A bounded queue which carries messages from the read loop to the command processor.
+///
+/// Messages pass through a lock-free ring (mpmc_ring). A thread only takes the mutex when it must
+/// sleep: a consumer which finds the queue empty or a producer which finds it full. The other side
+/// looks at the number of sleeping threads after each push or pop and signals only if there is one.
+///
+/// Control messages (such as the requests which stop the broker) bypass the ring: they are held in
+/// a separate, unbounded list so that pushing one never blocks, even when the thread doing so is
+/// the queue's only consumer.
 
 #ifndef PSTORE_BROKER_MESSAGE_QUEUE_HPP
 #define PSTORE_BROKER_MESSAGE_QUEUE_HPP
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <mutex>
-#include <queue>
 #include <utility>
 
+#include "pstore/support/mpmc_ring.hpp"
+
 namespace pstore {
     namespace broker {
 
+        /// Counters which describe the traffic through a message_queue.
+        struct message_queue_status {
+            /// The approximate number of messages waiting in the queue.
+            std::size_t size = 0;
+            /// The number of pushes which found the queue full and had to wait for a consumer.
+            std::uint64_t backpressure = 0;
+            /// The number of times that a sleeping thread was woken by a push or pop.
+            std::uint64_t wakeups = 0;
+        };
+
         template <typename T>
         class message_queue {
         public:
+            static constexpr std::size_t default_capacity = 1024U;
+
+            /// \param capacity  The maximum number of messages that the queue can hold. Must be a
+            ///   power of two.
+            explicit message_queue (std::size_t const capacity = default_capacity)
+                    : ring_{capacity} {}
+
+            /// Appends a message to the queue. Blocks while the queue is full. Once the queue has
+            /// been closed, the message is discarded rather than waiting for space.
             void push (T && message);
+            /// Appends a control message to the queue. It is not subject to the queue's capacity
+            /// so this function never blocks. Control messages are returned by pop() ahead of any
+            /// ordinary messages.
+            void push_control (T && message);
+            /// Removes the message at the front of the queue. Blocks while the queue is empty.
             T pop ();
             void clear ();
+            /// Releases any producers which are waiting for space and causes later pushes to
+            /// discard their message if the queue is full. Used when the consumer is about to
+            /// stop.
+            void close ();
+
+            message_queue_status status () const noexcept;
 
         private:
+            /// Called after a successful push or pop. If a thread is sleeping on \p cv, it is
+            /// woken.
+            void wake (std::atomic<unsigned> const & waiters, std::condition_variable & cv);
+            /// If a control message is waiting, moves it to \p res and returns true.
+            bool try_pop_control (T & res);
+
+            mpmc_ring<T> ring_;
+            /// Control messages. Guarded by mut_.
+            std::deque<T> control_;
+            /// The number of entries in control_: lets pop() skip the mutex when there are none.
+            std::atomic<std::size_t> control_size_{0U};
+            /// Set by close().
+            std::atomic<bool> closed_{false};
+
+            /// Guards sleeping: the ring's fast path never takes it.
             std::mutex mut_;
-            std::condition_variable cv;
-            std::queue<T> queue_;
+            std::condition_variable not_empty_;
+            std::condition_variable not_full_;
+            /// The number of consumers sleeping on not_empty_.
+            std::atomic<unsigned> pop_waiters_{0U};
+            /// The number of producers sleeping on not_full_.
+            std::atomic<unsigned> push_waiters_{0U};
+
+            std::atomic<std::uint64_t> backpressure_{0U};
+            std::atomic<std::uint64_t> wakeups_{0U};
         };
 
+        template <typename T>
+        constexpr std::size_t message_queue<T>::default_capacity;
+
+        // push
+        // ~~~~
         template <typename T>
         void message_queue<T>::push (T && message) {
-            std::unique_lock<decltype (mut_)> lock (mut_);
-            queue_.push (std::move (message));
-            cv.notify_one ();
+            if (!ring_.try_push (std::move (message))) {
+                backpressure_.fetch_add (1U, std::memory_order_relaxed);
+                std::unique_lock<decltype (mut_)> lock (mut_);
+                push_waiters_.fetch_add (1U);
+                // Pairs with the fence in wake(): either the consumer sees this waiter or this
+                // thread sees the space that the consumer made.
+                std::atomic_thread_fence (std::memory_order_seq_cst);
+                bool pushed = false;
+                while (!closed_ && !(pushed = ring_.try_push (std::move (message)))) {
+                    not_full_.wait (lock);
+                }
+                push_waiters_.fetch_sub (1U);
+                if (!pushed) {
+                    return;
+                }
+            }
+            this->wake (pop_waiters_, not_empty_);
         }
 
+        // push_control
+        // ~~~~~~~~~~~~
+        template <typename T>
+        void message_queue<T>::push_control (T && message) {
+            {
+                std::lock_guard<decltype (mut_)> const lock (mut_);
+                control_.push_back (std::move (message));
+                control_size_.store (control_.size ());
+            }
+            // A consumer checks control_ while holding the mutex before it sleeps, so it cannot
+            // miss this notification.
+            not_empty_.notify_one ();
+        }
+
+        // try_pop_control
+        // ~~~~~~~~~~~~~~~
+        template <typename T>
+        bool message_queue<T>::try_pop_control (T & res) {
+            if (control_.empty ()) {
+                return false;
+            }
+            res = std::move (control_.front ());
+            control_.pop_front ();
+            control_size_.store (control_.size ());
+            return true;
+        }
+
+        // pop
+        // ~~~
         template <typename T>
         T message_queue<T>::pop () {
-            std::unique_lock<decltype (mut_)> lock (mut_);
-            cv.wait (lock, [this]() { return queue_.size () > 0; });
-            T res = std::move (queue_.front ());
-            queue_.pop ();
+            T res{};
+            if (control_size_.load () > 0U) {
+                std::lock_guard<decltype (mut_)> const lock (mut_);
+                if (this->try_pop_control (res)) {
+                    return res;
+                }
+            }
+            if (!ring_.try_pop (res)) {
+                std::unique_lock<decltype (mut_)> lock (mut_);
+                pop_waiters_.fetch_add (1U);
+                std::atomic_thread_fence (std::memory_order_seq_cst);
+                while (!this->try_pop_control (res) && !ring_.try_pop (res)) {
+                    not_empty_.wait (lock);
+                }
+                pop_waiters_.fetch_sub (1U);
+            }
+            this->wake (push_waiters_, not_full_);
             return res;
         }
 
+        // clear
+        // ~~~~~
         template <typename T>
         void message_queue<T>::clear () {
-            std::unique_lock<decltype (mut_)> lock (mut_);
-            while (!queue_.empty ()) {
-                queue_.pop ();
+            T discard{};
+            while (ring_.try_pop (discard)) {
+            }
+            this->wake (push_waiters_, not_full_);
+        }
+
+        // close
+        // ~~~~~
+        template <typename T>
+        void message_queue<T>::close () {
+            {
+                std::lock_guard<decltype (mut_)> const lock (mut_);
+                closed_ = true;
             }
+            not_full_.notify_all ();
+        }
+
+        // status
+        // ~~~~~~
+        template <typename T>
+        message_queue_status message_queue<T>::status () const noexcept {
+            message_queue_status result;
+            result.size = ring_.size () + control_size_.load (std::memory_order_relaxed);
+            result.backpressure = backpressure_.load (std::memory_order_relaxed);
+            result.wakeups = wakeups_.load (std::memory_order_relaxed);
+            return result;
+        }
+
+        // wake
+        // ~~~~
+        template <typename T>
+        void message_queue<T>::wake (std::atomic<unsigned> const & waiters,
+                                     std::condition_variable & cv) {
+            std::atomic_thread_fence (std::memory_order_seq_cst);
+            if (waiters.load (std::memory_order_relaxed) == 0U) {
+                return;
+            }
+            // A waiter increments its count and re-checks the ring while holding the mutex, so
+            // acquiring it here guarantees that the waiter is either asleep or will see the
+            // change.
+            { std::lock_guard<decltype (mut_)> const lock (mut_); }
+            cv.notify_one ();
+            wakeups_.fetch_add (1U, std::memory_order_relaxed);
         }
 
     } // namespace broker
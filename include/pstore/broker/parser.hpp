@@ -123,6 +123,9 @@ namespace pstore {
 
         std::unique_ptr<broker_command> parse (message_type const & msg, partial_cmds & cmds);
 
+        /// Splits a complete command string into its verb and path.
+        broker_command parse_command (std::string const & complete_command);
+
     } // namespace broker
 } // namespace pstore
 
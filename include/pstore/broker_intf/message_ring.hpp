@@ -0,0 +1,172 @@
+//*                                                  _              *
+//*  _ __ ___   ___  ___ ___  __ _  __ _  ___   _ __(_)_ __   __ _  *
+//* | '_ ` _ \ / _ \/ __/ __|/ _` |/ _` |/ _ \ | '__| | '_ \ / _` | *
+//* | | | | | |  __/\__ \__ \ (_| | (_| |  __/ | |  | | | | | (_| | *
+//* |_| |_| |_|\___||___/___/\__,_|\__, |\___| |_|  |_|_| |_|\__, | *
+//*                                |___/                     |___/  *
+//===- include/pstore/broker_intf/message_ring.hpp ------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file message_ring.hpp
+/// \brief A shared-memory transport for messages which are too large for a single FIFO write.
+///
+/// A message longer than message_type::payload_chars must otherwise be split into many parts which
+/// the broker reassembles. Instead, a client may copy the message into a free slot of a
+/// message_ring which lives in shared memory (see pstore::shared_memory) and write a single
+/// "doorbell" message to the FIFO naming the slot. The broker copies the message out of the slot
+/// and frees it.
+///
+/// Each slot carries a sequence number which changes whenever the slot is claimed. The doorbell
+/// carries the sequence number as well, so the broker ignores a stale doorbell whose slot has been
+/// recycled or reset.
+
+#ifndef PSTORE_BROKER_INTF_MESSAGE_RING_HPP
+#define PSTORE_BROKER_INTF_MESSAGE_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "pstore/broker_intf/message_type.hpp"
+#include "pstore/support/gsl.hpp"
+#include "pstore/support/maybe.hpp"
+
+namespace pstore {
+    namespace broker {
+
+        class fifo_path;
+
+        /// The verb of the doorbell message which tells the broker that a message is waiting in
+        /// the message ring. Its path is the slot number followed by the slot's sequence number.
+        extern gsl::czstring const message_ring_doorbell_command;
+
+        /// Returns the name of the shared memory object which holds the message ring used by the
+        /// broker which listens on \p fifo.
+        std::string message_ring_name (fifo_path const & fifo);
+
+        /// A fixed number of fixed-size message slots which are shared between the broker and its
+        /// clients. Instances are placed in shared memory so the class must be standard-layout and
+        /// its atomics lock-free.
+        class message_ring {
+        public:
+            /// The number of slots in the ring.
+            static constexpr std::size_t num_slots = 16U;
+            /// The largest message that can be held in a slot. Larger messages are sent through
+            /// the FIFO.
+            static constexpr std::size_t slot_size = 64U * 1024U;
+
+            /// Identifies a message which has been placed in the ring.
+            struct ticket {
+                std::uint32_t slot;
+                std::uint32_t sequence;
+            };
+
+            /// Returns true if a message of \p length characters should be sent through the ring
+            /// rather than being split into FIFO message parts.
+            static constexpr bool wanted (std::size_t const length) noexcept {
+                return length > message_type::payload_chars && length <= slot_size;
+            }
+
+            /// Frees all of the slots. Called by the broker when it starts so that any slots left
+            /// in use by a client which crashed are recovered.
+            void reset () noexcept;
+
+            /// Copies \p message into a free slot.
+            ///
+            /// \param message  The message to be sent.
+            /// \returns  The slot's ticket or nothing if the message is too large or there are no
+            ///   free slots.
+            maybe<ticket> put (gsl::span<char const> message) noexcept;
+
+            /// Removes the message identified by \p t from the ring.
+            ///
+            /// \param t  The ticket of the message to be removed.
+            /// \returns  The message or nothing if the ticket does not refer to a message waiting
+            ///   in the ring or if the message's recorded length is invalid. The slot is freed in
+            ///   either of the latter cases.
+            maybe<std::string> take (ticket const & t);
+
+            /// Frees the slot of a message which will never be taken: for example, because the
+            /// doorbell could not be sent to the broker.
+            ///
+            /// \param t  The ticket of the message to be discarded.
+            /// \returns  True if the message was discarded, false if the ticket does not refer to a
+            ///   message waiting in the ring.
+            bool cancel (ticket const & t) noexcept;
+
+        private:
+            enum slot_state : std::uint32_t { vacant, writing, ready };
+
+            struct slot {
+                std::atomic<std::uint32_t> state;
+                std::atomic<std::uint32_t> sequence;
+                std::uint32_t length;
+                std::array<char, slot_size> data;
+            };
+
+            /// The slot at which the next put() starts its search for a free slot.
+            std::atomic<std::uint32_t> next_;
+            std::array<slot, num_slots> slots_;
+
+            /// Claims the slot holding the message identified by \p t for removal.
+            ///
+            /// \returns  The slot, whose state is now writing, or nullptr if the ticket does not
+            ///   refer to a message waiting in the ring.
+            slot * claim (ticket const & t) noexcept;
+        };
+
+        static_assert (std::is_standard_layout<message_ring>::value,
+                       "message_ring must be standard-layout");
+        static_assert (ATOMIC_INT_LOCK_FREE == 2,
+                       "message_ring requires lock-free atomics to be shared between processes");
+
+        /// Returns the path of the doorbell message for the ring message identified by \p t.
+        std::string doorbell_path (message_ring::ticket const & t);
+
+        /// Decodes the path of a doorbell message.
+        ///
+        /// \param path  The path of a message_ring_doorbell_command message.
+        /// \returns  The ticket named by the doorbell or nothing if \p path is malformed.
+        maybe<message_ring::ticket> parse_doorbell (std::string const & path);
+
+    } // namespace broker
+} // namespace pstore
+
+#endif // PSTORE_BROKER_INTF_MESSAGE_RING_HPP
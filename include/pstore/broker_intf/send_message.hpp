@@ -61,11 +61,17 @@ namespace pstore {
         /// dispatched by a call to send_message().
         std::uint32_t next_message_id ();
 
+        class message_ring;
         class writer;
 
         /// Sends a message consisting of a "verb" and optional "path" to the pstore broker for
         /// processing.
         ///
+        /// If \p ring is not null and the message is too long for a single FIFO message part (see
+        /// message_ring::wanted()), the message is placed in the ring and only a doorbell is
+        /// written to the pipe. If the ring has no free slot, the message is split into parts as
+        /// usual. If the doorbell cannot be written, the message is removed from the ring.
+        ///
         /// \param wr A connection to the broker via a named pipe.
         /// \param error_on_timeout  If true, an error will be raise in the event of a
         ///    timeout. If false, this condition is silently ignored.
@@ -73,8 +79,10 @@ namespace pstore {
         ///   broker should execute.
         /// \param path  A null-terminated character string which contains the parameter for the
         ///   broker command. Pass nullptr if no parameter is required for the command.
-        void send_message (writer & wr, bool error_on_timeout, ::pstore::gsl::czstring verb,
-                           ::pstore::gsl::czstring path);
+        /// \param ring  The broker's message ring or nullptr.
+        /// \returns  True if the message was written, false if a write timed out.
+        bool send_message (writer & wr, bool error_on_timeout, ::pstore::gsl::czstring verb,
+                           ::pstore::gsl::czstring path, message_ring * ring = nullptr);
 
     } // namespace broker
 } // namespace pstore
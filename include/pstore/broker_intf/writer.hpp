@@ -88,7 +88,12 @@ namespace pstore {
             writer & operator= (writer const &) = delete;
             writer & operator= (writer && rhs) noexcept = default;
 
-            void write (message_type const & msg, bool error_on_timeout);
+            /// Writes \p msg to the pipe, retrying until it succeeds or the retries are exhausted.
+            ///
+            /// \param msg  The message to be written.
+            /// \param error_on_timeout  If true, an error is raised if the retries are exhausted.
+            /// \returns  True if the message was written.
+            bool write (message_type const & msg, bool error_on_timeout);
 
         private:
             // (virtual for unit testing)
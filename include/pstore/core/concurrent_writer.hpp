@@ -0,0 +1,284 @@
+//*                                                 _                   _ _             *
+//*   ___ ___  _ __   ___ _   _ _ __ _ __ ___ _ __ | |_  __      ___ __(_) |_ ___ _ __  *
+//*  / __/ _ \| '_ \ / __| | | | '__| '__/ _ \ '_ \| __| \ \ /\ / / '__| | __/ _ \ '__| *
+//* | (_| (_) | | | | (__| |_| | |  | | |  __/ | | | |_   \ V  V /| |  | | ||  __/ |    *
+//*  \___\___/|_| |_|\___|\__,_|_|  |_|  \___|_| |_|\__|   \_/\_/ |_|  |_|\__\___|_|    *
+//*                                                                                     *
+//===- include/pstore/core/concurrent_writer.hpp --------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file concurrent_writer.hpp
+/// \brief Enables several threads to add data to a single transaction.
+///
+/// A transaction's storage is normally allocated by a single thread. A concurrent_writer gives
+/// each participating thread its own transaction_arena: a block of storage carved from the
+/// transaction from which the thread can allocate and fill data without synchronizing with the
+/// other writers. Index updates made through an arena are buffered and applied to the indices
+/// by concurrent_writer::merge() once all of the threads have finished.
+///
+/// Typical use is:
+///
+///     auto t = pstore::begin (db);
+///     pstore::concurrent_writer writer{t};
+///     // In each of N threads:
+///     //     pstore::transaction_arena & arena = writer.arena ();
+///     //     ... arena.alloc_rw<>() and arena.insert_or_assign() ...
+///     writer.merge ();
+///     t.commit ();
+
+#ifndef PSTORE_CORE_CONCURRENT_WRITER_HPP
+#define PSTORE_CORE_CONCURRENT_WRITER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pstore/core/address.hpp"
+#include "pstore/core/transaction.hpp"
+
+namespace pstore {
+
+    class concurrent_writer;
+
+    namespace details {
+
+        /// Index updates which have been buffered by a transaction_arena.
+        class pending_updates_base {
+        public:
+            virtual ~pending_updates_base () noexcept = default;
+
+            /// Returns the index to which the updates will be applied.
+            virtual void const * index () const noexcept = 0;
+            /// Appends the updates held by \p other, which must be for the same index.
+            virtual void append (pending_updates_base & other) = 0;
+            /// Applies the buffered updates to the index.
+            virtual void apply (transaction_base & transaction) = 0;
+        };
+
+        template <typename Index>
+        class pending_updates final : public pending_updates_base {
+        public:
+            using value_type = std::pair<typename Index::key_type, typename Index::mapped_type>;
+
+            explicit pending_updates (std::shared_ptr<Index> index)
+                    : index_{std::move (index)} {}
+
+            void push (value_type && v) { values_.push_back (std::move (v)); }
+
+            void const * index () const noexcept override { return index_.get (); }
+            void append (pending_updates_base & other) override {
+                assert (other.index () == this->index ());
+                auto & o = static_cast<pending_updates &> (other);
+                values_.insert (std::end (values_),
+                                std::make_move_iterator (std::begin (o.values_)),
+                                std::make_move_iterator (std::end (o.values_)));
+                o.values_.clear ();
+            }
+            void apply (transaction_base & transaction) override {
+                index_->insert_or_assign_range (transaction, std::begin (values_),
+                                                std::end (values_));
+            }
+
+        private:
+            std::shared_ptr<Index> index_;
+            std::vector<value_type> values_;
+        };
+
+    } // namespace details
+
+    //*  _                                  _   _                                           *
+    //* | |_ _ __ __ _ _ __  ___  __ _  ___| |_(_) ___  _ __     __ _ _ __ ___ _ __   __ _  *
+    //* | __| '__/ _` | '_ \/ __|/ _` |/ __| __| |/ _ \| '_ \   / _` | '__/ _ \ '_ \ / _` | *
+    //* | |_| | | (_| | | | \__ \ (_| | (__| |_| | (_) | | | | | (_| | | |  __/ | | | (_| | *
+    //*  \__|_|  \__,_|_| |_|___/\__,_|\___|\__|_|\___/|_| |_|  \__,_|_|  \___|_| |_|\__,_| *
+    //*                                                                                     *
+    /// A block of transaction storage from which a single thread allocates. Arenas are created
+    /// by concurrent_writer::arena(); an arena must only be used by the thread which created it.
+    class transaction_arena {
+    public:
+        transaction_arena (transaction_arena const &) = delete;
+        transaction_arena (transaction_arena &&) = delete;
+        ~transaction_arena () noexcept = default;
+
+        transaction_arena & operator= (transaction_arena const &) = delete;
+        transaction_arena & operator= (transaction_arena &&) = delete;
+
+        concurrent_writer & writer () noexcept { return writer_; }
+
+        ///@{
+        /// Allocates sufficient space in the transaction for 'size' bytes at an alignment given
+        /// by 'align' and returns both a writable pointer to the new space and its address. The
+        /// pointer remains valid until concurrent_writer::merge() is called.
+        ///
+        /// \param size  The number of bytes of storage to allocate.
+        /// \param align The alignment of the newly allocated storage. Must be a non-zero power
+        ///              of two.
+        /// \returns  A std::pair which contains a writable pointer to the newly
+        ///           allocated space and the address of that space.
+        ///
+        /// \note     The newly allocated space is not initialized.
+        std::pair<std::shared_ptr<void>, address> alloc_rw (std::size_t size, unsigned align);
+
+        /// Allocates sufficient space in the transaction for one or more new instances of
+        /// type 'Ty' and returns both a writable pointer to the new space and
+        /// its address. Ty must be a "standard layout" type.
+        ///
+        /// \param num  The number of instances of type Ty for which space should be allocated.
+        /// \returns  A std::pair which contains a writable pointer to the newly
+        ///           allocated space and the address of that space.
+        ///
+        /// \note     The newly allocated space it not initialized.
+        template <typename Ty,
+                  typename = typename std::enable_if<std::is_standard_layout<Ty>::value>::type>
+        auto alloc_rw (std::size_t const num = 1)
+            -> std::pair<std::shared_ptr<Ty>, typed_address<Ty>> {
+            auto result = this->alloc_rw (sizeof (Ty) * num, alignof (Ty));
+            return {std::static_pointer_cast<Ty> (result.first), typed_address<Ty> (result.second)};
+        }
+        ///@}
+
+        /// Records an insert-or-assign operation on \p index. The operation is performed when
+        /// concurrent_writer::merge() is called. If more than one arena records a value for the
+        /// same key, the value recorded by the arena that was created last is retained.
+        ///
+        /// \param index  The index to be updated. Must be a hamt_map<>.
+        /// \param key  The key to be inserted or updated.
+        /// \param value  The value to be associated with \p key.
+        template <typename Index>
+        void insert_or_assign (std::shared_ptr<Index> const & index,
+                               typename Index::key_type const & key,
+                               typename Index::mapped_type const & value);
+
+    private:
+        friend class concurrent_writer;
+        explicit transaction_arena (concurrent_writer & writer) noexcept
+                : writer_{writer} {}
+
+        /// Zeroes any unused space at the end of the current block and releases it.
+        void retire_block () noexcept;
+
+        concurrent_writer & writer_;
+
+        /// The block of transaction storage from which allocations are made.
+        std::shared_ptr<void> block_;
+        /// The store address of the start of block_.
+        address block_addr_ = address::null ();
+        /// The number of bytes in block_.
+        std::uint64_t block_size_ = 0;
+        /// The number of bytes of block_ which have been allocated.
+        std::uint64_t used_ = 0;
+
+        std::vector<std::unique_ptr<details::pending_updates_base>> updates_;
+    };
+
+    // insert_or_assign
+    // ~~~~~~~~~~~~~~~~
+    template <typename Index>
+    void transaction_arena::insert_or_assign (std::shared_ptr<Index> const & index,
+                                              typename Index::key_type const & key,
+                                              typename Index::mapped_type const & value) {
+        using updates_type = details::pending_updates<Index>;
+        auto pos = std::find_if (
+            std::begin (updates_), std::end (updates_),
+            [&index] (std::unique_ptr<details::pending_updates_base> const & u) {
+                return u->index () == index.get ();
+            });
+        if (pos == std::end (updates_)) {
+            updates_.push_back (std::make_unique<updates_type> (index));
+            pos = std::prev (std::end (updates_));
+        }
+        static_cast<updates_type *> (pos->get ())->push ({key, value});
+    }
+
+    //*                                                 _                   _ _             *
+    //*   ___ ___  _ __   ___ _   _ _ __ _ __ ___ _ __ | |_  __      ___ __(_) |_ ___ _ __  *
+    //*  / __/ _ \| '_ \ / __| | | | '__| '__/ _ \ '_ \| __| \ \ /\ / / '__| | __/ _ \ '__| *
+    //* | (_| (_) | | | | (__| |_| | |  | | |  __/ | | | |_   \ V  V /| |  | | ||  __/ |    *
+    //*  \___\___/|_| |_|\___|\__,_|_|  |_|  \___|_| |_|\__|   \_/\_/ |_|  |_|\__\___|_|    *
+    //*                                                                                     *
+    /// Coordinates a group of threads which are simultaneously writing to a single transaction.
+    class concurrent_writer {
+    public:
+        /// The default number of bytes which an arena takes from the transaction at a time.
+        static constexpr std::uint64_t default_block_size = 1024 * 1024;
+
+        /// \param transaction  The transaction to which data will be written.
+        /// \param block_size  The number of bytes which an arena takes from the transaction at a
+        ///   time. Allocations which would not fit in a block of this size are made directly
+        ///   from the transaction.
+        explicit concurrent_writer (transaction_base & transaction,
+                                    std::uint64_t block_size = default_block_size);
+        concurrent_writer (concurrent_writer const &) = delete;
+        concurrent_writer (concurrent_writer &&) = delete;
+        ~concurrent_writer () noexcept;
+
+        concurrent_writer & operator= (concurrent_writer const &) = delete;
+        concurrent_writer & operator= (concurrent_writer &&) = delete;
+
+        transaction_base & transaction () noexcept { return transaction_; }
+
+        /// Returns the arena belonging to the calling thread, creating it if necessary.
+        transaction_arena & arena ();
+
+        /// Releases the storage held by each of the arenas and applies their buffered index
+        /// updates. This must be called once all of the writing threads have finished and before
+        /// the transaction is committed. Any existing arenas are destroyed.
+        void merge ();
+
+    private:
+        friend class transaction_arena;
+
+        /// Allocates storage from the transaction. May be called from any thread.
+        std::pair<std::shared_ptr<void>, address> alloc_rw (std::uint64_t size, unsigned align);
+
+        transaction_base & transaction_;
+        std::uint64_t const block_size_;
+
+        std::mutex mut_;
+        std::vector<std::pair<std::thread::id, std::unique_ptr<transaction_arena>>> arenas_;
+    };
+
+} // namespace pstore
+
+#endif // PSTORE_CORE_CONCURRENT_WRITER_HPP
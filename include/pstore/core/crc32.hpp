@@ -47,6 +47,7 @@
 #define PSTORE_CORE_CRC32_HPP
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 
@@ -54,17 +55,32 @@ namespace pstore {
 
     namespace details {
         extern std::array<std::uint32_t, 256> const crc32_tab;
+
+        /// The signature shared by the CRC32 implementations. Each updates the running value \p
+        /// crc with the \p size bytes starting at \p buf and returns the new running value.
+        using crc32_function = std::uint32_t (*) (std::uint32_t crc, void const * buf,
+                                                  std::size_t size);
+
+        /// The reference implementation: processes the data a byte at a time.
+        std::uint32_t crc32_bytewise (std::uint32_t crc, void const * buf,
+                                      std::size_t size) noexcept;
+        /// A portable implementation which processes the data eight bytes at a time.
+        std::uint32_t crc32_slice8 (std::uint32_t crc, void const * buf,
+                                    std::size_t size) noexcept;
+        /// Returns an implementation which uses the host CPU's carry-less multiply or CRC
+        /// instructions or nullptr if no such implementation is available.
+        crc32_function crc32_hardware () noexcept;
+
+        /// Updates the running value \p crc using the fastest implementation available on the
+        /// host. The implementation is selected on first use.
+        std::uint32_t crc32_update (std::uint32_t crc, void const * buf,
+                                    std::size_t size) noexcept;
     } // end namespace details
 
     template <typename SpanType>
     std::uint32_t crc32 (SpanType buf) noexcept {
-        auto * p = reinterpret_cast<std::uint8_t const *> (buf.data ());
-        auto crc = std::uint32_t{0};
-        auto size = buf.size_bytes ();
-        while (size--) {
-            crc = details::crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
-        }
-        return crc ^ ~0U;
+        auto const size = static_cast<std::size_t> (buf.size_bytes ());
+        return details::crc32_update (0U, buf.data (), size) ^ ~0U;
     }
 
 } // end namespace pstore
@@ -55,6 +55,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <tuple>
 #include <type_traits>
 #include <vector>
@@ -62,6 +63,7 @@
 #include "pstore/core/file_header.hpp"
 #include "pstore/core/hamt_map_fwd.hpp"
 #include "pstore/core/region.hpp"
+#include "pstore/core/spanning_cache.hpp"
 #include "pstore/core/storage.hpp"
 #include "pstore/core/vacuum_intf.hpp"
 #include "pstore/os/file.hpp"
@@ -97,6 +99,20 @@ namespace pstore {
         explicit database (std::string const & path, access_mode am,
                            bool access_tick_enabled = true);
 
+        /// Selects when the file's memory-mapped regions are mapped. Eager mapping maps the entire
+        /// file when the database is opened; lazy mapping defers the mapping of each region until
+        /// an address within it is first accessed, which makes opening a large store very cheap.
+        enum class mapping_mode { eager, lazy };
+
+        /// \param path  The path of the file containing the database.
+        /// \param am  The requested access mode. If the file does not exist and writable access is
+        /// requested, a new empty database is created. If read-only access is requested and the
+        /// file does not exist, an error is raised.
+        /// \param mm  The mapping mode. Lazy mapping is used only for read-only access: a
+        /// writable database is always mapped eagerly.
+        database (std::string const & path, access_mode am, mapping_mode mm,
+                  bool access_tick_enabled = true);
+
         /// Create a database from a pre-opened file. This interface is intended to enable
         /// the database class to be unit tested.
         template <typename File>
@@ -154,6 +170,18 @@ namespace pstore {
         /// the old currently synced because to do so may require additional space to be mapped.
         typed_address<trailer> older_revision_footer_pos (unsigned revision) const;
 
+        /// \brief Returns the address of the footer of a specified revision by searching
+        /// backwards from a given footer.
+        ///
+        /// The search follows the trailer skip_generation pointers where they are present and so
+        /// normally visits O(log n) trailers. An unknown_revision error is raised if \p revision
+        /// is later than the revision of the footer at \p start.
+        ///
+        /// \param start  The address of the footer at which the search begins.
+        /// \param revision  The revision number to be found.
+        typed_address<trailer> find_revision_footer_pos (typed_address<trailer> start,
+                                                         unsigned revision) const;
+
         static constexpr bool small_files_enabled () noexcept {
             return region::small_files_enabled ();
         }
@@ -295,6 +323,103 @@ namespace pstore {
         vacuum_mode get_vacuum_mode () const noexcept { return vacuum_mode_; }
         ///@}
 
+        ///@{
+        /// Controls how modified index nodes are written to the store when a transaction is
+        /// committed. In parallel mode, storage for all of an index's modified nodes is allocated
+        /// up-front and the nodes are then written concurrently. The resulting store contents are
+        /// the same in either mode.
+        enum class flush_mode {
+            serial,
+            parallel,
+        };
+        void set_flush_mode (flush_mode const mode) noexcept { flush_mode_ = mode; }
+        flush_mode get_flush_mode () const noexcept { return flush_mode_; }
+        ///@}
+
+        ///@{
+        /// Controls whether a membership filter is written alongside each index when it is
+        /// flushed. An index's filter allows most lookups for keys which are not present to
+        /// complete without walking the index's tree. Indices read from the store use whatever
+        /// filter was written with them, regardless of this setting. Filters are written only to
+        /// a store whose minor version is at least header::index_filter_version.
+        enum class index_filter_mode {
+            disabled,
+            enabled,
+        };
+        void set_index_filter_mode (index_filter_mode const mode) noexcept {
+            index_filter_mode_ = mode;
+        }
+        index_filter_mode get_index_filter_mode () const noexcept { return index_filter_mode_; }
+        /// Returns true if indices written to this store carry a membership filter.
+        bool writes_index_filter () const noexcept {
+            return index_filter_mode_ == index_filter_mode::enabled &&
+                   this->minor_version () >= header::index_filter_version;
+        }
+        ///@}
+
+        ///@{
+        /// Controls whether index internal nodes are written with an array of hash fragments
+        /// which lets most lookups for absent keys finish without loading a leaf. The fragments
+        /// are written only to a store whose minor version is at least
+        /// header::index_fragments_version; nodes written in either form can be read.
+        enum class index_fragments_mode {
+            disabled,
+            enabled,
+        };
+        void set_index_fragments_mode (index_fragments_mode const mode) noexcept {
+            index_fragments_mode_ = mode;
+        }
+        index_fragments_mode get_index_fragments_mode () const noexcept {
+            return index_fragments_mode_;
+        }
+        /// Returns true if index internal nodes written to this store carry hash fragments.
+        bool writes_index_fragments () const noexcept {
+            return index_fragments_mode_ == index_fragments_mode::enabled &&
+                   this->minor_version () >= header::index_fragments_version;
+        }
+        ///@}
+
+        ///@{
+        /// Controls the access pattern hint given to the operating system for the store's
+        /// memory-mapped regions. The pattern applies to all regions, including those mapped after
+        /// the call. For example, a tool which reads the entire store might select
+        /// access_pattern::sequential whereas a process performing scattered index lookups might
+        /// select access_pattern::random.
+        void set_access_pattern (access_pattern const pattern) {
+            storage_.set_access_pattern (pattern);
+        }
+        access_pattern get_access_pattern () const noexcept {
+            return storage_.get_access_pattern ();
+        }
+        ///@}
+
+        ///@{
+        /// Asks the operating system to begin reading the pages that hold the given range of
+        /// addresses so that they are resident before they are accessed. This avoids a long
+        /// sequence of individual page faults when cold data (such as the nodes of a large index)
+        /// is about to be read.
+        ///
+        /// \param addr  The start of the address range to be prefetched.
+        /// \param size  The number of bytes to be prefetched.
+        void prefetch (address addr, std::uint64_t size) const;
+        template <typename T>
+        void prefetch (extent<T> const & ex) const {
+            this->prefetch (ex.addr.to_address (), ex.size);
+        }
+        ///@}
+
+        /// Returns the number of hits and misses recorded by the cache of read-only requests which
+        /// span more than one memory-mapped region.
+        spanning_cache::statistics spanning_cache_stats () const noexcept {
+            return spanning_cache_->stats ();
+        }
+
+        /// Returns true if the trailer at \p pos has already passed trailer::validate() since this
+        /// database was opened. Committed trailers are immutable so need only be checked once.
+        bool trailer_validated (typed_address<trailer> pos) const;
+        /// Records that the trailer at \p pos has passed trailer::validate().
+        void set_trailer_validated (typed_address<trailer> pos) const;
+
         /// For unit testing
         class storage const & storage () const noexcept {
             return storage_;
@@ -303,6 +428,9 @@ namespace pstore {
         void close ();
 
         header const & get_header () const noexcept { return *header_; }
+        /// Returns the minor version of the store's file format. Structures introduced by a later
+        /// minor version must not be written to the store.
+        std::uint16_t minor_version () const noexcept { return header_->a.version[1]; }
         typed_address<trailer> footer_pos () const noexcept { return size_.footer_pos (); }
 
         /// Returns the generation number to which the database is synced.
@@ -369,6 +497,11 @@ namespace pstore {
             return this->getro (this->footer_pos ());
         }
 
+        /// Clears the index cache: the next time that an index is requested it will be read from
+        /// the disk. Used after a sync() operation has changed the current database view and when
+        /// a transaction is rolled back, since the cached indices may refer to discarded data.
+        void clear_index_cache () noexcept;
+
     private:
         class storage storage_;
         std::shared_ptr<header> header_;
@@ -376,9 +509,23 @@ namespace pstore {
         std::unique_lock<file::range_lock> lock_;
 
         vacuum_mode vacuum_mode_ = vacuum_mode::disabled;
+        flush_mode flush_mode_ = flush_mode::serial;
+        index_filter_mode index_filter_mode_ = index_filter_mode::disabled;
+        index_fragments_mode index_fragments_mode_ = index_fragments_mode::disabled;
         bool modified_ = false;
         bool closed_ = false;
 
+        /// Retains the blocks of memory built by get_spanning() for read-only requests.
+        std::unique_ptr<spanning_cache> spanning_cache_ = std::make_unique<spanning_cache> ();
+
+        /// The positions of the trailers which have passed trailer::validate().
+        struct validated_trailers {
+            std::mutex mut;
+            std::set<std::uint64_t> positions;
+        };
+        std::unique_ptr<validated_trailers> validated_trailers_ =
+            std::make_unique<validated_trailers> ();
+
         /// The current logical end-of-file, which may be less than the physical end-of-file due to
         /// the memory manager on Windows requiring that the file backing a memory mapped region be
         /// at least as large as that region.
@@ -431,17 +578,14 @@ namespace pstore {
         shared_memory<shared> shared_;
         std::shared_ptr<heartbeat> heartbeat_;
 
-        /// Clears the index cache: the next time that an index is requested it will be read from
-        /// the disk. Used after a sync() operation has changed the current database view.
-        void clear_index_cache ();
-
         /// Returns the lowest address from which a writable pointer can be obtained.
         address first_writable_address () const;
 
         /// Returns a block of data from the store which spans more than one region. A fresh block
         /// of memory is allocated to which blocks of data from the store are copied. If a writable
         /// pointer is requested, the data will be copied back to the store when the pointer is
-        /// released.
+        /// released. Read-only requests for committed data are satisfied from spanning_cache_ when
+        /// possible.
         auto get_spanning (address addr, std::size_t size, bool initialized, bool writable) const
             -> std::shared_ptr<void const>;
 
@@ -512,7 +656,8 @@ namespace pstore {
         }
 #endif
         if (h->a.header_size != sizeof (class header) || h->a.version[0] != header::major_version ||
-            h->a.version[1] != header::minor_version) {
+            h->a.version[1] < header::oldest_minor_version ||
+            h->a.version[1] > header::minor_version) {
             raise (error_code::header_version_mismatch, file.path ());
         }
         if (!h->is_valid ()) {
@@ -50,6 +50,7 @@
 
 #include "pstore/core/address.hpp"
 #include "pstore/core/database.hpp"
+#include "pstore/core/pinned_view.hpp"
 #include "pstore/serialize/archive.hpp"
 #include "pstore/support/error.hpp"
 
@@ -141,6 +142,15 @@ namespace pstore {
                 database_reader (pstore::database const & db, pstore::address const addr) noexcept
                         : db_ (db)
                         , addr_ (addr) {}
+                /// Constructs the reader using a pinned database view and an address. Data is read
+                /// through the view so that no reference counts are modified.
+                ///
+                /// \param view The pinned view from which data is read.
+                /// \param addr The start address from which data is read.
+                database_reader (pstore::pinned_view & view, pstore::address const addr) noexcept
+                        : db_ (view.db ())
+                        , view_ (&view)
+                        , addr_ (addr) {}
 
                 pstore::database const & get_db () const noexcept { return db_; }
                 pstore::address get_address () const noexcept { return addr_; }
@@ -168,8 +178,9 @@ namespace pstore {
                 void getn (SpanType span);
 
             private:
-                database const & db_; ///< The database from which data is read.
-                address addr_;        ///< The address from which data is read.
+                database const & db_;          ///< The database from which data is read.
+                pinned_view * view_ = nullptr; ///< If not null, the view used to read data.
+                address addr_;                 ///< The address from which data is read.
             };
 
             // get
@@ -180,10 +191,14 @@ namespace pstore {
                 auto const extra_for_alignment = calc_alignment (addr_.absolute (), alignof (Ty));
                 assert (extra_for_alignment < sizeof (Ty));
                 addr_ += extra_for_alignment;
-                // Load the data.
-                auto result = db_.getro (typed_address<Ty> (addr_));
+                auto const src = typed_address<Ty> (addr_);
                 addr_ += sizeof (Ty);
-                // Copy to the destination.
+                // Load the data and copy to the destination.
+                if (view_ != nullptr) {
+                    new (&v) Ty (*view_->getro (src));
+                    return;
+                }
+                auto result = db_.getro (src);
                 new (&v) Ty (*result);
             }
 
@@ -201,12 +216,19 @@ namespace pstore {
 
                 // Load the data.
                 auto const size = unsigned_cast (span.size_bytes ());
-                auto src = db_.getro (typed_address<std::uint8_t> (addr_), size);
+                auto const src = typed_address<std::uint8_t> (addr_);
                 addr_ += size;
 
                 // Copy to the destination span.
-                auto first = src.get ();
-                std::copy (first, first + size, reinterpret_cast<std::uint8_t *> (span.data ()));
+                auto * const dest = reinterpret_cast<std::uint8_t *> (span.data ());
+                if (view_ != nullptr) {
+                    auto const * const first = view_->getro (src, size);
+                    std::copy (first, first + size, dest);
+                    return;
+                }
+                auto const ptr = db_.getro (src, size);
+                auto const * const first = ptr.get ();
+                std::copy (first, first + size, dest);
             }
 
             /// A convenience function which provides symmetry with the make_writer() function.
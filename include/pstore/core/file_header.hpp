@@ -117,7 +117,25 @@ namespace pstore {
         std::uint32_t get_crc () const noexcept;
 
         static std::uint16_t const major_version = 1;
-        static std::uint16_t const minor_version = 6;
+        static std::uint16_t const minor_version = 10;
+        /// The oldest minor version of the file format which can be read. A store whose minor
+        /// version lies between this value and minor_version is accepted.
+        static std::uint16_t const oldest_minor_version = 6;
+        /// The first minor version whose stores may contain trailer extension records, a payload
+        /// index, and sections with shared payloads. None of these are written to an older store
+        /// so that it remains readable by the code which created it.
+        static std::uint16_t const shared_payload_version = 7;
+        /// The first minor version whose index internal nodes may carry an array of hash
+        /// fragments. Nodes of this form are written only if the database's index fragments mode
+        /// is enabled.
+        static std::uint16_t const index_fragments_version = 8;
+        /// The first minor version whose indices may have a membership filter. Filters are
+        /// written only if the database's index filter mode is enabled.
+        static std::uint16_t const index_filter_version = 9;
+        /// The first minor version whose indirect_string records may carry the hash of their
+        /// string. Such records are written only if an indirect_string_adder is asked to store
+        /// hashes.
+        static std::uint16_t const indirect_string_hash_version = 10;
 
         static std::array<std::uint8_t, 4> const file_signature1;
         static std::uint32_t const file_signature2 = 0x0507FFFF;
@@ -203,12 +221,15 @@ namespace pstore {
 
     namespace index {
 
+// The order of this list fixes the slot used to record each index's location. Indices which
+// follow 'write' have no slot in the trailer itself and are recorded by a trailer::extension.
 #define PSTORE_INDICES                                                                             \
     X (compilation)                                                                                \
     X (debug_line_header)                                                                          \
     X (fragment)                                                                                   \
     X (name)                                                                                       \
-    X (write)
+    X (write)                                                                                      \
+    X (payload)
 
         struct header_block;
     } // namespace index
@@ -232,22 +253,77 @@ namespace pstore {
         /// Computes the trailer's CRC value.
         std::uint32_t get_crc () const noexcept;
 
+        /// Returns the number of the generation to which the skip_generation field of the trailer
+        /// for \p generation points. Every generation's target is lower than itself and (as in a
+        /// deterministic skip list) the targets are distributed such that any older generation
+        /// can be reached in O(log n) steps.
+        static constexpr unsigned skip_generation_number (unsigned const generation) noexcept {
+            if (generation < 2U) {
+                return 0U;
+            }
+            if ((generation & 1U) == 0U) {
+                return clear_lowest_one (generation);
+            }
+            return clear_lowest_one (clear_lowest_one (generation - 1U)) + 1U;
+        }
+
 
 #define X(a) a,
         // Note that the first enum member must have the value 0 or flush_indices() will need to
         // change.
         enum class indices : unsigned { PSTORE_INDICES last };
 #undef X
+        /// The number of indices whose locations are recorded in the trailer's body.
+        static constexpr auto num_trailer_indices =
+            static_cast<std::underlying_type<indices>::type> (indices::payload);
+        /// The number of indices whose locations are recorded by a trailer extension record.
+        static constexpr auto num_extension_indices =
+            static_cast<std::underlying_type<indices>::type> (indices::last) - num_trailer_indices;
+
+        /// The locations of all of the indices.
         using index_records_array =
             std::array<typed_address<index::header_block>,
                        static_cast<std::underlying_type<indices>::type> (indices::last)>;
 
+        /// Returns the locations of all of the indices recorded by the trailer at \p pos,
+        /// including those held by its extension record. Raises error_code::footer_corrupt if the
+        /// extension record is damaged.
+        static index_records_array get_index_records (database const & db,
+                                                      typed_address<trailer> pos);
+        /// Returns the location of index \p which as recorded by the trailer at \p pos.
+        static typed_address<index::header_block>
+        get_index_record (database const & db, typed_address<trailer> pos, indices which);
+
+        /// Records the locations of the indices which have no slot in the trailer body. A
+        /// transaction in which any of these indices is not empty writes an extension record
+        /// before its trailer and sets the trailer's extension_offset field.
+        struct extension {
+            static std::array<std::uint8_t, 8> const default_signature;
+
+            bool crc_is_valid () const noexcept;
+            bool signature_is_valid () const noexcept;
+            std::uint32_t get_crc () const noexcept;
+
+            /// Represents the portion of the record which is covered by the computed CRC value.
+            struct body {
+                std::array<std::uint8_t, 8> signature = default_signature;
+                std::array<typed_address<index::header_block>, num_extension_indices>
+                    index_records;
+            };
+
+            body a;
+            std::uint32_t crc = 0;
+            std::uint32_t unused1 = 0;
+        };
+
         /// Represents the portion of the trailer structure which is covered by the computed CRC
         /// value.
         struct body {
             std::array<std::uint8_t, 8> signature1 = default_signature1;
             std::atomic<std::uint32_t> generation{0};
-            std::uint32_t unused1{0};
+            /// The number of bytes from the start of this transaction's extension record to the
+            /// start of the trailer, or 0 if the transaction has no extension record.
+            std::uint32_t extension_offset{0};
 
             /// The number of bytes contained by this transaction. The value does not include the
             /// size of the footer record.
@@ -261,9 +337,15 @@ namespace pstore {
             /// "sync" to a specific number.
             typed_address<trailer> prev_generation = typed_address<trailer>::null ();
 
-            index_records_array index_records;
-            std::uint32_t unused2{0};
-            std::uint32_t unused3{0};
+            /// The locations of the first num_trailer_indices indices.
+            std::array<typed_address<index::header_block>, num_trailer_indices> index_records;
+
+            /// A pointer to an older generation -- the one numbered
+            /// skip_generation_number(generation) -- which turns the reverse linked list given by
+            /// prev_generation into a skip list. This enables the trailer for any revision to be
+            /// found in time logarithmic in the number of generations. May be null (in stores
+            /// written before it was introduced), in which case prev_generation must be followed.
+            typed_address<trailer> skip_generation = typed_address<trailer>::null ();
         };
 
 
@@ -277,17 +359,21 @@ namespace pstore {
         std::uint32_t crc = 0;
         std::uint32_t unused1 = 0;
         std::array<std::uint8_t, 8> signature2 = default_signature2;
+
+    private:
+        static constexpr unsigned clear_lowest_one (unsigned const n) noexcept {
+            return n & (n - 1U);
+        }
     };
 
     PSTORE_STATIC_ASSERT (offsetof (trailer::body, signature1) == 0);
     PSTORE_STATIC_ASSERT (offsetof (trailer::body, generation) == 8);
-    PSTORE_STATIC_ASSERT (offsetof (trailer::body, unused1) == 12);
+    PSTORE_STATIC_ASSERT (offsetof (trailer::body, extension_offset) == 12);
     PSTORE_STATIC_ASSERT (offsetof (trailer::body, size) == 16);
     PSTORE_STATIC_ASSERT (offsetof (trailer::body, time) == 24);
     PSTORE_STATIC_ASSERT (offsetof (trailer::body, prev_generation) == 32);
     PSTORE_STATIC_ASSERT (offsetof (trailer::body, index_records) == 40);
-    PSTORE_STATIC_ASSERT (offsetof (trailer::body, unused2) == 80);
-    PSTORE_STATIC_ASSERT (offsetof (trailer::body, unused3) == 84);
+    PSTORE_STATIC_ASSERT (offsetof (trailer::body, skip_generation) == 80);
     PSTORE_STATIC_ASSERT (sizeof (trailer::body) == 88);
 
     PSTORE_STATIC_ASSERT (offsetof (trailer, a) == 0);
@@ -296,5 +382,14 @@ namespace pstore {
     PSTORE_STATIC_ASSERT (alignof (trailer) == 8);
     PSTORE_STATIC_ASSERT (sizeof (trailer) == 104);
 
+    PSTORE_STATIC_ASSERT (offsetof (trailer::extension::body, signature) == 0);
+    PSTORE_STATIC_ASSERT (offsetof (trailer::extension::body, index_records) == 8);
+    PSTORE_STATIC_ASSERT (sizeof (trailer::extension::body) == 16);
+
+    PSTORE_STATIC_ASSERT (offsetof (trailer::extension, a) == 0);
+    PSTORE_STATIC_ASSERT (offsetof (trailer::extension, crc) == 16);
+    PSTORE_STATIC_ASSERT (alignof (trailer::extension) == 8);
+    PSTORE_STATIC_ASSERT (sizeof (trailer::extension) == 24);
+
 } // namespace pstore
 #endif // PSTORE_CORE_FILE_HEADER_HPP
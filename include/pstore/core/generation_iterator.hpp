@@ -86,6 +86,11 @@ namespace pstore {
         generation_iterator & operator++ ();  // pre-increment
         generation_iterator operator++ (int); // post-increment
 
+        /// Moves the iterator directly to the trailer for \p revision, which must not be later
+        /// than the revision at the iterator's current position. Normally visits O(log n)
+        /// trailers rather than every intervening generation.
+        generation_iterator & seek (unsigned revision);
+
     private:
         bool validate () const;
 
@@ -100,6 +105,8 @@ namespace pstore {
                 : db_ (db) {}
         generation_iterator begin ();
         generation_iterator end ();
+        /// Returns an iterator positioned at the trailer for \p revision.
+        generation_iterator find (unsigned revision);
 
     private:
         database const & db_;
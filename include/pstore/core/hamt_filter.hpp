@@ -0,0 +1,248 @@
+//*  _                     _      __ _ _ _             *
+//* | |__   __ _ _ __ ___ | |_   / _(_) | |_ ___ _ __  *
+//* | '_ \ / _` | '_ ` _ \| __| | |_| | | __/ _ \ '__| *
+//* | | | | (_| | | | | | | |_  |  _| | | ||  __/ |    *
+//* |_| |_|\__,_|_| |_| |_|\__| |_| |_|_|\__\___|_|    *
+//*                                                    *
+//===- include/pstore/core/hamt_filter.hpp --------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file hamt_filter.hpp
+/// \brief A persistent membership filter which allows a hamt_map to reject most lookups for absent
+/// keys without walking the tree.
+
+#ifndef PSTORE_CORE_HAMT_FILTER_HPP
+#define PSTORE_CORE_HAMT_FILTER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "pstore/core/address.hpp"
+#include "pstore/core/hamt_map_types.hpp"
+
+namespace pstore {
+    class database;
+    class pinned_view;
+    class transaction_base;
+
+    namespace index {
+
+        /// The in-store header of a membership filter. It is followed, at the next multiple of
+        /// filter_block_size bytes, by the array of filter blocks.
+        struct filter_header {
+            std::array<std::uint8_t, 8> signature;
+            /// The number of blocks in the filter. Always a power of 2.
+            std::uint64_t num_blocks;
+        };
+
+        PSTORE_STATIC_ASSERT (sizeof (filter_header) == 16);
+        PSTORE_STATIC_ASSERT (offsetof (filter_header, signature) == 0);
+        PSTORE_STATIC_ASSERT (offsetof (filter_header, num_blocks) == 8);
+
+        /// The in-store header of a filter overlay: a copy of those blocks of a filter which have
+        /// changed since the filter was last written in full. It is followed, at the next multiple
+        /// of filter_block_size bytes, by the sorted indices of the blocks that it holds (padded
+        /// to a multiple of filter_block_size bytes) and then by the blocks themselves.
+        struct filter_overlay_header {
+            std::array<std::uint8_t, 8> signature;
+            /// The number of blocks in the base filter.
+            std::uint64_t num_blocks;
+            /// The address of the base filter's filter_header.
+            address base;
+            /// The number of blocks held by the overlay.
+            std::uint64_t num_dirty;
+        };
+
+        PSTORE_STATIC_ASSERT (sizeof (filter_overlay_header) == 32);
+        PSTORE_STATIC_ASSERT (offsetof (filter_overlay_header, signature) == 0);
+        PSTORE_STATIC_ASSERT (offsetof (filter_overlay_header, num_blocks) == 8);
+        PSTORE_STATIC_ASSERT (offsetof (filter_overlay_header, base) == 16);
+        PSTORE_STATIC_ASSERT (offsetof (filter_overlay_header, num_dirty) == 24);
+
+        namespace details {
+
+            /// A blocked Bloom filter over the key hashes of a hamt_map.
+            ///
+            /// Each key sets eight bits, one in each word of a single 64-byte block, so a query
+            /// touches exactly one cache line. The block is chosen by the upper half of the
+            /// (re-mixed) key hash and the bits by the lower half. When the number of keys
+            /// outgrows the filter, it is rebuilt at twice the size from all of the index's keys.
+            ///
+            /// The store is append-only, so a new generation of the filter is written whenever its
+            /// index is flushed with new keys. Rather than copying every block, a generation is
+            /// normally written as an overlay on the last full copy of the filter. The overlay
+            /// holds just the blocks which have changed since that copy was made. A flush
+            /// therefore writes the blocks touched by the new keys and those in the previous
+            /// overlay. Once an overlay would hold more than 1/max_overlay_fraction of the
+            /// filter's blocks, a full copy is written instead and becomes the base for later
+            /// overlays. A lookup reads at most one block, plus a binary search of the overlay's
+            /// block indices.
+            class membership_filter {
+            public:
+                using block = std::array<std::uint64_t, 8>;
+
+                /// Constructs an object with no in-store filter. may_contain() always returns
+                /// true.
+                membership_filter () noexcept = default;
+                /// Loads the header of the in-store filter at \p addr.
+                ///
+                /// \param db  The database containing the filter.
+                /// \param addr  The filter's address. May be null in which case there is no
+                /// in-store filter.
+                membership_filter (database const & db, typed_address<filter_header> addr);
+
+                /// Returns the address of the in-store filter or null if there is none. This is
+                /// either a full filter or an overlay on one.
+                typed_address<filter_header> location () const noexcept { return addr_; }
+                /// Returns the address of the last full copy of the in-store filter or null if
+                /// there is none.
+                typed_address<filter_header> base () const noexcept { return base_; }
+                /// Returns the number of blocks held by the filter's overlay or 0 if the in-store
+                /// filter is a full copy.
+                std::uint64_t num_overlay_blocks () const noexcept { return num_dirty_; }
+                /// Returns the number of blocks in the in-store filter.
+                std::uint64_t num_blocks () const noexcept { return num_blocks_; }
+
+                /// Returns false if no key with the given hash was added to the in-store filter.
+                /// If there is no in-store filter, or keys have been added since it was written,
+                /// true is returned.
+                bool may_contain (database const & db, hash_type hash) const;
+                bool may_contain (pinned_view & view, hash_type hash) const;
+
+                /// Records that a key with the given hash has been added to the index. The hash
+                /// is added to the filter when it is next written. Nothing is recorded if there is
+                /// no in-store filter: if one is wanted, it is built from all of the index's keys.
+                void add (hash_type const hash) {
+                    if (addr_ != typed_address<filter_header>::null ()) {
+                        pending_.push_back (hash);
+                    }
+                }
+                /// Returns the number of hashes recorded by add() since the in-store filter was
+                /// written.
+                std::size_t num_pending () const noexcept { return pending_.size (); }
+
+                /// Returns true if the filter must be rebuilt from all of the index's keys in
+                /// order to hold \p num_keys keys.
+                bool needs_rebuild (std::uint64_t num_keys) const noexcept;
+
+                /// Writes a new generation of the filter holding the contents of the existing
+                /// in-store filter and the hashes passed to add() since it was written. This is
+                /// normally an overlay holding only the blocks which differ from the last full
+                /// copy of the filter.
+                ///
+                /// \param transaction  The transaction to which the filter is written.
+                void flush (transaction_base & transaction);
+
+                /// Writes a new filter built from the hashes of all of the index's keys.
+                ///
+                /// \param transaction  The transaction to which the filter is written.
+                /// \param hashes  The hashes of all of the keys in the index.
+                void rebuild (transaction_base & transaction,
+                              std::vector<hash_type> const & hashes);
+
+                /// Forgets the in-store filter and any pending hashes.
+                void reset () noexcept;
+
+                /// Sets the bits for \p hash in \p b.
+                static void insert (block & b, hash_type hash) noexcept;
+                /// Returns true if all of the bits for \p hash are set in \p b.
+                static bool contains (block const & b, hash_type hash) noexcept;
+                /// Returns the index of the block used for \p hash in a filter of \p num_blocks
+                /// blocks.
+                static std::uint64_t block_index (hash_type hash,
+                                                  std::uint64_t num_blocks) noexcept;
+                /// Returns the number of blocks for a newly built filter holding \p num_keys keys.
+                static std::uint64_t blocks_for (std::uint64_t num_keys) noexcept;
+
+                /// The maximum average number of keys in a block before the filter is rebuilt.
+                static constexpr std::uint64_t max_keys_per_block = 32U;
+                /// An overlay may hold at most 1/max_overlay_fraction of the filter's blocks. A
+                /// filter with fewer than this number of blocks is always written in full.
+                static constexpr std::uint64_t max_overlay_fraction = 8U;
+                /// The size of a filter block, and the offset of the first block from the start of
+                /// the filter.
+                static constexpr std::size_t block_size = sizeof (block);
+
+            private:
+                /// Allocates a zeroed filter with the given number of blocks and makes it the
+                /// current in-store filter.
+                std::shared_ptr<void> allocate (transaction_base & transaction,
+                                                std::uint64_t num_blocks);
+                /// Returns a pointer to the blocks of a filter allocated by allocate().
+                static block * blocks (std::shared_ptr<void> const & ptr) noexcept;
+                /// Returns the number of bytes occupied by the index array of an overlay holding
+                /// \p num_dirty blocks.
+                static std::uint64_t overlay_index_bytes (std::uint64_t num_dirty) noexcept;
+                /// Returns the store address of the index array of the current overlay.
+                address overlay_indices () const noexcept;
+                /// Returns the store address of the block with the given index.
+                ///
+                /// \param indices  The index array of the current overlay or nullptr if there is
+                ///   no overlay.
+                /// \param index  The index of the block within the filter.
+                address block_address (std::uint64_t const * indices,
+                                       std::uint64_t index) const noexcept;
+
+                /// Writes a full copy of the filter with the pending hashes added to it.
+                void flush_full (transaction_base & transaction,
+                                 std::uint64_t const * old_indices);
+                /// Writes an overlay holding the blocks whose indices are given by \p dirty with
+                /// the pending hashes added to them.
+                void flush_overlay (transaction_base & transaction,
+                                    std::uint64_t const * old_indices,
+                                    std::vector<std::uint64_t> const & dirty);
+
+                /// The current generation of the in-store filter: either a full filter or an
+                /// overlay.
+                typed_address<filter_header> addr_ = typed_address<filter_header>::null ();
+                /// The last full copy of the filter. Equal to addr_ unless there is an overlay.
+                typed_address<filter_header> base_ = typed_address<filter_header>::null ();
+                std::uint64_t num_blocks_ = 0;
+                /// The number of blocks held by the overlay or 0 if there is none.
+                std::uint64_t num_dirty_ = 0;
+                /// The hashes of keys added since the in-store filter was written.
+                std::vector<hash_type> pending_;
+            };
+
+        } // namespace details
+    }     // namespace index
+} // namespace pstore
+
+#endif // PSTORE_CORE_HAMT_FILTER_HPP
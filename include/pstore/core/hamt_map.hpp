@@ -46,11 +46,14 @@
 #ifndef PSTORE_CORE_HAMT_MAP_HPP
 #define PSTORE_CORE_HAMT_MAP_HPP
 
+#include <algorithm>
 #include <iterator>
 #include <type_traits>
+#include <vector>
 
 #include "pstore/core/database.hpp"
 #include "pstore/core/db_archive.hpp"
+#include "pstore/core/hamt_filter.hpp"
 #include "pstore/core/hamt_map_fwd.hpp"
 #include "pstore/core/hamt_map_types.hpp"
 #include "pstore/core/transaction.hpp"
@@ -96,6 +99,16 @@ namespace pstore {
                                              serialize::is_compatible<KeyType, K>::value &&
                                                  serialize::is_compatible<ValueType, V>::value> {};
 
+            /// A helper class which provides a member constant `value` which is true if the
+            /// value type of Iterator is a pair whose types are compatible with KeyType and
+            /// ValueType (as determined by pair_types_compatible<>).
+            template <typename Iterator,
+                      typename Pair = typename std::iterator_traits<Iterator>::value_type>
+            struct iterator_pair_types_compatible
+                    : pair_types_compatible<
+                          typename std::remove_const<typename Pair::first_type>::type,
+                          typename Pair::second_type> {};
+
         public:
             using key_equal = KeyEqual;
             using key_type = KeyType;
@@ -295,6 +308,23 @@ namespace pstore {
                          std::pair<OtherKeyType, OtherValueType> const & value)
                 -> std::pair<iterator, bool>;
 
+            /// Inserts an element into the hamt_map if the hamt_map doesn't already contain an
+            /// element with an equivalent key. The caller supplies the key's hash: this avoids
+            /// hashing the key a second time when the caller has already done so.
+            ///
+            /// \param transaction The transaction to which the new key-value pair will be appended.
+            /// \param value  The key-value pair to be inserted.
+            /// \param hash  The hash of value.first. This must be equal to the value produced by
+            /// the map's hash function for the same key.
+            /// \result The bool component is true if the insertion took place and false otherwise.
+            /// The iterator component points at the exiting or new element.
+            template <typename OtherKeyType, typename OtherValueType,
+                      typename = typename std::enable_if<
+                          pair_types_compatible<OtherKeyType, OtherValueType>::value>::type>
+            auto insert (transaction_base & transaction,
+                         std::pair<OtherKeyType, OtherValueType> const & value,
+                         details::hash_type hash) -> std::pair<iterator, bool>;
+
             /// If a key equivalent to \p value first already exists in the container, assigns
             /// \p value second to the mapped type. If the key does not exist, inserts the new value
             /// as if by insert(). If insertion occurs, all iterators are invalidated.
@@ -334,6 +364,43 @@ namespace pstore {
                           pair_types_compatible<OtherKeyType, OtherValueType>::value>::type>
             auto insert_or_assign (transaction_base & transaction, OtherKeyType const & key,
                                    OtherValueType const & value) -> std::pair<iterator, bool>;
+
+            /// Inserts each of the key-value pairs in the range [\p first, \p last) into the
+            /// hamt_map if it doesn't already contain an element with an equivalent key. The
+            /// result is the same as calling insert() for each member of the range in turn, but
+            /// the pairs are first grouped by hash so that each trie node that is touched is
+            /// loaded and copied to the heap no more than once for the whole batch. All iterators
+            /// are invalidated.
+            ///
+            /// \tparam ForwardIterator  A forward iterator whose value type is a std::pair<> with
+            /// members whose serialized representation is compatible with KeyType and ValueType.
+            /// \param transaction  The transaction to which the new key-value pairs will be
+            /// appended.
+            /// \param first  The start of the range of key-value pairs to be inserted.
+            /// \param last  The end of the range of key-value pairs to be inserted.
+            /// \result The number of key-value pairs that were inserted.
+            template <typename ForwardIterator,
+                      typename = typename std::enable_if<
+                          iterator_pair_types_compatible<ForwardIterator>::value>::type>
+            std::size_t insert_range (transaction_base & transaction, ForwardIterator first,
+                                      ForwardIterator last);
+
+            /// Inserts or updates each of the key-value pairs in the range [\p first, \p last) as
+            /// if by calling insert_or_assign() for each member of the range in turn. Like
+            /// insert_range(), the pairs are grouped by hash so that each trie node is visited
+            /// once for the whole batch. All iterators are invalidated.
+            ///
+            /// \tparam ForwardIterator  A forward iterator whose value type is a std::pair<> with
+            /// members whose serialized representation is compatible with KeyType and ValueType.
+            /// \param transaction  The transaction to which new data will be appended.
+            /// \param first  The start of the range of key-value pairs to be inserted or updated.
+            /// \param last  The end of the range of key-value pairs to be inserted or updated.
+            /// \result The number of key-value pairs that were inserted (rather than assigned).
+            template <typename ForwardIterator,
+                      typename = typename std::enable_if<
+                          iterator_pair_types_compatible<ForwardIterator>::value>::type>
+            std::size_t insert_or_assign_range (transaction_base & transaction,
+                                                ForwardIterator first, ForwardIterator last);
             ///@}
 
             /// Finds an element with key equivalent to \p key.
@@ -349,7 +416,22 @@ namespace pstore {
                           serialize::is_compatible<OtherKeyType, KeyType>::value>::type>
             const_iterator find (database const & db, OtherKeyType const & key) const;
 
-            /// Flush any modified tree nodes to the store.
+            /// Finds an element with key equivalent to \p key. In-store nodes are read through
+            /// \p view, so the lookup does not modify any reference counts.
+            ///
+            /// \tparam OtherKeyType  A type whose serialized representation is compatible with
+            /// KeyType.
+            /// \param view  A pinned view of the database to which the index belongs.
+            /// \param key  The key value of the element to be found.
+            /// \return Iterator to an element with key equivalent to key. If not such element is
+            ///         found, past-the end iterator it returned.
+            template <typename OtherKeyType,
+                      typename = typename std::enable_if<
+                          serialize::is_compatible<OtherKeyType, KeyType>::value>::type>
+            const_iterator find (pinned_view & view, OtherKeyType const & key) const;
+
+            /// Flush any modified tree nodes to the store. The nodes are written concurrently if
+            /// the database's flush mode is database::flush_mode::parallel.
             /// \param transaction  The transaction to which the map will be written.
             /// \param generation The generation number to which the map will be written.
             /// \returns The address of the tree root node.
@@ -361,14 +443,22 @@ namespace pstore {
 
             /// Read a leaf node from a store.
             value_type load_leaf_node (database const & db, address const addr) const;
+            /// Read a leaf node from a store through a pinned view.
+            value_type load_leaf_node (pinned_view & view, address const addr) const;
 
             /// Returns the index root pointer.
             index_pointer root () const noexcept { return root_; }
+            /// Returns the index's membership filter.
+            details::membership_filter const & filter () const noexcept { return filter_; }
             ///@}
 
         private:
             static constexpr std::array<std::uint8_t, 8> index_signature{
                 {'I', 'n', 'd', 'x', 'H', 'e', 'd', 'r'}};
+            /// The signature of an index header which is followed by the address of a
+            /// membership filter (a filtered_header_block).
+            static constexpr std::array<std::uint8_t, 8> filtered_index_signature{
+                {'I', 'n', 'd', 'x', 'H', 'd', 'r', 'F'}};
 
             /// Stores a key/value data pair.
             template <typename OtherValueType>
@@ -387,7 +477,19 @@ namespace pstore {
             }
 
             /// Read a key from a store.
-            key_type get_key (database const & db, address const addr) const;
+            /// \tparam Source  Either a (const) database or a pinned_view.
+            template <typename Source>
+            key_type get_key (Source & source, address const addr) const;
+
+            static database const & get_database (database const & db) noexcept { return db; }
+            static database const & get_database (pinned_view const & view) noexcept {
+                return view.db ();
+            }
+
+            /// The implementation of find(). Nodes are read from \p source which may be either a
+            /// database or a pinned_view.
+            template <typename Source, typename OtherKeyType>
+            const_iterator find_impl (Source & source, OtherKeyType const & key) const;
 
             /// Called when the trie's top-level loop has descended as far as a leaf node. We need
             /// to convert that to an internal node.
@@ -446,10 +548,52 @@ namespace pstore {
 
             /// Insert or insert_or_assign a node into a hamt_map.
             /// \tparam OtherValueType  A type whose serialization is compatible with value_type.
+            /// \param hash  The hash of the key of \p value.
             template <typename OtherValueType>
             std::pair<iterator, bool> insert_or_upsert (transaction_base & transaction,
                                                         OtherValueType const & value,
-                                                        bool is_upsert);
+                                                        hash_type hash, bool is_upsert);
+
+            /// A member of a batch insertion: the full hash of the key and a pointer to the
+            /// key-value pair that is to be inserted.
+            template <typename OtherValueType>
+            using batch_member = std::pair<hash_type, OtherValueType const *>;
+
+            /// Insert or insert_or_assign the range [first, last) into a hamt_map.
+            template <typename ForwardIterator>
+            std::size_t insert_or_upsert_range (transaction_base & transaction,
+                                                ForwardIterator first, ForwardIterator last,
+                                                bool is_upsert);
+
+            /// Inserts a batch of key/value pairs into a tree node which may be empty, a leaf, an
+            /// internal node, or a linear node.
+            ///
+            /// \param transaction  The transaction to which new data will be appended.
+            /// \param node  A heap or in-store reference to the node into which the batch is to be
+            /// inserted. May be empty if the batch is to be written to an unused slot.
+            /// \param first  The first of the batch members. All of the members of the range
+            /// [first, last) share the same hash bits below \p shifts and are ordered such that
+            /// members which share hash bits at the next level are adjacent.
+            /// \param last  The end of the range of batch members.
+            /// \param shifts  The number of bits by which the hash value is shifted to reach the
+            /// current tree level.
+            /// \param is_upsert  True if this is an "upsert" (insert or update) operation, false
+            /// otherwise.
+            /// \param inserted  Incremented for each of the batch members which resulted in a new
+            /// key being added to the tree.
+            /// \result  A reference to the node (which will be equal to \p node if the nothing was
+            /// modified by the insert operation).
+            template <typename OtherValueType>
+            index_pointer insert_batch (transaction_base & transaction, index_pointer node,
+                                        batch_member<OtherValueType> const * first,
+                                        batch_member<OtherValueType> const * last, unsigned shifts,
+                                        bool is_upsert, gsl::not_null<std::size_t *> inserted);
+
+            /// Writes the membership filter for the current generation of the index if the
+            /// database's index filter mode is enabled. The previous generation's filter is
+            /// extended with the keys added since it was written or, if it has become too
+            /// full, a new filter is built from all of the keys in the index.
+            void flush_filter (transaction_base & transaction);
 
             /// Frees memory consumed by a heap-allocated tree node.
             ///
@@ -466,6 +610,8 @@ namespace pstore {
             Hash hash_;
             /// The function used to compare keys for equality.
             key_equal equal_;
+            /// The membership filter which is consulted before the tree is searched.
+            details::membership_filter filter_;
         };
 #ifdef _WIN32
 #pragma warning(pop)
@@ -584,6 +730,9 @@ namespace pstore {
         template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
         constexpr std::array<std::uint8_t, 8>
             hamt_map<KeyType, ValueType, Hash, KeyEqual>::index_signature;
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        constexpr std::array<std::uint8_t, 8>
+            hamt_map<KeyType, ValueType, Hash, KeyEqual>::filtered_index_signature;
 
         template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
         hamt_map<KeyType, ValueType, Hash, KeyEqual>::hamt_map (
@@ -596,9 +745,10 @@ namespace pstore {
             if (pos != typed_address<header_block>::null ()) {
                 // 'pos' points to the index header block which gives us the tree root and size.
                 std::shared_ptr<header_block const> const hb = db.getro (pos);
+                bool const filtered = hb->signature == filtered_index_signature;
                 // Check that this block appears to be sensible.
 #if PSTORE_SIGNATURE_CHECKS_ENABLED
-                if (hb->signature != index_signature) {
+                if (!filtered && hb->signature != index_signature) {
                     raise (pstore::error_code::index_corrupt);
                 }
 #endif
@@ -615,6 +765,12 @@ namespace pstore {
                 }
                 size_ = hb->size;
                 root_ = hb->root;
+                if (filtered) {
+                    std::shared_ptr<filtered_header_block const> const fhb =
+                        db.getro (typed_address<filtered_header_block>::make (pos.to_address ()));
+                    filter_ = details::membership_filter{
+                        db, typed_address<filter_header>::make (fhb->filter)};
+                }
             }
         }
 
@@ -648,14 +804,24 @@ namespace pstore {
                 serialize::archive::database_reader{db, addr});
         }
 
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::load_leaf_node (pinned_view & view,
+                                                                           address const addr) const
+            -> value_type {
+
+            return serialize::read<std::pair<KeyType, ValueType>> (
+                serialize::archive::database_reader{view, addr});
+        }
+
         // hamt_map::get_key
         // ~~~~~~~~~~~~~~~~~
         template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
-        auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::get_key (database const & db,
+        template <typename Source>
+        auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::get_key (Source & source,
                                                                     address const addr) const
             -> key_type {
 
-            return serialize::read<KeyType> (serialize::archive::database_reader{db, addr});
+            return serialize::read<KeyType> (serialize::archive::database_reader{source, addr});
         }
 
         // hamt_map::store_leaf_node
@@ -698,8 +864,8 @@ namespace pstore {
                     address const leaf_addr =
                         this->store_leaf_node (transaction, new_leaf, parents);
                     auto const internal_ptr = index_pointer{
-                        internal_node::allocate (existing_leaf, index_pointer{leaf_addr}, old_hash,
-                                                 new_hash)
+                        internal_node::allocate (existing_leaf, index_pointer{leaf_addr},
+                                                 existing_hash, hash)
                             .release ()};
                     parents->push (
                         {internal_ptr, internal_node::get_new_index (new_hash, old_hash)});
@@ -887,8 +1053,8 @@ namespace pstore {
             index_pointer result;
             bool key_exists = false;
             if (node.is_leaf ()) {                                 // This node is a leaf node.
-                key_type const existing_key = get_key (transaction.db (), node.addr); // Read key.
-                if (equal_ (value.first, existing_key)) {
+                if (details::key_matcher<KeyType, KeyEqual>::matches (transaction.db (), node.addr,
+                                                                      value.first, equal_)) {
                     if (is_upsert) {
                         result = this->store_leaf_node (transaction, value, parents);
                     } else {
@@ -897,6 +1063,8 @@ namespace pstore {
                     }
                     key_exists = true;
                 } else {
+                    // The keys differ: the existing key is needed to compute its hash.
+                    key_type const existing_key = get_key (transaction.db (), node.addr);
                     auto const existing_hash =
                         static_cast<hash_type> ((hash_ (existing_key) >> shifts));
                     result = this->insert_into_leaf (transaction, node, value, existing_hash, hash,
@@ -921,8 +1089,8 @@ namespace pstore {
         template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
         template <typename OtherValueType>
         auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::insert_or_upsert (
-            transaction_base & transaction, OtherValueType const & value, bool is_upsert)
-            -> std::pair<iterator, bool> {
+            transaction_base & transaction, OtherValueType const & value, hash_type const hash,
+            bool const is_upsert) -> std::pair<iterator, bool> {
 
             database & db = transaction.db ();
             if (revision_ != db.get_current_revision ()) {
@@ -933,12 +1101,12 @@ namespace pstore {
             if (this->empty ()) {
                 root_ = this->store_leaf_node (transaction, value, &parents);
                 size_ = 1;
+                filter_.add (hash);
                 return std::make_pair (iterator (db, std::move (parents), this), true);
             }
 
             parent_stack reverse_parents;
             bool key_exists = false;
-            auto hash = static_cast<hash_type> (hash_ (value.first));
             std::tie (root_, key_exists) = this->insert_node (
                 transaction, root_, value, hash, 0 /* shifts */, &reverse_parents, is_upsert);
             while (!reverse_parents.empty ()) {
@@ -947,6 +1115,7 @@ namespace pstore {
             }
             if (!key_exists) {
                 ++size_;
+                filter_.add (hash);
             }
             return std::make_pair (iterator (db, std::move (parents), this), !key_exists);
         }
@@ -959,7 +1128,19 @@ namespace pstore {
             transaction_base & transaction, std::pair<OtherKeyType, OtherValueType> const & value)
             -> std::pair<iterator, bool> {
 
-            return this->insert_or_upsert (transaction, value, false /*is_upsert*/);
+            return this->insert_or_upsert (transaction, value,
+                                           static_cast<hash_type> (hash_ (value.first)),
+                                           false /*is_upsert*/);
+        }
+
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        template <typename OtherKeyType, typename OtherValueType, typename>
+        auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::insert (
+            transaction_base & transaction, std::pair<OtherKeyType, OtherValueType> const & value,
+            details::hash_type const hash) -> std::pair<iterator, bool> {
+
+            assert (hash == static_cast<hash_type> (hash_ (value.first)));
+            return this->insert_or_upsert (transaction, value, hash, false /*is_upsert*/);
         }
 
         // hamp_map::insert_or_assign
@@ -970,7 +1151,9 @@ namespace pstore {
             transaction_base & transaction, std::pair<OtherKeyType, OtherValueType> const & value)
             -> std::pair<iterator, bool> {
 
-            return this->insert_or_upsert (transaction, value, true /*is_upsert*/);
+            return this->insert_or_upsert (transaction, value,
+                                           static_cast<hash_type> (hash_ (value.first)),
+                                           true /*is_upsert*/);
         }
 
         // hamt_map::insert_or_assign
@@ -984,6 +1167,170 @@ namespace pstore {
             return this->insert_or_assign (transaction, std::make_pair (key, value));
         }
 
+        // hamt_map::insert_batch
+        // ~~~~~~~~~~~~~~~~~~~~~~
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        template <typename OtherValueType>
+        auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::insert_batch (
+            transaction_base & transaction, index_pointer node,
+            batch_member<OtherValueType> const * first, batch_member<OtherValueType> const * last,
+            unsigned const shifts, bool const is_upsert, gsl::not_null<std::size_t *> inserted)
+            -> index_pointer {
+
+            assert (first != last);
+
+            // Empty slots and leaves are handled by inserting batch members one at a time until the
+            // node becomes an internal node. Once we've run out of hash bits, linear nodes are
+            // updated in the same way.
+            while (first != last &&
+                   (node.is_leaf () || !details::depth_is_internal_node (shifts))) {
+                parent_stack parents;
+                index_pointer replacement;
+                if (node.is_empty ()) {
+                    replacement = this->store_leaf_node (transaction, *first->second, &parents);
+                    ++*inserted;
+                    filter_.add (first->first);
+                } else {
+                    auto const hash =
+                        shifts < details::hash_size ? first->first >> shifts : hash_type{0};
+                    bool key_exists = false;
+                    std::tie (replacement, key_exists) = this->insert_node (
+                        transaction, node, *first->second, hash, shifts, &parents, is_upsert);
+                    if (!key_exists) {
+                        ++*inserted;
+                        filter_.add (first->first);
+                    }
+                }
+                // Release a previous heap-allocated instance.
+                if (replacement != node) {
+                    this->delete_node (node, shifts);
+                    node = replacement;
+                }
+                ++first;
+            }
+            if (first == last) {
+                return node;
+            }
+
+            std::shared_ptr<internal_node const> iptr;
+            internal_node const * internal = nullptr;
+            std::tie (iptr, internal) = internal_node::get_node (transaction.db (), node);
+            assert (internal != nullptr);
+
+            // The node is only copied to the heap once we know that one of its children has
+            // changed.
+            std::unique_ptr<internal_node> new_node;
+            internal_node * inode = nullptr;
+            auto make_writable = [&] () {
+                if (inode == nullptr) {
+                    std::tie (new_node, inode) = internal_node::make_writable (node, *internal);
+                    internal = inode;
+                }
+            };
+
+            auto const child_shifts = shifts + details::hash_index_bits;
+            while (first != last) {
+                // Find the run of batch members which will be placed in the same child slot.
+                auto const hash_index = (first->first >> shifts) & details::hash_index_mask;
+                auto const group_end =
+                    std::find_if (first + 1, last, [shifts, hash_index] (
+                                                       batch_member<OtherValueType> const & m) {
+                        return ((m.first >> shifts) & details::hash_index_mask) != hash_index;
+                    });
+
+                index_pointer child;
+                auto index = std::size_t{0};
+                std::tie (child, index) = internal->lookup (hash_index);
+
+                index_pointer const new_child = this->insert_batch (
+                    transaction, child, first, group_end, child_shifts, is_upsert, inserted);
+                if (index == details::not_found) {
+                    make_writable ();
+                    parent_stack parents;
+                    inode->insert_child (first->first >> shifts, new_child, &parents);
+                } else if (new_child != child) {
+                    make_writable ();
+                    (*inode)[index] = new_child;
+                }
+                first = group_end;
+            }
+
+            if (inode != nullptr) {
+                new_node.release ();
+                node = inode;
+            }
+            return node;
+        }
+
+        // hamt_map::insert_or_upsert_range
+        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        template <typename ForwardIterator>
+        std::size_t hamt_map<KeyType, ValueType, Hash, KeyEqual>::insert_or_upsert_range (
+            transaction_base & transaction, ForwardIterator first, ForwardIterator last,
+            bool const is_upsert) {
+
+            if (revision_ != transaction.db ().get_current_revision ()) {
+                raise (error_code::index_not_latest_revision);
+            }
+
+            using pair_type = typename std::iterator_traits<ForwardIterator>::value_type;
+            using member = batch_member<pair_type>;
+
+            std::vector<member> members;
+            members.reserve (static_cast<std::size_t> (std::distance (first, last)));
+            std::transform (first, last, std::back_inserter (members),
+                            [this] (pair_type const & v) {
+                                return member{static_cast<hash_type> (hash_ (v.first)), &v};
+                            });
+            if (members.empty ()) {
+                return 0U;
+            }
+
+            // Order the members so that those which share the hash bits used to select a child
+            // at each level of the tree are adjacent. The sort is stable so that members with
+            // equal keys are processed in their original order.
+            std::stable_sort (
+                std::begin (members), std::end (members), [] (member const & a, member const & b) {
+                    for (auto shifts = 0U; shifts < details::hash_size;
+                         shifts += details::hash_index_bits) {
+                        auto const ia = (a.first >> shifts) & details::hash_index_mask;
+                        auto const ib = (b.first >> shifts) & details::hash_index_mask;
+                        if (ia != ib) {
+                            return ia < ib;
+                        }
+                    }
+                    return false;
+                });
+
+            auto inserted = std::size_t{0};
+            root_ = this->insert_batch (transaction, root_, members.data (),
+                                        members.data () + members.size (), 0U /*shifts*/,
+                                        is_upsert, &inserted);
+            size_ += inserted;
+            return inserted;
+        }
+
+        // hamt_map::insert_range
+        // ~~~~~~~~~~~~~~~~~~~~~~
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        template <typename ForwardIterator, typename>
+        std::size_t hamt_map<KeyType, ValueType, Hash, KeyEqual>::insert_range (
+            transaction_base & transaction, ForwardIterator first, ForwardIterator last) {
+
+            return this->insert_or_upsert_range (transaction, first, last, false /*is_upsert*/);
+        }
+
+        // hamt_map::insert_or_assign_range
+        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        template <typename ForwardIterator, typename>
+        std::size_t hamt_map<KeyType, ValueType, Hash, KeyEqual>::insert_or_assign_range (
+            transaction_base & transaction, ForwardIterator first, ForwardIterator last) {
+
+            return this->insert_or_upsert_range (transaction, first, last, true /*is_upsert*/);
+        }
+
         // hamt_map::flush
         // ~~~~~~~~~~~~~~~
         template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
@@ -999,20 +1346,61 @@ namespace pstore {
             if (!root_.is_address ()) {
                 assert (root_.is_internal ());
                 auto internal = root_.untag_node<internal_node *> ();
-                root_ = internal->flush (transaction, 0 /* shifts */);
+                root_ = transaction.db ().get_flush_mode () == database::flush_mode::parallel
+                            ? internal->flush_parallel (transaction, 0 /* shifts */)
+                            : internal->flush (transaction, 0 /* shifts */);
                 delete internal;
             }
 
+            this->flush_filter (transaction);
+
             // Write the index header. This simply holds a check signature, the tree root, and
-            // remembers the tree size for us on restore.
-            auto const pos = transaction.alloc_rw<header_block> ();
-            pos.first->signature = index_signature;
-            pos.first->size = this->size ();
-            pos.first->root = root_.addr;
+            // remembers the tree size for us on restore. If the index has a filter, the header is
+            // followed by its address.
+            auto const fill = [this] (header_block * const hb,
+                                      std::array<std::uint8_t, 8> const & signature) {
+                hb->signature = signature;
+                hb->size = this->size ();
+                hb->root = root_.addr;
+            };
+            typed_address<header_block> result;
+            if (filter_.location () == typed_address<filter_header>::null ()) {
+                auto const pos = transaction.alloc_rw<header_block> ();
+                fill (pos.first.get (), index_signature);
+                result = pos.second;
+            } else {
+                auto const pos = transaction.alloc_rw<filtered_header_block> ();
+                fill (&pos.first->base, filtered_index_signature);
+                pos.first->filter = filter_.location ().to_address ();
+                result = typed_address<header_block>::make (pos.second.to_address ());
+            }
 
             // Update the revision number into which the index will be flushed.
             revision_ = generation;
-            return pos.second;
+            return result;
+        }
+
+        // hamt_map::flush_filter
+        // ~~~~~~~~~~~~~~~~~~~~~~
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        void hamt_map<KeyType, ValueType, Hash, KeyEqual>::flush_filter (
+            transaction_base & transaction) {
+            database const & db = transaction.db ();
+            if (!db.writes_index_filter () || this->empty ()) {
+                filter_.reset ();
+                return;
+            }
+            if (!filter_.needs_rebuild (size_)) {
+                filter_.flush (transaction);
+                return;
+            }
+            std::vector<hash_type> hashes;
+            hashes.reserve (size_);
+            std::for_each (this->cbegin (db), this->cend (db),
+                           [this, &hashes] (value_type const & v) {
+                               hashes.push_back (static_cast<hash_type> (hash_ (v.first)));
+                           });
+            filter_.rebuild (transaction, hashes);
         }
 
         // hamt_map::find
@@ -1022,11 +1410,34 @@ namespace pstore {
         auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::find (database const & db,
                                                                  OtherKeyType const & key) const
             -> const_iterator {
+            return this->find_impl (db, key);
+        }
+
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        template <typename OtherKeyType, typename>
+        auto hamt_map<KeyType, ValueType, Hash, KeyEqual>::find (pinned_view & view,
+                                                                 OtherKeyType const & key) const
+            -> const_iterator {
+            return this->find_impl (view, key);
+        }
+
+        // hamt_map::find_impl
+        // ~~~~~~~~~~~~~~~~~~~
+        template <typename KeyType, typename ValueType, typename Hash, typename KeyEqual>
+        template <typename Source, typename OtherKeyType>
+        auto
+        hamt_map<KeyType, ValueType, Hash, KeyEqual>::find_impl (Source & source,
+                                                                 OtherKeyType const & key) const
+            -> const_iterator {
+            database const & db = get_database (source);
             if (empty ()) {
                 return this->cend (db);
             }
 
             auto hash = static_cast<hash_type> (hash_ (key));
+            if (!filter_.may_contain (source, hash)) {
+                return this->cend (db);
+            }
             unsigned bit_shifts = 0;
             index_pointer node = root_;
             parent_stack parents;
@@ -1039,14 +1450,20 @@ namespace pstore {
                 if (details::depth_is_internal_node (bit_shifts)) {
                     // It's an internal node.
                     internal_node const * internal = nullptr;
-                    std::tie (store_node, internal) = internal_node::get_node (db, node);
+                    std::tie (store_node, internal) = internal_node::get_node (source, node);
                     std::tie (child_node, index) =
                         internal->lookup (hash & details::hash_index_mask);
+                    // If the child is a leaf, its hash fragment may show that it cannot hold the
+                    // key without our having to load it.
+                    if (index != details::not_found && child_node.is_leaf () &&
+                        !internal->may_match (index, hash)) {
+                        return this->cend (db);
+                    }
                 } else {
                     // It's a linear node.
                     linear_node const * linear = nullptr;
-                    std::tie (store_node, linear) = linear_node::get_node (db, node);
-                    std::tie (child_node, index) = linear->lookup<KeyType> (db, key, equal_);
+                    std::tie (store_node, linear) = linear_node::get_node (source, node);
+                    std::tie (child_node, index) = linear->lookup<KeyType> (source, key, equal_);
                 }
 
                 if (index == details::not_found) {
@@ -1061,8 +1478,7 @@ namespace pstore {
             }
             // It's a leaf node.
             assert (node.is_leaf ());
-            key_type const existing_key = get_key (db, node.addr);
-            if (equal_ (existing_key, key)) {
+            if (details::key_matcher<KeyType, KeyEqual>::matches (source, node.addr, key, equal_)) {
                 parents.push ({node});
                 return const_iterator (db, std::move (parents), this);
             }
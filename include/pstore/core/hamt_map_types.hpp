@@ -47,13 +47,20 @@
 #define PSTORE_CORE_HAMT_MAP_TYPES_HPP
 
 #include <array>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "pstore/core/array_stack.hpp"
 #include "pstore/core/database.hpp"
 #include "pstore/core/db_archive.hpp"
+#include "pstore/core/pinned_view.hpp"
+#include "pstore/serialize/standard_types.hpp"
 #include "pstore/support/bit_count.hpp"
 #include "pstore/support/gsl.hpp"
+#include "pstore/support/sstring_view.hpp"
 
 namespace pstore {
     class transaction_base;
@@ -130,6 +137,19 @@ namespace pstore {
         PSTORE_STATIC_ASSERT (offsetof (header_block, size) == 8);
         PSTORE_STATIC_ASSERT (offsetof (header_block, root) == 16);
 
+        /// The header of an index which was written with a membership filter. It begins with a
+        /// header_block (whose signature distinguishes the two forms) so that the index is still
+        /// referred to by the address of a header_block.
+        struct filtered_header_block {
+            header_block base;
+            /// The store address of the index's membership filter.
+            address filter;
+        };
+
+        PSTORE_STATIC_ASSERT (sizeof (filtered_header_block) == 32);
+        PSTORE_STATIC_ASSERT (offsetof (filtered_header_block, base) == 0);
+        PSTORE_STATIC_ASSERT (offsetof (filtered_header_block, filter) == 24);
+
 
         namespace details {
 
@@ -142,6 +162,88 @@ namespace pstore {
                 return shift < details::max_hash_bits;
             }
 
+            // key_matcher
+            // ~~~~~~~~~~~
+            /// Compares the key stored at a given store address with a key value supplied by the
+            /// caller. The general case deserializes the stored key and passes it to the
+            /// key-comparison function.
+            ///
+            /// \tparam KeyType  The type of the keys stored in the index.
+            /// \tparam KeyEqual  The type of the key-comparison function.
+            template <typename KeyType, typename KeyEqual>
+            struct key_matcher {
+                template <typename Source, typename OtherKeyType>
+                static bool matches (Source & source, address const addr,
+                                     OtherKeyType const & key, KeyEqual const & equal) {
+                    return equal (serialize::read<KeyType> (
+                                      serialize::archive::database_reader{source, addr}),
+                                  key);
+                }
+            };
+
+            template <typename T>
+            class has_string_traits {
+                template <typename U>
+                static auto test (int) -> decltype (string_traits<U>::length (std::declval<U> ()),
+                                                    std::true_type ());
+                template <typename U>
+                static auto test (...) -> std::false_type;
+
+            public:
+                static constexpr bool value = decltype (test<T> (0))::value;
+            };
+
+            /// A specialization of key_matcher for string keys that are compared with
+            /// std::equal_to<>. The stored length is compared first; if that matches, the stored
+            /// characters are compared in place. Neither path constructs a std::string so a
+            /// lookup does not allocate.
+            template <>
+            struct key_matcher<std::string, std::equal_to<std::string>> {
+                template <typename Source, typename OtherKeyType>
+                static bool matches (Source & source, address const addr,
+                                     OtherKeyType const & key,
+                                     std::equal_to<std::string> const & equal) {
+                    return matches_impl (
+                        source, addr, key, equal,
+                        std::integral_constant<bool, has_string_traits<OtherKeyType>::value> ());
+                }
+
+            private:
+                template <typename Source, typename OtherKeyType>
+                static bool matches_impl (Source & source, address const addr,
+                                          OtherKeyType const & key,
+                                          std::equal_to<std::string> const & equal,
+                                          std::false_type) {
+                    return equal (serialize::read<std::string> (
+                                      serialize::archive::database_reader{source, addr}),
+                                  key);
+                }
+
+                template <typename Source, typename OtherKeyType>
+                static bool matches_impl (Source & source, address const addr,
+                                          OtherKeyType const & key,
+                                          std::equal_to<std::string> const &, std::true_type) {
+                    serialize::archive::database_reader reader{source, addr};
+                    std::size_t const length = serialize::string_helper::read_length (reader);
+                    if (length != string_traits<OtherKeyType>::length (key)) {
+                        return false;
+                    }
+                    return length == 0U ||
+                           equal_bytes (source, reader.get_address (),
+                                        string_traits<OtherKeyType>::data (key), length);
+                }
+
+                static bool equal_bytes (database const & db, address const addr,
+                                         gsl::czstring const chars, std::size_t const length) {
+                    std::shared_ptr<void const> const stored = db.getro (addr, length);
+                    return std::memcmp (stored.get (), chars, length) == 0;
+                }
+                static bool equal_bytes (pinned_view & view, address const addr,
+                                         gsl::czstring const chars, std::size_t const length) {
+                    return std::memcmp (view.getro (addr, length), chars, length) == 0;
+                }
+            };
+
 
             struct nchildren {
                 std::size_t n;
@@ -385,6 +487,13 @@ namespace pstore {
                 /// its raw pointer.
                 static auto get_node (database const & db, index_pointer const node)
                     -> std::pair<std::shared_ptr<linear_node const>, linear_node const *>;
+                /// \brief Returns a pointer to a linear node which may be in-heap or in-store.
+                ///
+                /// This overload reads in-store nodes through a pinned view: the first member of
+                /// the returned pair is always null and the raw pointer remains valid for the
+                /// lifetime of the view.
+                static auto get_node (pinned_view & view, index_pointer const node)
+                    -> std::pair<std::shared_ptr<linear_node const>, linear_node const *>;
                 ///@}
 
                 /// \name Element access
@@ -446,7 +555,8 @@ namespace pstore {
                 /// \tparam KeyType The type of the keys stored in the linear node.
                 /// \tparam OtherKeyType  A type whose serialized value is compatible with KeyType
                 /// \tparam KeyEqual  The type of the key-comparison function.
-                /// \param db  The dataase instance from which child nodes should be loaded.
+                /// \tparam Source  Either a (const) database or a pinned_view.
+                /// \param source  The database or view from which child nodes should be loaded.
                 /// \param key  The key to be located.
                 /// \param equal  A comparison function which will be called to compare child nodes
                 /// to the supplied key value. It should return true if the keys match and false
@@ -456,9 +566,10 @@ namespace pstore {
                 /// returns the pair index_pointer (), details::not_found.
 
                 template <typename KeyType, typename OtherKeyType, typename KeyEqual,
+                          typename Source,
                           typename = typename std::enable_if<
                               serialize::is_compatible<KeyType, OtherKeyType>::value>::type>
-                auto lookup (database const & db, OtherKeyType const & key, KeyEqual equal) const
+                auto lookup (Source & source, OtherKeyType const & key, KeyEqual equal) const
                     -> std::pair<index_pointer const, std::size_t>;
 
             private:
@@ -502,17 +613,16 @@ namespace pstore {
 
             // lookup
             // ~~~~~~
-            template <typename KeyType, typename OtherKeyType, typename KeyEqual, typename>
-            auto linear_node::lookup (database const & db, OtherKeyType const & key,
+            template <typename KeyType, typename OtherKeyType, typename KeyEqual,
+                      typename Source, typename>
+            auto linear_node::lookup (Source & source, OtherKeyType const & key,
                                       KeyEqual equal) const
                 -> std::pair<index_pointer const, std::size_t> {
                 // Linear search. TODO: perhaps we should sort the nodes and use a binary
                 // search? This would require a template compare method.
                 std::size_t cnum = 0;
                 for (auto const & child : *this) {
-                    KeyType const existing_key =
-                        serialize::read<KeyType> (serialize::archive::database_reader{db, child});
-                    if (equal (existing_key, key)) {
+                    if (key_matcher<KeyType, KeyEqual>::matches (source, child, key, equal)) {
                         return {index_pointer{child}, cnum};
                     }
                     ++cnum;
@@ -527,10 +637,20 @@ namespace pstore {
             //* |_|_||_\__\___|_| |_||_\__,_|_| |_|\_\___/\__,_\___| *
             //*                                                      *
             /// An internal trie node.
+            ///
+            /// The in-store representation of an internal node is the header (signature and
+            /// bitmap), the array of child references and then an array holding one hash fragment
+            /// for each child. The fragment array is padded to a multiple of the node's alignment.
+            /// A fragment records a few bits of the hash of a leaf child so that most lookups for
+            /// a key which is not present in the index can be rejected without loading the leaf.
+            /// Nodes written before fragments were introduced, or to a store which does not write
+            /// them (see database::writes_index_fragments()), carry a different signature and have
+            /// no fragment array. Heap nodes always carry fragments.
             class internal_node {
             public:
                 using iterator = index_pointer *;
                 using const_iterator = index_pointer const *;
+                using fragment_type = std::uint8_t;
 
                 void * operator new (std::size_t) = delete;
                 void operator delete (void * p);
@@ -543,10 +663,13 @@ namespace pstore {
                 static std::unique_ptr<internal_node> allocate ();
                 /// Construct an internal node with a child.
                 static std::unique_ptr<internal_node> allocate (internal_node const & other);
-                /// Construct an internal node with a child.
+                /// Construct an internal node with a child. The child must be an internal or
+                /// linear node.
                 static std::unique_ptr<internal_node> allocate (index_pointer const & leaf,
                                                                 hash_type hash);
-                /// Construct the internal node with two children.
+                /// Construct the internal node with two leaf children. The hashes are those of
+                /// the two keys shifted so that their least significant bits select the child
+                /// slot at this node.
                 static std::unique_ptr<internal_node> allocate (index_pointer const & existing_leaf,
                                                                 index_pointer const & new_leaf,
                                                                 hash_type existing_hash,
@@ -570,6 +693,19 @@ namespace pstore {
                 static auto read_node (database const & db, typed_address<internal_node> const addr)
                     -> std::shared_ptr<internal_node const>;
 
+                /// Return a pointer to an internal node, reading in-store nodes through a pinned
+                /// view. The first element of the returned pair is always null: the raw node
+                /// pointer remains valid for the lifetime of the view.
+                ///
+                /// \param view  The view through which the node is read.
+                /// \param node  The node's location: either in-store or in-heap.
+                static auto get_node (pinned_view & view, index_pointer const node)
+                    -> std::pair<std::shared_ptr<internal_node const>, internal_node const *>;
+
+                /// Load an internal node from the store through a pinned view.
+                static auto read_node (pinned_view & view, typed_address<internal_node> const addr)
+                    -> internal_node const *;
+
                 /// Returns a writable reference to an internal node. If the \p node parameter
                 /// references an in-heap node, then this pointer is returned otherwise a copy of
                 /// the \p internal parameter is placed in heap-allocated memory.
@@ -594,11 +730,35 @@ namespace pstore {
                 /// \return The number of bytes occupied by an in-store internal node with the given
                 /// number of child nodes.
                 static std::size_t size_bytes (std::size_t const num_children) noexcept {
+                    return legacy_size_bytes (num_children) + fragment_bytes (num_children);
+                }
+
+                /// Computes the number of bytes occupied by an internal node which was written
+                /// without a fragment array.
+                static std::size_t legacy_size_bytes (std::size_t const num_children) noexcept {
                     assert (num_children > 0 && num_children < max_hash_bits);
                     return sizeof (internal_node) - sizeof (internal_node::children_) +
                            sizeof (decltype (internal_node::children_[0])) * num_children;
                 }
 
+                /// Returns the number of bytes occupied by this node.
+                std::size_t size_bytes () const noexcept {
+                    return this->stored_size_bytes (this->has_fragments ());
+                }
+                /// Returns the number of bytes that write() produces for this node.
+                std::size_t stored_size_bytes (bool const fragments) const noexcept {
+                    return fragments ? size_bytes (this->size ())
+                                     : legacy_size_bytes (this->size ());
+                }
+
+                /// Writes the in-store representation of this node to \p dest which must have
+                /// room for stored_size_bytes(fragments) bytes.
+                ///
+                /// \param dest  The memory to which the node is written.
+                /// \param fragments  If false, the node is written without its fragment array and
+                ///   with the signature used before fragments were introduced.
+                void write (void * dest, bool fragments) const;
+
                 /// Returns the number of children contained by this node.
                 unsigned size () const noexcept {
                     assert (this->bitmap_ != hash_type{0});
@@ -613,13 +773,46 @@ namespace pstore {
 
                 std::pair<index_pointer, std::size_t> lookup (hash_type hash_index) const;
 
+                /// Returns the fragment recorded for a leaf whose key has the given hash.
+                ///
+                /// \param hash  The hash of the key shifted so that its least significant bits
+                /// select the child slot at this node.
+                static constexpr fragment_type make_fragment (hash_type const hash) noexcept {
+                    return static_cast<fragment_type> (
+                        fragment_valid_bit | ((hash >> hash_index_bits) & fragment_mask));
+                }
+
+                /// Returns false if the child at \p index is known not to be a leaf whose key has
+                /// the given hash. A true result means that the child must be examined to decide.
+                ///
+                /// \param index  The index of a child as returned by lookup().
+                /// \param hash  The hash of the key shifted so that its least significant bits
+                /// select the child slot at this node.
+                bool may_match (std::size_t index, hash_type hash) const noexcept;
+
+                /// Returns true if this node carries a hash fragment for each of its children.
+                bool has_fragments () const noexcept { return signature_ == node_signature_; }
+
                 /// Insert a child into the internal node (this).
+                ///
+                /// \param hash  The hash of the child's key shifted so that its least significant
+                /// bits select the child slot at this node. If the child is a leaf, the remaining
+                /// bits supply its hash fragment.
+                /// \param leaf  The child to be inserted.
+                /// \param parents  The child's position is pushed onto this stack.
                 void insert_child (hash_type const hash, index_pointer const leaf,
                                    gsl::not_null<parent_stack *> parents);
 
                 /// Write an internal node and its children into a store.
                 address flush (transaction_base & transaction, unsigned shifts);
 
+                /// Write an internal node and its children into a store using multiple threads.
+                /// Storage for all of the heap-resident nodes in the tree is allocated up-front and
+                /// each node is assigned its final address before any data is written. The nodes
+                /// may then be copied to the store in any order. The resulting store layout is
+                /// identical to that produced by flush().
+                address flush_parallel (transaction_base & transaction, unsigned shifts);
+
 
                 index_pointer const & operator[] (std::size_t const i) const {
                     assert (i < size ());
@@ -681,8 +874,36 @@ namespace pstore {
                 /// store. Returns a new (in-store) internal store address.
                 address store_node (transaction_base & transaction) const;
 
+                /// Set in a fragment to indicate that it holds hash bits. A fragment of zero is
+                /// recorded for children whose hash is not known.
+                static constexpr fragment_type fragment_valid_bit = 0x80;
+                static constexpr fragment_type fragment_mask = 0x7F;
+
+                /// Computes the number of bytes occupied by the fragment array of a node with the
+                /// given number of children.
+                static constexpr std::size_t fragment_bytes (std::size_t const num_children) {
+                    return (num_children + alignof (index_pointer) - 1U) &
+                           ~(alignof (index_pointer) - 1U);
+                }
+
+                /// Returns a pointer to the fragment array of a node with the given number of
+                /// children.
+                fragment_type * fragments (std::size_t const num_children) noexcept {
+                    return reinterpret_cast<fragment_type *> (&children_[0] + num_children);
+                }
+                fragment_type const * fragments (std::size_t const num_children) const noexcept {
+                    return reinterpret_cast<fragment_type const *> (&children_[0] + num_children);
+                }
+
+                /// Zeroes the padding which follows the fragment array of a node with the given
+                /// number of children.
+                void clear_fragment_padding (std::size_t num_children) noexcept;
+
                 using signature_type = std::array<std::uint8_t, 8>;
+                /// The signature of internal nodes which carry a fragment array.
                 static signature_type const node_signature_;
+                /// The signature of internal nodes written without a fragment array.
+                static signature_type const legacy_node_signature_;
 
                 /// A magic number for internal nodes in the store. Acts as a quick integrity test
                 /// for the index structures.
@@ -179,6 +179,27 @@ namespace pstore {
                 return {iterator{it.first}, it.second};
             }
 
+            /// \brief Inserts an element into the container, if the container doesn't already
+            /// contain an element with an equivalent key. The caller supplies the key's hash.
+            ///
+            /// \param transaction  The transaction into which the new value element will be
+            /// inserted.
+            /// \param key  Element value to insert.
+            /// \param hash  The hash of \p key. This must be equal to the value produced by the
+            /// set's hash function for the same key.
+            /// \returns A pair consisting of an iterator to the inserted element (or to the element
+            /// that prevented the insertion) and a bool value set to true if the insertion took
+            /// place.
+            template <typename OtherKeyType,
+                      typename = typename std::enable_if<
+                          serialize::is_compatible<KeyType, OtherKeyType>::value>::type>
+            std::pair<iterator, bool> insert (transaction_base & transaction,
+                                              OtherKeyType const & key, details::hash_type hash) {
+                auto it =
+                    map_.insert (transaction, std::make_pair (key, details::empty_class ()), hash);
+                return {iterator{it.first}, it.second};
+            }
+
             /// \brief Find the element with a specific key.
             /// Finds an element with key equivalent to \p key.
             ///
@@ -193,6 +214,12 @@ namespace pstore {
             const_iterator find (database const & db, OtherKeyType const & key) const {
                 return const_iterator{map_.find (db, key)};
             }
+            template <typename OtherKeyType,
+                      typename = typename std::enable_if<
+                          serialize::is_compatible<KeyType, OtherKeyType>::value>::type>
+            const_iterator find (pinned_view & view, OtherKeyType const & key) const {
+                return const_iterator{map_.find (view, key)};
+            }
 
             typed_address<header_block> flush (transaction_base & transaction,
                                                unsigned generation) {
@@ -49,6 +49,7 @@
 #include "pstore/core/indirect_string.hpp"
 #include "pstore/core/uuid.hpp"
 #include "pstore/support/fnv.hpp"
+#include "pstore/support/maybe.hpp"
 #include "pstore/support/sstring_view.hpp"
 #include "pstore/support/uint128.hpp"
 
@@ -126,10 +127,17 @@ namespace pstore {
         using compilation_index = hamt_map<digest, extent<repo::compilation>, u128_hash>;
         using debug_line_header_index = hamt_map<digest, extent<std::uint8_t>, u128_hash>;
         using fragment_index = hamt_map<digest, extent<repo::fragment>, u128_hash>;
+        /// Maps from the digest of a section payload to the extent of a single shared copy of that
+        /// payload. See repo::intern_payload().
+        using payload_index = hamt_map<digest, extent<std::uint8_t>, u128_hash>;
         using write_index = hamt_map<std::string, extent<char>>;
 
         struct fnv_64a_hash_indirect_string {
             std::uint64_t operator() (indirect_string const & indir) const {
+                maybe<std::uint64_t> const cached = indir.cached_hash ();
+                if (cached) {
+                    return *cached;
+                }
                 shared_sstring_view owner;
                 return fnv_64a_hash () (indir.as_string_view (&owner));
             }
@@ -146,6 +154,7 @@ namespace pstore {
         template <> struct enum_to_index<trailer::indices::debug_line_header   > { using type = debug_line_header_index; };
         template <> struct enum_to_index<trailer::indices::fragment            > { using type = fragment_index; };
         template <> struct enum_to_index<trailer::indices::name                > { using type = name_index; };
+        template <> struct enum_to_index<trailer::indices::payload             > { using type = payload_index; };
         template <> struct enum_to_index<trailer::indices::write               > { using type = write_index; };
         // clang-format on
 
@@ -159,9 +168,8 @@ namespace pstore {
 
             // Have we already loaded this index?
             if (dx.get () == nullptr) {
-                std::shared_ptr<trailer const> const footer = db.get_footer ();
-                typed_address<index::header_block> const location = footer->a.index_records.at (
-                    static_cast<typename std::underlying_type<decltype (Index)>::type> (Index));
+                typed_address<index::header_block> const location =
+                    trailer::get_index_record (db, db.footer_pos (), Index);
                 if (location == decltype (location)::null ()) {
                     if (create) {
                         // Create a new (empty) index.
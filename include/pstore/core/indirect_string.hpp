@@ -45,15 +45,26 @@
 #ifndef PSTORE_CORE_INDIRECT_STRING_HPP
 #define PSTORE_CORE_INDIRECT_STRING_HPP
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <vector>
 
 #include "pstore/core/db_archive.hpp"
 #include "pstore/core/sstring_view_archive.hpp"
 #include "pstore/serialize/types.hpp"
+#include "pstore/support/aligned.hpp"
+#include "pstore/support/fnv.hpp"
 #include "pstore/support/gsl.hpp"
+#include "pstore/support/maybe.hpp"
 
 namespace pstore {
 
+    namespace index {
+        struct fnv_64a_hash_indirect_string;
+    } // end namespace index
+
     //*  _         _ _            _        _       _            *
     //* (_)_ _  __| (_)_ _ ___ __| |_   __| |_ _ _(_)_ _  __ _  *
     //* | | ' \/ _` | | '_/ -_) _|  _| (_-<  _| '_| | ' \/ _` | *
@@ -71,8 +82,14 @@ namespace pstore {
     ///
     /// The use of the LBS of the address field to distinguish between in-heap and in-store
     /// addresses means that the in-store string bodies must be 2-byte aligned.
+    ///
+    /// An indirect_string may optionally carry the FNV-1a hash of its string. If it does, the
+    /// hash is written to the store immediately after the address and the MSB of the stored
+    /// address is set to indicate its presence. Strings read from such a record can be hashed, and
+    /// can be found to be unequal, without loading their bodies.
     class indirect_string {
         friend struct serialize::serializer<indirect_string>;
+        friend class indirect_string_adder;
 
     public:
         constexpr indirect_string (database const & db, address const addr) noexcept
@@ -86,6 +103,19 @@ namespace pstore {
                 , str_{str} {
             assert ((reinterpret_cast<std::uintptr_t> (str.get ()) & in_heap_mask) == 0);
         }
+        /// \param db  The database which will contain the string.
+        /// \param str  The string.
+        /// \param hash  The FNV-1a hash of \p str. This is stored alongside the string's address.
+        constexpr indirect_string (database const & db,
+                                   gsl::not_null<raw_sstring_view const *> const str,
+                                   std::uint64_t const hash) noexcept
+                : db_{db}
+                , is_pointer_{true}
+                , has_hash_{true}
+                , hash_{hash}
+                , str_{str} {
+            assert ((reinterpret_cast<std::uintptr_t> (str.get ()) & in_heap_mask) == 0);
+        }
 
         bool operator== (indirect_string const & rhs) const;
         bool operator!= (indirect_string const & rhs) const { return !operator== (rhs); }
@@ -111,6 +141,11 @@ namespace pstore {
         /// \returns True is the pointee is in the store rather than on the heap.
         bool is_in_store () const noexcept { return !is_pointer_ && !(address_ & in_heap_mask); }
 
+        /// \returns The FNV-1a hash of the string if it is recorded alongside the string address.
+        maybe<std::uint64_t> cached_hash () const {
+            return has_hash_ ? just (hash_) : nothing<std::uint64_t> ();
+        }
+
         /// Write the body of a string and updates the indirect pointer so that it points to that
         /// body.
         ///
@@ -129,6 +164,28 @@ namespace pstore {
 
     private:
         static constexpr std::uint64_t in_heap_mask = 0x01;
+        /// Set in a stored string address if the string's hash immediately follows it.
+        static constexpr std::uint64_t hash_follows_mask = std::uint64_t{1} << 63U;
+
+        /// The in-store layout of a string address which is followed by the string's hash.
+        struct hashed_address {
+            address addr;
+            std::uint64_t hash;
+        };
+
+        constexpr indirect_string (database const & db, address const addr,
+                                   std::uint64_t const hash) noexcept
+                : db_{db}
+                , is_pointer_{false}
+                , has_hash_{true}
+                , hash_{hash}
+                , address_{addr.absolute ()} {}
+
+        /// Updates an in-store string address so that it points to \p body, preserving the flag
+        /// which indicates whether it is followed by a hash.
+        template <typename Transaction>
+        static void patch_address (Transaction & transaction,
+                                   typed_address<address> address_to_patch, address body);
 
         database const & db_;
         // TODO: replace with std::variant<>...?
@@ -136,6 +193,9 @@ namespace pstore {
         /// address_ field points to the string body in the store unless (address_ & in_heap_mask)
         /// in which case it is the heap address of the string.
         bool is_pointer_;
+        /// True if hash_ holds the FNV-1a hash of the string.
+        bool has_hash_ = false;
+        std::uint64_t hash_ = 0;
         union {
             std::uint64_t address_;        ///< The in-store/in-heap string address.
             raw_sstring_view const * str_; ///< The address of the in-heap string.
@@ -162,11 +222,21 @@ namespace pstore {
             serialize::write (serialize::archive::make_writer (transaction), str);
 
         // Modify the in-store address field so that it points to the string body.
-        auto addr = transaction.getrw (address_to_patch);
-        *addr = body_address;
+        patch_address (transaction, address_to_patch, body_address);
         return body_address;
     }
 
+    // patch_address
+    // ~~~~~~~~~~~~~
+    template <typename Transaction>
+    void indirect_string::patch_address (Transaction & transaction,
+                                         typed_address<address> const address_to_patch,
+                                         address const body) {
+        assert ((body.absolute () & (in_heap_mask | hash_follows_mask)) == 0);
+        auto addr = transaction.getrw (address_to_patch);
+        *addr = address{body.absolute () | (addr->absolute () & hash_follows_mask)};
+    }
+
 
     namespace serialize {
 
@@ -242,9 +312,15 @@ namespace pstore {
             // The body of an indirect string must be written separately by the caller.
             assert (value.is_pointer_);
             constexpr auto mask = indirect_string::in_heap_mask;
-            assert (!(reinterpret_cast<std::uintptr_t> (value.str_) & mask));
+            auto const ptr =
+                static_cast<std::uint64_t> (reinterpret_cast<std::uintptr_t> (value.str_));
+            assert (!(ptr & (mask | indirect_string::hash_follows_mask)));
 
-            return archive.put (address{reinterpret_cast<std::uintptr_t> (value.str_) | mask});
+            if (value.has_hash_) {
+                return archive.put (indirect_string::hashed_address{
+                    address{ptr | mask | indirect_string::hash_follows_mask}, value.hash_});
+            }
+            return archive.put (address{ptr | mask});
         }
 
     } // end namespace serialize
@@ -284,17 +360,75 @@ namespace pstore {
         /// class records each of the added indirect strings in order that these addresses can be
         /// patched once the string bodies have been written.
         explicit indirect_string_adder (std::size_t expected_size);
+        /// \param expected_size  The anticipated number of strings being added to the index.
+        /// \param store_hashes  If true, the hash of each new string is stored alongside its
+        /// address in the index so that later hashing and comparisons need not load its body.
+        /// Hashes are not written to a store whose minor version is older than
+        /// header::indirect_string_hash_version.
+        indirect_string_adder (std::size_t expected_size, bool store_hashes);
 
         template <typename Transaction, typename Index>
         std::pair<typename Index::iterator, bool> add (Transaction & transaction,
                                                        std::shared_ptr<Index> const & index,
                                                        gsl::not_null<raw_sstring_view const *> str);
 
+        /// Adds a batch of strings, such as a symbol table, to the index. Duplicates within the
+        /// batch are removed in memory before the index is touched and the remaining strings are
+        /// inserted in the index's hash order, so that each is hashed only once and neighbouring
+        /// insertions visit the same tree nodes.
+        ///
+        /// \param transaction  The transaction to which new index records will be appended.
+        /// \param index  The name index. It must use FNV-1a to hash its keys.
+        /// \param first  The start of a range of raw_sstring_view instances. Each must remain
+        ///   valid until flush() has been called.
+        /// \param last  The end of the range of raw_sstring_view instances.
+        /// \param out  An output iterator which receives the in-store address of the
+        ///   indirect_string record for each member of [first, last), in order.
+        /// \returns The output iterator after the last address has been written.
+        template <typename Transaction, typename Index, typename ForwardIterator,
+                  typename OutputIterator>
+        OutputIterator add_range (Transaction & transaction, std::shared_ptr<Index> const & index,
+                                  ForwardIterator first, ForwardIterator last,
+                                  OutputIterator out);
+
+        /// Writes the bodies of all of the strings added since the last flush as a single
+        /// contiguous extent and patches their indirect_string records to point at them.
         template <typename Transaction>
         void flush (Transaction & transaction);
 
     private:
+        /// A member of a batch passed to add_range().
+        struct batch_member {
+            std::uint64_t hash;
+            /// The order in which members are inserted into the index.
+            std::uint64_t key;
+            raw_sstring_view const * str;
+            /// The position of the string in the caller's range.
+            std::size_t position;
+        };
+
+        /// Hashes a batch of strings and sorts them into the order in which they should be
+        /// inserted into the index. Equal strings are adjacent in the result.
+        static std::vector<batch_member>
+        make_batch (std::vector<raw_sstring_view const *> const & strings);
+
+        /// Returns true if the hashes of new strings are to be written to \p db.
+        bool stores_hashes (database const & db) const noexcept;
+
+        /// Serializes the bodies of the strings in views_ to a buffer. The offset of each body
+        /// within the buffer is appended to \p offsets.
+        std::vector<std::uint8_t>
+        serialize_bodies (gsl::not_null<std::vector<std::size_t> *> offsets) const;
+
+        /// The alignment of a string body: sufficient to ensure that the in_heap_mask bit of its
+        /// address is clear.
+        static constexpr std::size_t body_alignment = indirect_string::in_heap_mask + 1U;
+        static_assert (is_power_of_two (body_alignment) &&
+                           (indirect_string::in_heap_mask & ~(body_alignment - 1U)) == 0U,
+                       "A string body's alignment must clear the in_heap_mask bit");
+
         std::vector<std::pair<raw_sstring_view const *, typed_address<address>>> views_;
+        bool store_hashes_ = false;
     };
 
     // add
@@ -306,7 +440,11 @@ namespace pstore {
 
         // Inserting into the index immediately writes the indirect_string instance to the store if
         // the string isn't already in the set.
-        auto res = index->insert (transaction, pstore::indirect_string{transaction.db (), str});
+        database const & db = transaction.db ();
+        auto res = index->insert (transaction,
+                                  this->stores_hashes (db)
+                                      ? indirect_string{db, str, fnv_64a_hash () (*str)}
+                                      : indirect_string{db, str});
         if (res.second) {
             // Now the in-store addresses are pointing at the sstring_view instances on the heap.
             // If the string was written, we remember where it went.
@@ -316,16 +454,72 @@ namespace pstore {
         return res;
     }
 
+    // add_range
+    // ~~~~~~~~~
+    template <typename Transaction, typename Index, typename ForwardIterator,
+              typename OutputIterator>
+    OutputIterator indirect_string_adder::add_range (Transaction & transaction,
+                                                     std::shared_ptr<Index> const & index,
+                                                     ForwardIterator first, ForwardIterator last,
+                                                     OutputIterator out) {
+        static_assert (
+            std::is_same<typename Index::hasher, index::fnv_64a_hash_indirect_string>::value,
+            "add_range() requires an index whose keys are hashed with FNV-1a");
+
+        std::vector<raw_sstring_view const *> strings;
+        strings.reserve (static_cast<std::size_t> (std::distance (first, last)));
+        std::transform (first, last, std::back_inserter (strings),
+                        [] (raw_sstring_view const & str) { return &str; });
+        std::vector<batch_member> const members = make_batch (strings);
+
+        std::vector<typed_address<indirect_string>> addresses (members.size ());
+        database const & db = transaction.db ();
+        bool const hashes = this->stores_hashes (db);
+        auto it = members.begin ();
+        auto const end = members.end ();
+        while (it != end) {
+            // Insert the first member of each run of equal strings and share its address with the
+            // rest of the run.
+            auto const res = index->insert (
+                transaction,
+                hashes ? indirect_string{db, it->str, it->hash} : indirect_string{db, it->str},
+                it->hash);
+            auto const addr = typed_address<indirect_string>::make (res.first.get_address ());
+            if (res.second) {
+                views_.emplace_back (it->str, typed_address<address>::make (addr.to_address ()));
+            }
+            auto const run_end = std::find_if (it + 1, end, [it] (batch_member const & m) {
+                return m.hash != it->hash || *m.str != *it->str;
+            });
+            for (; it != run_end; ++it) {
+                addresses[it->position] = addr;
+            }
+        }
+        return std::copy (std::begin (addresses), std::end (addresses), out);
+    }
+
     // flush
     // ~~~~~
     template <typename Transaction>
     void indirect_string_adder::flush (Transaction & transaction) {
+        if (views_.empty ()) {
+            return;
+        }
+        std::vector<std::size_t> offsets;
+        offsets.reserve (views_.size ());
+        std::vector<std::uint8_t> const bodies = this->serialize_bodies (&offsets);
+
+        // Write all of the string bodies as a single contiguous extent.
+        address const base = transaction.allocate (bodies.size (), body_alignment);
+        std::memcpy (transaction.getrw (base, bodies.size ()).get (), bodies.data (),
+                     bodies.size ());
+
+        // Modify each of the in-store address fields so that they point to the string bodies.
+        auto offset_it = std::begin (offsets);
         for (auto const & v : views_) {
             assert (v.second != typed_address<address>::null ());
-            indirect_string::write_body_and_patch_address (transaction,
-                                                           *std::get<0> (v), // string body
-                                                           std::get<1> (v)   // address to patch
-            );
+            indirect_string::patch_address (transaction, v.second, base + *offset_it);
+            ++offset_it;
         }
         views_.clear ();
     }
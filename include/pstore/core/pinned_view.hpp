@@ -0,0 +1,173 @@
+//*        _                      _         _                *
+//*  _ __ (_)_ __  _ __   ___  __| | __   _(_) _____      __ *
+//* | '_ \| | '_ \| '_ \ / _ \/ _` | \ \ / / |/ _ \ \ /\ / / *
+//* | |_) | | | | | | | |  __/ (_| |  \ V /| |  __/\ V  V /  *
+//* | .__/|_|_| |_|_| |_|\___|\__,_|   \_/ |_|\___| \_/\_/   *
+//* |_|                                                      *
+//===- include/pstore/core/pinned_view.hpp --------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file pinned_view.hpp
+/// \brief Provides pinned_view: a read-only view of a database which hands out raw pointers
+/// rather than reference-counted ones.
+
+#ifndef PSTORE_CORE_PINNED_VIEW_HPP
+#define PSTORE_CORE_PINNED_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "pstore/core/database.hpp"
+
+namespace pstore {
+
+    /// A pinned_view is a read-only view of a database at the revision which was current when the
+    /// view was created. Its getro() functions behave like the corresponding database::getro()
+    /// members, but return raw pointers. Obtaining a pointer does not modify any reference count,
+    /// so lookups performed through a view make no atomic operations.
+    ///
+    /// Reads are bounded by the end of the pinned revision's trailer: data committed after the
+    /// view was created, or written by a transaction which was open at the time, cannot be read
+    /// through it.
+    ///
+    /// Pointers into the store are valid for as long as the database remains open. Requests which
+    /// span more than one region are satisfied from copies owned by the view: these remain valid
+    /// until the view is destroyed or release() is called. Repeated requests for the same block
+    /// share a copy.
+    ///
+    /// \note A pinned_view is not thread-safe: each thread should construct its own view.
+    class pinned_view {
+    public:
+        explicit pinned_view (database const & db)
+                : db_{db}
+                , revision_{db.get_current_revision ()}
+                , limit_{(db.footer_pos () + 1U).to_address ().absolute ()} {}
+        pinned_view (pinned_view const &) = delete;
+        pinned_view (pinned_view &&) noexcept = default;
+        ~pinned_view () noexcept = default;
+
+        pinned_view & operator= (pinned_view const &) = delete;
+        pinned_view & operator= (pinned_view &&) = delete;
+
+        /// Returns the database which is being viewed.
+        database const & db () const noexcept { return db_; }
+        /// Returns the revision number which was current when the view was created.
+        unsigned revision () const noexcept { return revision_; }
+        /// Returns the address of the first byte beyond the pinned revision. Requests which extend
+        /// beyond this point are rejected.
+        address limit () const noexcept { return address{limit_}; }
+        /// Returns the number of copies of region-spanning blocks currently held by the view.
+        std::size_t num_copies () const noexcept { return copies_.size (); }
+        /// Frees the copies of region-spanning blocks held by the view. Any pointer to such a
+        /// block previously returned by getro() is invalidated.
+        void release () noexcept;
+
+        ///@{
+        /// Load a block of data starting at address \p addr and of \p size bytes.
+        ///
+        /// \param addr The starting address of the data block to be loaded.
+        /// \param size The size of the data block to be loaded.
+        /// \return A read-only pointer to the loaded data.
+        void const * getro (address addr, std::size_t size);
+
+        /// Load a block of data starting at the address and size specified by \p ex.
+        ///
+        /// \param ex The extent of of the data to be loaded.
+        /// \return A read-only pointer to the loaded data.
+        template <typename T,
+                  typename = typename std::enable_if<std::is_standard_layout<T>::value>::type>
+        T const * getro (extent<T> const & ex) {
+            if (ex.addr.to_address ().absolute () % alignof (T) != 0) {
+                raise (error_code::bad_alignment);
+            }
+            return static_cast<T const *> (this->getro (ex.addr.to_address (), ex.size));
+        }
+
+        /// Returns a pointer to a immutable instance of type T.
+        ///
+        /// \tparam T  The type to be loaded. Must be standard-layout.
+        /// \param addr The address at which the data begins.
+        /// \return A read-only pointer to the loaded data.
+        template <typename T,
+                  typename = typename std::enable_if<std::is_standard_layout<T>::value>::type>
+        T const * getro (typed_address<T> const addr) {
+            return this->getro (addr, std::size_t{1});
+        }
+
+        /// Returns a pointer to a read-only array of instances of type T.
+        ///
+        /// \tparam T  The type to be loaded. Must be standard-layout.
+        /// \param addr The address at which the data begins.
+        /// \param elements The number of elements in the T[] array.
+        /// \return A read-only pointer to the loaded data.
+        template <typename T,
+                  typename = typename std::enable_if<std::is_standard_layout<T>::value>::type>
+        T const * getro (typed_address<T> const addr, std::size_t const elements) {
+            if (addr.to_address ().absolute () % alignof (T) != 0) {
+                raise (error_code::bad_alignment);
+            }
+            return static_cast<T const *> (
+                this->getro (addr.to_address (), sizeof (T) * elements));
+        }
+        ///@}
+
+    private:
+        struct copy {
+            std::size_t size;
+            std::uint8_t const * data;
+        };
+
+        /// Returns a copy of a block which spans more than one region.
+        std::uint8_t const * spanning_copy (address addr, std::size_t size);
+
+        database const & db_;
+        unsigned revision_;
+        /// The absolute address of the first byte beyond the pinned revision's trailer.
+        std::uint64_t limit_;
+        /// Copies of data blocks which span more than one region. A copy is kept until the view is
+        /// destroyed or release() is called.
+        std::vector<std::unique_ptr<std::uint8_t[]>> copies_;
+        /// Maps the absolute address of a spanning block to its largest copy.
+        std::unordered_map<std::uint64_t, copy> index_;
+    };
+
+} // namespace pstore
+
+#endif // PSTORE_CORE_PINNED_VIEW_HPP
@@ -64,6 +64,50 @@ namespace pstore {
         using memory_mapper_ptr = std::shared_ptr<memory_mapper_base>;
 
 
+        //*      _       __                        _                                          *
+        //*   __| | ___ / _| ___ _ __ _ __ ___  __| |  _ __ ___   __ _ _ __  _ __   ___ _ __  *
+        //*  / _` |/ _ \ |_ / _ \ '__| '__/ _ \/ _` | | '_ ` _ \ / _` | '_ \| '_ \ / _ \ '__| *
+        //* | (_| |  __/  _|  __/ |  | | |  __/ (_| | | | | | | | (_| | |_) | |_) |  __/ |    *
+        //*  \__,_|\___|_|  \___|_|  |_|  \___|\__,_| |_| |_| |_|\__,_| .__/| .__/ \___|_|    *
+        //*                                                           |_|   |_|               *
+        /// A memory-mapped region whose mapping is deferred until map() is first called. Until
+        /// then, the region records only its position and size within the file.
+        template <typename File, typename MemoryMapper>
+        class deferred_mapper final : public memory_mapper_base {
+        public:
+            deferred_mapper (std::shared_ptr<File> file, bool const is_writable,
+                             std::uint64_t const offset, std::uint64_t const size)
+                    : memory_mapper_base (nullptr, is_writable, offset, size)
+                    , file_{std::move (file)} {}
+            deferred_mapper (deferred_mapper const &) = delete;
+            deferred_mapper (deferred_mapper &&) noexcept = delete;
+            ~deferred_mapper () noexcept override = default;
+            deferred_mapper & operator= (deferred_mapper const &) = delete;
+            deferred_mapper & operator= (deferred_mapper &&) noexcept = delete;
+
+            void map () override {
+                if (mapper_ == nullptr) {
+                    mapper_ = std::make_shared<MemoryMapper> (*file_, this->is_writable (),
+                                                              this->offset (), this->size ());
+                    this->set_data (mapper_->data ());
+                }
+            }
+            void read_only (void * const addr, std::size_t const len) override {
+                assert (mapper_ != nullptr);
+                mapper_->read_only (addr, len);
+            }
+            void advise (void * const addr, std::size_t const len,
+                         access_pattern const pattern) override {
+                assert (mapper_ != nullptr);
+                mapper_->advise (addr, len, pattern);
+            }
+
+        private:
+            std::shared_ptr<File> file_;
+            std::shared_ptr<MemoryMapper> mapper_;
+        };
+
+
         //*                  _               _           _ _     _             *
         //*   _ __ ___  __ _(_) ___  _ __   | |__  _   _(_) | __| | ___ _ __   *
         //*  | '__/ _ \/ _` | |/ _ \| '_ \  | '_ \| | | | | |/ _` |/ _ \ '__|  *
@@ -88,8 +132,9 @@ namespace pstore {
             /// \param full_size The number of bytes in a "full size" memory-mapped region.
             /// \param minimum_size The number of bytes in a "minimum size" memory-mapped
             /// region.
+            /// \param deferred If true, the regions are not mapped until first used.
             region_builder (std::shared_ptr<File> file, std::uint64_t full_size,
-                            std::uint64_t minimum_size) noexcept;
+                            std::uint64_t minimum_size, bool deferred = false) noexcept;
             // No assignment or copying.
             region_builder (region_builder const &) = delete;
             region_builder (region_builder &&) noexcept = delete;
@@ -134,6 +179,8 @@ namespace pstore {
             std::uint64_t const full_size_;
             ///< The number of bytes in a "minimum size" memory-mapped region.
             std::uint64_t const minimum_size_;
+            /// If true, the regions are created as instances of deferred_mapper.
+            bool const deferred_;
         };
 
         // region_builder
@@ -141,10 +188,11 @@ namespace pstore {
         template <typename File, typename MemoryMapper>
         region_builder<File, MemoryMapper>::region_builder (
             std::shared_ptr<File> file, std::uint64_t const full_size,
-            std::uint64_t const minimum_size) noexcept
+            std::uint64_t const minimum_size, bool const deferred) noexcept
                 : file_ (file)
                 , full_size_ (full_size)
-                , minimum_size_ (minimum_size) {
+                , minimum_size_ (minimum_size)
+                , deferred_ (deferred) {
 
             assert (full_size >= minimum_size && full_size_ % minimum_size_ == 0);
         }
@@ -196,6 +244,11 @@ namespace pstore {
             assert (size >= minimum_size_);
             // (Note that we separately make pages read-only to guard against writing to committed
             // transactions: that's done by database::protect() rather than here.)
+            if (deferred_) {
+                regions->push_back (std::make_shared<deferred_mapper<File, MemoryMapper>> (
+                    file_, file_->is_writable (), offset, size));
+                return;
+            }
             regions->push_back (
                 std::make_shared<MemoryMapper> (*file_, file_->is_writable (), offset, size));
         }
@@ -259,6 +312,13 @@ namespace pstore {
             std::uint64_t full_size () const noexcept { return full_size_; }
             std::uint64_t min_size () const noexcept { return min_size_; }
 
+            ///@{
+            /// If deferred, the regions created by the factory are not mapped until they are first
+            /// used (see memory_mapper_base::map()).
+            void set_deferred (bool const deferred) noexcept { deferred_ = deferred; }
+            bool deferred () const noexcept { return deferred_; }
+            ///@}
+
         protected:
             /// \note full_size modulo minimum_size must be 0.
             /// \param full_size  The size of the largest memory-mapped file region.
@@ -280,6 +340,7 @@ namespace pstore {
         private:
             std::uint64_t const full_size_;
             std::uint64_t const min_size_;
+            bool deferred_ = false;
         };
 
         // create
@@ -293,7 +354,7 @@ namespace pstore {
 
             std::uint64_t const file_size = file->size ();
             region_builder<File, MemoryMapper> builder (file, this->full_size (),
-                                                        this->min_size ());
+                                                        this->min_size (), deferred_);
             return builder (file_size);
         }
 
@@ -307,7 +368,8 @@ namespace pstore {
             assert (new_size >= original_size);
 
             auto const min_size = this->min_size ();
-            region_builder<File, MemoryMapper> builder (file, this->full_size (), min_size);
+            region_builder<File, MemoryMapper> builder (file, this->full_size (), min_size,
+                                                        deferred_);
 
             new_size = round_up (new_size, min_size);
             if (!small_files_enabled ()) {
@@ -0,0 +1,152 @@
+//*                              _                              _           *
+//*  ___ _ __   __ _ _ __  _ __ (_)_ __   __ _    ___ __ _  ___| |__   ___  *
+//* / __| '_ \ / _` | '_ \| '_ \| | '_ \ / _` |  / __/ _` |/ __| '_ \ / _ \ *
+//* \__ \ |_) | (_| | | | | | | | | | | | (_| | | (_| (_| | (__| | | |  __/ *
+//* |___/ .__/ \__,_|_| |_|_| |_|_|_| |_|\__, |  \___\__,_|\___|_| |_|\___| *
+//*     |_|                              |___/                              *
+//===- include/pstore/core/spanning_cache.hpp -----------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file spanning_cache.hpp
+/// \brief A bounded cache of the blocks of memory which are built when a read request spans more
+/// than one memory-mapped region.
+
+#ifndef PSTORE_CORE_SPANNING_CACHE_HPP
+#define PSTORE_CORE_SPANNING_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "pstore/core/address.hpp"
+
+namespace pstore {
+
+    /// When a read-only request spans more than one region, database::get_spanning() must
+    /// allocate a fresh block of memory and copy the data from each of the regions. This class
+    /// retains those blocks so that subsequent requests for the same data can share them.
+    ///
+    /// Entries are keyed by address and size. Only committed data (which is never modified) is
+    /// cached, so an entry remains correct regardless of the revision to which the database is
+    /// synced. The cache is divided into a number of independently locked shards, each of which
+    /// evicts its least-recently used entries once its share of the total capacity is exceeded.
+    class spanning_cache {
+    public:
+        /// The default total capacity of the cache in bytes.
+        static constexpr std::size_t default_capacity = std::size_t{64} * 1024 * 1024;
+        /// The number of independently locked shards.
+        static constexpr std::size_t num_shards = 16;
+
+        struct statistics {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+        };
+
+        /// \param capacity  The maximum number of bytes held by the cache. A block which is
+        ///   larger than a single shard's share of this capacity is never cached.
+        explicit spanning_cache (std::size_t capacity = default_capacity);
+        spanning_cache (spanning_cache const &) = delete;
+        spanning_cache (spanning_cache &&) = delete;
+        ~spanning_cache () noexcept;
+
+        spanning_cache & operator= (spanning_cache const &) = delete;
+        spanning_cache & operator= (spanning_cache &&) = delete;
+
+        /// Returns the block holding the \p size bytes starting at \p addr or nullptr if no such
+        /// block is cached. Updates the hit/miss counters.
+        std::shared_ptr<void const> find (address addr, std::size_t size);
+
+        /// Records \p block as holding the \p size bytes starting at \p addr. If the cache
+        /// already holds an entry for this key, the existing entry is retained.
+        void insert (address addr, std::size_t size, std::shared_ptr<void const> const & block);
+
+        /// Discards all of the cached blocks. The hit/miss counters are not reset.
+        void clear ();
+
+        /// Returns the number of cache hits and misses.
+        statistics stats () const noexcept;
+        /// Returns the total number of bytes held by the cache.
+        std::size_t size_bytes () const;
+        std::size_t capacity () const noexcept { return shard_capacity_ * num_shards; }
+
+    private:
+        struct key {
+            address addr;
+            std::size_t size;
+            bool operator== (key const & rhs) const noexcept {
+                return addr == rhs.addr && size == rhs.size;
+            }
+        };
+        struct key_hash {
+            std::size_t operator() (key const & k) const noexcept;
+        };
+
+        class shard {
+        public:
+            std::shared_ptr<void const> find (key const & k);
+            void insert (key const & k, std::shared_ptr<void const> const & block,
+                         std::size_t capacity);
+            void clear ();
+            std::size_t size_bytes () const;
+
+        private:
+            using entry = std::pair<key, std::shared_ptr<void const>>;
+            using lru_list = std::list<entry>;
+
+            mutable std::mutex mut_;
+            /// Entries ordered from most- to least-recently used.
+            lru_list lru_;
+            std::unordered_map<key, lru_list::iterator, key_hash> map_;
+            std::size_t bytes_ = 0;
+        };
+
+        shard & get_shard (key const & k) noexcept { return shards_[key_hash{}(k) % num_shards]; }
+
+        std::size_t const shard_capacity_;
+        std::array<shard, num_shards> shards_;
+        std::atomic<std::uint64_t> hits_{0};
+        std::atomic<std::uint64_t> misses_{0};
+    };
+
+} // namespace pstore
+
+#endif // PSTORE_CORE_SPANNING_CACHE_HPP
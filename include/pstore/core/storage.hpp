@@ -46,8 +46,11 @@
 #ifndef PSTORE_CORE_STORAGE_HPP
 #define PSTORE_CORE_STORAGE_HPP
 
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <memory>
+#include <mutex>
 
 #include "pstore/core/address.hpp"
 #include "pstore/core/region.hpp"
@@ -68,8 +71,9 @@ namespace pstore {
 
 #ifndef NDEBUG
         bool is_valid () const noexcept {
-            if (value == nullptr && region == nullptr) {
-                return true;
+            if (value == nullptr) {
+                // Either an unused entry or one whose region has not yet been mapped.
+                return region == nullptr || !region->is_mapped ();
             }
 
             auto * const ptr = static_cast<std::uint8_t const *> (value.get ());
@@ -104,12 +108,13 @@ namespace pstore {
                 , region_factory_{std::move (region_factory)}
                 , regions_{region_factory_->init ()} {}
 
+        /// \param file  The file containing the store's data.
+        /// \param deferred  If true, the file's regions are not memory-mapped until an address
+        ///   within them is first used. See ensure_mapped().
         template <typename File>
-        explicit storage (std::shared_ptr<File> const & file)
+        explicit storage (std::shared_ptr<File> const & file, bool const deferred = false)
                 : file_{std::static_pointer_cast<file::file_base> (file)}
-                , region_factory_{region::get_factory (
-                      std::static_pointer_cast<file::file_handle> (file), full_region_size,
-                      min_region_size)}
+                , region_factory_{make_factory (file, deferred)}
                 , regions_{region_factory_->init ()} {}
 
         file::file_base * file () noexcept { return file_.get (); }
@@ -166,9 +171,29 @@ namespace pstore {
         /// \returns true if the given address range "spans" more than one region.
         bool request_spans_regions (address const & addr, std::size_t size) const noexcept;
 
-        /// Marks the address range [first, last) as read-only.
+        /// Marks the address range [first, last) as read-only. In a store whose regions are
+        /// mapped lazily, the protection is also applied to regions as they are mapped.
         void protect (address first, address last);
 
+        /// Ensures that the memory-mapped regions holding the address range [addr, addr + size)
+        /// are mapped. This must be called before the address range is accessed in a store whose
+        /// regions are mapped lazily; otherwise it does nothing. Thread-safe.
+        void ensure_mapped (address addr, std::size_t size) const;
+
+        /// Returns true if the store's regions are mapped lazily.
+        bool is_lazy () const noexcept { return lazy_ != nullptr; }
+
+        /// Advises the operating system of the expected access pattern for the address range
+        /// [first, last).
+        void advise (address first, address last, access_pattern pattern) const;
+
+        ///@{
+        /// The access pattern which is applied to every memory-mapped region, including those
+        /// mapped in the future.
+        void set_access_pattern (access_pattern pattern);
+        access_pattern get_access_pattern () const noexcept { return access_pattern_; }
+        ///@}
+
         ///@{
         /// Returns the base address of a segment given its index.
         /// \param segment The segment number whose base address it to be returned. The segment
@@ -190,15 +215,43 @@ namespace pstore {
         }
         ///@}
 
+        /// Returns a raw pointer to the memory-mapped data at \p addr. Unlike
+        /// address_to_pointer(), this function does not touch the reference count of the
+        /// underlying region: the pointer remains valid for as long as the region remains mapped.
+        void const * address_to_raw_pointer (address addr) const noexcept;
+
 
         // For unit testing only.
         region_container const & regions () const { return regions_; }
 
     private:
+        template <typename File>
+        static std::unique_ptr<region::factory> make_factory (std::shared_ptr<File> const & file,
+                                                              bool deferred);
+
         static sat_iterator
         slice_region_into_segments (std::shared_ptr<memory_mapper_base> const & region,
                                     sat_iterator segment_it, sat_iterator segment_end);
 
+        /// Marks the part of the address range [first, last) which lies within \p region as
+        /// read-only.
+        static void protect_region (memory_mapper_base & region, address first, address last);
+
+        /// Maps any deferred regions which hold the segments [first, last] and records their
+        /// addresses in the segment address table.
+        void map_segments (unsigned first, unsigned last) const;
+
+        /// The state used when regions are mapped on first use.
+        struct lazy_state {
+            std::mutex mut;
+            /// Set once the corresponding segment address table entry has been filled in.
+            std::array<std::atomic<bool>, sat_elements> mapped{};
+            /// The address range most recently passed to protect(), applied to regions as they
+            /// are mapped.
+            address protect_first = address::null ();
+            address protect_last = address::null ();
+        };
+
         /// The Segment Address Table: an array of pointers to the base-address of each segment's
         /// memory-mapped storage and their corresponding region object.
         std::unique_ptr<segment_address_table> sat_ = std::make_unique<segment_address_table> ();
@@ -209,8 +262,39 @@ namespace pstore {
             std::make_unique<system_page_size> ();
         std::unique_ptr<region::factory> region_factory_;
         region_container regions_;
+        access_pattern access_pattern_ = access_pattern::normal;
+        /// Non-null if the region factory creates regions whose mapping is deferred.
+        std::unique_ptr<lazy_state> lazy_ =
+            region_factory_->deferred () ? std::make_unique<lazy_state> () : nullptr;
     };
 
+    // make_factory [static]
+    // ~~~~~~~~~~~~
+    template <typename File>
+    std::unique_ptr<region::factory> storage::make_factory (std::shared_ptr<File> const & file,
+                                                            bool const deferred) {
+        std::unique_ptr<region::factory> factory = region::get_factory (
+            std::static_pointer_cast<file::file_handle> (file), full_region_size, min_region_size);
+        factory->set_deferred (deferred);
+        return factory;
+    }
+
+    // ensure_mapped
+    // ~~~~~~~~~~~~~
+    inline void storage::ensure_mapped (address const addr, std::size_t const size) const {
+        if (lazy_ == nullptr) {
+            return;
+        }
+        unsigned const first = addr.segment ();
+        unsigned const last = (size == 0U ? addr : addr + (size - 1U)).segment ();
+        for (auto segment = first; segment <= last; ++segment) {
+            if (!lazy_->mapped[segment].load (std::memory_order_acquire)) {
+                this->map_segments (first, last);
+                return;
+            }
+        }
+    }
+
     // segment_base
     // ~~~~~~~~~~~~
     inline auto storage::segment_base (address::segment_type const segment) const noexcept
@@ -241,6 +325,15 @@ namespace pstore {
         return std::const_pointer_cast<void> (cthis->address_to_pointer (addr));
     }
 
+    // address_to_raw_pointer
+    // ~~~~~~~~~~~~~~~~~~~~~~
+    inline void const * storage::address_to_raw_pointer (address const addr) const noexcept {
+        assert (addr.segment () < sat_->size ());
+        sat_entry const & e = (*sat_)[addr.segment ()];
+        assert (e.is_valid ());
+        return static_cast<std::uint8_t const *> (e.value.get ()) + addr.offset ();
+    }
+
     // request_spans_regions
     // ~~~~~~~~~~~~~~~~~~~~~
     inline bool storage::request_spans_regions (address const & addr, std::size_t const size) const
@@ -45,6 +45,8 @@
 #define PSTORE_DIFF_DIFF_HPP
 
 #include <deque>
+#include <numeric>
+#include <vector>
 
 #include "pstore/config/config.hpp"
 #include "pstore/core/database.hpp"
@@ -53,6 +55,7 @@
 #include "pstore/core/hamt_set.hpp"
 #include "pstore/diff/revision.hpp"
 #include "pstore/support/gsl.hpp"
+#include "pstore/support/parallel_for_each.hpp"
 #include "pstore/support/portab.hpp"
 
 namespace pstore {
@@ -74,6 +77,9 @@ namespace pstore {
                         , index_{index}
                         , threshold_ (std::move (threshold)) {}
 
+                /// Returns the addresses of the leaf nodes which are "new". The subtrees beneath
+                /// the root node's children are traversed concurrently; the results are in the
+                /// same order as those of a sequential traversal.
                 result_type operator() () const;
 
             private:
@@ -106,8 +112,33 @@ namespace pstore {
             template <typename Index>
             result_type traverser<Index>::operator() () const {
                 result_type result;
-                if (auto const root = index_.root ()) {
+                auto const root = index_.root ();
+                if (!root) {
+                    return result;
+                }
+                if (root.is_leaf () || !this->is_new (root)) {
                     this->visit_node (root, 0U, &result);
+                    return result;
+                }
+
+                // Split the work at the root node: each of its children is visited independently
+                // with the results being gathered into a per-child container. These are then
+                // concatenated in child order.
+                std::pair<std::shared_ptr<void const>, index::details::internal_node const *> const
+                    p = index::details::internal_node::get_node (db_, root);
+                index::details::internal_node const * const internal = std::get<1> (p);
+                assert (internal != nullptr);
+
+                std::vector<result_type> partial (internal->size ());
+                std::vector<std::size_t> indices (partial.size ());
+                std::iota (std::begin (indices), std::end (indices), std::size_t{0});
+                cmd_util::parallel_for_each (
+                    std::begin (indices), std::end (indices), [&] (std::size_t const index) {
+                        this->visit_node ((*internal)[index], index::details::hash_index_bits,
+                                          &partial[index]);
+                    });
+                for (result_type const & r : partial) {
+                    result.insert (std::end (result), std::begin (r), std::end (r));
                 }
                 return result;
             }
@@ -139,14 +170,17 @@ namespace pstore {
             traverser<Index>::visit_intermediate (index::details::index_pointer const node,
                                                   unsigned const shifts,
                                                   gsl::not_null<result_type *> const result) const {
+                // A node's children are always written before the node itself, so nothing below
+                // an "old" node can be new.
+                if (!this->is_new (node)) {
+                    return;
+                }
                 std::pair<std::shared_ptr<void const>, Node const *> const p =
                     Node::get_node (db_, node);
                 assert (std::get<1> (p) != nullptr);
                 for (auto child : *std::get<1> (p)) {
-                    if (this->is_new (node)) {
-                        this->visit_node (index_pointer{child},
-                                          shifts + index::details::hash_index_bits, result);
-                    }
+                    this->visit_node (index_pointer{child},
+                                      shifts + index::details::hash_index_bits, result);
                 }
             }
 
@@ -44,10 +44,14 @@
 #ifndef PSTORE_DIFF_VALUE_HPP
 #define PSTORE_DIFF_VALUE_HPP
 
+#include <numeric>
+#include <vector>
+
 #include "pstore/core/database.hpp"
 #include "pstore/diff/diff.hpp"
 #include "pstore/diff/revision.hpp"
 #include "pstore/dump/db_value.hpp"
+#include "pstore/support/parallel_for_each.hpp"
 #include "pstore/support/portab.hpp"
 
 namespace pstore {
@@ -103,6 +107,29 @@ namespace pstore {
 
         } // namespace details
 
+        /// Make a value pointer which contains the keys of \p index that are different between
+        /// two database revisions. Only const members of \p db are used so diffs of separate
+        /// indices may be made concurrently.
+        ///
+        /// \param db The database from which the index was read.
+        /// \param index  The index whose keys are to be compared.
+        /// \param old_revision  A old database revision number to be compared to new_contents.
+        /// \returns  A value pointer which contains all different keys between two revisions.
+        template <typename Index>
+        dump::value_ptr make_diff (database const & db, Index const & index,
+                                   diff::revision_number const old_revision) {
+            auto const differences = diff (db, index, old_revision);
+            dump::array::container members (differences.size ());
+            std::vector<std::size_t> indices (differences.size ());
+            std::iota (std::begin (indices), std::end (indices), std::size_t{0});
+            cmd_util::parallel_for_each (
+                std::begin (indices), std::end (indices), [&] (std::size_t const i) {
+                    members[i] =
+                        dump::make_value (get_key (index.load_leaf_node (db, differences[i])));
+                });
+            return dump::make_value (std::move (members));
+        }
+
         /// Make a value pointer which contains the keys that are different between two database
         /// revisions.
         ///
@@ -114,16 +141,8 @@ namespace pstore {
         template <typename Index, typename GetIndexFunction>
         dump::value_ptr make_diff (database & db, diff::revision_number const old_revision,
                                    GetIndexFunction get_index) {
-            dump::array::container members;
             std::shared_ptr<Index const> const index = get_index (db, true /* create */);
-
-            auto const differences = diff (db, *index, old_revision);
-            std::transform (std::begin (differences), std::end (differences),
-                            std::back_inserter (members), [&db, &index](pstore::address addr) {
-                                return dump::make_value (
-                                    get_key (index->load_leaf_node (db, addr)));
-                            });
-            return dump::make_value (members);
+            return make_diff (db, *index, old_revision);
         }
 
         /// Make a value pointer which contains all different keys between two revisions for a
@@ -156,7 +175,7 @@ namespace pstore {
         }
 
         /// Make a value pointer which contains all different keys between two revisions for all
-        /// database indices.
+        /// database indices. The indices are compared concurrently.
         ///
         /// \pre new_revision >= old_revision
         ///
@@ -125,6 +125,8 @@ namespace pstore {
         }
 
         value_ptr make_blob (database const & db, pstore::address begin, std::uint64_t size);
+        /// Returns a value which, when written, produces the contents of each of the generations
+        /// of the store in turn. \p db must remain open until the value is written.
         value_ptr make_contents (database const & db,
                                  pstore::typed_address<pstore::trailer> footer_pos, bool no_times);
 
@@ -44,25 +44,80 @@
 #ifndef PSTORE_DUMP_INDEX_VALUE_HPP
 #define PSTORE_DUMP_INDEX_VALUE_HPP
 
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
 #include "pstore/core/database.hpp"
 #include "pstore/core/index_types.hpp"
 #include "pstore/dump/mcrepo_value.hpp"
+#include "pstore/support/parallel_for_each.hpp"
 
 namespace pstore {
     namespace dump {
 
+        namespace details {
+
+            /// The maximum number of index members that are converted to values at a time. This
+            /// bounds the memory used whilst writing an index.
+            constexpr std::size_t index_window_size = 4096U;
+
+            // emit_members
+            // ~~~~~~~~~~~~
+            /// Passes the value of each member of the range [first, last) to a sink in order. The
+            /// members are converted to values by \p mk in batches of up to index_window_size, the
+            /// members of each batch being converted in parallel.
+            template <typename InputIt, typename MakeValueFn>
+            void emit_members (InputIt first, InputIt const last, MakeValueFn mk,
+                               lazy_array::sink const & sink) {
+                using member_type = typename std::remove_cv<
+                    typename std::iterator_traits<InputIt>::value_type>::type;
+                std::vector<member_type> members;
+                std::vector<value_ptr> values;
+                std::vector<std::size_t> indices;
+                members.reserve (index_window_size);
+
+                auto const flush = [&] () {
+                    values.resize (members.size ());
+                    indices.resize (members.size ());
+                    std::iota (std::begin (indices), std::end (indices), std::size_t{0});
+                    cmd_util::parallel_for_each (
+                        std::begin (indices), std::end (indices),
+                        [&] (std::size_t const index) { values[index] = mk (members[index]); });
+                    for (value_ptr & v : values) {
+                        sink (v);
+                        v.reset ();
+                    }
+                    members.clear ();
+                };
+
+                for (; first != last; ++first) {
+                    members.push_back (*first);
+                    if (members.size () >= index_window_size) {
+                        flush ();
+                    }
+                }
+                flush ();
+            }
+
+        } // end namespace details
+
+        /// Returns a value which, when written, produces the members of the index given by
+        /// \p Index. The members are generated as the value is written so the index need not be
+        /// held in memory in its entirety; \p db must remain open until the value is written.
         template <typename trailer::indices Index, typename MakeValueFn>
         value_ptr make_index (database const & db, MakeValueFn mk) {
             using return_type = typename index::enum_to_index<Index>::type const;
-            using value_type = typename return_type::value_type;
-            array::container members;
-            if (std::shared_ptr<return_type> const index =
-                    index::get_index<Index> (db, false /* create */)) {
-                std::for_each (
-                    index->begin (db), index->end (db),
-                    [&members, mk](value_type const & v) { members.emplace_back (mk (v)); });
-            }
-            return make_value (std::move (members));
+            std::shared_ptr<return_type> const index =
+                index::get_index<Index> (db, false /* create */);
+            return make_lazy_array ([&db, index, mk] (lazy_array::sink const & sink) {
+                if (index) {
+                    details::emit_members (index->begin (db), index->end (db), mk, sink);
+                }
+            });
         }
     } // namespace dump
 } // namespace pstore
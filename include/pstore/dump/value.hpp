@@ -51,6 +51,7 @@
 #include <cassert>
 #include <cstdint>
 #include <ctime>
+#include <functional>
 #include <ios>
 #include <memory>
 #include <ostream>
@@ -457,6 +458,40 @@ namespace pstore {
         using array_ptr = std::shared_ptr<array>;
 
 
+        //***************************
+        //*   l a z y _ a r r a y   *
+        //***************************
+        /// \brief A class used to write an array whose members are produced as it is written.
+        ///
+        /// Rather than holding its members, a lazy_array holds a generator function which is called
+        /// each time the array is written. The generator passes each member in turn to a sink which
+        /// writes it and then discards it. This means that the memory required to write the array
+        /// is bounded by the size of its largest member rather than the size of the whole.
+        ///
+        /// The output matches that of an array except that members are always written in block
+        /// style: the compact style used for arrays of numbers would require all of the members to
+        /// be known in advance.
+        class lazy_array final : public value {
+        public:
+            /// A function which writes a single member of the array.
+            using sink = std::function<void (value_ptr const &)>;
+            /// A function which passes each of the members of the array to a sink.
+            using generator = std::function<void (sink const &)>;
+
+            explicit lazy_array (generator gen)
+                    : gen_ (std::move (gen)) {}
+
+        private:
+            template <typename OStream>
+            OStream & writer (OStream & os, indent const & ind) const;
+
+            std::ostream & write_impl (std::ostream & os, indent const & ind) const override;
+            std::wostream & write_impl (std::wostream & os, indent const & ind) const override;
+
+            generator gen_;
+        };
+
+
         //*******************
         //*   o b j e c t   *
         //*******************
@@ -670,6 +705,13 @@ namespace pstore {
             return std::static_pointer_cast<value, array> (std::make_shared<array> (members));
         }
 
+        /// \brief  Makes a value object which represents an array whose members are produced by
+        /// \p gen as the array is written.
+        inline value_ptr make_lazy_array (lazy_array::generator gen) {
+            return std::static_pointer_cast<value, lazy_array> (
+                std::make_shared<lazy_array> (std::move (gen)));
+        }
+
         template <typename T, size_t Size>
         inline value_ptr make_value (std::array<T, Size> const & arr) {
             array::container contents;
@@ -45,13 +45,15 @@
 #define PSTORE_HTTP_BLOCK_FOR_INPUT_HPP
 
 #include <algorithm>
+#include <array>
+#include <cerrno>
 #include <cstring>
 #include <memory>
 
 #ifdef _WIN32
 #    include <winsock2.h>
 #else
-#    include <sys/select.h>
+#    include <poll.h>
 #endif
 
 #include "pstore/broker_intf/descriptor.hpp"
@@ -122,40 +124,29 @@ namespace pstore {
                 }
             }
 #else
-            timeval timeout{timeout_seconds, 0};
-            fd_set read_fds;
-            FD_ZERO (&read_fds);
-            FD_SET (socket_fd.native_handle (), &read_fds);
-            if (cv_fd != nullptr) {
-                FD_SET (cv_fd->native_handle (), &read_fds);
-            }
-
-            fd_set error_fds;
-            FD_ZERO (&error_fds);
-            FD_SET (socket_fd.native_handle (), &error_fds);
-            if (cv_fd != nullptr) {
-                FD_SET (cv_fd->native_handle (), &error_fds);
-            }
-
-            int const maxfd = std::max (socket_fd.native_handle (),
-                                        (cv_fd != nullptr) ? cv_fd->native_handle () : 0);
+            // poll() is used rather than select() because the latter cannot watch a descriptor
+            // whose value is FD_SETSIZE or larger.
+            std::array<pollfd, 2> fds{{{socket_fd.native_handle (), POLLIN, 0},
+                                       {cv_fd != nullptr ? cv_fd->native_handle () : -1, POLLIN,
+                                        0}}};
             auto err = 0;
-            while ((err = ::select (maxfd + 1, &read_fds, nullptr, &error_fds, &timeout)) == -1 &&
+            while ((err = ::poll (fds.data (), fds.size (),
+                                  static_cast<int> (timeout_seconds * 1000))) == -1 &&
                    errno == EINTR) {
                 continue; // Restart if interrupted by signal.
             }
 
             if (err == -1) {
-                raise (errno_erc{errno}, "select");
+                raise (errno_erc{errno}, "poll");
             } else if (err == 0) {
                 log (logging::priority::notice, "no data within timeout");
             }
 
-            auto const isset = [&read_fds, &error_fds] (int const fd) {
-                return FD_ISSET (fd, &read_fds) || FD_ISSET (fd, &error_fds);
+            // POLLHUP and POLLERR are reported so that the reader sees the end of the stream.
+            auto const isset = [] (pollfd const & pfd) {
+                return (pfd.revents & (POLLIN | POLLHUP | POLLERR)) != 0;
             };
-            return {isset (socket_fd.native_handle ()),
-                    cv_fd != nullptr ? isset (cv_fd->native_handle ()) : false};
+            return {isset (fds[0]), cv_fd != nullptr ? isset (fds[1]) : false};
 #endif
         } // namespace httpd
 
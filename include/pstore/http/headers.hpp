@@ -59,6 +59,9 @@ namespace pstore {
             bool connection_upgrade = false;
             pstore::maybe<std::string> websocket_key;
             pstore::maybe<unsigned> websocket_version;
+            /// The value of the If-None-Match header: the entity tags of the copies of the
+            /// resource held by the client.
+            pstore::maybe<std::string> if_none_match;
 
             header_info handler (std::string const & key, std::string const & value);
         };
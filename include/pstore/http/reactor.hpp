@@ -0,0 +1,128 @@
+//*                      _              *
+//*  _ __ ___  __ _  ___| |_ ___  _ __  *
+//* | '__/ _ \/ _` |/ __| __/ _ \| '__| *
+//* | | |  __/ (_| | (__| || (_) | |    *
+//* |_|  \___|\__,_|\___|\__\___/|_|    *
+//*                                     *
+//===- include/pstore/http/reactor.hpp ------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file reactor.hpp
+/// \brief A thin wrapper around the Linux epoll API.
+///
+/// The reactor allows a fixed pool of threads to wait for I/O readiness on an unbounded number of
+/// descriptors. Unlike select(), there is no FD_SETSIZE limit on the descriptors that may be
+/// watched.
+
+#ifndef PSTORE_HTTP_REACTOR_HPP
+#define PSTORE_HTTP_REACTOR_HPP
+
+#include "pstore/config/config.hpp"
+
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+
+#    include <chrono>
+#    include <cstdint>
+
+#    include "pstore/broker_intf/descriptor.hpp"
+#    include "pstore/support/gsl.hpp"
+
+namespace pstore {
+    namespace httpd {
+
+        class reactor {
+        public:
+            /// The events for which a descriptor may be watched.
+            enum interest : std::uint32_t {
+                readable = 1U << 0U,
+                writable = 1U << 1U,
+            };
+
+            /// Describes a descriptor which is ready for I/O.
+            struct event {
+                /// The token with which the descriptor was registered.
+                std::uint64_t token;
+                /// True if the descriptor has data to be read.
+                bool readable;
+                /// True if the descriptor can be written without blocking.
+                bool writable;
+                /// True if the peer hung up or an error is pending on the descriptor.
+                bool hangup;
+            };
+
+            reactor ();
+            reactor (reactor const &) = delete;
+            reactor (reactor &&) noexcept = default;
+            ~reactor () noexcept = default;
+
+            reactor & operator= (reactor const &) = delete;
+            reactor & operator= (reactor &&) noexcept = default;
+
+            /// Starts watching a descriptor.
+            ///
+            /// \param fd  The descriptor to be watched.
+            /// \param token  A value which identifies the descriptor in events produced by wait().
+            /// \param events  A mask of interest values.
+            /// \param oneshot  If true, the descriptor is disabled once wait() has reported an
+            ///   event for it. It must then be re-enabled by a call to rearm(). This guarantees
+            ///   that the descriptor is handled by just one thread at a time.
+            void add (int fd, std::uint64_t token, std::uint32_t events, bool oneshot);
+
+            /// Re-enables a descriptor that was added with the oneshot flag and changes the events
+            /// for which it is watched.
+            void rearm (int fd, std::uint64_t token, std::uint32_t events);
+
+            /// Stops watching a descriptor. This must be called before the descriptor is closed.
+            void remove (int fd) noexcept;
+
+            /// Waits for one or more descriptors to become ready.
+            ///
+            /// \param events  A span into which the ready events are written.
+            /// \param timeout  The maximum time to wait. A negative value waits indefinitely.
+            /// \returns  The number of members of \p events which were written. Zero if the
+            ///   timeout expired or the wait was interrupted by a signal.
+            std::size_t wait (gsl::span<event> events, std::chrono::milliseconds timeout);
+
+        private:
+            broker::pipe_descriptor fd_;
+        };
+
+    } // end namespace httpd
+} // end namespace pstore
+
+#endif // PSTORE_HAVE_SYS_EPOLL_H
+#endif // PSTORE_HTTP_REACTOR_HPP
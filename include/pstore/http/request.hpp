@@ -49,12 +49,15 @@
 #include <cassert>
 #include <cctype>
 #include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <sstream>
 #include <string>
 #include <system_error>
 #include <utility>
 
 #include "pstore/support/error_or.hpp"
+#include "pstore/support/gsl.hpp"
 #include "pstore/support/maybe.hpp"
 
 namespace pstore {
@@ -91,6 +94,33 @@ namespace pstore {
                 return std::make_error_code (std::errc::not_connected);
             }
 
+            /// Determines the number of bytes occupied by an HTTP request line and its headers:
+            /// that is, everything up to and including the first empty line. This allows a
+            /// non-blocking reader to wait until a complete request has been received before
+            /// passing it to read_request() and read_headers().
+            ///
+            /// \param available  The bytes received so far.
+            /// \returns  The length of the request or nothing if the empty line that marks the end
+            ///   of the headers has not yet been received.
+            inline maybe<std::size_t>
+            request_length (gsl::span<std::uint8_t const> const & available) {
+                auto line_length = std::size_t{0};
+                for (auto it = available.begin (), end = available.end (); it != end; ++it) {
+                    switch (*it) {
+                    case '\n':
+                        if (line_length == 0U) {
+                            return just (static_cast<std::size_t> (it - available.begin ()) + 1U);
+                        }
+                        line_length = 0U;
+                        break;
+                    // As in buffered_reader::gets(), a CR is not counted as part of the line.
+                    case '\r': break;
+                    default: ++line_length; break;
+                    }
+                }
+                return nothing<std::size_t> ();
+            }
+
         } // end namespace details
 
         // read_request
@@ -72,6 +72,15 @@ namespace pstore {
             return send (sender, io, os.str ());
         }
 
+        /// Sends bytes which live in memory that outlives the transmission (such as the contents of
+        /// a romfs file). This default simply sends the bytes; an IO type may provide an overload,
+        /// found by argument-dependent lookup, which queues a reference to the bytes rather than
+        /// a copy of them.
+        template <typename Sender, typename IO>
+        error_or<IO> send_static (Sender sender, IO io, gsl::span<std::uint8_t const> const & s) {
+            return send (sender, io, s);
+        }
+
         template <typename Sender, typename IO, typename T,
                   typename = typename std::enable_if<std::is_integral<T>::value>::type>
         error_or<IO> send (Sender sender, IO io, T v) {
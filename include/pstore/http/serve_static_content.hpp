@@ -50,39 +50,137 @@
 #ifndef PSTORE_HTTP_SERVE_STATIC_CONTENT_HPP
 #define PSTORE_HTTP_SERVE_STATIC_CONTENT_HPP
 
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <string>
+
 #include "pstore/http/http_date.hpp"
 #include "pstore/http/media_type.hpp"
 #include "pstore/http/send.hpp"
 #include "pstore/romfs/romfs.hpp"
+#include "pstore/support/maybe.hpp"
 
 namespace pstore {
     namespace httpd {
 
         namespace details {
 
-            template <typename Sender, typename IO>
-            pstore::error_or<IO> read_and_send (Sender sender, IO io,
-                                                pstore::romfs::descriptor fd) {
-                std::array<std::uint8_t, 1024> buffer{{0}};
-                auto * const data = buffer.data ();
-                std::size_t const num_read =
-                    fd.read (data, sizeof (decltype (buffer)::value_type), buffer.size ());
-                if (num_read == 0) {
-                    return pstore::error_or<IO>{io};
+            // current_http_date
+            // ~~~~~~~~~~~~~~~~~
+            /// Returns the current time formatted for use in an HTTP header. The string is
+            /// recomputed at most once per second by each thread.
+            inline std::string const & current_http_date () {
+                thread_local std::time_t last = 0;
+                thread_local std::string date;
+                std::time_t const now = std::time (nullptr);
+                if (now != last || date.empty ()) {
+                    date = http_date (now);
+                    last = now;
+                }
+                return date;
+            }
+
+            // response_header
+            // ~~~~~~~~~~~~~~~
+            /// Returns the HTTP response header for a file. The header which was precomputed by
+            /// genromfs is used if it is available.
+            inline std::string response_header (std::string const & path,
+                                                 romfs::dirent const & de) {
+                std::string header;
+                if (de.header () != nullptr) {
+                    header = de.header ();
+                } else {
+                    std::ostringstream os;
+                    os << "HTTP/1.0 200 OK" << crlf << "Server: pstore-httpd" << crlf
+                       << "Content-length: " << de.stat ().size << crlf
+                       << "Content-type: " << media_type_from_filename (path) << crlf
+                       << "Connection: close"
+                       << crlf // TODO remove this when we support persistent connections
+                       << "Last-Modified: " << http_date (de.stat ().mtime) << crlf;
+                    header = os.str ();
+                }
+                header += "Date: ";
+                header += current_http_date ();
+                header += crlf;
+                header += crlf;
+                return header;
+            }
+
+            // etag
+            // ~~~~
+            /// Returns the value of the ETag field in the precomputed response header \p header
+            /// (including its quotes) or an empty string if there is no such field.
+            inline std::string etag (gsl::czstring const header) {
+                static constexpr char field[] = "\r\nETag: ";
+                char const * const first = std::strstr (header, field);
+                if (first == nullptr) {
+                    return {};
                 }
-                pstore::error_or<IO> const eo =
-                    send (sender, io, gsl::span<std::uint8_t const> (data, data + num_read));
-                if (!eo) {
-                    return eo;
+                char const * const value = first + sizeof (field) - 1U;
+                char const * const last = std::strstr (value, crlf);
+                return last == nullptr ? std::string{} : std::string{value, last};
+            }
+
+            // etag_matches
+            // ~~~~~~~~~~~~
+            /// Returns true if \p tag matches one of the entity tags in the value of an
+            /// If-None-Match request header or that value is "*". As required by RFC 7232, the
+            /// comparison is weak: a "W/" prefix is ignored. An empty \p tag matches only "*".
+            inline bool etag_matches (std::string const & if_none_match, std::string const & tag) {
+                auto pos = std::string::size_type{0};
+                auto const length = if_none_match.length ();
+                while (pos < length) {
+                    pos = if_none_match.find_first_not_of (" \t,", pos);
+                    if (pos == std::string::npos) {
+                        break;
+                    }
+                    if (if_none_match[pos] == '*') {
+                        return true;
+                    }
+                    if (if_none_match.compare (pos, 2U, "W/") == 0) {
+                        pos += 2U;
+                    }
+                    // An entity tag is a quoted string which cannot itself contain a quote.
+                    auto end = if_none_match.find ('"', pos + 1U);
+                    end = end == std::string::npos ? length : end + 1U;
+                    if (if_none_match.compare (pos, end - pos, tag) == 0) {
+                        return true;
+                    }
+                    pos = end;
+                }
+                return false;
+            }
+
+            // not_modified_header
+            // ~~~~~~~~~~~~~~~~~~~
+            /// Returns the header of a "304 Not Modified" response for a resource whose entity
+            /// tag is \p tag (or which has no entity tag if \p tag is empty).
+            inline std::string not_modified_header (std::string const & tag) {
+                std::ostringstream os;
+                os << "HTTP/1.0 304 Not Modified" << crlf << "Server: pstore-httpd" << crlf
+                   << "Connection: close" << crlf;
+                if (!tag.empty ()) {
+                    os << "ETag: " << tag << crlf;
                 }
-                return read_and_send (sender, io, fd);
+                os << "Date: " << current_http_date () << crlf << crlf;
+                return os.str ();
             }
 
         } // end namespace details
 
+        /// Sends the contents of the romfs file at \p path preceded by an HTTP response header.
+        /// The file's contents are sent directly from the file system's memory.
+        ///
+        /// \param if_none_match  The value of the request's If-None-Match header, if present. If
+        ///   it is "*" or names the file's entity tag, a "304 Not Modified" response without a
+        ///   body is sent instead. Only files with a header precomputed by genromfs have an entity
+        ///   tag.
         template <typename Sender, typename IO>
-        pstore::error_or<IO> serve_static_content (Sender sender, IO io, std::string path,
-                                                   pstore::romfs::romfs const & file_system) {
+        pstore::error_or<IO>
+        serve_static_content (Sender sender, IO io, std::string path,
+                              pstore::romfs::romfs const & file_system,
+                              maybe<std::string> const & if_none_match = nothing<std::string> ()) {
             if (path.empty ()) {
                 path = "/";
             }
@@ -90,19 +188,25 @@ namespace pstore {
                 path += "index.html";
             }
 
-            return file_system.stat (path.c_str ()) >>= [&](pstore::romfs::stat const & stat) {
-                return file_system.open (path.c_str ()) >>= [&](pstore::romfs::descriptor fd) {
-                    // Send the response header.
-                    std::ostringstream os;
-                    os << "HTTP/1.0 200 OK" << crlf << "Server: pstore-httpd" << crlf
-                       << "Content-length: " << stat.size << crlf
-                       << "Content-type: " << pstore::httpd::media_type_from_filename (path) << crlf
-                       << "Connection: close"
-                       << crlf // TODO remove this when we support persistent connections
-                       << "Date: " << http_date (std::chrono::system_clock::now ()) << crlf
-                       << "Last-Modified: " << http_date (stat.mtime) << crlf << crlf;
-                    return send (sender, io, os.str ()) >>=
-                           [&](IO io2) { return details::read_and_send (sender, io2, fd); };
+            return file_system.find (path.c_str ()) >>= [&] (romfs::dirent const * const de) {
+                if (de->is_directory ()) {
+                    return error_or<IO>{make_error_code (romfs::error_code::enoent)};
+                }
+                if (if_none_match) {
+                    std::string const tag =
+                        de->header () != nullptr ? details::etag (de->header ()) : std::string{};
+                    if (details::etag_matches (*if_none_match, tag)) {
+                        return send (sender, io, details::not_modified_header (tag));
+                    }
+                }
+                return send (sender, io, details::response_header (path, *de)) >>= [&] (IO io2) {
+                    auto const size = de->stat ().size;
+                    if (size == 0) {
+                        return error_or<IO>{io2};
+                    }
+                    auto const * const data = static_cast<std::uint8_t const *> (de->contents ());
+                    return send_static (sender, io2,
+                                        gsl::make_span (data, static_cast<std::ptrdiff_t> (size)));
                 };
             };
         }
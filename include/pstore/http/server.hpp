@@ -55,8 +55,23 @@ namespace pstore {
 
         class server_status;
 
+        /// The number of threads used by server() unless the caller specifies otherwise.
+        constexpr unsigned default_server_workers = 4U;
+
+        /// Runs the HTTP and WebSockets server until it is stopped by a call to quit().
+        ///
+        /// Where the epoll API is available, connections are serviced by a fixed pool of
+        /// \p num_workers threads which are driven by I/O readiness events. Otherwise each
+        /// connection is served in turn by the calling thread and each WebSockets session is given
+        /// a thread of its own.
+        ///
+        /// \param file_system  The file system from which static content is served.
+        /// \param status  The server's state. Used to coordinate shutdown with quit().
+        /// \param channels  The pub-sub channels to which WebSockets clients may subscribe.
+        /// \param num_workers  The number of threads which service connections.
         int server (romfs::romfs & file_system, gsl::not_null<server_status *> status,
-                    channel_container const & channels);
+                    channel_container const & channels,
+                    unsigned num_workers = default_server_workers);
 
         void quit (in_port_t port_number = 8080);
 
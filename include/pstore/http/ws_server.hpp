@@ -63,6 +63,7 @@
 #include "pstore/http/send.hpp"
 #include "pstore/os/logging.hpp"
 #include "pstore/support/bit_field.hpp"
+#include "pstore/support/maybe.hpp"
 #include "pstore/support/pubsub.hpp"
 #include "pstore/support/utf.hpp"
 
@@ -258,6 +259,15 @@ namespace pstore {
                             gsl::span<std::uint8_t const> const & mask,
                             gsl::span<std::uint8_t> const & payload);
 
+            /// Determines the total number of bytes occupied by a frame given a buffer which
+            /// contains its leading bytes. This allows a non-blocking reader to wait until a
+            /// complete frame has been received before passing it to read_frame().
+            ///
+            /// \param available  The bytes received so far. The frame starts at the first byte.
+            /// \returns  The size of the frame (including its header) or nothing if \p available
+            ///   does not yet hold enough of the frame header to determine its size.
+            maybe<std::uint64_t> frame_length (gsl::span<std::uint8_t const> const & available);
+
         } // end namespace details
 
 
@@ -637,10 +647,11 @@ namespace pstore {
                     assert (cv != nullptr);
                     cv->reset ();
                     if (subscription) {
-                        while (maybe<std::string> const message = subscription->pop ()) {
-                            log (logging::priority::info, "sending:", *message);
+                        while (maybe<message_pointer> const message = subscription->pop ()) {
+                            std::string const & str = **message;
+                            log (logging::priority::info, "sending:", str);
                             error_or<IO> const eo3 = send_message (
-                                sender, io, opcode::text, as_bytes (gsl::make_span (*message)));
+                                sender, io, opcode::text, as_bytes (gsl::make_span (str)));
                             if (!eo3) {
                                 log (logging::priority::error,
                                      "Send error: ", eo3.get_error ().message ());
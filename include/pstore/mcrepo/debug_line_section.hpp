@@ -81,7 +81,7 @@ namespace pstore {
             // \returns The section's data payload.
             container<std::uint8_t> payload () const { return g_.payload (); }
             /// \returns The number of bytes in the section's data payload.
-            std::size_t size () const noexcept { return this->payload ().size (); }
+            std::size_t size () const noexcept { return static_cast<std::size_t> (g_.size ()); }
             container<internal_fixup> ifixups () const { return g_.ifixups (); }
             container<external_fixup> xfixups () const { return g_.xfixups (); }
 
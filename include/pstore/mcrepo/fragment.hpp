@@ -55,6 +55,7 @@
 
 #include "pstore/config/config.hpp"
 #include "pstore/core/address.hpp"
+#include "pstore/core/pinned_view.hpp"
 #include "pstore/core/transaction.hpp"
 #include "pstore/mcrepo/bss_section.hpp"
 #include "pstore/mcrepo/debug_line_section.hpp"
@@ -170,6 +171,15 @@ namespace pstore {
             static std::shared_ptr<fragment const> load (database const & db,
                                                          extent<fragment> const & location);
 
+            /// Provides a pointer to an individual fragment instance given a pinned database view
+            /// and an extent describing its address and size. No reference counts are modified.
+            ///
+            /// \param view  The pinned view from which the fragment is to be read.
+            /// \param location  The address and size of the fragment data.
+            /// \returns  A pointer to the fragment instance. Its validity follows the rules for
+            ///   pointers returned by pinned_view::getro().
+            static fragment const * load (pinned_view & view, extent<fragment> const & location);
+
             /// Provides a pointer to an individual fragment instance given a transaction and an
             /// extent describing its address and size.
             ///
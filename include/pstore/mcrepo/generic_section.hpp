@@ -51,6 +51,7 @@
 #include <type_traits>
 
 #include "pstore/core/address.hpp"
+#include "pstore/mcrepo/repo_error.hpp"
 #include "pstore/mcrepo/section.hpp"
 #include "pstore/support/aligned.hpp"
 #include "pstore/support/bit_count.hpp"
@@ -212,6 +213,17 @@ namespace pstore {
                     : generic_section (src.data_range, src.ifixups_range, src.xfixups_range,
                                        align) {}
 
+            /// Constructs a section whose payload is not stored inline but is instead held in a
+            /// separate extent which may be shared with other sections.
+            ///
+            /// \param shared  The extent of the section's payload.
+            /// \param i  The range of internal fixups.
+            /// \param x  The range of external fixups.
+            /// \param align  The section's alignment.
+            template <typename IFixupRange, typename XFixupRange>
+            generic_section (extent<std::uint8_t> const & shared, IFixupRange const & i,
+                             XFixupRange const & x, std::uint8_t align);
+
             generic_section (generic_section const &) = delete;
             generic_section & operator= (generic_section const &) = delete;
             generic_section (generic_section &&) = delete;
@@ -221,12 +233,28 @@ namespace pstore {
             /// The number of data bytes contained by this section.
             std::uint64_t size () const noexcept { return data_size_; }
 
-            container<std::uint8_t> payload () const noexcept {
+            /// \returns True if the section's payload is held in a separate extent rather than
+            /// following the section record.
+            bool has_shared_payload () const noexcept { return shared_payload_ != 0U; }
+            /// \returns The extent of the section's payload. The section must have a shared
+            /// payload.
+            extent<std::uint8_t> const & shared_payload () const noexcept {
+                assert (this->has_shared_payload ());
+                return *aligned_ptr<extent<std::uint8_t>> (this + 1);
+            }
+
+            /// \returns The section's payload. Raises error_code::payload_is_shared if the section
+            /// has a shared payload: such payloads must be loaded from the store using their
+            /// extent.
+            container<std::uint8_t> payload () const {
+                if (this->has_shared_payload ()) {
+                    raise (error_code::payload_is_shared);
+                }
                 auto * const begin = aligned_ptr<std::uint8_t> (this + 1);
                 return {begin, begin + data_size_};
             }
             container<internal_fixup> ifixups () const {
-                auto * const begin = aligned_ptr<internal_fixup> (payload ().end ());
+                auto * const begin = aligned_ptr<internal_fixup> (this->payload_end ());
                 return {begin, begin + this->num_ifixups ()};
             }
             container<external_fixup> xfixups () const {
@@ -246,6 +274,11 @@ namespace pstore {
             static std::size_t size_bytes (std::size_t data_size, std::size_t num_ifixups,
                                            std::size_t num_xfixups);
 
+            /// \returns The number of bytes needed to accommodate a fragment section with a
+            /// shared payload and the given number of fixups.
+            static std::size_t shared_size_bytes (std::size_t num_ifixups,
+                                                  std::size_t num_xfixups);
+
             template <typename DataRange, typename IFixupRange, typename XFixupRange>
             static std::size_t size_bytes (DataRange const & d, IFixupRange const & i,
                                            XFixupRange const & x);
@@ -275,7 +308,10 @@ namespace pstore {
                 std::uint32_t field32_ = 0;
                 /// The alignment of this section expressed as a power of two (i.e. 8 byte
                 /// alignment is expressed as an align_ value of 3).
-                bit_field <std::uint32_t, 0, 8> align_;
+                bit_field <std::uint32_t, 0, 7> align_;
+                /// Set if the payload is held in a separate extent. In this case, the extent
+                /// takes the place of the payload data.
+                bit_field <std::uint32_t, 7, 1> shared_payload_;
                 /// The number of internal fixups.
                 bit_field <std::uint32_t, 8, 24> num_ifixups_;
             };
@@ -285,6 +321,15 @@ namespace pstore {
             std::uint64_t data_size_ = 0;
 
             std::uint32_t num_ifixups () const noexcept;
+            /// \returns A pointer to the end of the payload or, if the payload is shared, its
+            /// extent.
+            std::uint8_t const * payload_end () const noexcept;
+
+            /// Copies the fixup ranges \p i and \p x to the memory starting at \p p.
+            /// \returns A pointer to the end of the copied fixups.
+            template <typename IFixupRange, typename XFixupRange>
+            std::uint8_t * write_fixups (std::uint8_t * p, IFixupRange const & i,
+                                         XFixupRange const & x);
 
             /// A helper function which returns the distance between two iterators,
             /// clamped to the maximum range of IntType.
@@ -312,6 +357,7 @@ namespace pstore {
         generic_section::generic_section (DataRange const & d, IFixupRange const & i,
                                           XFixupRange const & x, std::uint8_t const align) {
             align_ = bit_count::ctz (align);
+            shared_payload_ = std::uint32_t{0};
             num_ifixups_ = std::uint32_t{0};
 
             PSTORE_STATIC_ASSERT (std::is_standard_layout<generic_section>::value);
@@ -319,6 +365,8 @@ namespace pstore {
             PSTORE_STATIC_ASSERT (offsetof (generic_section, field32_) == 0);
             PSTORE_STATIC_ASSERT (offsetof (generic_section, align_) ==
                                   offsetof (generic_section, field32_));
+            PSTORE_STATIC_ASSERT (offsetof (generic_section, shared_payload_) ==
+                                  offsetof (generic_section, field32_));
             PSTORE_STATIC_ASSERT (offsetof (generic_section, num_ifixups_) ==
                                   offsetof (generic_section, field32_));
 
@@ -338,6 +386,44 @@ namespace pstore {
                 std::memcpy (p, d.first, data_size_);
                 p += data_size_;
             }
+            p = this->write_fixups (p, i, x);
+            assert (p >= start && static_cast<std::size_t> (p - start) == size_bytes (d, i, x));
+        }
+
+        template <typename IFixupRange, typename XFixupRange>
+        generic_section::generic_section (extent<std::uint8_t> const & shared,
+                                          IFixupRange const & i, XFixupRange const & x,
+                                          std::uint8_t const align) {
+            align_ = bit_count::ctz (align);
+            shared_payload_ = std::uint32_t{1};
+            num_ifixups_ = std::uint32_t{0};
+            assert (bit_count::pop_count (align) == 1);
+#ifndef NDEBUG
+            auto * const start = reinterpret_cast<std::uint8_t const *> (this);
+#endif
+            // Note that the memory following the section is uninitialized.
+            auto * const ext = aligned_ptr<extent<std::uint8_t>> (this + 1);
+            new (ext) extent<std::uint8_t> (shared);
+            data_size_ = shared.size;
+            auto * const p = this->write_fixups (reinterpret_cast<std::uint8_t *> (ext + 1), i, x);
+#ifndef NDEBUG
+            {
+                auto const num_ifixups = std::distance (i.first, i.second);
+                auto const num_xfixups = std::distance (x.first, x.second);
+                assert (num_ifixups >= 0 && num_xfixups >= 0);
+                auto const expected = shared_size_bytes (static_cast<std::size_t> (num_ifixups),
+                                                         static_cast<std::size_t> (num_xfixups));
+                assert (p >= start && static_cast<std::size_t> (p - start) == expected);
+            }
+#endif
+            (void) p;
+        }
+
+        // write_fixups
+        // ~~~~~~~~~~~~
+        template <typename IFixupRange, typename XFixupRange>
+        std::uint8_t * generic_section::write_fixups (std::uint8_t * p, IFixupRange const & i,
+                                                      XFixupRange const & x) {
             if (i.first != i.second) {
                 auto * iout = aligned_ptr<internal_fixup> (p);
                 std::for_each (i.first, i.second, [&iout](internal_fixup const & ifx) {
@@ -358,7 +444,7 @@ namespace pstore {
                 num_xfixups_ =
                     generic_section::set_size<decltype (num_xfixups_)> (x.first, x.second);
             }
-            assert (p >= start && static_cast<std::size_t> (p - start) == size_bytes (d, i, x));
+            return p;
         }
 
         // set_size
@@ -397,6 +483,15 @@ namespace pstore {
             return num_ifixups_;
         }
 
+        // payload_end
+        // ~~~~~~~~~~~
+        inline std::uint8_t const * generic_section::payload_end () const noexcept {
+            if (this->has_shared_payload ()) {
+                return reinterpret_cast<std::uint8_t const *> (&this->shared_payload () + 1);
+            }
+            return aligned_ptr<std::uint8_t> (this + 1) + data_size_;
+        }
+
         struct section_content {
             section_content (section_kind const kind_, std::uint8_t const align_) noexcept
                     : kind{kind_}
@@ -456,6 +551,20 @@ namespace pstore {
                                                  section_content const * const sec)
                     : section_creation_dispatcher (kind)
                     , section_{sec} {}
+            /// Creates a section whose payload is held in a shared extent. The data member of
+            /// \p sec is ignored.
+            ///
+            /// \param kind  The kind of the section being created.
+            /// \param sec  The section's alignment and fixups.
+            /// \param shared_payload  The extent of the section's payload.
+            generic_section_creation_dispatcher (section_kind const kind,
+                                                 section_content const * const sec,
+                                                 extent<std::uint8_t> const & shared_payload)
+                    : section_creation_dispatcher (kind)
+                    , section_{sec}
+                    , shared_payload_{shared_payload} {
+                assert (shared_payload.addr != typed_address<std::uint8_t>::null ());
+            }
 
             generic_section_creation_dispatcher (generic_section_creation_dispatcher const &) =
                 delete;
@@ -469,7 +578,13 @@ namespace pstore {
 
         private:
             std::uintptr_t aligned_impl (std::uintptr_t in) const final;
+            bool is_shared () const noexcept {
+                return shared_payload_.addr != typed_address<std::uint8_t>::null ();
+            }
+
             section_content const * const section_;
+            /// If the section's payload is shared, its extent. Otherwise null.
+            extent<std::uint8_t> const shared_payload_;
         };
 
 
@@ -484,7 +599,9 @@ namespace pstore {
             std::size_t size () const final { return s_.size (); }
             container<internal_fixup> ifixups () const final { return s_.ifixups (); }
             container<external_fixup> xfixups () const final { return s_.xfixups (); }
-            container<std::uint8_t> payload () const final { return s_.payload (); }
+            /// Returns the section's payload. Raises error_code::payload_is_shared if the payload is
+            /// shared: use load_payload() to read it from the store.
+            container<std::uint8_t> payload () const final;
 
         private:
             generic_section const & s_;
@@ -58,6 +58,7 @@ namespace pstore {
             bad_compilation_record,
             too_many_members_in_compilation,
             bss_section_too_large,
+            payload_is_shared, // the section's payload is held in a shared extent
         };
 
         class error_category : public std::error_category {
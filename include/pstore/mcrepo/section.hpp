@@ -217,7 +217,8 @@ namespace pstore {
             virtual container<internal_fixup> ifixups () const = 0;
             virtual container<external_fixup> xfixups () const = 0;
             /// Return the data section stored in the object file. For example, the bss section has
-            /// empty data section.
+            /// empty data section. A generic section whose payload is shared raises
+            /// error_code::payload_is_shared.
             virtual container<std::uint8_t> payload () const = 0;
         };
 
@@ -0,0 +1,289 @@
+//*                _   _                     _                *
+//*  ___  ___  ___| |_(_) ___  _ __   __   _(_) _____      __ *
+//* / __|/ _ \/ __| __| |/ _ \| '_ \  \ \ / / |/ _ \ \ /\ / / *
+//* \__ \  __/ (__| |_| | (_) | | | |  \ V /| |  __/\ V  V /  *
+//* |___/\___|\___|\__|_|\___/|_| |_|   \_/ |_|\___| \_/\_/   *
+//*                                                           *
+//===- include/pstore/mcrepo/section_view.hpp -----------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file section_view.hpp
+/// \brief Provides a non-owning, non-virtual view of the target sections of a fragment.
+///
+/// A linker typically needs to visit the payload and fixups of every section of many thousands
+/// of fragments. section_view describes one section as a set of raw, contiguous spans which point
+/// directly into the fragment's storage: creating one does not allocate or copy and does not
+/// involve the virtual dispatcher classes. When fragments are loaded with
+/// fragment::load(pinned_view&, ...) the spans remain valid for as long as the fragment pointer
+/// (see pinned_view for the rules governing data which spans regions) and no reference counts are
+/// modified. A payload which is shared between fragments (see intern_payload()) is reached through
+/// the pinned view passed to make_section_view().
+
+#ifndef PSTORE_MCREPO_SECTION_VIEW_HPP
+#define PSTORE_MCREPO_SECTION_VIEW_HPP
+
+#include <cstdint>
+#include <iterator>
+
+#include "pstore/core/pinned_view.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+#include "pstore/mcrepo/repo_error.hpp"
+#include "pstore/support/error.hpp"
+
+namespace pstore {
+    namespace repo {
+
+        //*                _   _                     _                *
+        //*  ___  ___  ___| |_(_) ___  _ __   __   _(_) _____      __ *
+        //* / __|/ _ \/ __| __| |/ _ \| '_ \  \ \ / / |/ _ \ \ /\ / / *
+        //* \__ \  __/ (__| |_| | (_) | | | |  \ V /| |  __/\ V  V /  *
+        //* |___/\___|\___|\__|_|\___/|_| |_|   \_/ |_|\___| \_/\_/   *
+        //*                                                           *
+        /// Describes a single target section of a fragment. Each of the spans points into the
+        /// fragment's storage.
+        struct section_view {
+            section_kind kind;
+            /// The section's alignment in bytes.
+            unsigned align;
+            /// The number of bytes occupied by the section when loaded. For a BSS section, this is
+            /// the size of the zero-filled region; otherwise it is the size of the payload.
+            std::uint64_t size;
+            /// The section's data. Empty for a BSS section.
+            container<std::uint8_t> payload;
+            container<internal_fixup> ifixups;
+            container<external_fixup> xfixups;
+        };
+
+        namespace details {
+
+            /// Returns the payload of section \p s. If \p wanted is false, a shared payload is not
+            /// loaded and an empty container is returned in its place.
+            inline container<std::uint8_t> payload (pinned_view * const view,
+                                                    generic_section const & s, bool const wanted) {
+                if (!s.has_shared_payload ()) {
+                    return s.payload ();
+                }
+                if (!wanted) {
+                    return {};
+                }
+                if (view == nullptr) {
+                    raise (error_code::payload_is_shared);
+                }
+                extent<std::uint8_t> const & ex = s.shared_payload ();
+                std::uint8_t const * const first = view->getro (ex);
+                return {first, first + ex.size};
+            }
+
+            inline section_view make_view (pinned_view * const view, bool const with_payload,
+                                           section_kind const kind, generic_section const & s) {
+                return {kind,
+                        s.align (),
+                        s.size (),
+                        payload (view, s, with_payload),
+                        s.ifixups (),
+                        s.xfixups ()};
+            }
+            inline section_view make_view (pinned_view * const view, bool const with_payload,
+                                           section_kind const kind, debug_line_section const & s) {
+                return make_view (view, with_payload, kind, s.generic ());
+            }
+            inline section_view make_view (pinned_view *, bool, section_kind const kind,
+                                           bss_section const & s) {
+                return {kind, s.align (), s.size (), {}, {}, {}};
+            }
+            inline section_view make_view (pinned_view *, bool, section_kind, dependents const &) {
+                raise (error_code::bad_fragment_type);
+            }
+
+            /// Returns a view of the section of the given kind in fragment \p f. If
+            /// \p with_payload is false, a shared payload is not loaded and the view's payload is
+            /// empty: this allows a section's alignment, size, and fixups to be read without a
+            /// pinned view.
+            inline section_view make_section_view (pinned_view * const view, fragment const & f,
+                                                   section_kind const kind,
+                                                   bool const with_payload = true) {
+                assert (f.has_section (kind));
+#define X(k)                                                                                       \
+    case section_kind::k:                                                                          \
+        return details::make_view (view, with_payload, kind, f.at<section_kind::k> ());
+                switch (kind) {
+                    PSTORE_MCREPO_SECTION_KINDS
+                case section_kind::last: break;
+                }
+#undef X
+                raise (error_code::bad_fragment_type);
+            }
+
+        } // end namespace details
+
+        /// Returns a view of the section of the given kind in fragment \p f. The fragment must
+        /// contain a section of this kind and it must be a target section. Raises
+        /// error_code::payload_is_shared if the section's payload is shared.
+        ///
+        /// \param f  The fragment containing the section.
+        /// \param kind  The section to be viewed.
+        /// \returns  A view of the section's payload and fixups.
+        inline section_view make_section_view (fragment const & f, section_kind const kind) {
+            return details::make_section_view (nullptr, f, kind);
+        }
+
+        /// Returns a view of the section of the given kind in fragment \p f. A shared payload is
+        /// read through \p view.
+        ///
+        /// \param view  The pinned view from which shared payloads are read.
+        /// \param f  The fragment containing the section.
+        /// \param kind  The section to be viewed.
+        /// \returns  A view of the section's payload and fixups. Its validity follows the rules for
+        ///   pointers returned by \p view.
+        inline section_view make_section_view (pinned_view & view, fragment const & f,
+                                               section_kind const kind) {
+            return details::make_section_view (&view, f, kind);
+        }
+
+
+        //*   __                                      _                   _   _                  *
+        //*  / _|_ __ __ _  __ _ _ __ ___   ___ _ __ | |_   ___  ___  ___| |_(_) ___  _ __  ___  *
+        //* | |_| '__/ _` |/ _` | '_ ` _ \ / _ \ '_ \| __| / __|/ _ \/ __| __| |/ _ \| '_ \/ __| *
+        //* |  _| | | (_| | (_| | | | | | |  __/ | | | |_  \__ \  __/ (__| |_| | (_) | | | \__ \ *
+        //* |_| |_|  \__,_|\__, |_| |_| |_|\___|_| |_|\__| |___/\___|\___|\__|_|\___/|_| |_|___/ *
+        //*                |___/                                                                 *
+        /// A range which yields a section_view for each of the target sections of a fragment, in
+        /// section_kind order. Repo metadata sections (such as the dependents) are skipped.
+        class fragment_sections {
+        public:
+            class const_iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = section_view;
+                using difference_type = std::ptrdiff_t;
+                using pointer = value_type const *;
+                using reference = value_type;
+
+                const_iterator (pinned_view * const view, fragment const & f,
+                                fragment::const_iterator const it) noexcept
+                        : view_{view}
+                        , f_{&f}
+                        , it_{it} {}
+
+                bool operator== (const_iterator const & rhs) const noexcept {
+                    return it_ == rhs.it_;
+                }
+                bool operator!= (const_iterator const & rhs) const noexcept {
+                    return !operator== (rhs);
+                }
+
+                section_view operator* () const {
+                    return details::make_section_view (view_, *f_, *it_);
+                }
+                const_iterator & operator++ () noexcept {
+                    ++it_;
+                    return *this;
+                }
+                const_iterator operator++ (int) noexcept {
+                    auto const prev = *this;
+                    ++*this;
+                    return prev;
+                }
+
+            private:
+                pinned_view * view_;
+                fragment const * f_;
+                fragment::const_iterator it_;
+            };
+
+            explicit fragment_sections (fragment const & f) noexcept
+                    : fragment_sections (nullptr, f) {}
+            /// \param view  The pinned view from which shared payloads are read.
+            /// \param f  The fragment whose sections are to be visited.
+            fragment_sections (pinned_view & view, fragment const & f) noexcept
+                    : fragment_sections (&view, f) {}
+
+            const_iterator begin () const noexcept { return {view_, f_, f_.begin ()}; }
+            const_iterator end () const noexcept { return {view_, f_, end_}; }
+
+        private:
+            fragment_sections (pinned_view * const view, fragment const & f) noexcept
+                    : view_{view}
+                    , f_{f}
+                    , end_{f.end ()} {
+                // The sections are stored in section_kind order and the metadata sections follow
+                // all of the target sections, so the target sections are a prefix of the fragment.
+                for (auto it = f.begin (); it != end_; ++it) {
+                    if (!is_target_section (*it)) {
+                        end_ = it;
+                        break;
+                    }
+                }
+            }
+
+            pinned_view * view_;
+            fragment const & f_;
+            fragment::const_iterator end_;
+        };
+
+        /// Calls \p function with a section_view for each of the target sections of fragment \p f.
+        ///
+        /// \param f  The fragment whose sections are to be visited.
+        /// \param function  A function which will be called with a section_view argument.
+        /// \returns  The function.
+        template <typename Function>
+        Function for_each_section (fragment const & f, Function function) {
+            for (section_view const & view : fragment_sections{f}) {
+                function (view);
+            }
+            return function;
+        }
+
+        /// Calls \p function with a section_view for each of the target sections of fragment \p f.
+        /// Shared payloads are read through \p view.
+        ///
+        /// \param view  The pinned view from which shared payloads are read.
+        /// \param f  The fragment whose sections are to be visited.
+        /// \param function  A function which will be called with a section_view argument.
+        /// \returns  The function.
+        template <typename Function>
+        Function for_each_section (pinned_view & view, fragment const & f, Function function) {
+            for (section_view const & sv : fragment_sections{view, f}) {
+                function (sv);
+            }
+            return function;
+        }
+
+    } // end namespace repo
+} // end namespace pstore
+
+#endif // PSTORE_MCREPO_SECTION_VIEW_HPP
@@ -0,0 +1,175 @@
+//*      _                        _                     _                 _  *
+//*  ___| |__   __ _ _ __ ___  __| |  _ __   __ _ _   _| | ___   __ _  __| | *
+//* / __| '_ \ / _` | '__/ _ \/ _` | | '_ \ / _` | | | | |/ _ \ / _` |/ _` | *
+//* \__ \ | | | (_| | | |  __/ (_| | | |_) | (_| | |_| | | (_) | (_| | (_| | *
+//* |___/_| |_|\__,_|_|  \___|\__,_| | .__/ \__,_|\__, |_|\___/ \__,_|\__,_| *
+//*                                  |_|          |___/                      *
+//===- include/pstore/mcrepo/shared_payload.hpp ---------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file shared_payload.hpp
+/// \brief Deduplication of generic section payloads.
+///
+/// Identical section payloads (the same read-only data, or the same inline function body compiled
+/// into fragments with different digests) can be stored once and shared by every section which
+/// contains them. Each shared payload is recorded in the payload index keyed by a digest of its
+/// contents.
+
+#ifndef PSTORE_MCREPO_SHARED_PAYLOAD_HPP
+#define PSTORE_MCREPO_SHARED_PAYLOAD_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "pstore/core/database.hpp"
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/index_types.hpp"
+#include "pstore/mcrepo/generic_section.hpp"
+#include "pstore/support/gsl.hpp"
+
+namespace pstore {
+    namespace repo {
+
+        /// Payloads smaller than this number of bytes are stored inline by
+        /// make_shared_payload_dispatcher(): sharing them would save less than the cost of the
+        /// extent and index entry.
+        constexpr std::size_t shared_payload_threshold = 64U;
+
+        /// Computes the digest by which a payload is keyed in the payload index.
+        ///
+        /// \param data  The payload.
+        /// \returns  The payload's digest.
+        index::digest payload_digest (gsl::span<std::uint8_t const> data) noexcept;
+
+        /// Returns the extent of a copy of \p data in the store. If the payload index records a
+        /// payload with identical contents then that copy is returned. Otherwise the data is
+        /// written and added to the index.
+        ///
+        /// \note The payload index may only be written to a store whose minor version is at least
+        ///   header::shared_payload_version. Committing a transaction which modifies it in an
+        ///   older store raises error_code::header_version_mismatch.
+        ///
+        /// \param transaction  The transaction to which the payload is written.
+        /// \param index  The payload index.
+        /// \param data  The payload.
+        /// \returns  The extent of a payload whose contents are equal to \p data.
+        template <typename Transaction>
+        extent<std::uint8_t> intern_payload (Transaction & transaction,
+                                             std::shared_ptr<index::payload_index> const & index,
+                                             gsl::span<std::uint8_t const> data);
+
+        /// Creates a creation dispatcher for a generic section. If the section's payload is at
+        /// least \p threshold bytes long and the store's format permits shared payloads, it is
+        /// stored using intern_payload(), otherwise it is stored inline.
+        ///
+        /// \param transaction  The transaction to which the payload is written.
+        /// \param index  The payload index.
+        /// \param kind  The kind of the section being created.
+        /// \param content  The section's contents. Must outlive the returned dispatcher.
+        /// \param threshold  The smallest payload which will be shared.
+        template <typename Transaction>
+        std::unique_ptr<section_creation_dispatcher> make_shared_payload_dispatcher (
+            Transaction & transaction, std::shared_ptr<index::payload_index> const & index,
+            section_kind kind, section_content const * content,
+            std::size_t threshold = shared_payload_threshold);
+
+        /// Returns the payload of a generic section, loading it from the store if it is shared.
+        ///
+        /// \param db  The database containing the section.
+        /// \param s  The section whose payload is to be returned.
+        /// \param owner  If the payload is shared, receives the pointer which owns its memory.
+        /// \returns  The section's payload. Valid for as long as \p s and \p owner.
+        container<std::uint8_t> load_payload (database const & db, generic_section const & s,
+                                              gsl::not_null<std::shared_ptr<void const> *> owner);
+
+
+        // intern_payload
+        // ~~~~~~~~~~~~~~
+        template <typename Transaction>
+        extent<std::uint8_t> intern_payload (Transaction & transaction,
+                                             std::shared_ptr<index::payload_index> const & index,
+                                             gsl::span<std::uint8_t const> const data) {
+            auto const size = static_cast<std::size_t> (data.size ());
+            auto const write = [&transaction, &data, size] () {
+                auto const storage = transaction.alloc_rw (size, 1U);
+                std::memcpy (storage.first.get (), data.data (), size);
+                return extent<std::uint8_t>{typed_address<std::uint8_t> (storage.second), size};
+            };
+
+            index::digest const key = payload_digest (data);
+            database const & db = transaction.db ();
+            auto const pos = index->find (db, key);
+            if (pos != index->cend (db)) {
+                // The digest is not a cryptographic hash, so check that the contents really do
+                // match before sharing them.
+                extent<std::uint8_t> const & existing = pos->second;
+                if (existing.size == size) {
+                    auto const existing_data = db.getro (existing);
+                    if (std::equal (data.begin (), data.end (), existing_data.get ())) {
+                        return existing;
+                    }
+                }
+                // A digest collision: this payload is written but not shared.
+                return write ();
+            }
+            extent<std::uint8_t> const result = write ();
+            index->insert (transaction, std::make_pair (key, result));
+            return result;
+        }
+
+        // make_shared_payload_dispatcher
+        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+        template <typename Transaction>
+        std::unique_ptr<section_creation_dispatcher> make_shared_payload_dispatcher (
+            Transaction & transaction, std::shared_ptr<index::payload_index> const & index,
+            section_kind const kind, section_content const * const content,
+            std::size_t const threshold) {
+            auto const & data = content->data;
+            if (data.size () < threshold ||
+                transaction.db ().minor_version () < header::shared_payload_version) {
+                return std::make_unique<generic_section_creation_dispatcher> (kind, content);
+            }
+            return std::make_unique<generic_section_creation_dispatcher> (
+                kind, content, intern_payload (transaction, index, gsl::make_span (data)));
+        }
+
+    } // end namespace repo
+} // end namespace pstore
+
+#endif // PSTORE_MCREPO_SHARED_PAYLOAD_HPP
@@ -58,6 +58,7 @@
 #include <cstdint>
 #include <iosfwd>
 #include <memory>
+#include <utility>
 
 #include "pstore/os/file.hpp"
 
@@ -96,6 +97,17 @@ namespace pstore {
     };
 
 
+    /// Describes the manner in which a range of memory-mapped addresses is expected to be accessed.
+    /// This information is passed to the operating system as a hint: it may be used to tune the
+    /// read-ahead and caching of the underlying file but never changes the program's behavior.
+    enum class access_pattern {
+        normal,     ///< No special treatment. This is the initial state of every mapping.
+        sequential, ///< Pages will be accessed in order: read ahead aggressively.
+        random,     ///< Pages will be accessed in random order: read-ahead is wasted.
+        willneed,   ///< The pages will be needed soon: start reading them in now.
+        hugepage,   ///< Back the range with huge pages if the host supports them.
+    };
+
     class memory_mapper_base {
     public:
         virtual ~memory_mapper_base () = 0;
@@ -112,6 +124,14 @@ namespace pstore {
         std::shared_ptr<void const> data () const { return ptr_; }
         //@}
 
+        /// Returns true if the region's memory is mapped. This is false only for regions whose
+        /// mapping has been deferred until first use.
+        bool is_mapped () const noexcept { return ptr_ != nullptr; }
+
+        /// Ensures that the region's memory is mapped. Regions are normally mapped when they are
+        /// constructed, in which case this function does nothing.
+        virtual void map ();
+
         /// \brief Returns true if the memory is to be writable.
         /// \note The operating system may separately protect memory pages, so it's perfectly likely
         /// that a memory page may be read-only even if this method returns true.
@@ -140,6 +160,19 @@ namespace pstore {
         /// \note The function is virtual for mocking.
         virtual void read_only (void * addr, std::size_t len);
 
+        /// \brief Advises the operating system of the expected access pattern for the range of
+        /// addresses given by addr and len.
+        ///
+        /// This function validates the input parameters before calling advise_impl() which is
+        /// responsible for calling the real OS API. The range is extended to page boundaries as
+        /// necessary. Requests for huge pages are silently ignored where they are not supported.
+        ///
+        /// \param addr  A pointer to the first byte of the range to which the advice applies.
+        /// \param len   The size of the range to which the advice applies.
+        /// \param pattern  The expected access pattern.
+        /// \note The function is virtual for mocking.
+        virtual void advise (void * addr, std::size_t len, access_pattern pattern);
+
     protected:
         /// \param ptr          A pointer to the mapped memory.
         /// \param is_writable  If the mapped memory  writeable? If true, then the underlying file,
@@ -153,6 +186,9 @@ namespace pstore {
                 , offset_{offset}
                 , size_{size} {}
 
+        /// Records the address of the mapped memory for a region whose mapping was deferred.
+        void set_data (std::shared_ptr<void> ptr) noexcept { ptr_ = std::move (ptr); }
+
     private:
         /// \brief Marks the range of addresses given by addr and len as read-only.
         ///
@@ -164,6 +200,13 @@ namespace pstore {
         ///       automatically gains the behavior.
         void read_only_impl (void * addr, std::size_t len);
 
+        /// \brief Passes the access pattern for the range of addresses given by addr and len to
+        /// the host OS.
+        ///
+        /// \note This method is implemented directly in the base class in order that each subclass
+        ///       automatically gains the behavior.
+        void advise_impl (void * addr, std::size_t len, access_pattern pattern);
+
         /// A pointer to the mapped memory.
         std::shared_ptr<void> ptr_;
         /// True if the underlying memory is writable.
@@ -128,12 +128,29 @@ namespace pstore {
 
 
 namespace pstore {
+    /// Specifies whether a shared memory object's name is removed when a shared_memory instance
+    /// which refers to it is destroyed.
+    enum class shared_memory_unlink {
+        on_close, ///< The name is removed: later openers will create a new object.
+        never,    ///< The name is left in place so that other processes can continue to open it.
+    };
+
+    /// Specifies whether a shared_memory instance creates its shared memory object if it does not
+    /// already exist.
+    enum class shared_memory_create {
+        if_missing, ///< The object is created if necessary.
+        never,      ///< A missing object is not created: the instance is empty and get() returns
+                    ///< nullptr.
+    };
+
     /// \brief Opens a shared memory object containing type Ty with the given name.
     template <typename Ty>
     class shared_memory {
     public:
         shared_memory ();
-        explicit shared_memory (std::string const & name);
+        explicit shared_memory (std::string const & name,
+                                shared_memory_unlink unlink = shared_memory_unlink::on_close,
+                                shared_memory_create create = shared_memory_create::if_missing);
         shared_memory (shared_memory const &) = delete;
         shared_memory (shared_memory && rhs) noexcept;
 
@@ -214,14 +231,16 @@ namespace pstore {
 
         class file_mapping {
         public:
-            explicit file_mapping (gsl::czstring const name)
-                    : descriptor_ (open (name)) {}
+            file_mapping (gsl::czstring const name, shared_memory_create const create)
+                    : descriptor_ (open (name, create)) {}
             ~file_mapping () noexcept;
             void set_size ();
             os_file_handle get () { return descriptor_; }
+            /// Returns false if the object did not exist and was not created.
+            bool valid () const noexcept;
 
         private:
-            static os_file_handle open (gsl::czstring name);
+            static os_file_handle open (gsl::czstring name, shared_memory_create create);
             os_file_handle descriptor_;
         };
 
@@ -247,6 +266,7 @@ namespace pstore {
             std::string name_;
         };
         shm_name name_;
+        shared_memory_unlink unlink_ = shared_memory_unlink::on_close;
         pointer_type ptr_;
     };
 
@@ -303,11 +323,19 @@ namespace pstore {
             , ptr_ (nullptr, &unmap) {}
 
     template <typename Ty>
-    shared_memory<Ty>::shared_memory (std::string const & name)
+    shared_memory<Ty>::shared_memory (std::string const & name, shared_memory_unlink const unlink,
+                                      shared_memory_create const create)
             : name_ (name)
+            , unlink_ (unlink)
             , ptr_ (nullptr, &unmap) {
 
-        file_mapping mapping (name_.c_str ());
+        file_mapping mapping (name_.c_str (), create);
+        if (!mapping.valid ()) {
+            // The object does not exist and we were asked not to create it. Forget the name so
+            // that the destructor does not remove an object created later by someone else.
+            name_ = shm_name ();
+            return;
+        }
         ptr_ = mmap (mapping.get ());
 
         // The initialization of 'contents' is guarded by a simple atomic spin-lock mutex. We MUST
@@ -326,6 +354,7 @@ namespace pstore {
     template <typename Ty>
     shared_memory<Ty>::shared_memory (shared_memory && rhs) noexcept
             : name_ (std::move (rhs.name_))
+            , unlink_ (rhs.unlink_)
             , ptr_ (std::move (rhs.ptr_)) {}
 
     // (dtor)
@@ -333,7 +362,7 @@ namespace pstore {
     template <typename Ty>
     shared_memory<Ty>::~shared_memory () {
 #ifndef _WIN32
-        if (!name_.empty ()) {
+        if (!name_.empty () && unlink_ == shared_memory_unlink::on_close) {
             ::shm_unlink (name_.c_str ());
         }
 #endif
@@ -345,6 +374,7 @@ namespace pstore {
     auto shared_memory<Ty>::operator= (shared_memory && rhs) noexcept -> shared_memory & {
         if (this != &rhs) {
             name_ = std::move (rhs.name_);
+            unlink_ = rhs.unlink_;
             ptr_ = std::move (rhs.ptr_);
         }
         return *this;
@@ -369,7 +399,7 @@ namespace pstore {
         auto mapped_ptr = static_cast<value_type *> (::MapViewOfFile (map_file, FILE_MAP_ALL_ACCESS,
                                                                       0, // file offset (high)
                                                                       0, // file offset (low)
-                                                                      sizeof (Ty)));
+                                                                      sizeof (value_type)));
         if (mapped_ptr == nullptr) {
             auto const error = ::GetLastError ();
             raise (win32_erc (error), "MapViewOfFile");
@@ -383,7 +413,7 @@ namespace pstore {
     // ~~~~~
     template <typename Ty>
     void shared_memory<Ty>::unmap (value_type * const p) {
-        if (::munmap (p, sizeof (Ty)) == -1) {
+        if (::munmap (p, sizeof (value_type)) == -1) {
             raise (errno_erc{errno}, "munmap");
         }
     }
@@ -392,9 +422,10 @@ namespace pstore {
     // ~~~~
     template <typename Ty>
     auto shared_memory<Ty>::mmap (os_file_handle const fd) -> pointer_type {
-        auto ptr = static_cast<value_type *> (
-            ::mmap (nullptr, sizeof (Ty), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)); // NOLINT
-        if (ptr == MAP_FAILED) {                                                       // NOLINT
+        auto ptr = static_cast<value_type *> (::mmap (nullptr, sizeof (value_type),
+                                                      PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                                                      0)); // NOLINT
+        if (ptr == MAP_FAILED) {                           // NOLINT
             raise (errno_erc{errno}, "mmap");
         }
         return {ptr, &unmap};
@@ -413,21 +444,40 @@ namespace pstore {
     // ~~~~~~
     template <typename Ty>
     shared_memory<Ty>::file_mapping::~file_mapping () noexcept {
-        ::CloseHandle (descriptor_);
-        descriptor_ = nullptr;
+        if (descriptor_ != nullptr) {
+            ::CloseHandle (descriptor_);
+            descriptor_ = nullptr;
+        }
+    }
+
+    // valid
+    // ~~~~~
+    template <typename Ty>
+    bool shared_memory<Ty>::file_mapping::valid () const noexcept {
+        return descriptor_ != nullptr;
     }
 
     // open
     // ~~~~
     template <typename Ty>
-    auto shared_memory<Ty>::file_mapping::open (gsl::czstring const name) -> os_file_handle {
-
+    auto shared_memory<Ty>::file_mapping::open (gsl::czstring const name,
+                                                shared_memory_create const create)
+        -> os_file_handle {
+
+        if (create == shared_memory_create::never) {
+            HANDLE const existing = ::OpenFileMappingW (FILE_MAP_ALL_ACCESS, FALSE,
+                                                        utf::win32::to16 (name).c_str ());
+            if (existing == nullptr && ::GetLastError () != ERROR_FILE_NOT_FOUND) {
+                raise (win32_erc (::GetLastError ()), "OpenFileMapping");
+            }
+            return existing;
+        }
         HANDLE map_file = ::CreateFileMappingW (
             INVALID_HANDLE_VALUE,              // use paging file
             nullptr,                           // default security
             PAGE_READWRITE,                    // read/write access
-            uint64_high4 (sizeof (Ty)),        // maximum object size (high-order DWORD)
-            uint64_low4 (sizeof (Ty)),         // maximum object size (low-order DWORD)
+            uint64_high4 (sizeof (value_type)), // maximum object size (high-order DWORD)
+            uint64_low4 (sizeof (value_type)),  // maximum object size (low-order DWORD)
             utf::win32::to16 (name).c_str ()); // name of mapping object
         if (map_file == nullptr) {
             std::ostringstream str;
@@ -444,17 +494,35 @@ char const * n = "hello";
     // ~~~~~~
     template <typename Ty>
     shared_memory<Ty>::file_mapping::~file_mapping () noexcept {
-        ::close (descriptor_);
-        descriptor_ = -1;
+        if (descriptor_ != -1) {
+            ::close (descriptor_);
+            descriptor_ = -1;
+        }
+    }
+
+    // valid
+    // ~~~~~
+    template <typename Ty>
+    bool shared_memory<Ty>::file_mapping::valid () const noexcept {
+        return descriptor_ != -1;
     }
 
     // open
     // ~~~~
     template <typename Ty>
-    auto shared_memory<Ty>::file_mapping::open (gsl::czstring const name) -> os_file_handle {
-        int const fd = ::shm_open (name, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR); // NOLINT
+    auto shared_memory<Ty>::file_mapping::open (gsl::czstring const name,
+                                                shared_memory_create const create)
+        -> os_file_handle {
+        int oflag = O_RDWR; // NOLINT
+        if (create == shared_memory_create::if_missing) {
+            oflag |= O_CREAT; // NOLINT
+        }
+        int const fd = ::shm_open (name, oflag, S_IRUSR | S_IWUSR); // NOLINT
         if (fd == -1) {
             int const error = errno;
+            if (error == ENOENT && create == shared_memory_create::never) {
+                return -1;
+            }
             if (error == ENAMETOOLONG) {
                 std::ostringstream str;
                 str << "shared memory object name (" << name << ") is too long";
@@ -464,14 +532,14 @@ char const * n = "hello";
             }
         }
 
-        // If the shared memory object doesn't have room for at least sizeof(Ty) bytes,
+        // If the shared memory object doesn't have room for at least sizeof(value_type) bytes,
         // then we need to grow it before the memory map operation.
         struct stat st;
         if (::fstat (fd, &st) == -1) {
             raise (errno_erc{errno}, "fstat");
         }
-        if (st.st_size < static_cast<off_t> (sizeof (Ty))) {
-            if (::ftruncate (fd, sizeof (Ty)) == -1) {
+        if (st.st_size < static_cast<off_t> (sizeof (value_type))) {
+            if (::ftruncate (fd, sizeof (value_type)) == -1) {
                 raise (errno_erc{errno}, "ftruncate");
             }
         }
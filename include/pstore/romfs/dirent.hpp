@@ -82,11 +82,18 @@ namespace pstore {
 
         class dirent {
         public:
+            /// \param name  The file's name.
+            /// \param contents  The file's contents.
+            /// \param s  The file's size, modification time, and mode.
+            /// \param header  An optional, precomputed, HTTP response header for the file (less
+            ///   its Date field and terminating blank line) or nullptr.
             constexpr dirent (gsl::czstring const PSTORE_NONNULL name,
-                              void const * const PSTORE_NONNULL contents, stat const s) noexcept
+                              void const * const PSTORE_NONNULL contents, stat const s,
+                              gsl::czstring const PSTORE_NULLABLE header = nullptr) noexcept
                     : name_{name}
                     , contents_{contents}
-                    , stat_{s} {}
+                    , stat_{s}
+                    , header_{header} {}
             constexpr dirent (gsl::czstring const PSTORE_NONNULL name,
                               directory const * const PSTORE_NONNULL dir) noexcept
                     : name_{name}
@@ -95,6 +102,8 @@ namespace pstore {
 
             constexpr gsl::czstring PSTORE_NONNULL name () const noexcept { return name_; }
             constexpr void const * PSTORE_NONNULL contents () const noexcept { return contents_; }
+            /// Returns the file's precomputed HTTP response header or nullptr if there is none.
+            constexpr gsl::czstring PSTORE_NULLABLE header () const noexcept { return header_; }
 
             error_or<class directory const * PSTORE_NONNULL> opendir () const;
 
@@ -107,6 +116,7 @@ namespace pstore {
             gsl::czstring PSTORE_NONNULL name_;
             void const * PSTORE_NONNULL contents_;
             struct stat stat_;
+            gsl::czstring PSTORE_NULLABLE header_ = nullptr;
         };
 
     } // end namespace romfs
@@ -162,6 +162,10 @@ namespace pstore {
             error_or<descriptor> open (gsl::czstring PSTORE_NONNULL path) const;
             error_or<dirent_descriptor> opendir (gsl::czstring PSTORE_NONNULL path);
             error_or<struct stat> stat (gsl::czstring PSTORE_NONNULL path) const;
+            /// Returns the directory entry for \p path. Since the file system is read-only, the
+            /// entry and the file contents to which it refers remain valid for the lifetime of the
+            /// program.
+            error_or<dirent const * PSTORE_NONNULL> find (gsl::czstring PSTORE_NONNULL path) const;
 
             error_or<std::string> getcwd () const;
             std::error_code chdir (gsl::czstring PSTORE_NONNULL path);
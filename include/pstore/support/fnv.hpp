@@ -80,6 +80,18 @@ namespace pstore {
     std::uint64_t fnv_64a_buf (void const * buf, std::size_t len,
                                std::uint64_t hval = fnv1a_64_init) noexcept;
 
+    /// \brief Performs a 64 bit FNV-1a hash on each of a collection of buffers.
+    ///
+    /// The result is identical to calling fnv_64a_buf() with the default initial basis on each
+    /// buffer in turn, but the buffers are hashed several at a time so that the work can overlap.
+    ///
+    /// \param count  The number of buffers to be hashed.
+    /// \param bufs  An array of \p count pointers to the start of each buffer.
+    /// \param lens  An array of \p count buffer lengths in octets.
+    /// \param out  An array of \p count values which receive the hash of each buffer.
+    void fnv_64a_bufs (std::size_t count, void const * const * bufs, std::size_t const * lens,
+                       std::uint64_t * out) noexcept;
+
     /// \brief perform a 64 bit Fowler/Noll/Vo FNV-1a hash on a buffer
     /// \param str  Start of the NUL-terminated string to hash
     /// \param hval  Previous hash value
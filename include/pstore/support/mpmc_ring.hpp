@@ -0,0 +1,203 @@
+//*                                        _              *
+//*  _ __ ___  _ __  _ __ ___   ___   _ __(_)_ __   __ _  *
+//* | '_ ` _ \| '_ \| '_ ` _ \ / __| | '__| | '_ \ / _` | *
+//* | | | | | | |_) | | | | | | (__  | |  | | | | | (_| | *
+//* |_| |_| |_| .__/|_| |_| |_|\___| |_|  |_|_| |_|\__, | *
+//*           |_|                                  |___/  *
+//===- include/pstore/support/mpmc_ring.hpp -------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file mpmc_ring.hpp
+/// \brief A bounded, lock-free, multi-producer/multi-consumer queue.
+///
+/// The algorithm is Dmitry Vyukov's bounded MPMC queue. Each cell carries a sequence number which
+/// tells producers and consumers whether it is ready to be written or read. A push or pop is a
+/// single compare-and-swap of the shared position plus one release store to the cell.
+
+#ifndef PSTORE_SUPPORT_MPMC_RING_HPP
+#define PSTORE_SUPPORT_MPMC_RING_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "pstore/support/aligned.hpp"
+
+namespace pstore {
+
+    /// A bounded, lock-free queue which may be used by any number of producer and consumer threads.
+    /// try_push() and try_pop() never block; they fail if the ring is full or empty respectively.
+    ///
+    /// \tparam T  The type of the queued values. Must be default constructible and move
+    ///   assignable.
+    template <typename T>
+    class mpmc_ring {
+        static_assert (std::is_default_constructible<T>::value,
+                       "T must be default constructible");
+        static_assert (std::is_nothrow_move_assignable<T>::value,
+                       "T must be nothrow move assignable");
+
+    public:
+        /// \param capacity  The maximum number of values that the ring can hold. Must be a power
+        ///   of two.
+        explicit mpmc_ring (std::size_t capacity);
+        mpmc_ring (mpmc_ring const &) = delete;
+        mpmc_ring & operator= (mpmc_ring const &) = delete;
+
+        /// Appends \p value to the ring if there is space for it.
+        ///
+        /// \param value  The value to be appended. It is moved-from if and only if the push
+        ///   succeeds.
+        /// \returns True if the value was appended, false if the ring was full.
+        bool try_push (T && value) noexcept;
+
+        /// Removes the value at the front of the ring if there is one.
+        ///
+        /// \param value  On success, receives the removed value.
+        /// \returns True if a value was removed, false if the ring was empty.
+        bool try_pop (T & value) noexcept;
+
+        /// Returns the maximum number of values that the ring can hold.
+        std::size_t capacity () const noexcept { return mask_ + 1U; }
+
+        /// Returns an approximation of the number of values in the ring. The result may be stale
+        /// by the time the function returns if other threads are using the ring.
+        std::size_t size () const noexcept;
+
+    private:
+        struct cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        /// The producer and consumer positions are padded so that they lie on different cache
+        /// lines.
+        struct position {
+            static constexpr std::size_t cache_line_size = 64U;
+            std::atomic<std::size_t> pos{0U};
+            char padding[cache_line_size - sizeof (std::atomic<std::size_t>)];
+        };
+
+        std::size_t const mask_;
+        std::unique_ptr<cell[]> const cells_;
+        position push_;
+        position pop_;
+    };
+
+    // (ctor)
+    // ~~~~~~
+    template <typename T>
+    mpmc_ring<T>::mpmc_ring (std::size_t const capacity)
+            : mask_{capacity - 1U}
+            , cells_{new cell[capacity]} {
+        assert (capacity >= 2U && is_power_of_two (capacity));
+        for (std::size_t ctr = 0U; ctr < capacity; ++ctr) {
+            cells_[ctr].sequence.store (ctr, std::memory_order_relaxed);
+        }
+    }
+
+    // try_push
+    // ~~~~~~~~
+    template <typename T>
+    bool mpmc_ring<T>::try_push (T && value) noexcept {
+        std::size_t pos = push_.pos.load (std::memory_order_relaxed);
+        for (;;) {
+            cell & c = cells_[pos & mask_];
+            std::size_t const seq = c.sequence.load (std::memory_order_acquire);
+            auto const diff = static_cast<std::intptr_t> (seq) - static_cast<std::intptr_t> (pos);
+            if (diff == 0) {
+                // The cell is free. Claim it by advancing the push position.
+                if (push_.pos.compare_exchange_weak (pos, pos + 1U, std::memory_order_relaxed)) {
+                    c.value = std::move (value);
+                    c.sequence.store (pos + 1U, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The cell still holds a value from the previous lap: the ring is full.
+                return false;
+            } else {
+                // Another producer claimed this position. Try again from the current one.
+                pos = push_.pos.load (std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // try_pop
+    // ~~~~~~~
+    template <typename T>
+    bool mpmc_ring<T>::try_pop (T & value) noexcept {
+        std::size_t pos = pop_.pos.load (std::memory_order_relaxed);
+        for (;;) {
+            cell & c = cells_[pos & mask_];
+            std::size_t const seq = c.sequence.load (std::memory_order_acquire);
+            auto const diff =
+                static_cast<std::intptr_t> (seq) - static_cast<std::intptr_t> (pos + 1U);
+            if (diff == 0) {
+                // The cell holds a value. Claim it by advancing the pop position.
+                if (pop_.pos.compare_exchange_weak (pos, pos + 1U, std::memory_order_relaxed)) {
+                    value = std::move (c.value);
+                    c.value = T{};
+                    // Mark the cell as free for the producers' next lap.
+                    c.sequence.store (pos + mask_ + 1U, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The cell has not yet been written: the ring is empty.
+                return false;
+            } else {
+                // Another consumer claimed this position. Try again from the current one.
+                pos = pop_.pos.load (std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // size
+    // ~~~~
+    template <typename T>
+    std::size_t mpmc_ring<T>::size () const noexcept {
+        std::size_t const pop = pop_.pos.load (std::memory_order_relaxed);
+        std::size_t const push = push_.pos.load (std::memory_order_relaxed);
+        return push >= pop ? push - pop : 0U;
+    }
+
+} // end namespace pstore
+
+#endif // PSTORE_SUPPORT_MPMC_RING_HPP
@@ -41,79 +41,132 @@
 // TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
 // SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
 //===----------------------------------------------------------------------===//
+/// \file parallel_for_each.hpp
+/// \brief Loops whose iterations are shared between the calling thread and the workers of the
+/// process-wide thread pool.
+///
+/// The input range is divided into a number of chunks several times greater than the number of
+/// threads. Threads claim chunks one at a time so that the work is balanced dynamically: a thread
+/// which draws cheap elements simply goes on to claim more of them.
 
 #ifndef PSTORE_CMD_UTIL_PARALLEL_FOR_EACH_HPP
 #define PSTORE_CMD_UTIL_PARALLEL_FOR_EACH_HPP
 
 #include <algorithm>
 #include <cassert>
-#include <future>
+#include <cstddef>
 #include <iterator>
+#include <numeric>
+#include <utility>
 #include <vector>
 
 // To ensure that min and max are not macros on Windows.
 #include "pstore/support/portab.hpp"
+#include "pstore/support/thread_pool.hpp"
 
 namespace pstore {
     namespace cmd_util {
 
-        template <typename InputIt, typename UnaryFunction>
-        void parallel_for_each (InputIt first, InputIt last, UnaryFunction fn) {
-            auto it_distance = std::distance (first, last);
-            if (it_distance <= 0) {
-                return;
+        namespace details {
+
+            /// The number of chunks into which a range is divided for each thread that may work on
+            /// it. More chunks give better balance at the cost of more frequent synchronization.
+            constexpr std::size_t chunks_per_thread = 8U;
+
+            // chunk_bounds
+            // ~~~~~~~~~~~~
+            /// Divides the range [first, last) into chunks of roughly equal numbers of elements.
+            ///
+            /// \returns An iterator to the start of each chunk followed by \p last. Empty if the
+            ///   range is empty.
+            template <typename ForwardIt>
+            std::vector<ForwardIt> chunk_bounds (ForwardIt first, ForwardIt const last,
+                                                 unsigned const concurrency) {
+                std::vector<ForwardIt> bounds;
+                auto const it_distance = std::distance (first, last);
+                if (it_distance <= 0) {
+                    return bounds;
+                }
+                using difference_type =
+                    typename std::iterator_traits<ForwardIt>::difference_type;
+                auto const num_elements = static_cast<std::size_t> (it_distance);
+                std::size_t const max_chunks =
+                    std::min (num_elements, std::size_t{concurrency} * chunks_per_thread);
+                std::size_t const chunk_size = (num_elements + max_chunks - 1U) / max_chunks;
+
+                bounds.reserve ((num_elements + chunk_size - 1U) / chunk_size + 1U);
+                for (std::size_t remaining = num_elements; remaining > 0U;) {
+                    bounds.push_back (first);
+                    std::size_t const distance = std::min (chunk_size, remaining);
+                    std::advance (first, static_cast<difference_type> (distance));
+                    remaining -= distance;
+                }
+                bounds.push_back (first);
+                assert (first == last);
+                return bounds;
             }
 
-            using difference_type = typename std::iterator_traits<InputIt>::difference_type;
-            using udifference_type = typename std::make_unsigned<difference_type>::type;
-            using wide_type =
-                typename std::conditional<sizeof (udifference_type) >= sizeof (unsigned int),
-                                          udifference_type, unsigned int>::type;
-            auto num_elements = static_cast<wide_type> (it_distance);
-
-            auto const num_threads = std::min (
-                static_cast<wide_type> (std::max (std::thread::hardware_concurrency (), 1U)),
-                num_elements);
-
-            // The number of work items to be processed by each worker thread.
-            auto const partition_size = (num_elements + num_threads - 1) / num_threads;
-            assert (partition_size * num_threads >= num_elements);
-
-            // TODO: use small_vector<>.
-            std::vector<std::future<void>> futures;
-            futures.reserve (num_threads);
-
-            while (first != last) {
-                wide_type const distance = std::min (partition_size, num_elements);
-                auto next = first;
-                assert (distance >= 0 &&
-                        distance < static_cast<udifference_type> (
-                                       std::numeric_limits<difference_type>::max ()));
+        } // end namespace details
 
-                std::advance (next, static_cast<difference_type> (distance));
-                using value_type = typename std::iterator_traits<InputIt>::value_type;
-
-                // Create an asynchronous task which will sequentially process from 'first' to
-                // 'next' invoking f() for each data member.
-                auto per_thread_fn = [&fn](InputIt fst, InputIt lst) {
-                    std::for_each (fst, lst, [&fn](value_type const & v) { fn (v); });
-                };
-                futures.emplace_back (std::async (std::launch::async, per_thread_fn, first, next));
-
-                first = next;
-                assert (num_elements >= distance);
-                num_elements -= distance;
+        // parallel_for_each
+        // ~~~~~~~~~~~~~~~~~
+        /// Calls \p fn for each element of the range [first, last). The calls are made
+        /// concurrently and in no particular order. If \p fn throws, the first exception is
+        /// propagated to the caller once the calls that are already underway have finished.
+        template <typename InputIt, typename UnaryFunction>
+        void parallel_for_each (InputIt first, InputIt last, UnaryFunction fn) {
+            using value_type = typename std::iterator_traits<InputIt>::value_type;
+            thread_pool & pool = thread_pool::get ();
+            std::vector<InputIt> const bounds =
+                details::chunk_bounds (first, last, pool.concurrency ());
+            if (bounds.empty ()) {
+                return;
             }
-            assert (num_elements == 0 && futures.size () <= num_threads);
+            pool.run_chunks (bounds.size () - 1U, [&bounds, &fn] (std::size_t const chunk) {
+                std::for_each (bounds[chunk], bounds[chunk + 1U],
+                               [&fn] (value_type const & v) { fn (v); });
+            });
+        }
 
-            // Join
-            for (auto & f : futures) {
-                assert (f.valid ());
-                // Note that future::get<> is normally used to retreive the future's result, but
-                // here I'm calling it to ensure that an exception stored in the future's state is
-                // raised.
-                f.get ();
+        // parallel_reduce
+        // ~~~~~~~~~~~~~~~
+        /// Applies \p map to each element of the range [first, last) and combines the results
+        /// using \p reduce. Each chunk of the range is reduced separately and concurrently; the
+        /// per-chunk results are then combined in order so that \p reduce must be associative but
+        /// need not be commutative.
+        ///
+        /// \param first  The start of the range of elements to be reduced.
+        /// \param last  The end of the range of elements to be reduced.
+        /// \param identity  The identity value of \p reduce. It is the result if the range is
+        ///   empty.
+        /// \param reduce  A binary function with the signature T(T, T).
+        /// \param map  A unary function which converts an element of the range to T.
+        template <typename InputIt, typename T, typename ReduceFunction, typename MapFunction>
+        T parallel_reduce (InputIt first, InputIt last, T identity, ReduceFunction reduce,
+                           MapFunction map) {
+            thread_pool & pool = thread_pool::get ();
+            std::vector<InputIt> const bounds =
+                details::chunk_bounds (first, last, pool.concurrency ());
+            if (bounds.empty ()) {
+                return identity;
             }
+            // Each chunk's result is wrapped so that the elements of 'partial' are distinct
+            // objects even if T is bool.
+            struct result {
+                T value;
+            };
+            std::vector<result> partial (bounds.size () - 1U, result{identity});
+            pool.run_chunks (partial.size (), [&] (std::size_t const chunk) {
+                T acc = identity;
+                for (auto it = bounds[chunk]; it != bounds[chunk + 1U]; ++it) {
+                    acc = reduce (std::move (acc), map (*it));
+                }
+                partial[chunk].value = std::move (acc);
+            });
+            return std::accumulate (std::begin (partial), std::end (partial), std::move (identity),
+                                    [&reduce] (T acc, result & r) {
+                                        return reduce (std::move (acc), std::move (r.value));
+                                    });
         }
 
     } // namespace cmd_util
@@ -46,15 +46,23 @@
 /// This module provides a means for one part of a program to "publish" information to which other
 /// parts can subscribe. There can be multiple "channels" of information representing different
 /// groups of data.
+///
+/// Each published message is allocated once and shared, immutable, by all of the subscribers to
+/// its channel. A channel retains a bounded ring of recent messages and each subscriber records
+/// only its position in that ring: a subscriber which falls so far behind that the messages it
+/// has yet to receive are overwritten skips them.
 #ifndef PSTORE_SUPPORT_PUBSUB_HPP
 #define PSTORE_SUPPORT_PUBSUB_HPP
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "pstore/support/gsl.hpp"
 #include "pstore/support/maybe.hpp"
@@ -64,6 +72,9 @@ namespace pstore {
     template <typename ConditionVariable>
     class channel;
 
+    /// A published message. The string is shared by all of the channel's subscribers.
+    using message_pointer = std::shared_ptr<std::string const>;
+
     //*          _               _ _              *
     //*  ____  _| |__ ___ __ _ _(_) |__  ___ _ _  *
     //* (_-< || | '_ (_-</ _| '_| | '_ \/ -_) '_| *
@@ -89,7 +100,7 @@ namespace pstore {
         ///
         /// \returns A maybe holding a message published to the owning channel or with no value
         /// indicating that the subscription has been cancelled.
-        maybe<std::string> listen ();
+        maybe<message_pointer> listen ();
 
         /// Cancels a subscription.
         ///
@@ -102,23 +113,25 @@ namespace pstore {
         channel<ConditionVariable> const & owner () const noexcept { return *owner_; }
 
         /// Removes a single message from the subscription queue if available.
-        maybe<std::string> pop ();
+        maybe<message_pointer> pop ();
 
-    private:
-        explicit subscriber (gsl::not_null<channel<ConditionVariable> *> c) noexcept
-                : owner_{c} {}
+        /// \returns The number of messages which this subscriber has missed because they were
+        /// overwritten in the channel's ring before they were received.
+        std::uint64_t dropped () const;
 
-        /// The queue of published messages waiting to be delivered to a listening subscriber.
-        ///
-        /// \note This is a queue of strings. If there are multiple subscribers to this channel then
-        /// the strings will be duplicated in each which could be very inefficient. An alternative
-        /// would be to store shared_ptr<string>. For the moment I'm leaving it like this on the
-        /// assumption that there will typically be just a single subscriber.
-        std::queue<std::string> queue_;
+    private:
+        subscriber (gsl::not_null<channel<ConditionVariable> *> c, std::uint64_t next) noexcept
+                : owner_{c}
+                , next_{next} {}
 
         /// The channel with which this subscription is associated.
         channel<ConditionVariable> * const owner_;
 
+        /// The sequence number of the next message to be delivered to this subscriber.
+        std::uint64_t next_;
+        /// The number of messages that were overwritten before they could be delivered.
+        std::uint64_t dropped_ = 0;
+
         /// Should this subscriber continue to listen to messages?
         bool active_ = true;
     };
@@ -138,7 +151,15 @@ namespace pstore {
         using subscriber_type = subscriber<ConditionVariable>;
         using subscriber_pointer = std::unique_ptr<subscriber_type>;
 
-        explicit channel (gsl::not_null<ConditionVariable *> cv);
+        /// The default number of messages retained for subscribers.
+        static constexpr std::size_t default_capacity = 64U;
+
+        /// \param cv  The condition variable which is notified when a message is published.
+        /// \param capacity  The number of messages retained for subscribers which have not yet
+        ///   received them. A capacity of 1 coalesces messages: a subscriber receives only the
+        ///   most recent which is appropriate when each message supersedes its predecessors.
+        explicit channel (gsl::not_null<ConditionVariable *> cv,
+                          std::size_t capacity = default_capacity);
         ~channel () noexcept;
 
         // No copying or assignment.
@@ -172,7 +193,9 @@ namespace pstore {
         subscriber_pointer new_subscriber ();
 
     private:
-        maybe<std::string> listen (subscriber_type & sub);
+        maybe<message_pointer> listen (subscriber_type & sub);
+        /// Removes the next message for \p sub from the ring. mut_ must be held.
+        maybe<message_pointer> pop (subscriber_type & sub);
 
         /// Cancels a subscription.
         ///
@@ -187,6 +210,12 @@ namespace pstore {
 
         /// All of the subscribers to this channel.
         std::unordered_set<subscriber_type *> subscribers_;
+
+        /// The most recently published messages. The message with sequence number n is at index
+        /// n % ring_.size().
+        std::vector<message_pointer> ring_;
+        /// The sequence number of the next message to be published.
+        std::uint64_t head_ = 0;
     };
 
 
@@ -213,21 +242,24 @@ namespace pstore {
     // listen
     // ~~~~~~
     template <typename ConditionVariable>
-    inline maybe<std::string> subscriber<ConditionVariable>::listen () {
+    inline maybe<message_pointer> subscriber<ConditionVariable>::listen () {
         return owner_->listen (*this);
     }
 
     // pop
     // ~~~
     template <typename ConditionVariable>
-    maybe<std::string> subscriber<ConditionVariable>::pop () {
-        std::unique_lock<std::mutex> const lock{this->owner ().mut_};
-        if (queue_.size () == 0) {
-            return {};
-        }
-        std::string const message = std::move (queue_.front ());
-        queue_.pop ();
-        return just (message);
+    maybe<message_pointer> subscriber<ConditionVariable>::pop () {
+        std::lock_guard<std::mutex> const lock{this->owner ().mut_};
+        return this->owner ().pop (*this);
+    }
+
+    // dropped
+    // ~~~~~~~
+    template <typename ConditionVariable>
+    std::uint64_t subscriber<ConditionVariable>::dropped () const {
+        std::lock_guard<std::mutex> const lock{this->owner ().mut_};
+        return dropped_;
     }
 
     //*     _                       _  *
@@ -239,8 +271,13 @@ namespace pstore {
     // ctor
     // ~~~~
     template <typename ConditionVariable>
-    channel<ConditionVariable>::channel (gsl::not_null<ConditionVariable *> cv)
-            : cv_{cv} {}
+    channel<ConditionVariable>::channel (gsl::not_null<ConditionVariable *> cv,
+                                         std::size_t const capacity)
+            : cv_{cv}
+            , ring_ (std::max (capacity, std::size_t{1})) {}
+
+    template <typename ConditionVariable>
+    constexpr std::size_t channel<ConditionVariable>::default_capacity;
 
     // dtor
     // ~~~~
@@ -271,12 +308,12 @@ namespace pstore {
         }
         if (render) {
             // Note that f() is called without the lock held.
-            std::string const message = f (std::forward<Args> (args)...);
+            auto message = std::make_shared<std::string const> (f (std::forward<Args> (args)...));
 
             std::lock_guard<std::mutex> const lock{mut_};
-            for (auto & sub : subscribers_) {
-                sub->queue_.push (message);
-            }
+            // Overwriting the oldest message releases it if no subscriber still holds it.
+            ring_[static_cast<std::size_t> (head_ % ring_.size ())] = std::move (message);
+            ++head_;
             cv_->notify_all ();
         }
     }
@@ -295,18 +332,35 @@ namespace pstore {
     // listen
     // ~~~~~~
     template <typename ConditionVariable>
-    maybe<std::string> channel<ConditionVariable>::listen (subscriber_type & sub) {
+    maybe<message_pointer> channel<ConditionVariable>::listen (subscriber_type & sub) {
         std::unique_lock<std::mutex> lock{mut_};
         while (sub.active_) {
-            if (sub.queue_.size () == 0) {
-                cv_->wait (lock);
-            } else {
-                std::string const message = std::move (sub.queue_.front ());
-                sub.queue_.pop ();
-                return just (message);
+            if (maybe<message_pointer> message = this->pop (sub)) {
+                return message;
             }
+            cv_->wait (lock);
+        }
+        return nothing<message_pointer> ();
+    }
+
+    // pop
+    // ~~~
+    template <typename ConditionVariable>
+    maybe<message_pointer> channel<ConditionVariable>::pop (subscriber_type & sub) {
+        if (sub.next_ == head_) {
+            return nothing<message_pointer> ();
+        }
+        // If the subscriber has fallen behind by more than the capacity of the ring, skip the
+        // messages that have been overwritten.
+        std::uint64_t const capacity = ring_.size ();
+        if (head_ - sub.next_ > capacity) {
+            std::uint64_t const oldest = head_ - capacity;
+            sub.dropped_ += oldest - sub.next_;
+            sub.next_ = oldest;
         }
-        return nothing<std::string> ();
+        message_pointer const & message = ring_[static_cast<std::size_t> (sub.next_ % capacity)];
+        ++sub.next_;
+        return just (message);
     }
 
     // new_subscriber
@@ -314,7 +368,8 @@ namespace pstore {
     template <typename ConditionVariable>
     auto channel<ConditionVariable>::new_subscriber () -> subscriber_pointer {
         std::lock_guard<std::mutex> const lock{mut_};
-        auto resl = subscriber_pointer{new subscriber_type (this)};
+        // A new subscriber receives only messages published after it subscribed.
+        auto resl = subscriber_pointer{new subscriber_type (this, head_)};
         subscribers_.insert (resl.get ());
         return resl;
     }
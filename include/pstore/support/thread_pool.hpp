@@ -0,0 +1,137 @@
+//*  _   _                        _                     _  *
+//* | |_| |__  _ __ ___  __ _  __| |  _ __   ___   ___ | | *
+//* | __| '_ \| '__/ _ \/ _` |/ _` | | '_ \ / _ \ / _ \| | *
+//* | |_| | | | | |  __/ (_| | (_| | | |_) | (_) | (_) | | *
+//*  \__|_| |_|_|  \___|\__,_|\__,_| | .__/ \___/ \___/|_| *
+//*                                  |_|                   *
+//===- include/pstore/support/thread_pool.hpp -----------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file thread_pool.hpp
+/// \brief A persistent, work-stealing pool of worker threads.
+///
+/// Each worker owns a queue of tasks. A worker takes tasks from the back of its own queue and,
+/// when that is empty, steals from the front of the other workers' queues. Tasks submitted by a
+/// thread which is not one of the pool's workers are distributed between the queues in turn.
+
+#ifndef PSTORE_SUPPORT_THREAD_POOL_HPP
+#define PSTORE_SUPPORT_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pstore {
+
+    class thread_pool {
+    public:
+        using task = std::function<void ()>;
+
+        /// \param num_workers  The number of worker threads to create. May be zero in which case
+        ///   all work is performed by the threads which submit it.
+        explicit thread_pool (unsigned num_workers);
+        thread_pool (thread_pool const &) = delete;
+        thread_pool & operator= (thread_pool const &) = delete;
+        /// Waits for the queued tasks to be run and then joins the worker threads.
+        ~thread_pool () noexcept;
+
+        /// Returns the process-wide pool. It is created on first use with one worker fewer than the
+        /// hardware's concurrency: the thread which submits work is expected to share in it.
+        static thread_pool & get ();
+
+        /// Returns the number of worker threads.
+        unsigned num_workers () const noexcept {
+            return static_cast<unsigned> (queues_.size ());
+        }
+
+        /// Returns the number of threads which may run work concurrently: the workers plus the
+        /// calling thread.
+        unsigned concurrency () const noexcept { return this->num_workers () + 1U; }
+
+        /// Queues a task to be run by one of the workers. If the calling thread is one of this
+        /// pool's workers, the task is added to its own queue. The task must not throw.
+        ///
+        /// \pre num_workers() > 0
+        void submit (task t);
+
+        /// Calls \p body once for each chunk number in the range [0, num_chunks). Chunks are
+        /// claimed one at a time by the calling thread and by as many workers as are free to help,
+        /// so that threads which draw short-running chunks go on to take more of them. Returns
+        /// once every chunk has been run.
+        ///
+        /// If \p body throws, no further chunks are started and the first exception is rethrown to
+        /// the caller once those already running have finished.
+        ///
+        /// \note This function may be called from within \p body: a nested call will be run by
+        ///   the calling worker if no other worker is free to help.
+        void run_chunks (std::size_t num_chunks, std::function<void (std::size_t)> const & body);
+
+    private:
+        struct queue {
+            std::mutex mut;
+            std::deque<task> tasks;
+        };
+
+        /// Removes a task from the queue numbered \p home or, if it is empty, steals one from
+        /// another queue.
+        bool try_pop (std::size_t home, task * const t);
+        void worker (std::size_t index);
+
+        std::vector<std::unique_ptr<queue>> queues_;
+
+        /// Guards pending_ and done_. Idle workers wait on cv_.
+        std::mutex mut_;
+        std::condition_variable cv_;
+        /// The number of tasks in the queues. This may briefly be negative if a task is taken
+        /// before the submitting thread has finished recording it.
+        std::ptrdiff_t pending_ = 0;
+        bool done_ = false;
+
+        /// The next queue to receive a task submitted from outside the pool.
+        std::atomic<std::size_t> next_queue_{0U};
+        std::vector<std::thread> threads_;
+    };
+
+} // end namespace pstore
+
+#endif // PSTORE_SUPPORT_THREAD_POOL_HPP
@@ -0,0 +1,155 @@
+//*            _ _           _              *
+//*   ___ ___ | | | ___  ___| |_ ___  _ __  *
+//*  / __/ _ \| | |/ _ \/ __| __/ _ \| '__| *
+//* | (_| (_) | | |  __/ (__| || (_) | |    *
+//*  \___\___/|_|_|\___|\___|\__\___/|_|    *
+//*                                         *
+//===- include/pstore/vacuum/collector.hpp --------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file collector.hpp
+/// \brief Incrementally copies the live contents of a store into a compacted replacement.
+
+#ifndef PSTORE_VACUUM_COLLECTOR_HPP
+#define PSTORE_VACUUM_COLLECTOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "pstore/core/address.hpp"
+#include "pstore/core/index_types.hpp"
+
+namespace pstore {
+    class database;
+    class indirect_string;
+    namespace repo {
+        class compilation;
+        struct compilation_member;
+        class fragment;
+    } // end namespace repo
+} // end namespace pstore
+
+namespace vacuum {
+
+    /// The collector copies the live contents of a source store into a destination store. Rather
+    /// than rebuilding the destination from scratch, it remembers the source revision that it last
+    /// collected; each pass copies only the index entries which were added or replaced since then.
+    ///
+    /// Compilations and fragments hold the store addresses of names, fragments, compilation
+    /// members, debug line headers, and shared section payloads. These are relocated into the
+    /// destination's address space as the records are copied.
+    class collector {
+    public:
+        /// A function which is polled periodically during a pass. If it returns true, the pass is
+        /// abandoned.
+        using cancel_predicate = std::function<bool ()>;
+
+        collector (pstore::database & source, pstore::database & destination);
+        collector (collector const &) = delete;
+        collector & operator= (collector const &) = delete;
+
+        /// Copies the index entries that were committed to the source store between the last
+        /// collected revision and the source's current revision. The data is committed to the
+        /// destination as a single transaction.
+        ///
+        /// \param cancel  Checked periodically. If it becomes true, the pass is abandoned and its
+        ///   transaction rolled back; the next pass starts from the same revision.
+        /// \returns True if the pass ran to completion, false if it was cancelled.
+        bool pass (std::atomic<bool> const & cancel);
+        /// \param cancelled  Polled before each record is copied. If it returns true, the pass is
+        ///   abandoned and its transaction rolled back; the next pass starts from the same
+        ///   revision.
+        /// \returns True if the pass ran to completion, false if it was cancelled.
+        bool pass (cancel_predicate const & cancelled);
+
+        /// Returns the source revision whose contents have been copied to the destination.
+        unsigned collected_revision () const noexcept { return collected_; }
+
+    private:
+        struct pass_state;
+
+        bool copy_names (pass_state & ps, cancel_predicate const & cancelled);
+        bool copy_write (pass_state & ps, cancel_predicate const & cancelled);
+        bool copy_debug_line_headers (pass_state & ps, cancel_predicate const & cancelled);
+        bool copy_fragments (pass_state & ps, cancel_predicate const & cancelled);
+        bool copy_compilations (pass_state & ps, cancel_predicate const & cancelled);
+        void patch_dependents (pass_state & ps);
+        /// Removes the relocation map entries which were added by an abandoned pass: the records
+        /// to which they refer were discarded when its transaction was rolled back.
+        void forget (pass_state const & ps) noexcept;
+
+        /// Returns the destination address of the name whose source address is \p addr, copying
+        /// the string if it has not been seen before.
+        pstore::typed_address<pstore::indirect_string>
+        relocate_name (pass_state & ps, pstore::typed_address<pstore::indirect_string> addr);
+        /// Returns the destination extent of a debug line header, copying its bytes if they have
+        /// not been seen before.
+        pstore::extent<std::uint8_t> relocate_debug_line_header (pass_state & ps,
+                                                                 pstore::extent<std::uint8_t> ext);
+        /// Returns the destination extent of a shared section payload, interning it in the
+        /// destination's payload index if it has not been seen before.
+        pstore::extent<std::uint8_t> relocate_payload (pass_state & ps,
+                                                       pstore::extent<std::uint8_t> ext);
+        /// Returns the destination extent of the fragment with the given digest.
+        pstore::extent<pstore::repo::fragment> relocate_fragment (pstore::index::digest digest);
+        /// Returns the destination address of a compilation member.
+        pstore::typed_address<pstore::repo::compilation_member>
+        relocate_member (pstore::typed_address<pstore::repo::compilation_member> addr) const;
+
+        pstore::database & source_;
+        pstore::database & destination_;
+        /// The source revision whose contents have been copied to the destination.
+        unsigned collected_ = 0;
+
+        /// Maps from the source address of a name to its address in the destination.
+        std::unordered_map<std::uint64_t, pstore::typed_address<pstore::indirect_string>> names_;
+        /// Maps from the source address of a debug line header to its destination extent.
+        std::unordered_map<std::uint64_t, pstore::extent<std::uint8_t>> debug_line_headers_;
+        /// Maps from the source address of a shared section payload to its destination extent.
+        std::unordered_map<std::uint64_t, pstore::extent<std::uint8_t>> payloads_;
+        /// Maps from the source address of a compilation to its destination address and size.
+        /// Ordered so that the compilation containing a member address can be found.
+        std::map<std::uint64_t, pstore::extent<pstore::repo::compilation>> compilations_;
+    };
+
+} // end namespace vacuum
+
+#endif // PSTORE_VACUUM_COLLECTOR_HPP
@@ -65,6 +65,7 @@
 #include "pstore/broker/quit.hpp"
 #include "pstore/broker/recorder.hpp"
 #include "pstore/broker_intf/fifo_path.hpp"
+#include "pstore/broker_intf/message_ring.hpp"
 #include "pstore/broker_intf/writer.hpp"
 #include "pstore/json/utility.hpp"
 #include "pstore/os/logging.hpp"
@@ -100,6 +101,12 @@ namespace pstore {
         descriptor_condition_variable commits_cv;
         channel<descriptor_condition_variable> commits_channel (&commits_cv);
 
+        descriptor_condition_variable queue_cv;
+        // Each status message supersedes its predecessor so subscribers need only the latest.
+        channel<descriptor_condition_variable> queue_channel (&queue_cv, 1U);
+
+        constexpr std::chrono::seconds command_processor::queue_status_interval;
+
         // ctor
         // ~~~~
         command_processor::command_processor (
@@ -172,6 +179,31 @@ namespace pstore {
         // ~~~
         void command_processor::nop (fifo_path const &, broker_command const &) {}
 
+        // ring
+        // ~~~~
+        void command_processor::ring (fifo_path const & fifo, broker_command const & c) {
+            message_ring * const r = ring_.load ();
+            if (r == nullptr) {
+                logging::log (logging::priority::error, "No message ring for doorbell: ",
+                              c.path.c_str ());
+                return;
+            }
+            maybe<message_ring::ticket> const t = parse_doorbell (c.path);
+            maybe<std::string> const message = t ? r->take (*t) : nothing<std::string> ();
+            if (!message) {
+                logging::log (logging::priority::error, "Stale or malformed doorbell: ",
+                              c.path.c_str ());
+                return;
+            }
+            broker_command const command = parse_command (*message);
+            // A doorbell must not refer to another doorbell.
+            if (command.verb == message_ring_doorbell_command) {
+                this->unknown (command);
+                return;
+            }
+            this->dispatch (fifo, command);
+        }
+
         // unknown
         // ~~~~~~~
         void command_processor::unknown (broker_command const & c) const {
@@ -204,7 +236,7 @@ namespace pstore {
             logging::log (logging::priority::info, str);
         }
 
-        std::array<command_processor::command_entry, 6> const command_processor::commands_{{
+        std::array<command_processor::command_entry, 7> const command_processor::commands_{{
             command_processor::command_entry ("ECHO", &command_processor::echo),
             command_processor::command_entry ("GC", &command_processor::gc),
             command_processor::command_entry ("NOP", &command_processor::nop),
@@ -218,6 +250,9 @@ namespace pstore {
             command_processor::command_entry (
                 read_loop_quit_command,
                 &command_processor::quit), //  shut down a single pipe-reader thread.
+            command_processor::command_entry (
+                message_ring_doorbell_command,
+                &command_processor::ring), // execute a command held in the message ring.
         }};
 
         // process_command
@@ -225,15 +260,21 @@ namespace pstore {
         void command_processor::process_command (fifo_path const & fifo, message_type const & msg) {
             auto const command = this->parse (msg);
             if (broker_command const * const c = command.get ()) {
-                this->log (*c);
-                auto const pos = std::lower_bound (std::begin (commands_), std::end (commands_),
-                                                   command_entry (c->verb.c_str (), nullptr),
-                                                   command_entry_compare);
-                if (pos != std::end (commands_) && c->verb == std::get<gsl::czstring> (*pos)) {
-                    std::get<handler> (*pos) (this, fifo, *c);
-                } else {
-                    this->unknown (*c);
-                }
+                this->dispatch (fifo, *c);
+            }
+        }
+
+        // dispatch
+        // ~~~~~~~~
+        void command_processor::dispatch (fifo_path const & fifo, broker_command const & c) {
+            this->log (c);
+            auto const pos = std::lower_bound (std::begin (commands_), std::end (commands_),
+                                               command_entry (c.verb.c_str (), nullptr),
+                                               command_entry_compare);
+            if (pos != std::end (commands_) && c.verb == std::get<gsl::czstring> (*pos)) {
+                std::get<handler> (*pos) (this, fifo, c);
+            } else {
+                this->unknown (c);
             }
         }
 
@@ -250,17 +291,27 @@ namespace pstore {
         void command_processor::thread_entry (fifo_path const & fifo) {
             try {
                 logging::log (logging::priority::info, "Waiting for commands");
+                auto last_status = std::chrono::steady_clock::now ();
                 while (!commands_done_) {
                     message_ptr msg = messages_.pop ();
                     assert (msg);
                     this->process_command (fifo, *msg);
                     pool.return_to_pool (std::move (msg));
+
+                    auto const now = std::chrono::steady_clock::now ();
+                    if (now - last_status >= queue_status_interval) {
+                        this->publish_queue_status ();
+                        last_status = now;
+                    }
                 }
             } catch (std::exception const & ex) {
                 logging::log (logging::priority::error, "An error occurred: ", ex.what ());
             } catch (...) {
                 logging::log (logging::priority::error, "Unknown error");
             }
+            // Nothing will drain the queue from now on: release any producers that are waiting for
+            // space in it.
+            messages_.close ();
             logging::log (logging::priority::info, "Exiting command thread");
         }
 
@@ -273,10 +324,32 @@ namespace pstore {
             messages_.push (std::move (cmd));
         }
 
+        // push_control_command
+        // ~~~~~~~~~~~~~~~~~~~~
+        void command_processor::push_control_command (message_ptr && cmd) {
+            messages_.push_control (std::move (cmd));
+        }
+
         // clear_queue
         // ~~~~~~~~~~~
         void command_processor::clear_queue () { messages_.clear (); }
 
+        // publish_queue_status
+        // ~~~~~~~~~~~~~~~~~~~~
+        void command_processor::publish_queue_status () const {
+            queue_channel.publish ([this]() {
+                message_queue_status const status = this->queue_status ();
+                std::ostringstream os;
+                os << "{ \"queue\": { \"size\": " << status.size
+                   << ", \"backpressure\": " << status.backpressure
+                   << ", \"wakeups\": " << status.wakeups
+                   << ", \"pool_misses\": " << pool.misses () << " } }";
+                std::string const & str = os.str ();
+                assert (json::is_valid (str));
+                return str;
+            });
+        }
+
         // scavenge
         // ~~~~~~~~
         void command_processor::scavenge () {
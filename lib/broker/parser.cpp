@@ -136,17 +136,19 @@ namespace pstore {
                     }
 
                     cmds.erase (it);
-
-                    auto end = std::end (complete_command);
-                    auto const verb_parts = extract_word (std::begin (complete_command), end);
-                    auto const path_parts = std::make_pair (skip_ws (verb_parts.second, end), end);
-                    return std::make_unique<broker_command> (substr (verb_parts),
-                                                             substr (path_parts));
+                    return std::make_unique<broker_command> (parse_command (complete_command));
                 }
             }
 
             return nullptr;
         }
 
+        broker_command parse_command (std::string const & complete_command) {
+            auto end = std::end (complete_command);
+            auto const verb_parts = extract_word (std::begin (complete_command), end);
+            auto const path_parts = std::make_pair (skip_ws (verb_parts.second, end), end);
+            return {substr (verb_parts), substr (path_parts)};
+        }
+
     } // end namespace broker
 } // end namespace pstore
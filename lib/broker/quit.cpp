@@ -85,7 +85,8 @@ namespace {
 
     // push
     // ~~~~
-    /// Push a simple message onto the command queue.
+    /// Push a simple control message onto the command queue. This must not block: shutdown may be
+    /// called by the command thread in response to a "SUICIDE" command.
     void push (pstore::broker::command_processor & cp, std::string const & message) {
         static std::atomic<std::uint32_t> mid{0};
 
@@ -95,7 +96,7 @@ namespace {
         assert (message.length () <= pstore::broker::message_type::payload_chars);
         auto msg = std::make_unique<pstore::broker::message_type> (mid++, std::uint16_t{0},
                                                                    std::uint16_t{1}, message);
-        cp.push_command (std::move (msg), nullptr);
+        cp.push_control_command (std::move (msg));
     }
 
 
@@ -54,7 +54,8 @@ namespace pstore {
     namespace broker {
 
         descriptor_condition_variable uptime_cv;
-        channel<descriptor_condition_variable> uptime_channel (&uptime_cv);
+        // Each tick supersedes its predecessor so subscribers need only the latest.
+        channel<descriptor_condition_variable> uptime_channel (&uptime_cv, 1U);
 
         void uptime (gsl::not_null<std::atomic<bool> *> const done) {
             log (logging::priority::info, "uptime 1 second tick starting");
@@ -0,0 +1,176 @@
+//*                                                  _              *
+//*  _ __ ___   ___  ___ ___  __ _  __ _  ___   _ __(_)_ __   __ _  *
+//* | '_ ` _ \ / _ \/ __/ __|/ _` |/ _` |/ _ \ | '__| | '_ \ / _` | *
+//* | | | | | |  __/\__ \__ \ (_| | (_| |  __/ | |  | | | | | (_| | *
+//* |_| |_| |_|\___||___/___/\__,_|\__, |\___| |_|  |_|_| |_|\__, | *
+//*                                |___/                     |___/  *
+//===- lib/broker_intf/message_ring.cpp -----------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file message_ring.cpp
+/// \brief Implements the shared-memory transport for large broker messages.
+
+#include "pstore/broker_intf/message_ring.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include "pstore/broker_intf/fifo_path.hpp"
+#include "pstore/support/fnv.hpp"
+
+namespace pstore {
+    namespace broker {
+
+        gsl::czstring const message_ring_doorbell_command = "_RING";
+
+        constexpr std::size_t message_ring::num_slots;
+        constexpr std::size_t message_ring::slot_size;
+
+        // message_ring_name
+        // ~~~~~~~~~~~~~~~~~
+        std::string message_ring_name (fifo_path const & fifo) {
+            std::string const & path = fifo.get ();
+            std::ostringstream str;
+            str << "pstore-ring-" << std::hex << fnv_64a_buf (path.data (), path.length ());
+            return str.str ();
+        }
+
+        // reset
+        // ~~~~~
+        void message_ring::reset () noexcept {
+            for (slot & s : slots_) {
+                s.sequence.fetch_add (1U, std::memory_order_relaxed);
+                s.state.store (vacant, std::memory_order_release);
+            }
+        }
+
+        // put
+        // ~~~
+        auto message_ring::put (gsl::span<char const> const message) noexcept -> maybe<ticket> {
+            auto const length = static_cast<std::size_t> (message.size ());
+            if (length > slot_size) {
+                return nothing<ticket> ();
+            }
+            for (auto ctr = std::size_t{0}; ctr < num_slots; ++ctr) {
+                std::uint32_t const index =
+                    next_.fetch_add (1U, std::memory_order_relaxed) % num_slots;
+                slot & s = slots_[index];
+                auto expected = std::uint32_t{vacant};
+                if (s.state.compare_exchange_strong (expected, writing,
+                                                     std::memory_order_acquire)) {
+                    std::uint32_t const sequence =
+                        s.sequence.fetch_add (1U, std::memory_order_relaxed) + 1U;
+                    std::copy (message.begin (), message.end (), s.data.begin ());
+                    s.length = static_cast<std::uint32_t> (length);
+                    s.state.store (ready, std::memory_order_release);
+                    return just (ticket{index, sequence});
+                }
+            }
+            return nothing<ticket> ();
+        }
+
+        // claim
+        // ~~~~~
+        auto message_ring::claim (ticket const & t) noexcept -> slot * {
+            if (t.slot >= num_slots) {
+                return nullptr;
+            }
+            slot & s = slots_[t.slot];
+            // Claim the slot so that a concurrent reset() or take() cannot recycle it while its
+            // contents are being copied.
+            auto expected = std::uint32_t{ready};
+            if (!s.state.compare_exchange_strong (expected, writing, std::memory_order_acquire)) {
+                return nullptr;
+            }
+            if (s.sequence.load (std::memory_order_relaxed) != t.sequence) {
+                // A stale doorbell: the slot now holds a different message.
+                s.state.store (ready, std::memory_order_release);
+                return nullptr;
+            }
+            return &s;
+        }
+
+        // take
+        // ~~~~
+        maybe<std::string> message_ring::take (ticket const & t) {
+            slot * const s = this->claim (t);
+            if (s == nullptr) {
+                return nothing<std::string> ();
+            }
+            // The ring is writable by any client so the length cannot be trusted.
+            std::uint32_t const length = s->length;
+            if (length > slot_size) {
+                s->state.store (vacant, std::memory_order_release);
+                return nothing<std::string> ();
+            }
+            std::string result (s->data.data (), length);
+            s->state.store (vacant, std::memory_order_release);
+            return just (std::move (result));
+        }
+
+        // cancel
+        // ~~~~~~
+        bool message_ring::cancel (ticket const & t) noexcept {
+            slot * const s = this->claim (t);
+            if (s == nullptr) {
+                return false;
+            }
+            s->state.store (vacant, std::memory_order_release);
+            return true;
+        }
+
+        // doorbell_path
+        // ~~~~~~~~~~~~~
+        std::string doorbell_path (message_ring::ticket const & t) {
+            std::ostringstream str;
+            str << t.slot << ' ' << t.sequence;
+            return str.str ();
+        }
+
+        // parse_doorbell
+        // ~~~~~~~~~~~~~~
+        maybe<message_ring::ticket> parse_doorbell (std::string const & path) {
+            std::istringstream str{path};
+            message_ring::ticket t{};
+            if (!(str >> t.slot >> t.sequence) || !(str >> std::ws).eof ()) {
+                return nothing<message_ring::ticket> ();
+            }
+            return just (t);
+        }
+
+    } // end namespace broker
+} // end namespace pstore
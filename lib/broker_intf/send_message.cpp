@@ -48,8 +48,10 @@
 #include <iterator>
 #include <string>
 
+#include "pstore/broker_intf/message_ring.hpp"
 #include "pstore/broker_intf/message_type.hpp"
 #include "pstore/broker_intf/writer.hpp"
+#include "pstore/support/scope_guard.hpp"
 
 namespace {
 
@@ -60,8 +62,8 @@ namespace {
 namespace pstore {
     namespace broker {
 
-        void send_message (writer & wr, bool const error_on_timeout, gsl::czstring const verb,
-                           gsl::czstring const path) {
+        bool send_message (writer & wr, bool const error_on_timeout, gsl::czstring const verb,
+                           gsl::czstring const path, message_ring * const ring) {
             assert (verb != nullptr);
 
             auto payload = std::string{verb};
@@ -70,6 +72,22 @@ namespace pstore {
                 payload.append (path);
             }
 
+            if (ring != nullptr && message_ring::wanted (payload.length ())) {
+                auto const span = gsl::make_span (payload.data (),
+                                                  static_cast<std::ptrdiff_t> (payload.length ()));
+                if (maybe<message_ring::ticket> const t = ring->put (span)) {
+                    // The message is in the ring: tell the broker where to find it. If it can't be
+                    // told, the slot would otherwise stay in use until the broker next starts.
+                    auto cancel = make_scope_guard ([ring, &t] () { ring->cancel (*t); });
+                    if (!send_message (wr, error_on_timeout, message_ring_doorbell_command,
+                                       doorbell_path (*t).c_str (), nullptr)) {
+                        return false;
+                    }
+                    cancel.release ();
+                    return true;
+                }
+            }
+
             // Work out the number of pieces into which we need to break this payload.
             using num_parts_type = std::remove_const<decltype (message_type::num_parts)>::type;
             auto const num_parts =
@@ -96,9 +114,13 @@ namespace pstore {
                 std::advance (last, std::min (remaining, static_cast<difference_type> (
                                                              message_type::payload_chars)));
 
-                wr.write (message_type{mid, part, num_parts, first, last}, error_on_timeout);
+                if (!wr.write (message_type{mid, part, num_parts, first, last},
+                               error_on_timeout)) {
+                    return false;
+                }
                 first = last;
             }
+            return true;
         }
 
         std::uint32_t next_message_id () { return message_id.load (); }
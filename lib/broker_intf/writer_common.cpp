@@ -81,7 +81,7 @@ namespace pstore {
 
         // write
         // ~~~~~
-        void writer::write (message_type const & msg, bool const error_on_timeout) {
+        bool writer::write (message_type const & msg, bool const error_on_timeout) {
             auto tries = 0U;
             bool const infinite_tries = max_retries_ == infinite_retries;
             for (; infinite_tries || tries <= max_retries_; ++tries) {
@@ -92,9 +92,11 @@ namespace pstore {
                 std::this_thread::sleep_for (retry_timeout_);
             }
 
-            if (error_on_timeout && !infinite_tries && tries > max_retries_) {
+            bool const timed_out = !infinite_tries && tries > max_retries_;
+            if (error_on_timeout && timed_out) {
                 raise (::pstore::error_code::pipe_write_timeout);
             }
+            return !timed_out;
         }
 
     } // namespace broker
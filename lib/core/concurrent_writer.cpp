@@ -0,0 +1,184 @@
+//*                                                 _                   _ _             *
+//*   ___ ___  _ __   ___ _   _ _ __ _ __ ___ _ __ | |_  __      ___ __(_) |_ ___ _ __  *
+//*  / __/ _ \| '_ \ / __| | | | '__| '__/ _ \ '_ \| __| \ \ /\ / / '__| | __/ _ \ '__| *
+//* | (_| (_) | | | | (__| |_| | |  | | |  __/ | | | |_   \ V  V /| |  | | ||  __/ |    *
+//*  \___\___/|_| |_|\___|\__,_|_|  |_|  \___|_| |_|\__|   \_/\_/ |_|  |_|\__\___|_|    *
+//*                                                                                     *
+//===- lib/core/concurrent_writer.cpp -------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file concurrent_writer.cpp
+/// \brief Enables several threads to add data to a single transaction.
+
+#include "pstore/core/concurrent_writer.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include "pstore/support/aligned.hpp"
+
+namespace pstore {
+
+    //*  _                                  _   _                                           *
+    //* | |_ _ __ __ _ _ __  ___  __ _  ___| |_(_) ___  _ __     __ _ _ __ ___ _ __   __ _  *
+    //* | __| '__/ _` | '_ \/ __|/ _` |/ __| __| |/ _ \| '_ \   / _` | '__/ _ \ '_ \ / _` | *
+    //* | |_| | | (_| | | | \__ \ (_| | (__| |_| | (_) | | | | | (_| | | |  __/ | | | (_| | *
+    //*  \__|_|  \__,_|_| |_|___/\__,_|\___|\__|_|\___/|_| |_|  \__,_|_|  \___|_| |_|\__,_| *
+    //*                                                                                     *
+    // alloc_rw
+    // ~~~~~~~~
+    std::pair<std::shared_ptr<void>, address> transaction_arena::alloc_rw (std::size_t const size,
+                                                                           unsigned const align) {
+        assert (is_power_of_two (align));
+        std::uint64_t const block_size = writer_.block_size_;
+        if (align > block_size || size > block_size - align) {
+            // This allocation is too large (or too strictly aligned) to be carved from a block:
+            // allocate it directly from the transaction.
+            return writer_.alloc_rw (size, align);
+        }
+
+        std::uint64_t extra = calc_alignment ((block_addr_ + used_).absolute (), align);
+        if (block_ == nullptr || used_ + extra + size > block_size_) {
+            // Start a new block. Any space remaining in the current block is abandoned.
+            this->retire_block ();
+            std::tie (block_, block_addr_) =
+                writer_.alloc_rw (block_size, alignof (std::max_align_t));
+            block_size_ = block_size;
+            extra = calc_alignment (block_addr_.absolute (), align);
+        }
+
+        std::uint64_t const offset = used_ + extra;
+        used_ = offset + size;
+        assert (used_ <= block_size_);
+        auto * const ptr = static_cast<std::uint8_t *> (block_.get ()) + offset;
+        return {std::shared_ptr<void> (block_, ptr), block_addr_ + offset};
+    }
+
+    // retire_block
+    // ~~~~~~~~~~~~
+    void transaction_arena::retire_block () noexcept {
+        if (block_ != nullptr) {
+            // Don't leave uninitialized memory in the store.
+            std::memset (static_cast<std::uint8_t *> (block_.get ()) + used_, 0,
+                         block_size_ - used_);
+            block_.reset ();
+        }
+        block_addr_ = address::null ();
+        block_size_ = 0;
+        used_ = 0;
+    }
+
+    //*                                                 _                   _ _             *
+    //*   ___ ___  _ __   ___ _   _ _ __ _ __ ___ _ __ | |_  __      ___ __(_) |_ ___ _ __  *
+    //*  / __/ _ \| '_ \ / __| | | | '__| '__/ _ \ '_ \| __| \ \ /\ / / '__| | __/ _ \ '__| *
+    //* | (_| (_) | | | | (__| |_| | |  | | |  __/ | | | |_   \ V  V /| |  | | ||  __/ |    *
+    //*  \___\___/|_| |_|\___|\__,_|_|  |_|  \___|_| |_|\__|   \_/\_/ |_|  |_|\__\___|_|    *
+    //*                                                                                     *
+    constexpr std::uint64_t concurrent_writer::default_block_size;
+
+    // (ctor)
+    // ~~~~~~
+    concurrent_writer::concurrent_writer (transaction_base & transaction,
+                                          std::uint64_t const block_size)
+            : transaction_{transaction}
+            , block_size_{block_size} {
+        assert (block_size_ > alignof (std::max_align_t));
+    }
+
+    // (dtor)
+    // ~~~~~~
+    concurrent_writer::~concurrent_writer () noexcept = default;
+
+    // arena
+    // ~~~~~
+    transaction_arena & concurrent_writer::arena () {
+        auto const id = std::this_thread::get_id ();
+        std::lock_guard<std::mutex> const lock{mut_};
+        auto const pos = std::find_if (
+            std::begin (arenas_), std::end (arenas_),
+            [id] (std::pair<std::thread::id, std::unique_ptr<transaction_arena>> const & a) {
+                return a.first == id;
+            });
+        if (pos != std::end (arenas_)) {
+            return *pos->second;
+        }
+        // transaction_arena's constructor is private so we can't use std::make_unique<>().
+        arenas_.emplace_back (id,
+                              std::unique_ptr<transaction_arena> (new transaction_arena (*this)));
+        return *arenas_.back ().second;
+    }
+
+    // merge
+    // ~~~~~
+    void concurrent_writer::merge () {
+        std::lock_guard<std::mutex> const lock{mut_};
+
+        // Gather the index updates from each of the arenas. Arenas are visited in the order in
+        // which they were created.
+        std::vector<std::unique_ptr<details::pending_updates_base>> combined;
+        for (auto & a : arenas_) {
+            transaction_arena & arena = *a.second;
+            arena.retire_block ();
+            for (std::unique_ptr<details::pending_updates_base> & u : arena.updates_) {
+                auto const pos = std::find_if (
+                    std::begin (combined), std::end (combined),
+                    [&u] (std::unique_ptr<details::pending_updates_base> const & c) {
+                        return c->index () == u->index ();
+                    });
+                if (pos == std::end (combined)) {
+                    combined.push_back (std::move (u));
+                } else {
+                    (*pos)->append (*u);
+                }
+            }
+        }
+        arenas_.clear ();
+
+        for (std::unique_ptr<details::pending_updates_base> const & c : combined) {
+            c->apply (transaction_);
+        }
+    }
+
+    // alloc_rw
+    // ~~~~~~~~
+    std::pair<std::shared_ptr<void>, address>
+    concurrent_writer::alloc_rw (std::uint64_t const size, unsigned const align) {
+        std::lock_guard<std::mutex> const lock{mut_};
+        return transaction_.alloc_rw (size, align);
+    }
+
+} // namespace pstore
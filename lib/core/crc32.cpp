@@ -85,6 +85,30 @@
  */
 #include "pstore/core/crc32.hpp"
 
+#include <cassert>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#    define PSTORE_CRC32_CLMUL 1
+#    include <cpuid.h>
+#    include <immintrin.h>
+#    define PSTORE_CRC32_CLMUL_TARGET __attribute__ ((target ("pclmul,sse4.1")))
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER)
+#    define PSTORE_CRC32_CLMUL 1
+#    include <immintrin.h>
+#    include <intrin.h>
+#    define PSTORE_CRC32_CLMUL_TARGET
+#else
+#    define PSTORE_CRC32_CLMUL 0
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#    define PSTORE_CRC32_ARMV8 1
+#    include <arm_acle.h>
+#    include <cstring>
+#else
+#    define PSTORE_CRC32_ARMV8 0
+#endif
+
 namespace pstore {
     namespace details {
 
@@ -129,3 +153,256 @@ namespace pstore {
 
     } // end namespace details
 } // end namespace pstore
+
+namespace {
+
+    /// The tables used by the slicing-by-8 algorithm. Table 0 is the same as crc32_tab; table k
+    /// gives the CRC contribution of a byte which is followed by k zero bytes.
+    struct slice8_tables {
+        std::uint32_t t[8][256];
+    };
+
+    constexpr slice8_tables make_slice8_tables () noexcept {
+        slice8_tables r{};
+        for (auto i = 0U; i < 256U; ++i) {
+            std::uint32_t crc = i;
+            for (auto bit = 0U; bit < 8U; ++bit) {
+                crc = (crc >> 1U) ^ (UINT32_C (0xEDB88320) & (0U - (crc & 1U)));
+            }
+            r.t[0][i] = crc;
+        }
+        for (auto i = 0U; i < 256U; ++i) {
+            for (auto k = 1U; k < 8U; ++k) {
+                std::uint32_t const prev = r.t[k - 1U][i];
+                r.t[k][i] = (prev >> 8U) ^ r.t[0][prev & 0xFFU];
+            }
+        }
+        return r;
+    }
+
+    constexpr slice8_tables slice8 = make_slice8_tables ();
+
+    /// Reads a little-endian 32-bit value. Compilers reduce this to a single load on
+    /// little-endian hosts.
+    inline std::uint32_t load32le (std::uint8_t const * const p) noexcept {
+        return static_cast<std::uint32_t> (p[0]) | (static_cast<std::uint32_t> (p[1]) << 8U) |
+               (static_cast<std::uint32_t> (p[2]) << 16U) |
+               (static_cast<std::uint32_t> (p[3]) << 24U);
+    }
+
+#if PSTORE_CRC32_CLMUL
+    /// Returns true if the host CPU supports the PCLMULQDQ and SSE4.1 instructions.
+    bool have_clmul () noexcept {
+        constexpr auto pclmulqdq_bit = 1U << 1U;
+        constexpr auto sse41_bit = 1U << 19U;
+#    ifdef _MSC_VER
+        int info[4];
+        __cpuid (info, 1);
+        auto const ecx = static_cast<unsigned> (info[2]);
+#    else
+        unsigned eax = 0;
+        unsigned ebx = 0;
+        unsigned ecx = 0;
+        unsigned edx = 0;
+        if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+#    endif
+        return (ecx & pclmulqdq_bit) != 0U && (ecx & sse41_bit) != 0U;
+    }
+
+    PSTORE_CRC32_CLMUL_TARGET
+    inline __m128i load128 (std::uint8_t const * const p) noexcept {
+        return _mm_loadu_si128 (reinterpret_cast<__m128i const *> (p));
+    }
+
+    /// Folds the 128-bit value \p a by the constants in \p k and adds it to \p b.
+    PSTORE_CRC32_CLMUL_TARGET
+    inline __m128i fold128 (__m128i const a, __m128i const b, __m128i const k) noexcept {
+        __m128i const lo = _mm_clmulepi64_si128 (a, k, 0x00);
+        __m128i const hi = _mm_clmulepi64_si128 (a, k, 0x11);
+        return _mm_xor_si128 (_mm_xor_si128 (hi, b), lo);
+    }
+
+    /// Folds blocks of data using carry-less multiplication following "Fast CRC Computation for
+    /// Generic Polynomials Using PCLMULQDQ Instruction" (Gopal et al., Intel, 2009). The constants
+    /// are the bit-reflected values for the CRC32 polynomial given at the end of that paper.
+    ///
+    /// \param crc  The running CRC value.
+    /// \param buf  The data to be processed.
+    /// \param size  The number of bytes to process. Must be at least 64 and a multiple of 16.
+    PSTORE_CRC32_CLMUL_TARGET
+    std::uint32_t clmul_fold (std::uint32_t const crc, std::uint8_t const * buf,
+                              std::size_t size) noexcept {
+        alignas (16) static std::uint64_t const k1k2[] = {UINT64_C (0x0154442bd4),
+                                                           UINT64_C (0x01c6e41596)};
+        alignas (16) static std::uint64_t const k3k4[] = {UINT64_C (0x01751997d0),
+                                                           UINT64_C (0x00ccaa009e)};
+        alignas (16) static std::uint64_t const k5k0[] = {UINT64_C (0x0163cd6124),
+                                                           UINT64_C (0x0000000000)};
+        alignas (16) static std::uint64_t const poly[] = {UINT64_C (0x01db710641),
+                                                           UINT64_C (0x01f7011641)};
+        assert (size >= 64U && size % 16U == 0U);
+
+        __m128i x1 = load128 (buf + 0x00);
+        __m128i x2 = load128 (buf + 0x10);
+        __m128i x3 = load128 (buf + 0x20);
+        __m128i x4 = load128 (buf + 0x30);
+        x1 = _mm_xor_si128 (x1, _mm_cvtsi32_si128 (static_cast<int> (crc)));
+        __m128i x0 = _mm_load_si128 (reinterpret_cast<__m128i const *> (k1k2));
+        buf += 64;
+        size -= 64;
+
+        // Fold four 128-bit lanes in parallel.
+        while (size >= 64) {
+            __m128i const x5 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+            __m128i const x6 = _mm_clmulepi64_si128 (x2, x0, 0x00);
+            __m128i const x7 = _mm_clmulepi64_si128 (x3, x0, 0x00);
+            __m128i const x8 = _mm_clmulepi64_si128 (x4, x0, 0x00);
+            x1 = _mm_clmulepi64_si128 (x1, x0, 0x11);
+            x2 = _mm_clmulepi64_si128 (x2, x0, 0x11);
+            x3 = _mm_clmulepi64_si128 (x3, x0, 0x11);
+            x4 = _mm_clmulepi64_si128 (x4, x0, 0x11);
+            x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5), load128 (buf + 0x00));
+            x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6), load128 (buf + 0x10));
+            x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7), load128 (buf + 0x20));
+            x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8), load128 (buf + 0x30));
+            buf += 64;
+            size -= 64;
+        }
+
+        // Fold the four lanes into one.
+        x0 = _mm_load_si128 (reinterpret_cast<__m128i const *> (k3k4));
+        x1 = fold128 (x1, x2, x0);
+        x1 = fold128 (x1, x3, x0);
+        x1 = fold128 (x1, x4, x0);
+
+        // Fold any remaining 16-byte blocks.
+        while (size >= 16) {
+            x1 = fold128 (x1, load128 (buf), x0);
+            buf += 16;
+            size -= 16;
+        }
+
+        // Fold 128 bits to 64 bits.
+        __m128i x2a = _mm_clmulepi64_si128 (x1, x0, 0x10);
+        __m128i const mask32 = _mm_setr_epi32 (~0, 0, ~0, 0);
+        x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8), x2a);
+        x0 = _mm_loadl_epi64 (reinterpret_cast<__m128i const *> (k5k0));
+        x2a = _mm_srli_si128 (x1, 4);
+        x1 = _mm_and_si128 (x1, mask32);
+        x1 = _mm_clmulepi64_si128 (x1, x0, 0x00);
+        x1 = _mm_xor_si128 (x1, x2a);
+
+        // Barrett reduction to 32 bits.
+        x0 = _mm_load_si128 (reinterpret_cast<__m128i const *> (poly));
+        x2a = _mm_and_si128 (x1, mask32);
+        x2a = _mm_clmulepi64_si128 (x2a, x0, 0x10);
+        x2a = _mm_and_si128 (x2a, mask32);
+        x2a = _mm_clmulepi64_si128 (x2a, x0, 0x00);
+        x1 = _mm_xor_si128 (x1, x2a);
+        return static_cast<std::uint32_t> (_mm_extract_epi32 (x1, 1));
+    }
+
+    std::uint32_t crc32_clmul (std::uint32_t crc, void const * const buf,
+                               std::size_t size) noexcept {
+        auto const * p = static_cast<std::uint8_t const *> (buf);
+        if (size >= 64U) {
+            std::size_t const chunk = size & ~std::size_t{15};
+            crc = clmul_fold (crc, p, chunk);
+            p += chunk;
+            size -= chunk;
+        }
+        return pstore::details::crc32_slice8 (crc, p, size);
+    }
+#endif // PSTORE_CRC32_CLMUL
+
+#if PSTORE_CRC32_ARMV8
+    std::uint32_t crc32_armv8 (std::uint32_t crc, void const * const buf,
+                               std::size_t size) noexcept {
+        auto const * p = static_cast<std::uint8_t const *> (buf);
+        while (size >= 8U) {
+            std::uint64_t v;
+            std::memcpy (&v, p, sizeof (v));
+            crc = __crc32d (crc, v);
+            p += 8;
+            size -= 8;
+        }
+        while (size > 0U) {
+            crc = __crc32b (crc, *p);
+            ++p;
+            --size;
+        }
+        return crc;
+    }
+#endif // PSTORE_CRC32_ARMV8
+
+    pstore::details::crc32_function select_crc32 () noexcept {
+        if (pstore::details::crc32_function const hw = pstore::details::crc32_hardware ()) {
+            return hw;
+        }
+        return pstore::details::crc32_slice8;
+    }
+
+} // end anonymous namespace
+
+namespace pstore {
+    namespace details {
+
+        // crc32_bytewise
+        // ~~~~~~~~~~~~~~
+        std::uint32_t crc32_bytewise (std::uint32_t crc, void const * const buf,
+                                      std::size_t size) noexcept {
+            auto const * p = static_cast<std::uint8_t const *> (buf);
+            while (size--) {
+                crc = crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+            }
+            return crc;
+        }
+
+        // crc32_slice8
+        // ~~~~~~~~~~~~
+        std::uint32_t crc32_slice8 (std::uint32_t crc, void const * const buf,
+                                    std::size_t size) noexcept {
+            auto const * p = static_cast<std::uint8_t const *> (buf);
+            auto const & t = slice8.t;
+            while (size >= 8U) {
+                std::uint32_t const one = load32le (p) ^ crc;
+                std::uint32_t const two = load32le (p + 4);
+                crc = t[7][one & 0xFFU] ^ t[6][(one >> 8U) & 0xFFU] ^
+                      t[5][(one >> 16U) & 0xFFU] ^ t[4][one >> 24U] ^ t[3][two & 0xFFU] ^
+                      t[2][(two >> 8U) & 0xFFU] ^ t[1][(two >> 16U) & 0xFFU] ^ t[0][two >> 24U];
+                p += 8;
+                size -= 8U;
+            }
+            while (size--) {
+                crc = t[0][(crc ^ *p++) & 0xFFU] ^ (crc >> 8U);
+            }
+            return crc;
+        }
+
+        // crc32_hardware
+        // ~~~~~~~~~~~~~~
+        crc32_function crc32_hardware () noexcept {
+#if PSTORE_CRC32_CLMUL
+            if (have_clmul ()) {
+                return crc32_clmul;
+            }
+#endif
+#if PSTORE_CRC32_ARMV8
+            return crc32_armv8;
+#else
+            return nullptr;
+#endif
+        }
+
+        // crc32_update
+        // ~~~~~~~~~~~~
+        std::uint32_t crc32_update (std::uint32_t const crc, void const * const buf,
+                                    std::size_t const size) noexcept {
+            static crc32_function const fn = select_crc32 ();
+            return fn (crc, buf, size);
+        }
+
+    } // end namespace details
+} // end namespace pstore
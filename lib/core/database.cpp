@@ -101,7 +101,12 @@ namespace pstore {
 
     database::database (std::string const & path, access_mode const am,
                         bool const access_tick_enabled)
-            : storage_{database::open (path, am)}
+            : database (path, am, mapping_mode::eager, access_tick_enabled) {}
+
+    database::database (std::string const & path, access_mode const am, mapping_mode const mm,
+                        bool const access_tick_enabled)
+            : storage_{database::open (path, am),
+                       am == access_mode::read_only && mm == mapping_mode::lazy}
             , size_{database::get_footer_pos (*this->file ())} {
 
         this->finish_init (access_tick_enabled);
@@ -126,6 +131,7 @@ namespace pstore {
         trailer::validate (*this, size_.footer_pos ());
         this->protect (address{sizeof (header)}, address{size_.logical_size ()});
 
+        storage_.ensure_mapped (address::null (), sizeof (header));
         header_ = storage_.address_to_pointer (typed_address<header>::null ());
         sync_name_ = database::build_sync_name (*header_);
 
@@ -177,7 +183,7 @@ namespace pstore {
 
     // clear_index_cache
     // ~~~~~~~~~~~~~~~~~
-    void database::clear_index_cache () {
+    void database::clear_index_cache () noexcept {
         for (std::shared_ptr<index::index_base> & index : indices_) {
             index.reset ();
         }
@@ -190,25 +196,44 @@ namespace pstore {
             raise (pstore::error_code::unknown_revision);
         }
 
-        // Walk backwards down the linked list of revisions to find it.
-        typed_address<trailer> footer_pos = size_.footer_pos ();
-        for (;;) {
-            auto const tail = this->getro (footer_pos);
-            unsigned int const tail_revision = tail->a.generation;
-            if (revision > tail_revision) {
-                raise (pstore::error_code::unknown_revision);
-            }
-            if (tail_revision == revision) {
-                break;
+        return this->find_revision_footer_pos (size_.footer_pos (), revision);
+    }
+
+    // find_revision_footer_pos
+    // ~~~~~~~~~~~~~~~~~~~~~~~~
+    typed_address<trailer> database::find_revision_footer_pos (typed_address<trailer> const start,
+                                                               unsigned const revision) const {
+        typed_address<trailer> footer_pos = start;
+        trailer::validate (*this, footer_pos);
+        auto tail = this->getro (footer_pos);
+        unsigned tail_revision = tail->a.generation;
+        if (revision > tail_revision) {
+            raise (pstore::error_code::unknown_revision);
+        }
+
+        // Walk backwards down the list of revisions to find it. We follow the skip pointer when
+        // it lands on the requested revision or when doing so won't pass over the previous
+        // generation's (smaller) skip which would have taken us closer to the target.
+        while (tail_revision != revision) {
+            unsigned const skip = trailer::skip_generation_number (tail_revision);
+            unsigned const prev_skip = trailer::skip_generation_number (tail_revision - 1U);
+            typed_address<trailer> const skip_pos = tail->a.skip_generation;
+            if (skip_pos != typed_address<trailer>::null () &&
+                (skip == revision ||
+                 (skip > revision && !(prev_skip + 2U < skip && prev_skip >= revision)))) {
+                footer_pos = skip_pos;
+            } else {
+                footer_pos = tail->a.prev_generation;
             }
 
-            // TODO: check that footer_pos and generation number are be getting smaller; time must
-            // not be getting larger.
-            // TODO: prev_generation should probably be atomic
-            footer_pos = tail->a.prev_generation;
             trailer::validate (*this, footer_pos);
+            tail = this->getro (footer_pos);
+            unsigned const next_revision = tail->a.generation;
+            if (next_revision >= tail_revision || next_revision < revision) {
+                raise (error_code::footer_corrupt, this->path ());
+            }
+            tail_revision = next_revision;
         }
-
         return footer_pos;
     }
 
@@ -375,10 +400,34 @@ namespace pstore {
         return (header_->footer_pos.load () + 1).to_address ();
     }
 
+    // trailer_validated
+    // ~~~~~~~~~~~~~~~~~
+    bool database::trailer_validated (typed_address<trailer> const pos) const {
+        std::lock_guard<std::mutex> const lock{validated_trailers_->mut};
+        return validated_trailers_->positions.count (pos.absolute ()) > 0U;
+    }
+
+    // set_trailer_validated
+    // ~~~~~~~~~~~~~~~~~~~~~
+    void database::set_trailer_validated (typed_address<trailer> const pos) const {
+        std::lock_guard<std::mutex> const lock{validated_trailers_->mut};
+        validated_trailers_->positions.insert (pos.absolute ());
+    }
+
     // get_spanning
     // ~~~~~~~~~~~~
     auto database::get_spanning (address const addr, std::size_t const size, bool const initialized,
                                  bool const writable) const -> std::shared_ptr<void const> {
+        // Committed data is immutable so read-only requests for it can share a previously built
+        // block. The file header is excluded because it is modified by every commit.
+        bool const cacheable = initialized && !writable && addr.absolute () >= leader_size &&
+                               (addr + size).absolute () <= first_writable_address ().absolute ();
+        if (cacheable) {
+            if (std::shared_ptr<void const> cached = spanning_cache_->find (addr, size)) {
+                return cached;
+            }
+        }
+
         // The deleter is called when the shared pointer that we're about to return is
         // released.
         auto deleter = [this, addr, size, writable](std::uint8_t * const p) {
@@ -411,6 +460,9 @@ namespace pstore {
                     std::memcpy (dest, src, n);
                 });
         }
+        if (cacheable) {
+            spanning_cache_->insert (addr, size, result);
+        }
         return std::static_pointer_cast<void const> (result);
     }
 
@@ -432,12 +484,28 @@ namespace pstore {
             raise (error_code::bad_address);
         }
 
+        storage_.ensure_mapped (addr, size);
         if (storage_.request_spans_regions (addr, size)) {
             return this->get_spanning (addr, size, initialized, writable);
         }
         return storage_.address_to_pointer (addr);
     }
 
+    // prefetch
+    // ~~~~~~~~
+    void database::prefetch (address const addr, std::uint64_t const size) const {
+        if (closed_) {
+            raise (pstore::error_code::store_closed);
+        }
+        std::uint64_t const start = addr.absolute ();
+        std::uint64_t const logical_size = size_.logical_size ();
+        if (start > logical_size || size > logical_size - start) {
+            raise (error_code::bad_address);
+        }
+        storage_.ensure_mapped (addr, size);
+        storage_.advise (addr, addr + size, access_pattern::willneed);
+    }
+
     // allocate
     // ~~~~~~~~
     pstore::address database::allocate (std::uint64_t const bytes, unsigned const align) {
@@ -482,6 +550,12 @@ namespace pstore {
         storage_.map_bytes (size);
 
         size_.truncate_logical_size (size);
+        {
+            // Forget any trailers that lay in the discarded part of the file.
+            std::lock_guard<std::mutex> const lock{validated_trailers_->mut};
+            auto & positions = validated_trailers_->positions;
+            positions.erase (positions.lower_bound (size), positions.end ());
+        }
         if (database::small_files_enabled ()) { //! OCLINT(PH - don't warn that this is a constant)
             this->file ()->truncate (size);
         }
@@ -69,6 +69,11 @@ namespace pstore {
     //*                              *
     std::uint16_t const header::major_version;
     std::uint16_t const header::minor_version;
+    std::uint16_t const header::oldest_minor_version;
+    std::uint16_t const header::shared_payload_version;
+    std::uint16_t const header::index_fragments_version;
+    std::uint16_t const header::index_filter_version;
+    std::uint16_t const header::indirect_string_hash_version;
     std::array<std::uint8_t, 4> const header::file_signature1{{'p', 'S', 't', 'r'}};
     std::uint32_t const header::file_signature2;
 
@@ -114,6 +119,8 @@ namespace pstore {
         {'h', 'P', 'P', 'y', 'f', 'o', 'o', 'T'}};
     std::array<std::uint8_t, 8> const trailer::default_signature2{
         {'h', 'P', 'P', 'y', 'T', 'a', 'i', 'l'}};
+    constexpr std::underlying_type<trailer::indices>::type trailer::num_trailer_indices;
+    constexpr std::underlying_type<trailer::indices>::type trailer::num_extension_indices;
 
     // crc_is_valid
     // ~~~~~~~~~~~~
@@ -145,7 +152,7 @@ namespace pstore {
     // validate [static]
     // ~~~~~~~~
     bool trailer::validate (database const & db, typed_address<trailer> const pos) {
-        if (pos == typed_address<trailer>::null ()) {
+        if (pos == typed_address<trailer>::null () || db.trailer_validated (pos)) {
             return true;
         }
         bool ok = true;
@@ -159,6 +166,7 @@ namespace pstore {
             auto const footer = db.getro<trailer> (pos);
             // Get the address of the previous generation.
             typed_address<trailer> const prev_pos = footer->a.prev_generation;
+            typed_address<trailer> const skip_pos = footer->a.skip_generation;
 
             if (!footer->crc_is_valid () || !footer->signature_is_valid ()) {
                 ok = false;
@@ -168,8 +176,16 @@ namespace pstore {
                 // be separated by at least the size of the trailer and agree with the location
                 // given by the current trailer's 'size' field.
                 ok = false;
+            } else if (skip_pos > prev_pos) {
+                // The skip pointer, if present, must not lie beyond the previous trailer.
+                ok = false;
             } else if (pos.absolute () < footer->a.size) {
                 ok = false;
+            } else if (footer->a.extension_offset != 0U &&
+                       (footer->a.extension_offset < sizeof (extension) ||
+                        footer->a.extension_offset > footer->a.size)) {
+                // An extension record must lie within the transaction's data.
+                ok = false;
             } else {
                 address const transaction_first_byte = prev_pos == typed_address<trailer>::null ()
                                                            ? address{leader_size}
@@ -183,7 +199,70 @@ namespace pstore {
         if (!ok) {
             raise (error_code::footer_corrupt, db.path ());
         }
+        db.set_trailer_validated (pos);
         return ok;
     }
 
+    // get_index_records [static]
+    // ~~~~~~~~~~~~~~~~~
+    auto trailer::get_index_records (database const & db, typed_address<trailer> const pos)
+        -> index_records_array {
+        index_records_array result;
+        auto const footer = db.getro (pos);
+        auto const out = std::copy (std::begin (footer->a.index_records),
+                                    std::end (footer->a.index_records), std::begin (result));
+        if (footer->a.extension_offset == 0U) {
+            std::fill (out, std::end (result), typed_address<index::header_block>::null ());
+        } else {
+            auto const ext = db.getro (typed_address<extension>::make (
+                pos.to_address () - footer->a.extension_offset));
+            if (!ext->crc_is_valid () || !ext->signature_is_valid ()) {
+                raise (error_code::footer_corrupt, db.path ());
+            }
+            std::copy (std::begin (ext->a.index_records), std::end (ext->a.index_records), out);
+        }
+        return result;
+    }
+
+    // get_index_record [static]
+    // ~~~~~~~~~~~~~~~~
+    typed_address<index::header_block>
+    trailer::get_index_record (database const & db, typed_address<trailer> const pos,
+                               indices const which) {
+        auto const slot = static_cast<std::underlying_type<indices>::type> (which);
+        if (slot < num_trailer_indices) {
+            return db.getro (pos)->a.index_records[slot];
+        }
+        return get_index_records (db, pos)[slot];
+    }
+
+    std::array<std::uint8_t, 8> const trailer::extension::default_signature{
+        {'h', 'P', 'P', 'y', 'X', 't', 'n', 'd'}};
+
+    // extension::crc_is_valid
+    // ~~~~~~~~~~~~~~~~~~~~~~~
+    bool trailer::extension::crc_is_valid () const noexcept {
+#if PSTORE_CRC_CHECKS_ENABLED
+        return crc == this->get_crc ();
+#else
+        return true;
+#endif
+    }
+
+    // extension::signature_is_valid
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    bool trailer::extension::signature_is_valid () const noexcept {
+#if PSTORE_SIGNATURE_CHECKS_ENABLED
+        return a.signature == extension::default_signature;
+#else
+        return true;
+#endif
+    }
+
+    // extension::get_crc
+    // ~~~~~~~~~~~~~~~~~~
+    std::uint32_t trailer::extension::get_crc () const noexcept {
+        return crc32 (gsl::make_span (&this->a, 1));
+    }
+
 } // end namespace pstore
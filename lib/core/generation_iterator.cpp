@@ -73,6 +73,16 @@ namespace pstore {
         return prev;
     }
 
+    // seek
+    // ~~~~
+    generation_iterator & generation_iterator::seek (unsigned const revision) {
+        if (pos_ == typed_address<trailer>::null ()) {
+            raise (error_code::unknown_revision);
+        }
+        pos_ = db_->find_revision_footer_pos (pos_, revision);
+        return *this;
+    }
+
     // validate
     // ~~~~~~~~
     bool generation_iterator::validate () const { return trailer::validate (*db_, pos_); }
@@ -85,5 +95,8 @@ namespace pstore {
     generation_iterator generation_container::end () {
         return {&db_, pstore::typed_address<pstore::trailer>::null ()};
     }
+    generation_iterator generation_container::find (unsigned const revision) {
+        return {&db_, db_.older_revision_footer_pos (revision)};
+    }
 
 } // namespace pstore
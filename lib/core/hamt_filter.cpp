@@ -0,0 +1,413 @@
+//*  _                     _      __ _ _ _             *
+//* | |__   __ _ _ __ ___ | |_   / _(_) | |_ ___ _ __  *
+//* | '_ \ / _` | '_ ` _ \| __| | |_| | | __/ _ \ '__| *
+//* | | | | (_| | | | | | | |_  |  _| | | ||  __/ |    *
+//* |_| |_|\__,_|_| |_| |_|\__| |_| |_|_|\__\___|_|    *
+//*                                                    *
+//===- lib/core/hamt_filter.cpp -------------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file hamt_filter.cpp
+#include "pstore/core/hamt_filter.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "pstore/core/database.hpp"
+#include "pstore/core/pinned_view.hpp"
+#include "pstore/core/transaction.hpp"
+#include "pstore/support/aligned.hpp"
+#include "pstore/support/error.hpp"
+
+namespace {
+
+    constexpr std::array<std::uint8_t, 8> filter_signature{
+        {'I', 'n', 'd', 'x', 'F', 'l', 't', 'r'}};
+    constexpr std::array<std::uint8_t, 8> overlay_signature{
+        {'I', 'n', 'd', 'x', 'F', 'l', 'O', 'v'}};
+
+    /// Re-mixes a key hash. The hash functions used by indices are not required to distribute
+    /// their bits evenly (the trie only needs them to be distinct) but the filter's false positive
+    /// rate depends on it. This is the finalizer from MurmurHash3.
+    constexpr std::uint64_t mix (std::uint64_t h) noexcept {
+        h ^= h >> 33U;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33U;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33U;
+        return h;
+    }
+
+    /// Odd multipliers used to derive the bit set in each word of a block from a 32-bit hash.
+    constexpr std::array<std::uint32_t, 8> salt{{0x47B6137BU, 0x44974D91U, 0x8824AD5BU,
+                                                 0xA2B7289DU, 0x705495C7U, 0x2DF1424BU,
+                                                 0x9EFC4947U, 0x5C6BFB31U}};
+
+    /// Returns the bit within word \p word of a block which is set for the given mixed hash.
+    inline std::uint64_t word_bit (std::uint64_t const mixed, std::size_t const word) noexcept {
+        auto const lo = static_cast<std::uint32_t> (mixed);
+        return std::uint64_t{1} << ((lo * salt[word]) >> 26U);
+    }
+
+} // end anonymous namespace
+
+namespace pstore {
+    namespace index {
+        namespace details {
+
+            constexpr std::uint64_t membership_filter::max_keys_per_block;
+            constexpr std::uint64_t membership_filter::max_overlay_fraction;
+            constexpr std::size_t membership_filter::block_size;
+
+            // (ctor)
+            // ~~~~~~
+            membership_filter::membership_filter (database const & db,
+                                                  typed_address<filter_header> const addr)
+                    : addr_{addr}
+                    , base_{addr} {
+                if (addr == typed_address<filter_header>::null ()) {
+                    return;
+                }
+                std::shared_ptr<filter_header const> h = db.getro (addr);
+                if (h->signature == overlay_signature) {
+                    std::shared_ptr<filter_overlay_header const> const ov =
+                        db.getro (typed_address<filter_overlay_header>::make (addr.to_address ()));
+                    base_ = typed_address<filter_header>::make (ov->base);
+                    num_dirty_ = ov->num_dirty;
+                    // An overlay is always written after the full filter on which it sits.
+                    if (base_ == typed_address<filter_header>::null () || !(base_ < addr)) {
+                        raise (error_code::index_corrupt, db.path ());
+                    }
+                    h = db.getro (base_);
+                    if (h->num_blocks != ov->num_blocks || num_dirty_ == 0U ||
+                        num_dirty_ > ov->num_blocks) {
+                        raise (error_code::index_corrupt, db.path ());
+                    }
+                }
+                std::uint64_t const n = h->num_blocks;
+#if PSTORE_SIGNATURE_CHECKS_ENABLED
+                if (h->signature != filter_signature) {
+                    raise (error_code::index_corrupt, db.path ());
+                }
+#endif
+                if (n == 0U || !is_power_of_two (n)) {
+                    raise (error_code::index_corrupt, db.path ());
+                }
+                num_blocks_ = n;
+            }
+
+            // insert
+            // ~~~~~~
+            void membership_filter::insert (block & b, hash_type const hash) noexcept {
+                auto const m = mix (hash);
+                for (auto word = std::size_t{0}; word < b.size (); ++word) {
+                    b[word] |= word_bit (m, word);
+                }
+            }
+
+            // contains
+            // ~~~~~~~~
+            bool membership_filter::contains (block const & b, hash_type const hash) noexcept {
+                auto const m = mix (hash);
+                for (auto word = std::size_t{0}; word < b.size (); ++word) {
+                    auto const bit = word_bit (m, word);
+                    if ((b[word] & bit) == 0U) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // block_index
+            // ~~~~~~~~~~~
+            std::uint64_t membership_filter::block_index (hash_type const hash,
+                                                          std::uint64_t const num_blocks) noexcept {
+                assert (is_power_of_two (num_blocks));
+                return (mix (hash) >> 32U) & (num_blocks - 1U);
+            }
+
+            // blocks_for
+            // ~~~~~~~~~~
+            std::uint64_t membership_filter::blocks_for (std::uint64_t const num_keys) noexcept {
+                // A new filter is half full so that it can absorb as many keys again before it
+                // needs to be rebuilt.
+                constexpr auto keys_per_block = max_keys_per_block / 2U;
+                auto const min_blocks = (num_keys + keys_per_block - 1U) / keys_per_block;
+                auto result = std::uint64_t{1};
+                while (result < min_blocks) {
+                    result <<= 1U;
+                }
+                return result;
+            }
+
+            // needs_rebuild
+            // ~~~~~~~~~~~~~
+            bool membership_filter::needs_rebuild (std::uint64_t const num_keys) const noexcept {
+                return addr_ == typed_address<filter_header>::null () ||
+                       num_keys > num_blocks_ * max_keys_per_block;
+            }
+
+            // may_contain
+            // ~~~~~~~~~~~
+            bool membership_filter::may_contain (database const & db,
+                                                 hash_type const hash) const {
+                if (addr_ == typed_address<filter_header>::null () || !pending_.empty ()) {
+                    return true;
+                }
+                std::shared_ptr<void const> indices;
+                if (num_dirty_ > 0U) {
+                    indices = db.getro (
+                        this->overlay_indices (),
+                        static_cast<std::size_t> (num_dirty_ * sizeof (std::uint64_t)));
+                }
+                address const a =
+                    this->block_address (static_cast<std::uint64_t const *> (indices.get ()),
+                                         block_index (hash, num_blocks_));
+                auto const b = std::static_pointer_cast<block const> (db.getro (a, block_size));
+                return contains (*b, hash);
+            }
+
+            bool membership_filter::may_contain (pinned_view & view, hash_type const hash) const {
+                if (addr_ == typed_address<filter_header>::null () || !pending_.empty ()) {
+                    return true;
+                }
+                std::uint64_t const * indices = nullptr;
+                if (num_dirty_ > 0U) {
+                    indices = static_cast<std::uint64_t const *> (view.getro (
+                        this->overlay_indices (),
+                        static_cast<std::size_t> (num_dirty_ * sizeof (std::uint64_t))));
+                }
+                auto const * const b = static_cast<block const *> (view.getro (
+                    this->block_address (indices, block_index (hash, num_blocks_)), block_size));
+                return contains (*b, hash);
+            }
+
+            // allocate
+            // ~~~~~~~~
+            std::shared_ptr<void> membership_filter::allocate (transaction_base & transaction,
+                                                               std::uint64_t const num_blocks) {
+                assert (is_power_of_two (num_blocks));
+                std::shared_ptr<void> ptr;
+                address addr;
+                std::tie (ptr, addr) = transaction.alloc_rw (
+                    static_cast<std::size_t> (block_size * (num_blocks + 1U)), block_size);
+
+                std::memset (ptr.get (), 0, block_size * (num_blocks + 1U));
+                auto * const h = static_cast<filter_header *> (ptr.get ());
+                h->signature = filter_signature;
+                h->num_blocks = num_blocks;
+
+                addr_ = typed_address<filter_header>::make (addr);
+                base_ = addr_;
+                num_blocks_ = num_blocks;
+                num_dirty_ = 0U;
+                return ptr;
+            }
+
+            // blocks
+            // ~~~~~~
+            auto membership_filter::blocks (std::shared_ptr<void> const & ptr) noexcept
+                -> block * {
+                return reinterpret_cast<block *> (static_cast<std::uint8_t *> (ptr.get ()) +
+                                                  block_size);
+            }
+
+            // flush
+            // ~~~~~
+            void membership_filter::flush (transaction_base & transaction) {
+                assert (!this->needs_rebuild (0U));
+                if (pending_.empty ()) {
+                    // Nothing has changed: the existing filter remains valid.
+                    return;
+                }
+                // The blocks which differ from the base filter are those held by the existing
+                // overlay and those touched by the new keys.
+                std::shared_ptr<void const> old_indices;
+                std::vector<std::uint64_t> dirty;
+                dirty.reserve (static_cast<std::size_t> (num_dirty_) + pending_.size ());
+                if (num_dirty_ > 0U) {
+                    old_indices = transaction.db ().getro (
+                        this->overlay_indices (),
+                        static_cast<std::size_t> (num_dirty_ * sizeof (std::uint64_t)));
+                    auto const * const first =
+                        static_cast<std::uint64_t const *> (old_indices.get ());
+                    dirty.assign (first, first + num_dirty_);
+                }
+                for (hash_type const hash : pending_) {
+                    dirty.push_back (block_index (hash, num_blocks_));
+                }
+                std::sort (std::begin (dirty), std::end (dirty));
+                dirty.erase (std::unique (std::begin (dirty), std::end (dirty)), std::end (dirty));
+
+                auto const * const indices =
+                    static_cast<std::uint64_t const *> (old_indices.get ());
+                if (dirty.size () > num_blocks_ / max_overlay_fraction) {
+                    this->flush_full (transaction, indices);
+                } else {
+                    this->flush_overlay (transaction, indices, dirty);
+                }
+                pending_.clear ();
+            }
+
+            // flush_full
+            // ~~~~~~~~~~
+            void membership_filter::flush_full (transaction_base & transaction,
+                                                std::uint64_t const * const old_indices) {
+                database const & db = transaction.db ();
+                auto const num_blocks = num_blocks_;
+                auto const old_num_dirty = num_dirty_;
+                std::shared_ptr<void const> const old_base =
+                    db.getro (base_.to_address () + block_size,
+                              static_cast<std::size_t> (block_size * num_blocks));
+                std::shared_ptr<void const> old_overlay;
+                if (old_num_dirty > 0U) {
+                    old_overlay = db.getro (this->overlay_indices () +
+                                                overlay_index_bytes (old_num_dirty),
+                                            static_cast<std::size_t> (block_size * old_num_dirty));
+                }
+
+                std::shared_ptr<void> const ptr = this->allocate (transaction, num_blocks);
+                block * const b = blocks (ptr);
+                std::memcpy (b, old_base.get (),
+                             static_cast<std::size_t> (block_size * num_blocks));
+                auto const * const overlay = static_cast<block const *> (old_overlay.get ());
+                for (auto ctr = std::uint64_t{0}; ctr < old_num_dirty; ++ctr) {
+                    b[old_indices[ctr]] = overlay[ctr];
+                }
+                for (hash_type const hash : pending_) {
+                    insert (b[block_index (hash, num_blocks)], hash);
+                }
+            }
+
+            // flush_overlay
+            // ~~~~~~~~~~~~~
+            void membership_filter::flush_overlay (transaction_base & transaction,
+                                                   std::uint64_t const * const old_indices,
+                                                   std::vector<std::uint64_t> const & dirty) {
+                database const & db = transaction.db ();
+                auto const num_dirty = static_cast<std::uint64_t> (dirty.size ());
+                auto const index_bytes = overlay_index_bytes (num_dirty);
+                auto const size =
+                    static_cast<std::size_t> (block_size + index_bytes + block_size * num_dirty);
+                std::shared_ptr<void> ptr;
+                address addr;
+                std::tie (ptr, addr) = transaction.alloc_rw (size, block_size);
+
+                std::memset (ptr.get (), 0, size);
+                auto * const h = static_cast<filter_overlay_header *> (ptr.get ());
+                h->signature = overlay_signature;
+                h->num_blocks = num_blocks_;
+                h->base = base_.to_address ();
+                h->num_dirty = num_dirty;
+
+                auto * const indices = reinterpret_cast<std::uint64_t *> (
+                    static_cast<std::uint8_t *> (ptr.get ()) + block_size);
+                std::copy (std::begin (dirty), std::end (dirty), indices);
+                auto * const b = reinterpret_cast<block *> (
+                    static_cast<std::uint8_t *> (ptr.get ()) + block_size + index_bytes);
+                for (auto ctr = std::uint64_t{0}; ctr < num_dirty; ++ctr) {
+                    auto const old = db.getro (this->block_address (old_indices, dirty[ctr]),
+                                               block_size);
+                    std::memcpy (&b[ctr], old.get (), block_size);
+                }
+                for (hash_type const hash : pending_) {
+                    auto const pos = std::lower_bound (std::begin (dirty), std::end (dirty),
+                                                       block_index (hash, num_blocks_));
+                    assert (pos != std::end (dirty));
+                    insert (b[pos - std::begin (dirty)], hash);
+                }
+
+                addr_ = typed_address<filter_header>::make (addr);
+                num_dirty_ = num_dirty;
+            }
+
+            // rebuild
+            // ~~~~~~~
+            void membership_filter::rebuild (transaction_base & transaction,
+                                             std::vector<hash_type> const & hashes) {
+                auto const num_blocks = blocks_for (hashes.size ());
+                std::shared_ptr<void> const ptr = this->allocate (transaction, num_blocks);
+                block * const b = blocks (ptr);
+                for (hash_type const hash : hashes) {
+                    insert (b[block_index (hash, num_blocks)], hash);
+                }
+                pending_.clear ();
+            }
+
+            // reset
+            // ~~~~~
+            void membership_filter::reset () noexcept {
+                addr_ = typed_address<filter_header>::null ();
+                base_ = typed_address<filter_header>::null ();
+                num_blocks_ = 0U;
+                num_dirty_ = 0U;
+                pending_.clear ();
+            }
+
+            // overlay_index_bytes
+            // ~~~~~~~~~~~~~~~~~~~
+            std::uint64_t
+            membership_filter::overlay_index_bytes (std::uint64_t const num_dirty) noexcept {
+                return aligned (num_dirty * sizeof (std::uint64_t), std::uint64_t{block_size});
+            }
+
+            // overlay_indices
+            // ~~~~~~~~~~~~~~~
+            address membership_filter::overlay_indices () const noexcept {
+                assert (num_dirty_ > 0U);
+                return addr_.to_address () + block_size;
+            }
+
+            // block_address
+            // ~~~~~~~~~~~~~
+            address membership_filter::block_address (std::uint64_t const * const indices,
+                                                      std::uint64_t const index) const noexcept {
+                assert (index < num_blocks_);
+                if (indices != nullptr) {
+                    auto const * const end = indices + num_dirty_;
+                    auto const * const pos = std::lower_bound (indices, end, index);
+                    if (pos != end && *pos == index) {
+                        return this->overlay_indices () + overlay_index_bytes (num_dirty_) +
+                               block_size * static_cast<std::uint64_t> (pos - indices);
+                    }
+                }
+                return base_.to_address () + block_size * (index + 1U);
+            }
+
+        } // namespace details
+    }     // namespace index
+} // namespace pstore
@@ -44,9 +44,142 @@
 /// \file hamt_map_types.cpp
 #include "pstore/core/hamt_map_types.hpp"
 
+#include <cstring>
 #include <new>
 
 #include "pstore/core/transaction.hpp"
+#include "pstore/support/parallel_for_each.hpp"
+
+namespace {
+
+    using pstore::index::details::hash_index_bits;
+    using pstore::index::details::internal_node;
+    using pstore::index::details::internal_node_bit;
+    using pstore::index::details::linear_node;
+    using pstore::index::details::max_hash_bits;
+
+    /// Describes a heap-resident node which is to be written to the store by
+    /// internal_node::flush_parallel().
+    struct dirty_node {
+        /// The heap node. The node's child references have already been updated to point to the
+        /// in-store locations of their children.
+        void const * node;
+        /// The number of bytes occupied by the node.
+        std::size_t size;
+        /// The store address to which the node will be written.
+        pstore::address addr;
+        /// True if the node is an internal node which is to be written without its fragment
+        /// array. Such a node cannot simply be copied to the store.
+        bool legacy;
+    };
+
+    /// Records the heap nodes visited by internal_node::flush_parallel(). The descendants of the
+    /// root node are owned by this object and are released when it is destroyed.
+    class dirty_nodes {
+    public:
+        dirty_nodes () = default;
+        dirty_nodes (dirty_nodes const &) = delete;
+        dirty_nodes & operator= (dirty_nodes const &) = delete;
+        ~dirty_nodes () noexcept {
+            for (auto const & on : nodes_) {
+                switch (on.kind) {
+                case node_kind::internal:
+                    delete static_cast<internal_node const *> (on.d.node);
+                    break;
+                case node_kind::linear: delete static_cast<linear_node const *> (on.d.node); break;
+                case node_kind::unowned: break;
+                }
+            }
+        }
+
+        void reserve (std::size_t const n) { nodes_.reserve (n); }
+
+        void push (internal_node const * const n, pstore::address const addr, bool const owned,
+                   bool const fragments) {
+            nodes_.push_back ({{n, n->stored_size_bytes (fragments), addr, !fragments},
+                               owned ? node_kind::internal : node_kind::unowned});
+        }
+        void push (linear_node const * const n, pstore::address const addr) {
+            nodes_.push_back ({{n, n->size_bytes (), addr, false}, node_kind::linear});
+        }
+
+        /// Calls \p fn for each of the recorded nodes. Large collections of nodes are divided
+        /// between multiple threads.
+        template <typename Function>
+        void for_each (Function fn) const {
+            auto const call = [&fn] (owned_node const & on) { fn (on.d); };
+            if (nodes_.size () < parallel_threshold) {
+                std::for_each (std::begin (nodes_), std::end (nodes_), call);
+            } else {
+                pstore::cmd_util::parallel_for_each (std::begin (nodes_), std::end (nodes_), call);
+            }
+        }
+
+    private:
+        /// Below this number of nodes, the cost of handing work to the thread pool is likely to
+        /// be greater than that of simply copying the nodes.
+        static constexpr std::size_t parallel_threshold = 256;
+
+        enum class node_kind { internal, linear, unowned };
+        struct owned_node {
+            dirty_node d;
+            node_kind kind;
+        };
+        std::vector<owned_node> nodes_;
+    };
+
+    constexpr std::size_t dirty_nodes::parallel_threshold;
+
+    /// Computes the number of bytes and the number of nodes that are needed to write an internal
+    /// node and all of its heap-resident descendants to the store.
+    void measure (internal_node const & internal, unsigned shifts, bool const fragments,
+                  pstore::gsl::not_null<std::uint64_t *> const bytes,
+                  pstore::gsl::not_null<std::size_t *> const count) {
+        shifts += hash_index_bits;
+        for (auto const & p : internal) {
+            if (p.is_heap ()) {
+                if (shifts < max_hash_bits) {
+                    measure (*p.untag_node<internal_node const *> (), shifts, fragments, bytes,
+                             count);
+                } else {
+                    *bytes += p.untag_node<linear_node const *> ()->size_bytes ();
+                    ++*count;
+                }
+            }
+        }
+        *bytes += internal.stored_size_bytes (fragments);
+        ++*count;
+    }
+
+    /// Assigns store addresses to the heap-resident descendants of an internal node. The addresses
+    /// are allocated depth-first (matching the order used by internal_node::flush()) and the child
+    /// references of each node are updated to point to their new in-store locations. The heap
+    /// nodes are recorded in \p nodes.
+    void layout_children (internal_node * const internal, unsigned shifts, bool const fragments,
+                          pstore::gsl::not_null<pstore::address *> const cursor,
+                          pstore::gsl::not_null<dirty_nodes *> const nodes) {
+        shifts += hash_index_bits;
+        for (auto & p : *internal) {
+            if (p.is_heap ()) {
+                if (shifts < max_hash_bits) { // internal node
+                    assert (p.is_internal ());
+                    auto const child = p.untag_node<internal_node *> ();
+                    layout_children (child, shifts, fragments, cursor, nodes);
+                    nodes->push (child, *cursor, true /*owned*/, fragments);
+                    p = *cursor | internal_node_bit;
+                    *cursor += child->stored_size_bytes (fragments);
+                } else { // linear node
+                    assert (p.is_linear ());
+                    auto const linear = p.untag_node<linear_node *> ();
+                    nodes->push (linear, *cursor);
+                    p = *cursor | internal_node_bit;
+                    *cursor += linear->size_bytes ();
+                }
+            }
+        }
+    }
+
+} // end anonymous namespace
 
 namespace pstore {
     namespace index {
@@ -175,6 +308,28 @@ namespace pstore {
                 return {std::move (ln), p};
             }
 
+            auto linear_node::get_node (pinned_view & view, index_pointer const node)
+                -> std::pair<std::shared_ptr<linear_node const>, linear_node const *> {
+
+                if (node.is_heap ()) {
+                    auto ptr = node.untag_node<linear_node const *> ();
+                    assert (ptr->signature_ == node_signature_);
+                    return {nullptr, ptr};
+                }
+
+                auto const addr = node.untag_linear_address ();
+                std::size_t const in_store_size =
+                    linear_node::size_bytes (view.getro (addr)->size ());
+                auto const * const ln = static_cast<linear_node const *> (
+                    view.getro (addr.to_address (), in_store_size));
+#if PSTORE_SIGNATURE_CHECKS_ENABLED
+                if (ln->signature_ != node_signature_) {
+                    raise (pstore::error_code::index_corrupt);
+                }
+#endif
+                return {nullptr, ln};
+            }
+
             // flush
             // ~~~~~
             address linear_node::flush (transaction_base & transaction) const {
@@ -194,8 +349,13 @@ namespace pstore {
             //*                                                      *
 
             internal_node::signature_type const internal_node::node_signature_ = {
+                {'I', 'n', 't', 'e', 'r', 'n', 'l', '2'}};
+            internal_node::signature_type const internal_node::legacy_node_signature_ = {
                 {'I', 'n', 't', 'e', 'r', 'n', 'a', 'l'}};
 
+            constexpr internal_node::fragment_type internal_node::fragment_valid_bit;
+            constexpr internal_node::fragment_type internal_node::fragment_mask;
+
             // operator new
             // ~~~~~~~~~~~~
             void * internal_node::operator new (std::size_t const s, nchildren const size) {
@@ -236,17 +396,24 @@ namespace pstore {
             // ctor (one child)
             // ~~~~~~~~~~~~~~~~
             internal_node::internal_node (index_pointer const & leaf, hash_type const hash)
-                    : bitmap_{hash_type{1} << hash}
-                    , children_{{leaf}} {}
+                    : bitmap_{hash_type{1} << (hash & hash_index_mask)}
+                    , children_{{leaf}} {
+                assert (!leaf.is_leaf ());
+                // The child is a sub-trie, so there's no hash fragment to record.
+                *this->fragments (1U) = 0U;
+                this->clear_fragment_padding (1U);
+            }
 
             // ctor (two children)
             // ~~~~~~~~~~~~~~~~~~~
             internal_node::internal_node (index_pointer const & existing_leaf,
                                           index_pointer const & new_leaf,
                                           hash_type const existing_hash, hash_type const new_hash)
-                    : bitmap_ (hash_type{1} << existing_hash | hash_type{1} << new_hash) {
+                    : bitmap_ (hash_type{1} << (existing_hash & hash_index_mask) |
+                               hash_type{1} << (new_hash & hash_index_mask)) {
 
-                auto const index_a = get_new_index (new_hash, existing_hash);
+                auto const index_a =
+                    get_new_index (new_hash & hash_index_mask, existing_hash & hash_index_mask);
                 auto const index_b = static_cast<unsigned> (index_a == 0);
 
                 assert ((index_a & 1) == index_a); //! OCLINT(PH - bitwise in conditional is ok)
@@ -255,6 +422,11 @@ namespace pstore {
 
                 children_[index_a] = index_pointer{new_leaf};
                 children_[index_b] = existing_leaf;
+
+                fragment_type * const f = this->fragments (2U);
+                f[index_a] = make_fragment (new_hash);
+                f[index_b] = make_fragment (existing_hash);
+                this->clear_fragment_padding (2U);
             }
 
             // copy ctor
@@ -262,8 +434,24 @@ namespace pstore {
             internal_node::internal_node (internal_node const & rhs)
                     : bitmap_{rhs.bitmap_} {
 
+                auto const size = rhs.size ();
                 auto const first = std::begin (rhs.children_);
-                std::copy (first, first + rhs.size (), std::begin (children_));
+                std::copy (first, first + size, std::begin (children_));
+                // A node without fragments records zero ("unknown") for each of its children.
+                if (rhs.has_fragments ()) {
+                    std::copy_n (rhs.fragments (size), size, this->fragments (size));
+                } else {
+                    std::fill_n (this->fragments (size), size, fragment_type{0});
+                }
+                this->clear_fragment_padding (size);
+            }
+
+            // clear_fragment_padding
+            // ~~~~~~~~~~~~~~~~~~~~~~
+            void internal_node::clear_fragment_padding (std::size_t const num_children) noexcept {
+                std::fill (this->fragments (num_children) + num_children,
+                           this->fragments (num_children) + fragment_bytes (num_children),
+                           fragment_type{0});
             }
 
             // allocate
@@ -301,7 +489,7 @@ namespace pstore {
                 internal_node * inode = nullptr;
                 if (node.is_heap ()) {
                     inode = node.untag_node<internal_node *> ();
-                    assert (inode->signature_ == node_signature_);
+                    assert (inode->has_fragments ());
                 } else {
                     new_node = internal_node::allocate (internal);
                     inode = new_node.get ();
@@ -326,6 +514,19 @@ namespace pstore {
                 return {child, index};
             }
 
+            // may_match
+            // ~~~~~~~~~
+            bool internal_node::may_match (std::size_t const index,
+                                           hash_type const hash) const noexcept {
+                if (!this->has_fragments ()) {
+                    return true;
+                }
+                auto const size = this->size ();
+                assert (index < size);
+                fragment_type const fragment = this->fragments (size)[index];
+                return (fragment & fragment_valid_bit) == 0U || fragment == make_fragment (hash);
+            }
+
             // validate_after_load
             // ~~~~~~~~~~~~~~~~~~~
             /// Perform crude validation of the internal node that we've just read from the
@@ -346,7 +547,8 @@ namespace pstore {
             bool internal_node::validate_after_load (internal_node const & internal,
                                                      typed_address<internal_node> const addr) {
 #if PSTORE_SIGNATURE_CHECKS_ENABLED
-                if (internal.signature_ != node_signature_) {
+                if (internal.signature_ != node_signature_ &&
+                    internal.signature_ != legacy_node_signature_) {
                     return false;
                 }
 #endif
@@ -383,7 +585,7 @@ namespace pstore {
                 if (base->get_bitmap () == 0) {
                     raise (error_code::index_corrupt, db.path ());
                 }
-                std::size_t const actual_size = internal_node::size_bytes (base->size ());
+                std::size_t const actual_size = base->size_bytes ();
                 base.reset ();
 
                 assert (actual_size > sizeof (internal_node) - sizeof (internal_node::children_));
@@ -412,6 +614,33 @@ namespace pstore {
                 return {std::move (store_internal), p};
             }
 
+            auto internal_node::read_node (pinned_view & view,
+                                           typed_address<internal_node> const addr)
+                -> internal_node const * {
+                auto const * const base = static_cast<internal_node const *> (
+                    view.getro (addr.to_address (),
+                                sizeof (internal_node) - sizeof (internal_node::children_)));
+                if (base->get_bitmap () == 0) {
+                    raise (error_code::index_corrupt, view.db ().path ());
+                }
+                std::size_t const actual_size = base->size_bytes ();
+                assert (actual_size > sizeof (internal_node) - sizeof (internal_node::children_));
+                auto const * const resl = static_cast<internal_node const *> (
+                    view.getro (addr.to_address (), actual_size));
+                if (!validate_after_load (*resl, addr)) {
+                    raise (error_code::index_corrupt, view.db ().path ());
+                }
+                return resl;
+            }
+
+            auto internal_node::get_node (pinned_view & view, index_pointer const node)
+                -> std::pair<std::shared_ptr<internal_node const>, internal_node const *> {
+                if (node.is_heap ()) {
+                    return {nullptr, node.untag_node<internal_node *> ()};
+                }
+                return {nullptr, internal_node::read_node (view, node.untag_internal_address ())};
+            }
+
             // insert_child
             // ~~~~~~~~~~~~
             void internal_node::insert_child (hash_type const hash, index_pointer const leaf,
@@ -428,6 +657,13 @@ namespace pstore {
                 assert (old_size < hash_size);
                 assert (index <= old_size);
 
+                // The fragment array follows the children so it must move up to make room for the
+                // new child.
+                {
+                    fragment_type * const old_fragments = this->fragments (old_size);
+                    std::memmove (this->fragments (old_size + 1U), old_fragments, old_size);
+                }
+
                 // Move elements from [index..old_size) to [index+1..old_size+1)
                 {
                     auto const children_span = gsl::make_span (&children_[0], hash_size);
@@ -442,6 +678,13 @@ namespace pstore {
 
                 children_[index] = leaf;
 
+                {
+                    fragment_type * const f = this->fragments (old_size + 1U);
+                    std::move_backward (f + index, f + old_size, f + old_size + 1U);
+                    f[index] = leaf.is_leaf () ? make_fragment (hash) : fragment_type{0};
+                    this->clear_fragment_padding (old_size + 1U);
+                }
+
                 this->bitmap_ = this->bitmap_ | bit_pos;
                 assert (bit_count::pop_count (this->bitmap_) == old_size + 1);
                 parents->push ({index_pointer{this}, index});
@@ -450,15 +693,27 @@ namespace pstore {
             // store_node
             // ~~~~~~~~~~
             address internal_node::store_node (transaction_base & transaction) const {
-                std::size_t const num_bytes = internal_node::size_bytes (this->size ());
+                bool const fragments = transaction.db ().writes_index_fragments ();
+                std::size_t const num_bytes = this->stored_size_bytes (fragments);
 
                 std::shared_ptr<void> ptr;
                 address result;
                 std::tie (ptr, result) = transaction.alloc_rw (num_bytes, alignof (internal_node));
-                new (ptr.get ()) internal_node (*this);
+                this->write (ptr.get (), fragments);
                 return result;
             }
 
+            // write
+            // ~~~~~
+            void internal_node::write (void * const dest, bool const fragments) const {
+                if (fragments) {
+                    new (dest) internal_node (*this);
+                    return;
+                }
+                std::memcpy (dest, this, legacy_size_bytes (this->size ()));
+                static_cast<internal_node *> (dest)->signature_ = legacy_node_signature_;
+            }
+
             // flush
             // ~~~~~
             address internal_node::flush (transaction_base & transaction, unsigned shifts) {
@@ -483,6 +738,47 @@ namespace pstore {
                 return this->store_node (transaction) | internal_node_bit;
             }
 
+            // flush_parallel
+            // ~~~~~~~~~~~~~~
+            address internal_node::flush_parallel (transaction_base & transaction,
+                                                   unsigned const shifts) {
+                static_assert (alignof (internal_node) == alignof (linear_node),
+                               "internal and linear nodes must have the same alignment");
+
+                // Work out how much space is needed for all of the nodes and allocate it in one
+                // block. Every node size is a multiple of the alignment so the nodes can be packed
+                // exactly as they would be by a series of individual allocations.
+                bool const fragments = transaction.db ().writes_index_fragments ();
+                auto bytes = std::uint64_t{0};
+                auto count = std::size_t{0};
+                measure (*this, shifts, fragments, &bytes, &count);
+                assert (bytes % alignof (internal_node) == 0);
+                address cursor = transaction.allocate (bytes, alignof (internal_node));
+
+                // Assign each node its final address. From this point the heap-resident children
+                // are owned by 'nodes' which will delete them once they have been written (or if
+                // an exception is raised).
+                dirty_nodes nodes;
+                nodes.reserve (count);
+                layout_children (this, shifts, fragments, &cursor, &nodes);
+                address const result = cursor;
+                nodes.push (this, result, false /*owned*/, fragments);
+
+                // Each of the nodes can now be copied to its place in the store independently of
+                // all of the others. The nodes are standard-layout and (unless an internal node is
+                // written without its fragments) their in-store representation is simply a copy
+                // of the heap node's bytes.
+                nodes.for_each ([&transaction] (dirty_node const & dn) {
+                    std::shared_ptr<void> const dest = transaction.getrw (dn.addr, dn.size);
+                    if (dn.legacy) {
+                        static_cast<internal_node const *> (dn.node)->write (dest.get (), false);
+                    } else {
+                        std::memcpy (dest.get (), dn.node, dn.size);
+                    }
+                });
+                return result | internal_node_bit;
+            }
+
         } // namespace details
     }     // namespace index
 } // namespace pstore
@@ -61,7 +61,12 @@ namespace {
                       unsigned const generation) {
         pstore::database & db = transaction.db ();
         if (auto const index = pstore::index::get_index<Index> (db, false /*create*/)) {
-            (*locations)[index_integral (Index)] = index->flush (transaction, generation);
+            auto & location = (*locations)[index_integral (Index)];
+            // An index which has never held an entry need not be written.
+            if (location != pstore::typed_address<pstore::index::header_block>::null () ||
+                !index->empty ()) {
+                location = index->flush (transaction, generation);
+            }
         }
     }
 
@@ -43,6 +43,12 @@
 //===----------------------------------------------------------------------===//
 #include "pstore/core/indirect_string.hpp"
 
+#include <algorithm>
+
+#include "pstore/serialize/archive.hpp"
+#include "pstore/support/aligned.hpp"
+#include "pstore/support/fnv.hpp"
+
 namespace pstore {
 
     raw_sstring_view
@@ -61,6 +67,10 @@ namespace pstore {
 
     bool indirect_string::operator== (indirect_string const & rhs) const {
         assert (&db_ == &rhs.db_);
+        // If both hashes are known, differing hashes avoid the need to load either string.
+        if (has_hash_ && rhs.has_hash_ && hash_ != rhs.hash_) {
+            return false;
+        }
         shared_sstring_view lhs_owner;
         shared_sstring_view rhs_owner;
         return this->as_string_view (&lhs_owner) == rhs.as_string_view (&rhs_owner);
@@ -85,6 +95,14 @@ namespace pstore {
                                                                value_type & value) {
             database const & db = archive.get_db ();
             auto const addr = *db.getro (typed_address<address>::make (archive.get_address ()));
+            if (addr.absolute () & indirect_string::hash_follows_mask) {
+                auto const hashed = *db.getro (
+                    typed_address<indirect_string::hashed_address>::make (archive.get_address ()));
+                new (&value) value_type (
+                    db, address{addr.absolute () & ~indirect_string::hash_follows_mask},
+                    hashed.hash);
+                return;
+            }
             new (&value) value_type (db, addr);
         }
 
@@ -111,6 +129,85 @@ namespace pstore {
     indirect_string_adder::indirect_string_adder (std::size_t const expected_size) {
         views_.reserve (expected_size);
     }
+    indirect_string_adder::indirect_string_adder (std::size_t const expected_size,
+                                                  bool const store_hashes)
+            : store_hashes_{store_hashes} {
+        views_.reserve (expected_size);
+    }
+
+    constexpr std::size_t indirect_string_adder::body_alignment;
+
+    // stores_hashes
+    // ~~~~~~~~~~~~~
+    bool indirect_string_adder::stores_hashes (database const & db) const noexcept {
+        return store_hashes_ && db.minor_version () >= header::indirect_string_hash_version;
+    }
+
+    // make_batch [static]
+    // ~~~~~~~~~~
+    auto indirect_string_adder::make_batch (std::vector<raw_sstring_view const *> const & strings)
+        -> std::vector<batch_member> {
+        auto const count = strings.size ();
+        std::vector<void const *> bufs;
+        std::vector<std::size_t> lens;
+        bufs.reserve (count);
+        lens.reserve (count);
+        for (raw_sstring_view const * const str : strings) {
+            bufs.push_back (str->data ());
+            lens.push_back (str->size ());
+        }
+        std::vector<std::uint64_t> hashes (count);
+        fnv_64a_bufs (count, bufs.data (), lens.data (), hashes.data ());
+
+        // The index consumes hash bits starting with the least significant. Reversing the bits
+        // gives a sort key which places strings that share a path through the tree next to one
+        // another.
+        auto const reverse_bits = [] (std::uint64_t v) {
+            v = ((v >> 1U) & UINT64_C (0x5555555555555555)) |
+                ((v & UINT64_C (0x5555555555555555)) << 1U);
+            v = ((v >> 2U) & UINT64_C (0x3333333333333333)) |
+                ((v & UINT64_C (0x3333333333333333)) << 2U);
+            v = ((v >> 4U) & UINT64_C (0x0F0F0F0F0F0F0F0F)) |
+                ((v & UINT64_C (0x0F0F0F0F0F0F0F0F)) << 4U);
+            v = ((v >> 8U) & UINT64_C (0x00FF00FF00FF00FF)) |
+                ((v & UINT64_C (0x00FF00FF00FF00FF)) << 8U);
+            v = ((v >> 16U) & UINT64_C (0x0000FFFF0000FFFF)) |
+                ((v & UINT64_C (0x0000FFFF0000FFFF)) << 16U);
+            return (v >> 32U) | (v << 32U);
+        };
+
+        std::vector<batch_member> members;
+        members.reserve (count);
+        for (auto ctr = std::size_t{0}; ctr < count; ++ctr) {
+            members.push_back (
+                batch_member{hashes[ctr], reverse_bits (hashes[ctr]), strings[ctr], ctr});
+        }
+        // Strings with equal hashes are ordered by value so that duplicates are adjacent. This
+        // comparison touches only the in-memory strings, never those already in the store.
+        std::sort (std::begin (members), std::end (members),
+                   [] (batch_member const & a, batch_member const & b) {
+                       if (a.key != b.key) {
+                           return a.key < b.key;
+                       }
+                       return *a.str < *b.str;
+                   });
+        return members;
+    }
+
+    // serialize_bodies
+    // ~~~~~~~~~~~~~~~~
+    std::vector<std::uint8_t> indirect_string_adder::serialize_bodies (
+        gsl::not_null<std::vector<std::size_t> *> const offsets) const {
+        std::vector<std::uint8_t> bodies;
+        serialize::archive::vector_writer writer{bodies};
+        for (auto const & v : views_) {
+            // Each body must be aligned so that the least-significant bit of its address is clear.
+            bodies.resize (aligned (bodies.size (), body_alignment));
+            offsets->push_back (bodies.size ());
+            serialize::write (writer, *v.first);
+        }
+        return bodies;
+    }
 
     // read
     // ~~~~
@@ -0,0 +1,99 @@
+//*        _                      _         _                *
+//*  _ __ (_)_ __  _ __   ___  __| | __   _(_) _____      __ *
+//* | '_ \| | '_ \| '_ \ / _ \/ _` | \ \ / / |/ _ \ \ /\ / / *
+//* | |_) | | | | | | | |  __/ (_| |  \ V /| |  __/\ V  V /  *
+//* | .__/|_|_| |_|_| |_|\___|\__,_|   \_/ |_|\___| \_/\_/   *
+//* |_|                                                      *
+//===- lib/core/pinned_view.cpp -------------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file pinned_view.cpp
+/// \brief Implements pinned_view: a read-only database view which hands out raw pointers.
+
+#include "pstore/core/pinned_view.hpp"
+
+#include <cstring>
+
+namespace pstore {
+
+    // getro
+    // ~~~~~
+    void const * pinned_view::getro (address const addr, std::size_t const size) {
+        std::uint64_t const start = addr.absolute ();
+        if (start > limit_ || size > limit_ - start) {
+            raise (error_code::bad_address);
+        }
+
+        auto const & store = db_.storage ();
+        store.ensure_mapped (addr, size);
+        if (!store.request_spans_regions (addr, size)) {
+            return store.address_to_raw_pointer (addr);
+        }
+        return this->spanning_copy (addr, size);
+    }
+
+    // spanning_copy
+    // ~~~~~~~~~~~~~
+    std::uint8_t const * pinned_view::spanning_copy (address const addr, std::size_t const size) {
+        // The data below limit_ is immutable so an existing copy which covers the request can be
+        // reused.
+        auto const pos = index_.find (addr.absolute ());
+        if (pos != index_.end () && pos->second.size >= size) {
+            return pos->second.data;
+        }
+
+        // A smaller copy of the same block is superseded in the index but remains allocated: the
+        // caller may still hold a pointer to it.
+        copies_.emplace_back (new std::uint8_t[size]);
+        std::uint8_t * const result = copies_.back ().get ();
+        index_[addr.absolute ()] = copy{size, result};
+        db_.storage ().copy<storage::copy_from_store_traits> (
+            addr, size, result,
+            [](std::uint8_t const * const src, std::uint8_t * const dest, std::size_t const n) {
+                std::memcpy (dest, src, n);
+            });
+        return result;
+    }
+
+    // release
+    // ~~~~~~~
+    void pinned_view::release () noexcept {
+        index_.clear ();
+        copies_.clear ();
+    }
+
+} // namespace pstore
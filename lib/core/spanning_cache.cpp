@@ -0,0 +1,179 @@
+//*                              _                              _           *
+//*  ___ _ __   __ _ _ __  _ __ (_)_ __   __ _    ___ __ _  ___| |__   ___  *
+//* / __| '_ \ / _` | '_ \| '_ \| | '_ \ / _` |  / __/ _` |/ __| '_ \ / _ \ *
+//* \__ \ |_) | (_| | | | | | | | | | | | (_| | | (_| (_| | (__| | | |  __/ *
+//* |___/ .__/ \__,_|_| |_|_| |_|_|_| |_|\__, |  \___\__,_|\___|_| |_|\___| *
+//*     |_|                              |___/                              *
+//===- lib/core/spanning_cache.cpp ----------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file spanning_cache.cpp
+/// \brief Implements the cache of blocks built when a read request spans more than one region.
+
+#include "pstore/core/spanning_cache.hpp"
+
+namespace pstore {
+
+    constexpr std::size_t spanning_cache::default_capacity;
+    constexpr std::size_t spanning_cache::num_shards;
+
+    // (ctor)
+    // ~~~~~~
+    spanning_cache::spanning_cache (std::size_t const capacity)
+            : shard_capacity_{capacity / num_shards} {}
+
+    // (dtor)
+    // ~~~~~~
+    spanning_cache::~spanning_cache () noexcept = default;
+
+    // find
+    // ~~~~
+    std::shared_ptr<void const> spanning_cache::find (address const addr, std::size_t const size) {
+        key const k{addr, size};
+        std::shared_ptr<void const> result = this->get_shard (k).find (k);
+        (result ? hits_ : misses_).fetch_add (1U, std::memory_order_relaxed);
+        return result;
+    }
+
+    // insert
+    // ~~~~~~
+    void spanning_cache::insert (address const addr, std::size_t const size,
+                                 std::shared_ptr<void const> const & block) {
+        if (size > shard_capacity_) {
+            return;
+        }
+        key const k{addr, size};
+        this->get_shard (k).insert (k, block, shard_capacity_);
+    }
+
+    // clear
+    // ~~~~~
+    void spanning_cache::clear () {
+        for (shard & s : shards_) {
+            s.clear ();
+        }
+    }
+
+    // stats
+    // ~~~~~
+    auto spanning_cache::stats () const noexcept -> statistics {
+        statistics result;
+        result.hits = hits_.load (std::memory_order_relaxed);
+        result.misses = misses_.load (std::memory_order_relaxed);
+        return result;
+    }
+
+    // size_bytes
+    // ~~~~~~~~~~
+    std::size_t spanning_cache::size_bytes () const {
+        std::size_t result = 0;
+        for (shard const & s : shards_) {
+            result += s.size_bytes ();
+        }
+        return result;
+    }
+
+    // key_hash::operator()
+    // ~~~~~~~~~~~~~~~~~~~~
+    std::size_t spanning_cache::key_hash::operator() (key const & k) const noexcept {
+        // Spanning blocks are large, so the low bits of their addresses carry little
+        // information. Mix the address and size so that neighbouring blocks land in different
+        // shards.
+        std::uint64_t h = k.addr.absolute () ^ (std::uint64_t{k.size} << 32U);
+        h ^= h >> 33U;
+        h *= UINT64_C (0xff51afd7ed558ccd);
+        h ^= h >> 33U;
+        return static_cast<std::size_t> (h);
+    }
+
+    //*      _                   _  *
+    //*  ___| |__   __ _ _ __ __| | *
+    //* / __| '_ \ / _` | '__/ _` | *
+    //* \__ \ | | | (_| | | | (_| | *
+    //* |___/_| |_|\__,_|_|  \__,_| *
+    //*                             *
+    // find
+    // ~~~~
+    std::shared_ptr<void const> spanning_cache::shard::find (key const & k) {
+        std::lock_guard<std::mutex> const lock{mut_};
+        auto const pos = map_.find (k);
+        if (pos == map_.end ()) {
+            return nullptr;
+        }
+        // Move this entry to the front of the LRU list.
+        lru_.splice (lru_.begin (), lru_, pos->second);
+        return pos->second->second;
+    }
+
+    // insert
+    // ~~~~~~
+    void spanning_cache::shard::insert (key const & k, std::shared_ptr<void const> const & block,
+                                        std::size_t const capacity) {
+        std::lock_guard<std::mutex> const lock{mut_};
+        if (map_.find (k) != map_.end ()) {
+            return;
+        }
+        lru_.emplace_front (k, block);
+        map_.emplace (k, lru_.begin ());
+        bytes_ += k.size;
+
+        // Evict the least-recently used entries until we're back within our capacity.
+        while (bytes_ > capacity) {
+            entry const & victim = lru_.back ();
+            bytes_ -= victim.first.size;
+            map_.erase (victim.first);
+            lru_.pop_back ();
+        }
+    }
+
+    // clear
+    // ~~~~~
+    void spanning_cache::shard::clear () {
+        std::lock_guard<std::mutex> const lock{mut_};
+        map_.clear ();
+        lru_.clear ();
+        bytes_ = 0;
+    }
+
+    // size_bytes
+    // ~~~~~~~~~~
+    std::size_t spanning_cache::shard::size_bytes () const {
+        std::lock_guard<std::mutex> const lock{mut_};
+        return bytes_;
+    }
+
+} // namespace pstore
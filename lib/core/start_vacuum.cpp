@@ -44,18 +44,35 @@
 
 #include "pstore/core/start_vacuum.hpp"
 
+// Standard includes
+#include <cstring>
+#include <string>
+
 // Local (public) includes
 #include "pstore/broker_intf/fifo_path.hpp"
+#include "pstore/broker_intf/message_ring.hpp"
 #include "pstore/broker_intf/send_message.hpp"
 #include "pstore/broker_intf/writer.hpp"
 #include "pstore/core/database.hpp"
+#include "pstore/os/shared_memory.hpp"
 
 namespace pstore {
 
     void start_vacuum (database const & db) {
         broker::fifo_path const fifo (nullptr);
         broker::writer wr (fifo);
-        broker::send_message (wr, false /*error on timeout*/, "GC", db.path ().c_str ());
+        std::string const & path = db.path ();
+        if (broker::message_ring::wanted (std::strlen ("GC ") + path.length ())) {
+            // The ring is owned by the broker: we must not create it if the broker hasn't (there
+            // may be no broker running) nor remove it when we are done. If it doesn't exist,
+            // get() returns nullptr and the message is sent through the FIFO.
+            shared_memory<broker::message_ring> ring{broker::message_ring_name (fifo),
+                                                     shared_memory_unlink::never,
+                                                     shared_memory_create::never};
+            broker::send_message (wr, false /*error on timeout*/, "GC", path.c_str (), ring.get ());
+            return;
+        }
+        broker::send_message (wr, false /*error on timeout*/, "GC", path.c_str ());
     }
 
 } // namespace pstore
@@ -46,6 +46,9 @@
 #include "pstore/core/storage.hpp"
 #include "pstore/core/file_header.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 namespace {
 
     ///@{
@@ -90,6 +93,16 @@ namespace pstore {
             // Allocate new memory region(s) to accommodate the additional bytes requested.
             region_factory_->add (&regions_, old_size, new_size);
             this->update_master_pointers (old_num_regions);
+            if (access_pattern_ != access_pattern::normal) {
+                // (Deferred regions receive the access pattern when they are mapped.)
+                std::for_each (std::next (std::begin (regions_),
+                                          static_cast<std::ptrdiff_t> (old_num_regions)),
+                               std::end (regions_), [this] (region::memory_mapper_ptr const & r) {
+                                   if (r->is_mapped ()) {
+                                       r->advise (r->data ().get (), r->size (), access_pattern_);
+                                   }
+                               });
+            }
         } else if (new_size < old_size) {   // if shrinking the storage
             bool done = false;
             // we now look backwards through the regions, discarding segments and regions introduced by this transaction
@@ -122,7 +135,7 @@ namespace pstore {
             assert (old_length < regions_.size ());
             region::memory_mapper_ptr const & region = regions_[old_length - 1];
             last_sat_entry = (region->offset () + region->size ()) / address::segment_size;
-            assert (sat_->at (last_sat_entry - 1).value != nullptr);
+            assert (sat_->at (last_sat_entry - 1).region != nullptr);
         }
 
         auto segment_it = std::begin (*sat_);
@@ -161,6 +174,17 @@ namespace pstore {
                                               sat_iterator const segment_end) -> sat_iterator {
 
         (void) segment_end; // silence unused argument warning in release build.
+        if (!region->is_mapped ()) {
+            // A deferred region: record the region so that it can be mapped on first use.
+            for (auto ctr = region->size () / address::segment_size; ctr > 0U; --ctr) {
+                assert (segment_it != segment_end);
+                assert (segment_it->value == nullptr && segment_it->region == nullptr);
+                segment_it->region = region;
+                ++segment_it;
+            }
+            return segment_it;
+        }
+
         std::shared_ptr<void> const data = region->data ();
 
         auto ptr = std::static_pointer_cast<std::uint8_t> (data).get ();
@@ -189,27 +213,110 @@ namespace pstore {
                           address{round_down (leader_size + page_size - 1U, page_size)});
         last = round_down (last, page_size);
 
+        std::unique_lock<std::mutex> lock;
+        if (lazy_ != nullptr) {
+            // Record the range so that it can be applied to regions that are mapped later.
+            lock = std::unique_lock<std::mutex>{lazy_->mut};
+            lazy_->protect_first = first;
+            lazy_->protect_last = last;
+        }
+
         auto const end = regions_.rend ();
         for (auto region_it = regions_.rbegin (); region_it != end; ++region_it) {
             std::shared_ptr<memory_mapper_base> & region = *region_it;
 
             assert (region->offset () % page_size == 0);
-            std::uint64_t const first_offset = std::max (region->offset (), first.absolute ());
-            std::uint64_t const last_offset =
-                std::min (region->offset () + region->size (), last.absolute ());
-
-            if (region->offset () + region->size () < first_offset) {
+            if (region->offset () + region->size () < first.absolute ()) {
                 break;
             }
+            if (region->is_mapped ()) {
+                storage::protect_region (*region, first, last);
+            }
+        }
+    }
+
+    // protect_region [static]
+    // ~~~~~~~~~~~~~~
+    void storage::protect_region (memory_mapper_base & region, address const first,
+                                  address const last) {
+        std::uint64_t const first_offset = std::max (region.offset (), first.absolute ());
+        std::uint64_t const last_offset = std::min (region.end (), last.absolute ());
+        if (last_offset > first_offset) {
+            assert (last_offset - region.offset () <= region.size ());
+            auto * const base = static_cast<std::uint8_t *> (region.data ().get ());
+            region.read_only (base + (first_offset - region.offset ()),
+                              last_offset - first_offset);
+        }
+    }
+
+    // map_segments
+    // ~~~~~~~~~~~~
+    void storage::map_segments (unsigned const first, unsigned const last) const {
+        assert (lazy_ != nullptr && first <= last && last < sat_->size ());
+        std::lock_guard<std::mutex> const lock{lazy_->mut};
+        for (auto segment = first; segment <= last; ++segment) {
+            if (lazy_->mapped[segment].load (std::memory_order_relaxed)) {
+                continue;
+            }
+            region::memory_mapper_ptr const region = (*sat_)[segment].region;
+            if (region == nullptr) {
+                // This segment lies beyond the end of the store.
+                continue;
+            }
 
-            if (first_offset >= first.absolute () && last_offset > first_offset) {
-                auto const pfirst =
-                    this->address_to_pointer (typed_address<std::uint8_t>::make (first_offset));
+            region->map ();
+            if (access_pattern_ != access_pattern::normal) {
+                region->advise (region->data ().get (), region->size (), access_pattern_);
+            }
+            storage::protect_region (*region, lazy_->protect_first, lazy_->protect_last);
 
-                assert (pfirst >= region->data ());
-                assert (last_offset - region->offset () <= region->size ());
+            // Fill in the segment address table entries for the whole region.
+            std::shared_ptr<void> const data = region->data ();
+            auto * ptr = static_cast<std::uint8_t *> (data.get ());
+            auto const region_first = region->offset () / address::segment_size;
+            auto const region_last = region_first + region->size () / address::segment_size;
+            for (auto s = region_first; s < region_last; ++s, ptr += address::segment_size) {
+                sat_entry & entry = (*sat_)[s];
+                assert (entry.region == region);
+                entry.value = std::shared_ptr<void> (data, ptr);
+                lazy_->mapped[s].store (true, std::memory_order_release);
+            }
+        }
+    }
 
-                region->read_only (pfirst.get (), last_offset - first_offset);
+    // advise
+    // ~~~~~~
+    void storage::advise (address const first, address const last,
+                          access_pattern const pattern) const {
+        std::unique_lock<std::mutex> lock;
+        if (lazy_ != nullptr) {
+            lock = std::unique_lock<std::mutex>{lazy_->mut};
+        }
+        for (region::memory_mapper_ptr const & region : regions_) {
+            if (!region->is_mapped ()) {
+                continue;
+            }
+            std::uint64_t const first_offset = std::max (region->offset (), first.absolute ());
+            std::uint64_t const last_offset = std::min (region->end (), last.absolute ());
+            if (last_offset > first_offset) {
+                auto * const base = static_cast<std::uint8_t *> (region->data ().get ());
+                region->advise (base + (first_offset - region->offset ()),
+                                last_offset - first_offset, pattern);
+            }
+        }
+    }
+
+    // set_access_pattern
+    // ~~~~~~~~~~~~~~~~~~
+    void storage::set_access_pattern (access_pattern const pattern) {
+        std::unique_lock<std::mutex> lock;
+        if (lazy_ != nullptr) {
+            lock = std::unique_lock<std::mutex>{lazy_->mut};
+        }
+        access_pattern_ = pattern;
+        for (region::memory_mapper_ptr const & region : regions_) {
+            if (region->is_mapped ()) {
+                region->advise (region->data ().get (), region->size (), pattern);
             }
         }
     }
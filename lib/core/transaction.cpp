@@ -45,6 +45,8 @@
 /// \brief Data store transaction implementation
 #include "pstore/core/transaction.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "pstore/core/index_types.hpp"
@@ -123,16 +125,40 @@ namespace pstore {
             // This must happen before the transaction is final because we're allocating and
             // writing data here.
 
-            auto locations = prev_footer->a.index_records;
+            trailer::index_records_array locations =
+                trailer::get_index_records (db, head.footer_pos.load ());
             index::flush_indices (*this, &locations, generation);
 
+            // The locations of the indices which have no slot in the trailer are recorded by an
+            // extension record.
+            auto const extension_first = std::begin (locations) + trailer::num_trailer_indices;
+            auto extension_pos = typed_address<trailer::extension>::null ();
+            if (std::any_of (extension_first, std::end (locations),
+                             [] (typed_address<index::header_block> const addr) {
+                                 return addr != typed_address<index::header_block>::null ();
+                             })) {
+                if (db.minor_version () < header::shared_payload_version) {
+                    raise (error_code::header_version_mismatch, db.path ());
+                }
+                std::shared_ptr<trailer::extension> extension_ptr;
+                std::tie (extension_ptr, extension_pos) = this->alloc_rw<trailer::extension> ();
+                auto * const e = new (extension_ptr.get ()) trailer::extension;
+                std::copy (extension_first, std::end (locations), std::begin (e->a.index_records));
+                e->crc = e->get_crc ();
+            }
+
             // Writing new data is done. Now we begin to build the new file footer.
             {
                 std::shared_ptr<trailer> trailer_ptr;
                 std::tie (trailer_ptr, new_footer_pos) = this->alloc_rw<trailer> ();
                 auto * const t = new (trailer_ptr.get ()) trailer;
 
-                t->a.index_records = locations;
+                std::copy (std::begin (locations), extension_first,
+                           std::begin (t->a.index_records));
+                if (extension_pos != typed_address<trailer::extension>::null ()) {
+                    t->a.extension_offset = static_cast<std::uint32_t> (
+                        (new_footer_pos.to_address () - extension_pos.to_address ()).absolute ());
+                }
 
                 // Point the new header at the previous version.
                 t->a.generation = generation;
@@ -140,6 +166,8 @@ namespace pstore {
                 t->a.size = size_ - sizeof (trailer);
                 t->a.time = pstore::milliseconds_since_epoch ();
                 t->a.prev_generation = head.footer_pos;
+                t->a.skip_generation = db.find_revision_footer_pos (
+                    head.footer_pos, trailer::skip_generation_number (generation));
                 t->crc = t->get_crc ();
             }
         }
@@ -167,6 +195,9 @@ namespace pstore {
                 db_.truncate (dbsize_);
                 assert (db_.size () == dbsize_);
             }
+            // Any index which was modified by the transaction holds nodes which refer to the
+            // data that has just been discarded.
+            db_.clear_index_cache ();
         }
         return *this;
     }
@@ -44,30 +44,67 @@
 
 #include "pstore/diff/diff_value.hpp"
 
+#include <array>
+#include <functional>
+#include <numeric>
+
 #include "pstore/core/hamt_map.hpp"
 #include "pstore/core/hamt_set.hpp"
 #include "pstore/core/index_types.hpp"
 #include "pstore/core/sstring_view_archive.hpp"
 
 
+namespace {
+
+    using task_type = std::function<pstore::dump::value_ptr ()>;
+
+    // make_task
+    // ~~~~~~~~~
+    /// Loads the index given by \p Index and returns a function which will produce its diff. The
+    /// index is loaded by the caller's thread because doing so may update the database's index
+    /// cache; the returned function only reads from the database.
+    template <pstore::trailer::indices Index>
+    task_type make_task (pstore::gsl::czstring const name, pstore::database & db,
+                         pstore::diff::revision_number const old_revision) {
+        using index_type = typename pstore::index::enum_to_index<Index>::type;
+        std::shared_ptr<index_type const> const index =
+            pstore::index::get_index<Index> (db, true /* create */);
+        pstore::database const & cdb = db;
+        return [name, &cdb, index, old_revision] () {
+            return pstore::dump::make_value (pstore::dump::object::container{
+                {"name", pstore::dump::make_value (name)},
+                {"members", pstore::diff::make_diff (cdb, *index, old_revision)},
+            });
+        };
+    }
+
+} // end anonymous namespace
+
 namespace pstore {
     namespace diff {
 
         dump::value_ptr make_indices_diff (database & db, diff::revision_number const new_revision,
                                            diff::revision_number const old_revision) {
             assert (new_revision >= old_revision);
-            return dump::make_value (
-                {make_index_diff<index::name_index> ("names", db, new_revision, old_revision,
-                                                     index::get_index<trailer::indices::name>),
-                 make_index_diff<index::fragment_index> (
-                     "fragments", db, new_revision, old_revision,
-                     index::get_index<trailer::indices::fragment>),
-                 make_index_diff<index::compilation_index> (
-                     "compilations", db, new_revision, old_revision,
-                     index::get_index<trailer::indices::compilation>),
-                 make_index_diff<index::debug_line_header_index> (
-                     "debug_line_headers", db, new_revision, old_revision,
-                     index::get_index<trailer::indices::debug_line_header>)});
+
+            details::revision_restorer const _{db};
+            db.sync (new_revision);
+
+            std::array<task_type, 4> const tasks{{
+                make_task<trailer::indices::name> ("names", db, old_revision),
+                make_task<trailer::indices::fragment> ("fragments", db, old_revision),
+                make_task<trailer::indices::compilation> ("compilations", db, old_revision),
+                make_task<trailer::indices::debug_line_header> ("debug_line_headers", db,
+                                                                old_revision),
+            }};
+
+            dump::array::container members (tasks.size ());
+            std::array<std::size_t, std::tuple_size<decltype (tasks)>::value> indices;
+            std::iota (std::begin (indices), std::end (indices), std::size_t{0});
+            cmd_util::parallel_for_each (
+                std::begin (indices), std::end (indices),
+                [&] (std::size_t const index) { members[index] = tasks[index] (); });
+            return dump::make_value (std::move (members));
         }
 
     } // namespace diff
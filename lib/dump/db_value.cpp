@@ -149,14 +149,16 @@ namespace pstore {
 
         value_ptr make_contents (database const & db, typed_address<trailer> const footer_pos,
                                  bool const no_times) {
-            array::container array;
-            std::for_each (
-                generation_iterator (&db, footer_pos),
-                generation_iterator (&db, typed_address<trailer>::null ()),
-                [&db, &array, no_times] (pstore::typed_address<pstore::trailer> const fp) {
-                    array.emplace_back (make_generation (db, fp, no_times));
-                });
-            return make_value (std::move (array));
+            // The contents of each generation are read only as they are written: the store as a
+            // whole may be much larger than the available memory.
+            return make_lazy_array ([&db, footer_pos, no_times] (lazy_array::sink const & sink) {
+                std::for_each (
+                    generation_iterator (&db, footer_pos),
+                    generation_iterator (&db, typed_address<trailer>::null ()),
+                    [&db, &sink, no_times] (pstore::typed_address<pstore::trailer> const fp) {
+                        sink (make_generation (db, fp, no_times));
+                    });
+            });
         }
 
     } // end namespace dump
@@ -51,6 +51,7 @@
 #include "pstore/core/db_archive.hpp"
 #include "pstore/core/hamt_map.hpp"
 #include "pstore/core/hamt_set.hpp"
+#include "pstore/mcrepo/shared_payload.hpp"
 
 namespace pstore {
     namespace dump {
@@ -97,7 +98,8 @@ namespace pstore {
 
             (void) sk;
             (void) triple;
-            auto const & payload = section.payload ();
+            std::shared_ptr<void const> owner;
+            auto const payload = repo::load_payload (db, section, &owner);
             value_ptr data_value;
 #ifdef PSTORE_IS_INSIDE_LLVM
             if (sk == repo::section_kind::text) {
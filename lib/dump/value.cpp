@@ -376,6 +376,35 @@ namespace pstore {
         }
 
 
+        //***************************
+        //*   l a z y _ a r r a y   *
+        //***************************
+        // writer
+        // ~~~~~~
+        template <typename OStream>
+        OStream & lazy_array::writer (OStream & os, indent const & ind) const {
+            bool empty = true;
+            gen_ ([&os, &ind, &empty] (value_ptr const & value) {
+                os << '\n' << ind << "- ";
+                value->write_impl (os, ind.next (value->dynamic_cast_object () == nullptr ? 4 : 2));
+                empty = false;
+            });
+            if (empty) {
+                os << "[ ]";
+            }
+            return os;
+        }
+
+        // write_impl
+        // ~~~~~~~~~~
+        std::ostream & lazy_array::write_impl (std::ostream & os, indent const & ind) const {
+            return this->writer (os, ind);
+        }
+        std::wostream & lazy_array::write_impl (std::wostream & os, indent const & ind) const {
+            return this->writer (os, ind);
+        }
+
+
         //*******************
         //*   o b j e c t   *
         //*******************
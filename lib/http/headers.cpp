@@ -161,12 +161,17 @@ namespace {
         return hi;
     }
 
+    header_info if_none_match_header (header_info hi, std::string const & value) {
+        hi.if_none_match = value;
+        return hi;
+    }
+
 } // end anonymous namespace
 
 bool pstore::httpd::header_info::operator== (header_info const & rhs) const {
     return upgrade_to_websocket == rhs.upgrade_to_websocket &&
            connection_upgrade == rhs.connection_upgrade && websocket_key == rhs.websocket_key &&
-           websocket_version == rhs.websocket_version;
+           websocket_version == rhs.websocket_version && if_none_match == rhs.if_none_match;
 }
 
 header_info pstore::httpd::header_info::handler (std::string const & key,
@@ -178,6 +183,7 @@ header_info pstore::httpd::header_info::handler (std::string const & key,
             {"upgrade", upgrade},
             {"sec-websocket-key", sec_websocket_key},
             {"sec-websocket-version", sec_websocket_version},
+            {"if-none-match", if_none_match_header},
         };
     auto const pos = handlers.find (key);
     return pos != handlers.end () ? pos->second (*this, value) : *this;
@@ -0,0 +1,148 @@
+//*                      _              *
+//*  _ __ ___  __ _  ___| |_ ___  _ __  *
+//* | '__/ _ \/ _` |/ __| __/ _ \| '__| *
+//* | | |  __/ (_| | (__| || (_) | |    *
+//* |_|  \___|\__,_|\___|\__\___/|_|    *
+//*                                     *
+//===- lib/http/reactor.cpp -----------------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/http/reactor.hpp"
+
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+
+#    include <algorithm>
+#    include <array>
+#    include <cassert>
+#    include <cerrno>
+
+#    include <sys/epoll.h>
+
+#    include "pstore/support/error.hpp"
+
+namespace {
+
+    std::uint32_t epoll_events (std::uint32_t const events, bool const oneshot) noexcept {
+        using pstore::httpd::reactor;
+        std::uint32_t result = EPOLLRDHUP;
+        if ((events & reactor::readable) != 0U) {
+            result |= EPOLLIN;
+        }
+        if ((events & reactor::writable) != 0U) {
+            result |= EPOLLOUT;
+        }
+        if (oneshot) {
+            result |= EPOLLONESHOT;
+        }
+        return result;
+    }
+
+} // end anonymous namespace
+
+namespace pstore {
+    namespace httpd {
+
+        // (ctor)
+        // ~~~~~~
+        reactor::reactor ()
+                : fd_{::epoll_create1 (EPOLL_CLOEXEC)} {
+            if (!fd_.valid ()) {
+                raise (errno_erc{errno}, "epoll_create1");
+            }
+        }
+
+        // add
+        // ~~~
+        void reactor::add (int const fd, std::uint64_t const token, std::uint32_t const events,
+                           bool const oneshot) {
+            epoll_event ev{};
+            ev.events = epoll_events (events, oneshot);
+            ev.data.u64 = token;
+            if (::epoll_ctl (fd_.native_handle (), EPOLL_CTL_ADD, fd, &ev) != 0) {
+                raise (errno_erc{errno}, "epoll_ctl");
+            }
+        }
+
+        // rearm
+        // ~~~~~
+        void reactor::rearm (int const fd, std::uint64_t const token, std::uint32_t const events) {
+            epoll_event ev{};
+            ev.events = epoll_events (events, true);
+            ev.data.u64 = token;
+            if (::epoll_ctl (fd_.native_handle (), EPOLL_CTL_MOD, fd, &ev) != 0) {
+                raise (errno_erc{errno}, "epoll_ctl");
+            }
+        }
+
+        // remove
+        // ~~~~~~
+        void reactor::remove (int const fd) noexcept {
+            // Before Linux 2.6.9, EPOLL_CTL_DEL required a non-null event pointer.
+            epoll_event ev{};
+            ::epoll_ctl (fd_.native_handle (), EPOLL_CTL_DEL, fd, &ev);
+        }
+
+        // wait
+        // ~~~~
+        std::size_t reactor::wait (gsl::span<event> const events,
+                                   std::chrono::milliseconds const timeout) {
+            constexpr auto max_events = std::size_t{64};
+            std::array<epoll_event, max_events> ready;
+            auto const size = std::min (static_cast<std::size_t> (events.size ()), max_events);
+            int const count = ::epoll_wait (fd_.native_handle (), ready.data (),
+                                            static_cast<int> (size),
+                                            static_cast<int> (timeout.count ()));
+            if (count < 0) {
+                if (errno == EINTR) {
+                    return 0U;
+                }
+                raise (errno_erc{errno}, "epoll_wait");
+            }
+            assert (static_cast<std::size_t> (count) <= size);
+            auto out = events.begin ();
+            std::for_each (ready.begin (), ready.begin () + count, [&out] (epoll_event const & ev) {
+                *(out++) = event{ev.data.u64, (ev.events & EPOLLIN) != 0U,
+                                 (ev.events & EPOLLOUT) != 0U,
+                                 (ev.events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) != 0U};
+            });
+            return static_cast<std::size_t> (count);
+        }
+
+    } // end namespace httpd
+} // end namespace pstore
+
+#endif // PSTORE_HAVE_SYS_EPOLL_H
@@ -45,13 +45,20 @@
 
 // Standard library includes
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <deque>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 // OS-specific includes
 #ifdef _WIN32
@@ -62,20 +69,25 @@
 
 #else
 
+#    include <fcntl.h>
 #    include <netdb.h>
 #    include <sys/socket.h>
 #    include <sys/types.h>
+#    include <sys/uio.h>
 
 #endif
 
 // Local includes
 #include "pstore/broker_intf/descriptor.hpp"
+#include "pstore/broker_intf/signal_cv.hpp"
+#include "pstore/config/config.hpp"
 #include "pstore/http/buffered_reader.hpp"
 #include "pstore/http/error.hpp"
 #include "pstore/http/headers.hpp"
 #include "pstore/http/net_txrx.hpp"
 #include "pstore/http/query_to_kvp.hpp"
 #include "pstore/http/quit.hpp"
+#include "pstore/http/reactor.hpp"
 #include "pstore/http/request.hpp"
 #include "pstore/http/send.hpp"
 #include "pstore/http/serve_dynamic_content.hpp"
@@ -84,6 +96,7 @@
 #include "pstore/http/ws_server.hpp"
 #include "pstore/http/wskey.hpp"
 #include "pstore/os/logging.hpp"
+#include "pstore/os/thread.hpp"
 #include "pstore/support/pubsub.hpp"
 
 namespace {
@@ -160,7 +173,7 @@ namespace {
         }
 
         // Get ready to accept connection requests.
-        if (::listen (fd.native_handle (), 5) < 0) { // allow 5 requests to queue up.
+        if (::listen (fd.native_handle (), SOMAXCONN) < 0) {
             return eo{pstore::httpd::get_last_error ()};
         }
 
@@ -176,9 +189,12 @@ namespace {
 #else
         using size_type = std::size_t;
 #endif //!_WIN32
-        int const gni_err = ::getnameinfo (
-            reinterpret_cast<sockaddr const *> (&client_addr), sizeof (client_addr),
-            host_name.data (), static_cast<size_type> (size), nullptr, socklen_t{0}, 0 /*flags*/);
+        // The numeric form of the address is requested so that a (potentially slow) reverse DNS
+        // lookup cannot stall the server.
+        int const gni_err = ::getnameinfo (reinterpret_cast<sockaddr const *> (&client_addr),
+                                           sizeof (client_addr), host_name.data (),
+                                           static_cast<size_type> (size), nullptr, socklen_t{0},
+                                           NI_NUMERICHOST /*flags*/);
         if (gni_err != 0) {
             return pstore::error_or<std::string>{pstore::httpd::get_last_error ()};
         }
@@ -188,15 +204,13 @@ namespace {
 
 
     // Here we bridge from the std::error_code world to HTTP status codes.
-    void report_error (std::error_code error, pstore::httpd::request_info const & request,
-                       socket_descriptor & socket) {
+    template <typename Sender, typename IO>
+    void report_error (Sender const sender, IO io, std::error_code error,
+                       pstore::httpd::request_info const & request) {
         static constexpr auto crlf = pstore::httpd::crlf;
-        static constexpr auto sender = pstore::httpd::net::network_sender;
 
-        auto report = [&error, &request, &socket](unsigned const code,
-                                                  pstore::gsl::czstring const message) {
-            cerror (sender, std::ref (socket), request.uri ().c_str (), code, message,
-                    error.message ().c_str ());
+        auto report = [&] (unsigned const code, pstore::gsl::czstring const message) {
+            cerror (sender, io, request.uri ().c_str (), code, message, error.message ().c_str ());
         };
 
         log (pstore::logging::priority::error, "Error:", error.message ());
@@ -217,8 +231,7 @@ namespace {
                    << "Sec-WebSocket-Version: " << pstore::httpd::ws_version << crlf
                    << "Server: pstore-httpd" << crlf //
                    << crlf;
-                std::string const & reply = os.str ();
-                sender (socket, as_bytes (pstore::gsl::make_span (reply)));
+                pstore::httpd::send (sender, io, os);
             }
                 return;
 
@@ -242,12 +255,14 @@ namespace {
     }
 
 
-    template <typename Reader, typename IO>
-    pstore::error_or<std::unique_ptr<std::thread>>
-    upgrade_to_ws (Reader & reader, IO io, pstore::httpd::request_info const & request,
-                   pstore::httpd::header_info const & header_contents,
-                   pstore::httpd::channel_container const & channels) {
-        using return_type = pstore::error_or<std::unique_ptr<std::thread>>;
+    // accept_ws_upgrade
+    // ~~~~~~~~~~~~~~~~~
+    /// Validates the headers of a WebSockets upgrade request and sends the server's handshake
+    /// response.
+    template <typename Sender, typename IO>
+    pstore::error_or<IO> accept_ws_upgrade (Sender const sender, IO io,
+                                            pstore::httpd::header_info const & header_contents) {
+        using return_type = pstore::error_or<IO>;
         using pstore::logging::priority;
         assert (header_contents.connection_upgrade && header_contents.upgrade_to_websocket);
 
@@ -264,29 +279,815 @@ namespace {
             return return_type{pstore::httpd::error_code::bad_websocket_version};
         }
 
-
         // Send back the server handshake response.
-        auto const accept_ws_connection = [&header_contents, &io]() {
-            log (priority::info, "Accepting WebSockets upgrade");
+        log (priority::info, "Accepting WebSockets upgrade");
 
-            static constexpr auto crlf = pstore::httpd::crlf;
-            std::string const date = pstore::httpd::http_date (std::chrono::system_clock::now ());
-            std::ostringstream os;
-            // clang-format off
-            os << "HTTP/1.1 101 Switching Protocols" << crlf
-               << "Server: pstore-httpd" << crlf
-               << "Upgrade: WebSocket" << crlf
-               << "Connection: Upgrade" << crlf
-               << "Sec-WebSocket-Accept: " << pstore::httpd::source_key (*header_contents.websocket_key) << crlf
-               << "Date: " << date << crlf
-               << "Last-Modified: " << date << crlf
-               << crlf;
-            // clang-format on
-
-            // Here I assume that the send() IO param is the same as the Reader's IO parameter.
-            return pstore::httpd::send (pstore::httpd::net::network_sender, std::ref (io), os);
+        static constexpr auto crlf = pstore::httpd::crlf;
+        std::string const date = pstore::httpd::http_date (std::chrono::system_clock::now ());
+        std::ostringstream os;
+        // clang-format off
+        os << "HTTP/1.1 101 Switching Protocols" << crlf
+           << "Server: pstore-httpd" << crlf
+           << "Upgrade: WebSocket" << crlf
+           << "Connection: Upgrade" << crlf
+           << "Sec-WebSocket-Accept: " << pstore::httpd::source_key (*header_contents.websocket_key) << crlf
+           << "Date: " << date << crlf
+           << "Last-Modified: " << date << crlf
+           << crlf;
+        // clang-format on
+        return pstore::httpd::send (sender, io, os);
+    }
+
+
+    // serve_content
+    // ~~~~~~~~~~~~~
+    /// Sends the response to a GET request for \p uri.
+    template <typename Sender, typename IO>
+    std::error_code serve_content (Sender const sender, IO io, std::string const & uri,
+                                   pstore::httpd::header_info const & header_contents,
+                                   pstore::romfs::romfs & file_system) {
+        if (!pstore::httpd::details::starts_with (uri, pstore::httpd::dynamic_path)) {
+            return pstore::httpd::serve_static_content (sender, io, uri, file_system,
+                                                        header_contents.if_none_match)
+                .get_error ();
+        }
+        return pstore::httpd::serve_dynamic_content (sender, io, uri).get_error ();
+    }
+
+} // end anonymous namespace
+
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+
+namespace {
+
+    using pstore::httpd::reactor;
+
+    //*  _            __  __             _        *
+    //* | |__  _   _ / _|/ _| ___ _ __  (_) ___   *
+    //* | '_ \| | | | |_| |_ / _ \ '__| | |/ _ \  *
+    //* | |_) | |_| |  _|  _|  __/ |    | | (_) | *
+    //* |_.__/ \__,_|_| |_|  \___|_|    |_|\___/  *
+    //*                                           *
+    using byte_vector = std::vector<std::uint8_t>;
+    using byte_span = pstore::gsl::span<std::uint8_t const>;
+
+    /// Bytes waiting to be sent to a peer. Most output is copied into the queue but static content
+    /// (which lives in the read-only file system for the lifetime of the program) is referenced in
+    /// place. This means that a response's header and body are written to the socket by a single
+    /// gathering send without the body being copied.
+    class output_queue {
+    public:
+        bool empty () const noexcept { return chunks_.empty (); }
+        /// Returns the number of bytes waiting to be sent.
+        std::size_t size () const noexcept { return size_; }
+        void clear () noexcept {
+            chunks_.clear ();
+            offset_ = 0;
+            size_ = 0;
+        }
+
+        /// Appends a copy of the bytes in \p s to the queue.
+        void append (byte_span s);
+        /// Appends a reference to the bytes in \p s to the queue. The memory must remain valid
+        /// until the bytes have been sent.
+        void append_static (byte_span s);
+
+        /// Sends as much of the queue as the socket will accept without blocking.
+        ///
+        /// \param fd  The socket to which the bytes are written.
+        /// \returns An error if the socket failed.
+        std::error_code send (int fd);
+
+    private:
+        struct chunk {
+            /// The bytes of a copied chunk.
+            byte_vector owned;
+            /// The bytes of a static chunk or null if the chunk is a copy.
+            std::uint8_t const * view = nullptr;
+            std::size_t view_size = 0;
+
+            std::uint8_t const * data () const noexcept {
+                return view != nullptr ? view : owned.data ();
+            }
+            std::size_t size () const noexcept {
+                return view != nullptr ? view_size : owned.size ();
+            }
+        };
+        std::deque<chunk> chunks_;
+        /// The number of bytes of the first chunk that have been sent.
+        std::size_t offset_ = 0;
+        /// The number of bytes waiting to be sent.
+        std::size_t size_ = 0;
+    };
+
+    // append
+    // ~~~~~~
+    void output_queue::append (byte_span const s) {
+        if (s.empty ()) {
+            return;
+        }
+        if (chunks_.empty () || chunks_.back ().view != nullptr) {
+            chunks_.emplace_back ();
+        }
+        byte_vector & owned = chunks_.back ().owned;
+        owned.insert (owned.end (), s.begin (), s.end ());
+        size_ += static_cast<std::size_t> (s.size ());
+    }
+
+    // append_static
+    // ~~~~~~~~~~~~~
+    void output_queue::append_static (byte_span const s) {
+        if (s.empty ()) {
+            return;
+        }
+        chunks_.emplace_back ();
+        chunk & c = chunks_.back ();
+        c.view = s.data ();
+        c.view_size = static_cast<std::size_t> (s.size ());
+        size_ += c.view_size;
+    }
+
+    // send
+    // ~~~~
+    std::error_code output_queue::send (int const fd) {
+        static constexpr auto max_iov = std::size_t{16};
+        while (!chunks_.empty ()) {
+            std::array<::iovec, max_iov> iov;
+            std::size_t iovcnt = 0;
+            for (auto it = chunks_.begin (); it != chunks_.end () && iovcnt < max_iov; ++it) {
+                std::size_t const skip = iovcnt == 0 ? offset_ : std::size_t{0};
+                iov[iovcnt].iov_base = const_cast<std::uint8_t *> (it->data () + skip);
+                iov[iovcnt].iov_len = it->size () - skip;
+                ++iovcnt;
+            }
+
+            ::msghdr msg{};
+            msg.msg_iov = iov.data ();
+            msg.msg_iovlen = iovcnt;
+            ssize_t const nsent = ::sendmsg (fd, &msg, MSG_NOSIGNAL);
+            if (nsent < 0) {
+                int const err = errno;
+                if (err == EINTR) {
+                    continue;
+                }
+                if (err == EAGAIN || err == EWOULDBLOCK) {
+                    return {}; // Wait for the socket to become writable.
+                }
+                return pstore::httpd::get_last_error ();
+            }
+
+            // Discard the chunks that have been completely sent.
+            auto remaining = static_cast<std::size_t> (nsent);
+            size_ -= remaining;
+            while (remaining > 0) {
+                std::size_t const available = chunks_.front ().size () - offset_;
+                if (remaining < available) {
+                    offset_ += remaining;
+                    break;
+                }
+                remaining -= available;
+                chunks_.pop_front ();
+                offset_ = 0;
+            }
+        }
+        return {};
+    }
+
+
+    /// The I/O state used by the reactor-driven server. Input is read from a request or frame which
+    /// has already been received in its entirety; output is appended to a connection's output
+    /// queue which is written to the socket as it becomes writable.
+    struct buffer_io {
+        byte_span * input;
+        output_queue * output;
+    };
+
+    // buffer_refiller
+    // ~~~~~~~~~~~~~~~
+    /// The buffered_reader<> refill function used with buffer_io.
+    pstore::error_or_n<buffer_io, pstore::gsl::span<std::uint8_t>::iterator>
+    buffer_refiller (buffer_io const io, pstore::gsl::span<std::uint8_t> const & s) {
+        assert (io.input != nullptr);
+        auto const size = std::min (io.input->size (), s.size ());
+        auto const last = std::copy_n (io.input->begin (), size, s.begin ());
+        *io.input = io.input->subspan (size);
+        return {pstore::in_place, io, last};
+    }
+
+    // buffer_sender
+    // ~~~~~~~~~~~~~
+    /// The sender function used with buffer_io.
+    pstore::error_or<buffer_io> buffer_sender (buffer_io const io, byte_span const & s) {
+        assert (io.output != nullptr);
+        io.output->append (s);
+        return pstore::error_or<buffer_io>{pstore::in_place, io};
+    }
+
+    // send_static
+    // ~~~~~~~~~~~
+    /// Found by argument-dependent lookup from pstore::httpd::serve_static_content(): queues a
+    /// reference to static content rather than a copy of it.
+    template <typename Sender>
+    pstore::error_or<buffer_io> send_static (Sender, buffer_io const io, byte_span const & s) {
+        assert (io.output != nullptr);
+        io.output->append_static (s);
+        return pstore::error_or<buffer_io>{pstore::in_place, io};
+    }
+
+    //*                                  _   _              *
+    //*   ___ ___  _ __  _ __   ___  ___| |_(_) ___  _ __   *
+    //*  / __/ _ \| '_ \| '_ \ / _ \/ __| __| |/ _ \| '_ \  *
+    //* | (_| (_) | | | | | | |  __/ (__| |_| | (_) | | | | *
+    //*  \___\___/|_| |_|_| |_|\___|\___|\__|_|\___/|_| |_| *
+    //*                                                     *
+    /// The state of a single client connection. All members other than token are guarded by mut.
+    class connection {
+    public:
+        enum class mode {
+            http,      ///< Waiting for an HTTP request.
+            websocket, ///< Upgraded to the WebSockets protocol.
+            closing,   ///< Waiting for output to be flushed before the connection is closed.
+            closed,
+        };
+        using subscriber_pointer =
+            pstore::channel<pstore::descriptor_condition_variable>::subscriber_pointer;
+        static constexpr auto no_channel = std::numeric_limits<std::size_t>::max ();
+
+        connection (socket_descriptor && s, std::uint64_t const t) noexcept
+                : fd{std::move (s)}
+                , token{t} {}
+
+        bool output_pending () const noexcept { return !out.empty (); }
+
+        std::mutex mut;
+        socket_descriptor fd;
+        std::uint64_t const token;
+        mode state = mode::http;
+
+        /// Bytes received but not yet consumed.
+        byte_vector in;
+        /// Bytes waiting to be sent.
+        output_queue out;
+
+        /// The WebSockets message being assembled.
+        pstore::httpd::ws_command command;
+        /// The subscription to a pub-sub channel, if any, whose messages are pushed to the peer.
+        subscriber_pointer subscription;
+        /// The index of the condition variable signalled when the subscription has messages.
+        std::size_t cv_index = no_channel;
+    };
+
+    constexpr std::size_t connection::no_channel;
+
+    //*                      _                                             *
+    //*  _ __ ___  __ _  ___| |_ ___  _ __   ___  ___ _ ____   _____ _ __  *
+    //* | '__/ _ \/ _` |/ __| __/ _ \| '__| / __|/ _ \ '__\ \ / / _ \ '__| *
+    //* | | |  __/ (_| | (__| || (_) | |    \__ \  __/ |   \ V /  __/ |    *
+    //* |_|  \___|\__,_|\___|\__\___/|_|    |___/\___|_|    \_/ \___|_|    *
+    //*                                                                    *
+    /// An event-driven server. A fixed pool of worker threads waits on a single reactor for
+    /// activity on the listening socket, on client connections, and on the condition variables of
+    /// the pub-sub channels. Each connection is a state machine which consumes a request or
+    /// WebSockets frame only once it has been received in its entirety so a worker never blocks on
+    /// a slow peer.
+    class reactor_server {
+    public:
+        reactor_server (pstore::romfs::romfs & file_system, pstore::httpd::server_status & status,
+                        pstore::httpd::channel_container const & channels,
+                        socket_descriptor && listener);
+
+        void run (unsigned num_workers);
+
+    private:
+        /// The longest HTTP request (including headers) that will be accepted.
+        static constexpr auto max_request_size = std::size_t{16 * 1024};
+        /// The largest WebSockets frame that will be accepted.
+        static constexpr auto max_frame_size = std::size_t{1024 * 1024};
+        /// Channel messages are moved to a connection's output queue only while it holds fewer
+        /// than this many bytes. The rest wait in the subscription so that its drop and coalesce
+        /// policy applies to a slow peer.
+        static constexpr auto max_pushed_output = std::size_t{16 * 1024};
+
+        enum : std::uint64_t { listener_token, stop_token, first_channel_token };
+        std::uint64_t first_connection_token () const noexcept {
+            return first_channel_token + cvs_.size ();
+        }
+
+        struct channel_entry {
+            pstore::gsl::not_null<pstore::channel<pstore::descriptor_condition_variable> *> chan;
+            std::size_t cv_index;
+        };
+        using gsl_span = pstore::gsl::span<std::uint8_t const>;
+
+        void worker ();
+        void stop ();
+        void dispatch (reactor::event const & ev);
+        void accept_connections ();
+        void channel_ready (std::size_t cv_index);
+        void connection_ready (connection & conn, reactor::event const & ev);
+
+        bool receive (connection & conn);
+        void process_http (connection & conn);
+        void process_websocket (connection & conn);
+        void subscribe (connection & conn, std::string const & uri);
+        bool push_messages (connection & conn);
+        void flush (connection & conn);
+        void rearm_or_close (connection & conn);
+        void close (connection & conn);
+
+        std::shared_ptr<connection> find (std::uint64_t token);
+
+        pstore::romfs::romfs & file_system_;
+        pstore::httpd::server_status & status_;
+        std::unordered_map<std::string, channel_entry> channels_;
+        /// The distinct condition variables of the channels. More than one channel may share a
+        /// condition variable but each must be registered with the reactor just once.
+        std::vector<pstore::descriptor_condition_variable *> cvs_;
+
+        reactor reactor_;
+        socket_descriptor listener_;
+        /// Signalled (and never reset) to wake all of the workers when the server stops.
+        pstore::descriptor_condition_variable stop_cv_;
+        std::atomic<bool> done_{false};
+
+        std::mutex connections_mut_;
+        std::uint64_t next_token_;
+        std::unordered_map<std::uint64_t, std::shared_ptr<connection>> connections_;
+    };
+
+    constexpr std::size_t reactor_server::max_request_size;
+    constexpr std::size_t reactor_server::max_frame_size;
+    constexpr std::size_t reactor_server::max_pushed_output;
+
+    // (ctor)
+    // ~~~~~~
+    reactor_server::reactor_server (pstore::romfs::romfs & file_system,
+                                    pstore::httpd::server_status & status,
+                                    pstore::httpd::channel_container const & channels,
+                                    socket_descriptor && listener)
+            : file_system_{file_system}
+            , status_{status}
+            , listener_{std::move (listener)} {
+        for (auto const & kvp : channels) {
+            pstore::descriptor_condition_variable * const cv = std::get<1> (kvp.second);
+            auto const pos = std::find (cvs_.begin (), cvs_.end (), cv);
+            auto const cv_index = static_cast<std::size_t> (pos - cvs_.begin ());
+            if (pos == cvs_.end ()) {
+                cvs_.push_back (cv);
+            }
+            channels_.emplace (kvp.first, channel_entry{std::get<0> (kvp.second), cv_index});
+        }
+        next_token_ = this->first_connection_token ();
+    }
+
+    // run
+    // ~~~
+    void reactor_server::run (unsigned const num_workers) {
+        reactor_.add (listener_.native_handle (), listener_token, reactor::readable, true);
+        reactor_.add (stop_cv_.wait_descriptor ().native_handle (), stop_token, reactor::readable,
+                      false);
+        for (auto ctr = std::size_t{0}; ctr < cvs_.size (); ++ctr) {
+            reactor_.add (cvs_[ctr]->wait_descriptor ().native_handle (),
+                          first_channel_token + ctr, reactor::readable, true);
+        }
+
+        // The calling thread is the first of the workers.
+        std::vector<std::thread> workers;
+        for (auto ctr = 1U; ctr < num_workers; ++ctr) {
+            workers.emplace_back ([this, ctr] () {
+                auto const name = "http" + std::to_string (ctr);
+                pstore::threads::set_name (name.c_str ());
+                pstore::logging::create_log_stream (name);
+                this->worker ();
+            });
+        }
+        this->worker ();
+        for (std::thread & w : workers) {
+            w.join ();
+        }
+
+        // Close any remaining connections, telling WebSockets peers that we're going away.
+        for (auto const & kvp : connections_) {
+            connection & conn = *kvp.second;
+            std::lock_guard<std::mutex> const lock{conn.mut};
+            if (conn.state == connection::mode::websocket) {
+                send_close_frame (buffer_sender, buffer_io{nullptr, &conn.out},
+                                  pstore::httpd::close_status_code::going_away);
+                this->flush (conn);
+            }
+            reactor_.remove (conn.fd.native_handle ());
+            conn.state = connection::mode::closed;
+        }
+        connections_.clear ();
+    }
+
+    // worker
+    // ~~~~~~
+    void reactor_server::worker () {
+        std::array<reactor::event, 16> events;
+        while (!done_) {
+            std::size_t const count =
+                reactor_.wait (pstore::gsl::make_span (events), std::chrono::milliseconds{-1});
+            for (auto ctr = std::size_t{0}; ctr < count && !done_; ++ctr) {
+                PSTORE_TRY { this->dispatch (events[ctr]); }
+                // clang-format off
+                PSTORE_CATCH (std::exception const & ex, { // clang-format on
+                    log (pstore::logging::priority::error, "Error: ", ex.what ());
+                })
+                // clang-format off
+                PSTORE_CATCH (..., { // clang-format on
+                    log (pstore::logging::priority::error, "Unknown exception");
+                })
+            }
+        }
+    }
+
+    // stop
+    // ~~~~
+    void reactor_server::stop () {
+        done_ = true;
+        stop_cv_.notify_all ();
+    }
+
+    // dispatch
+    // ~~~~~~~~
+    void reactor_server::dispatch (reactor::event const & ev) {
+        if (ev.token == listener_token) {
+            this->accept_connections ();
+        } else if (ev.token == stop_token) {
+            assert (done_);
+        } else if (ev.token < this->first_connection_token ()) {
+            this->channel_ready (static_cast<std::size_t> (ev.token - first_channel_token));
+        } else if (std::shared_ptr<connection> const conn = this->find (ev.token)) {
+            this->connection_ready (*conn, ev);
+        }
+    }
+
+    // find
+    // ~~~~
+    std::shared_ptr<connection> reactor_server::find (std::uint64_t const token) {
+        std::lock_guard<std::mutex> const lock{connections_mut_};
+        auto const pos = connections_.find (token);
+        return pos != connections_.end () ? pos->second : nullptr;
+    }
+
+    // accept_connections
+    // ~~~~~~~~~~~~~~~~~~
+    void reactor_server::accept_connections () {
+        using pstore::logging::priority;
+        for (;;) {
+            // Wait for a connection request.
+            sockaddr_in client_addr{}; // client address.
+            auto clientlen = static_cast<socklen_t> (sizeof (client_addr));
+            socket_descriptor childfd{::accept4 (listener_.native_handle (),
+                                                 reinterpret_cast<struct sockaddr *> (&client_addr),
+                                                 &clientlen, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+            if (!childfd.valid ()) {
+                int const err = errno;
+                if (err == EINTR) {
+                    continue;
+                }
+                if (err != EAGAIN && err != EWOULDBLOCK) {
+                    log (priority::error, "accept", pstore::httpd::get_last_error ().message ());
+                }
+                break;
+            }
+
+            // A connection is used by quit() to wake the server when it is shutting down.
+            if (!status_.listening (pstore::httpd::server_status::http_state::listening)) {
+                this->stop ();
+                return;
+            }
+
+            // Determine who sent the message.
+            assert (clientlen == static_cast<socklen_t> (sizeof (client_addr)));
+            pstore::error_or<std::string> ename = get_client_name (client_addr);
+            if (!ename) {
+                log (priority::error, "getnameinfo", ename.get_error ().message ());
+                continue;
+            }
+            log (priority::info, "Connection from ", ename.get ());
+
+            std::shared_ptr<connection> conn;
+            {
+                std::lock_guard<std::mutex> const lock{connections_mut_};
+                std::uint64_t const token = next_token_++;
+                conn = std::make_shared<connection> (std::move (childfd), token);
+                connections_.emplace (token, conn);
+            }
+            reactor_.add (conn->fd.native_handle (), conn->token, reactor::readable, true);
+        }
+        reactor_.rearm (listener_.native_handle (), listener_token, reactor::readable);
+    }
+
+    // channel_ready
+    // ~~~~~~~~~~~~~
+    void reactor_server::channel_ready (std::size_t const cv_index) {
+        assert (cv_index < cvs_.size ());
+        pstore::descriptor_condition_variable * const cv = cvs_[cv_index];
+        cv->reset ();
+
+        std::vector<std::shared_ptr<connection>> subscribers;
+        {
+            std::lock_guard<std::mutex> const lock{connections_mut_};
+            subscribers.reserve (connections_.size ());
+            for (auto const & kvp : connections_) {
+                subscribers.push_back (kvp.second);
+            }
+        }
+
+        // Push messages to each of our peers that is subscribed to a channel using this
+        // condition variable.
+        for (std::shared_ptr<connection> const & conn : subscribers) {
+            std::lock_guard<std::mutex> const lock{conn->mut};
+            if (conn->state != connection::mode::websocket || !conn->subscription ||
+                conn->cv_index != cv_index) {
+                continue;
+            }
+            this->flush (*conn);
+            if (this->push_messages (*conn)) {
+                this->flush (*conn);
+            }
+            this->rearm_or_close (*conn);
+        }
+        reactor_.rearm (cv->wait_descriptor ().native_handle (), first_channel_token + cv_index,
+                        reactor::readable);
+    }
+
+    // connection_ready
+    // ~~~~~~~~~~~~~~~~
+    void reactor_server::connection_ready (connection & conn, reactor::event const & ev) {
+        std::lock_guard<std::mutex> const lock{conn.mut};
+        if (conn.state == connection::mode::closed) {
+            return;
+        }
+        if (ev.readable || ev.hangup) {
+            bool const open = this->receive (conn);
+            switch (conn.state) {
+            case connection::mode::http: this->process_http (conn); break;
+            case connection::mode::websocket: this->process_websocket (conn); break;
+            case connection::mode::closing:
+            case connection::mode::closed: break;
+            }
+            if (!open) {
+                conn.state = connection::mode::closing;
+            }
+        }
+        this->flush (conn);
+        // Making room in the output queue may allow channel messages that were left waiting to
+        // be sent.
+        if (this->push_messages (conn)) {
+            this->flush (conn);
+        }
+        this->rearm_or_close (conn);
+    }
+
+    // receive
+    // ~~~~~~~
+    /// Reads the data available on a connection's socket. Returns false if the peer has closed the
+    /// connection or an error occurred.
+    bool reactor_server::receive (connection & conn) {
+        // Stop reading once we have more than enough to hold the largest request or frame that
+        // will be accepted: the input processing functions will reject it.
+        constexpr auto max_input = std::max (max_request_size, max_frame_size) + 1U;
+        std::array<std::uint8_t, 4096> buffer;
+        while (conn.in.size () < max_input) {
+            ssize_t const nread = ::recv (conn.fd.native_handle (), buffer.data (), buffer.size (),
+                                          0 /*flags*/);
+            if (nread > 0) {
+                conn.in.insert (conn.in.end (), buffer.data (), buffer.data () + nread);
+                continue;
+            }
+            if (nread == 0) {
+                return false; // The peer closed the connection.
+            }
+            int const err = errno;
+            if (err == EINTR) {
+                continue;
+            }
+            if (err == EAGAIN || err == EWOULDBLOCK) {
+                break;
+            }
+            log (pstore::logging::priority::error, "recv",
+                 pstore::httpd::get_last_error ().message ());
+            return false;
+        }
+        return true;
+    }
+
+    // process_http
+    // ~~~~~~~~~~~~
+    void reactor_server::process_http (connection & conn) {
+        using pstore::logging::priority;
+        pstore::maybe<std::size_t> const length =
+            pstore::httpd::details::request_length (pstore::gsl::make_span (conn.in));
+        if (!length) {
+            if (conn.in.size () > max_request_size) {
+                log (priority::error, "HTTP request too long");
+                conn.state = connection::mode::closing;
+            }
+            return;
+        }
+
+        // The connection is closed once this request has been served unless it is upgraded to
+        // the WebSockets protocol.
+        conn.state = connection::mode::closing;
+
+        gsl_span input = pstore::gsl::make_span (conn.in.data (), *length);
+        buffer_io const io{&input, &conn.out};
+        auto reader = pstore::httpd::make_buffered_reader<buffer_io> (buffer_refiller);
+
+        // Get the HTTP request line.
+        pstore::error_or_n<buffer_io, pstore::httpd::request_info> const eri =
+            read_request (reader, io);
+        if (!eri) {
+            log (priority::error, "Failed reading HTTP request: ", eri.get_error ().message ());
+            return;
+        }
+        pstore::httpd::request_info const & request = std::get<1> (eri);
+        log (priority::info, "Request: ",
+             request.method () + ' ' + request.version () + ' ' + request.uri ());
+
+        // We only currently support the GET method.
+        if (request.method () != "GET") {
+            cerror (buffer_sender, io, request.method ().c_str (), 501, "Not Implemented",
+                    "httpd does not implement this method");
+            return;
+        }
+
+        // Respond appropriately based on the request and headers.
+        auto const serve_reply =
+            [&] (buffer_io const io2,
+                 pstore::httpd::header_info const & header_contents) -> std::error_code {
+            if (header_contents.connection_upgrade && header_contents.upgrade_to_websocket) {
+                pstore::error_or<buffer_io> const eo =
+                    accept_ws_upgrade (buffer_sender, io2, header_contents);
+                if (eo) {
+                    log (priority::info, "Started WebSockets session");
+                    conn.state = connection::mode::websocket;
+                    this->subscribe (conn, request.uri ());
+                }
+                return eo.get_error ();
+            }
+            return serve_content (buffer_sender, io2, request.uri (), header_contents,
+                                  file_system_);
         };
 
+        // Scan the HTTP headers.
+        std::error_code const err =
+            read_headers (
+                reader, std::get<0> (eri),
+                [] (pstore::httpd::header_info io3, std::string const & key,
+                    std::string const & value) { return io3.handler (key, value); },
+                pstore::httpd::header_info ()) >>= serve_reply;
+        if (err) {
+            // Report the error to the user as an HTTP error.
+            report_error (buffer_sender, io, err, request);
+        }
+
+        // Anything that follows the request belongs to the WebSockets session (if there is one).
+        conn.in.erase (conn.in.begin (),
+                       conn.in.begin () + static_cast<byte_vector::difference_type> (*length));
+        if (conn.state == connection::mode::websocket) {
+            this->process_websocket (conn);
+        }
+    }
+
+    // process_websocket
+    // ~~~~~~~~~~~~~~~~~
+    void reactor_server::process_websocket (connection & conn) {
+        using pstore::logging::priority;
+        while (conn.state == connection::mode::websocket) {
+            pstore::maybe<std::uint64_t> const length =
+                pstore::httpd::details::frame_length (pstore::gsl::make_span (conn.in));
+            if (!length) {
+                return;
+            }
+            if (*length > max_frame_size) {
+                log (priority::error, "WebSockets frame too large: ", *length);
+                send_close_frame (buffer_sender, buffer_io{nullptr, &conn.out},
+                                  pstore::httpd::close_status_code::message_too_big);
+                conn.state = connection::mode::closing;
+                return;
+            }
+            auto const frame_size = static_cast<std::size_t> (*length);
+            if (conn.in.size () < frame_size) {
+                return; // Wait for the rest of the frame.
+            }
+
+            gsl_span input = pstore::gsl::make_span (conn.in.data (), frame_size);
+            auto reader = pstore::httpd::make_buffered_reader<buffer_io> (buffer_refiller);
+            bool done = false;
+            std::tie (std::ignore, done) = socket_read (reader, buffer_sender,
+                                                        buffer_io{&input, &conn.out},
+                                                        &conn.command);
+            auto const first = conn.in.begin ();
+            conn.in.erase (first, first + static_cast<byte_vector::difference_type> (frame_size));
+            if (done) {
+                log (priority::info, "Ended WebSockets session");
+                conn.state = connection::mode::closing;
+            }
+        }
+    }
+
+    // subscribe
+    // ~~~~~~~~~
+    void reactor_server::subscribe (connection & conn, std::string const & uri) {
+        if (uri.length () > 0 && uri[0] == '/') {
+            std::string const name = uri.substr (1);
+            auto const pos = channels_.find (name);
+            if (pos != channels_.end ()) {
+                conn.subscription = pos->second.chan->new_subscriber ();
+                conn.cv_index = pos->second.cv_index;
+            } else {
+                log (pstore::logging::priority::error, "No channel named: ", name);
+            }
+        }
+    }
+
+    // push_messages
+    // ~~~~~~~~~~~~~
+    /// Moves messages from the connection's subscription to its output queue until either the
+    /// subscription is empty or the queue holds max_pushed_output bytes. Returns true if any
+    /// message was moved.
+    bool reactor_server::push_messages (connection & conn) {
+        if (conn.state != connection::mode::websocket || !conn.subscription) {
+            return false;
+        }
+        bool pushed = false;
+        while (conn.out.size () < max_pushed_output) {
+            pstore::maybe<pstore::message_pointer> const message = conn.subscription->pop ();
+            if (!message) {
+                break;
+            }
+            std::string const & str = **message;
+            log (pstore::logging::priority::info, "sending:", str);
+            send_message (buffer_sender, buffer_io{nullptr, &conn.out}, pstore::httpd::opcode::text,
+                          as_bytes (pstore::gsl::make_span (str)));
+            pushed = true;
+        }
+        return pushed;
+    }
+
+    // flush
+    // ~~~~~
+    /// Writes as much of a connection's pending output as the socket will accept without blocking.
+    void reactor_server::flush (connection & conn) {
+        if (std::error_code const erc = conn.out.send (conn.fd.native_handle ())) {
+            log (pstore::logging::priority::error, "send", erc.message ());
+            // The output cannot be delivered: discard it and close the connection.
+            conn.out.clear ();
+            conn.state = connection::mode::closing;
+        }
+    }
+
+    // rearm_or_close
+    // ~~~~~~~~~~~~~~
+    /// Re-enables the reactor events appropriate for the connection's state or closes it if it has
+    /// nothing further to do.
+    void reactor_server::rearm_or_close (connection & conn) {
+        bool const pending = conn.output_pending ();
+        std::uint32_t events = pending ? reactor::writable : 0U;
+        switch (conn.state) {
+        case connection::mode::http:
+        case connection::mode::websocket: events |= reactor::readable; break;
+        case connection::mode::closing:
+            if (!pending) {
+                this->close (conn);
+                return;
+            }
+            break;
+        case connection::mode::closed: return;
+        }
+        reactor_.rearm (conn.fd.native_handle (), conn.token, events);
+    }
+
+    // close
+    // ~~~~~
+    void reactor_server::close (connection & conn) {
+        reactor_.remove (conn.fd.native_handle ());
+        conn.fd.reset ();
+        conn.state = connection::mode::closed;
+        conn.subscription.reset ();
+
+        std::lock_guard<std::mutex> const lock{connections_mut_};
+        connections_.erase (conn.token);
+    }
+
+} // end anonymous namespace
+
+#else // PSTORE_HAVE_SYS_EPOLL_H
+
+namespace {
+
+    template <typename Reader, typename IO>
+    pstore::error_or<std::unique_ptr<std::thread>>
+    upgrade_to_ws (Reader & reader, IO io, pstore::httpd::request_info const & request,
+                   pstore::httpd::header_info const & header_contents,
+                   pstore::httpd::channel_container const & channels) {
+        using return_type = pstore::error_or<std::unique_ptr<std::thread>>;
+        using pstore::logging::priority;
+
         auto server_loop_thread = [&channels](Reader && reader2, socket_descriptor io2,
                                               std::string const uri) {
             PSTORE_TRY {
@@ -322,20 +1123,21 @@ namespace {
         };
 
         assert (io.get ().valid ());
-        return accept_ws_connection () >>= create_ws_server;
+        return accept_ws_upgrade (pstore::httpd::net::network_sender, io, header_contents) >>=
+               create_ws_server;
     }
 
-#ifndef NDEBUG
+#    ifndef NDEBUG
     template <typename BufferedReader>
     bool input_is_empty (BufferedReader const & reader, socket_descriptor const & fd) {
         if (reader.available () == 0) {
             return true;
         }
-#    ifdef _WIN32
+#        ifdef _WIN32
         // TODO: not yet implemented for Windows.
         (void) fd;
         return true;
-#    else
+#        else
         // There should be nothing in the buffered-reader or the input socket waiting to be read.
         errno = 0;
         std::array<std::uint8_t, 256> buf;
@@ -346,22 +1148,42 @@ namespace {
             log (pstore::logging::priority::error, "error:", err);
         }
         return nread == 0 || nread == -1;
-#    endif
+#        endif
     }
-#endif
+#    endif
 
 } // end anonymous namespace
 
+#endif // PSTORE_HAVE_SYS_EPOLL_H
+
 namespace pstore {
     namespace httpd {
 
         int server (romfs::romfs & file_system, gsl::not_null<server_status *> const status,
-                    channel_container const & channels) {
+                    channel_container const & channels, unsigned const num_workers) {
             pstore::error_or<socket_descriptor> eparentfd = initialize_socket (status->port ());
             if (!eparentfd) {
                 log (logging::priority::error, "opening socket", eparentfd.get_error ().message ());
                 return 0;
             }
+
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+            socket_descriptor & parentfd = eparentfd.get ();
+            int const flags = ::fcntl (parentfd.native_handle (), F_GETFL);
+            if (flags == -1 ||
+                ::fcntl (parentfd.native_handle (), F_SETFL, flags | O_NONBLOCK) == -1) {
+                log (logging::priority::error, "fcntl", get_last_error ().message ());
+                return 0;
+            }
+            if (!status->listening (server_status::http_state::initializing)) {
+                return 0;
+            }
+
+            log (logging::priority::info, "starting server-loop");
+            reactor_server (file_system, *status, channels, std::move (parentfd))
+                .run (std::max (num_workers, 1U));
+#else
+            (void) num_workers;
             socket_descriptor const & parentfd = eparentfd.get ();
 
             log (logging::priority::info, "starting server-loop");
@@ -431,15 +1253,8 @@ namespace pstore {
                         return p.get_error ();
                     }
 
-                    if (!details::starts_with (request.uri (), dynamic_path)) {
-                        return serve_static_content (pstore::httpd::net::network_sender,
-                                                     std::ref (io2), request.uri (), file_system)
-                            .get_error ();
-                    }
-
-                    return serve_dynamic_content (pstore::httpd::net::network_sender,
-                                                  std::ref (io2), request.uri ())
-                        .get_error ();
+                    return serve_content (pstore::httpd::net::network_sender, std::ref (io2),
+                                          request.uri (), header_contents, file_system);
                 };
 
                 // Scan the HTTP headers.
@@ -453,7 +1268,8 @@ namespace pstore {
 
                 if (err) {
                     // Report the error to the user as an HTTP error.
-                    report_error (err, request, childfd);
+                    report_error (pstore::httpd::net::network_sender, std::ref (childfd), err,
+                                  request);
                 }
 
                 assert (input_is_empty (reader, childfd));
@@ -462,7 +1278,7 @@ namespace pstore {
             for (std::unique_ptr<std::thread> const & worker : websockets_workers) {
                 worker->join ();
             }
-
+#endif // PSTORE_HAVE_SYS_EPOLL_H
             return 0;
         }
 
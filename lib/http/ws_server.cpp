@@ -138,5 +138,37 @@ namespace pstore {
             return return_type{in_place, payload};
         }
 
+        maybe<std::uint64_t>
+        details::frame_length (gsl::span<std::uint8_t const> const & available) {
+            auto const size = unsigned_cast (available.size ());
+            auto header_size = std::size_t{2};
+            if (size < header_size) {
+                return nothing<std::uint64_t> ();
+            }
+            auto const base_length = available[1] & 0x7FU;
+            bool const masked = (available[1] & 0x80U) != 0U;
+            auto const extended_length_size = base_length < 126U    ? std::size_t{0}
+                                              : base_length == 126U ? sizeof (std::uint16_t)
+                                                                    : sizeof (std::uint64_t);
+            header_size += extended_length_size;
+            if (size < header_size) {
+                return nothing<std::uint64_t> ();
+            }
+            auto payload_length = std::uint64_t{base_length};
+            if (extended_length_size > 0U) {
+                // The extended payload length is in network byte order.
+                payload_length = 0U;
+                for (auto ctr = std::size_t{2}; ctr < header_size; ++ctr) {
+                    payload_length = (payload_length << 8U) | available[ctr];
+                }
+            }
+            if (masked) {
+                header_size += 4U; // The masking key.
+            }
+            // Clamp the result so that a malicious length cannot overflow.
+            constexpr auto max = std::numeric_limits<std::uint64_t>::max ();
+            return just (payload_length > max - header_size ? max : payload_length + header_size);
+        }
+
     } // end namespace httpd
 } // end namespace pstore
@@ -47,6 +47,7 @@
 
 #include "pstore/config/config.hpp"
 #include "pstore/mcrepo/repo_error.hpp"
+#include "pstore/mcrepo/section_view.hpp"
 #include "pstore/support/gsl.hpp"
 
 using namespace pstore::repo;
@@ -122,6 +123,12 @@ std::shared_ptr<fragment const> fragment::load (pstore::database const & db,
         location, [&db](extent<fragment> const & x) { return db.getro (x); });
 }
 
+fragment const * fragment::load (pstore::pinned_view & view,
+                                 pstore::extent<fragment> const & location) {
+    return load_impl<fragment const *> (
+        location, [&view](extent<fragment> const & x) { return view.getro (x); });
+}
+
 // section_offset_is_valid [static]
 // ~~~~~~~~~~~~~~~~~~~~~~~
 template <section_kind Key, typename InstanceType>
@@ -203,36 +210,31 @@ std::size_t fragment::size_bytes () const {
 // section_align
 // ~~~~~~~~~~~~~
 unsigned pstore::repo::section_align (fragment const & f, section_kind const kind) {
-    dispatcher_buffer buffer;
-    return make_dispatcher (f, kind, &buffer)->align ();
+    return details::make_section_view (nullptr, f, kind, false).align;
 }
 
 // section_size
 // ~~~~~~~~~~~~~
 std::size_t pstore::repo::section_size (fragment const & f, section_kind const kind) {
-    dispatcher_buffer buffer;
-    return make_dispatcher (f, kind, &buffer)->size ();
+    return static_cast<std::size_t> (details::make_section_view (nullptr, f, kind, false).size);
 }
 
 // section_ifixups
 // ~~~~~~~~~~~~~~~
 container<internal_fixup> pstore::repo::section_ifixups (fragment const & f,
                                                          section_kind const kind) {
-    dispatcher_buffer buffer;
-    return make_dispatcher (f, kind, &buffer)->ifixups ();
+    return details::make_section_view (nullptr, f, kind, false).ifixups;
 }
 
 // section_xfixups
 // ~~~~~~~~~~~~~~~
 container<external_fixup> pstore::repo::section_xfixups (fragment const & f,
                                                          section_kind const kind) {
-    dispatcher_buffer buffer;
-    return make_dispatcher (f, kind, &buffer)->xfixups ();
+    return details::make_section_view (nullptr, f, kind, false).xfixups;
 }
 
 // section_data
 // ~~~~~~~~~~~~
 container<std::uint8_t> pstore::repo::section_value (fragment const & f, section_kind const kind) {
-    dispatcher_buffer buffer;
-    return make_dispatcher (f, kind, &buffer)->payload ();
+    return make_section_view (f, kind).payload;
 }
@@ -45,6 +45,8 @@
 
 #include <cstring>
 
+#include "pstore/mcrepo/repo_error.hpp"
+
 namespace pstore {
     namespace repo {
 
@@ -65,8 +67,20 @@ namespace pstore {
             return result;
         }
 
+        std::size_t generic_section::shared_size_bytes (std::size_t const num_ifixups,
+                                                        std::size_t const num_xfixups) {
+            auto result = sizeof (generic_section);
+            result = generic_section::part_size_bytes<extent<std::uint8_t>> (result, 1U);
+            result = generic_section::part_size_bytes<internal_fixup> (result, num_ifixups);
+            result = generic_section::part_size_bytes<external_fixup> (result, num_xfixups);
+            return result;
+        }
+
         std::size_t generic_section::size_bytes () const {
-            return generic_section::size_bytes (payload ().size (), ifixups ().size (),
+            if (this->has_shared_payload ()) {
+                return generic_section::shared_size_bytes (ifixups ().size (), xfixups ().size ());
+            }
+            return generic_section::size_bytes (this->size (), ifixups ().size (),
                                                 xfixups ().size ());
         }
 
@@ -77,12 +91,23 @@ namespace pstore {
         //*                                            |_|                              *
 
         std::size_t generic_section_creation_dispatcher::size_bytes () const {
+            if (this->is_shared ()) {
+                return generic_section::shared_size_bytes (section_->ifixups.size (),
+                                                           section_->xfixups.size ());
+            }
             return generic_section::size_bytes (section_->make_sources ());
         }
 
         std::uint8_t * generic_section_creation_dispatcher::write (std::uint8_t * const out) const {
             assert (this->aligned (out) == out);
-            auto * const scn = new (out) generic_section (section_->make_sources (), section_->align);
+            generic_section * scn = nullptr;
+            if (this->is_shared ()) {
+                auto const sources = section_->make_sources ();
+                scn = new (out) generic_section (shared_payload_, sources.ifixups_range,
+                                                 sources.xfixups_range, section_->align);
+            } else {
+                scn = new (out) generic_section (section_->make_sources (), section_->align);
+            }
             return out + scn->size_bytes ();
         }
 
@@ -99,6 +124,10 @@ namespace pstore {
         //*                                       |_|                              *
         section_dispatcher::~section_dispatcher () noexcept {}
 
+        // payload
+        // ~~~~~~~
+        container<std::uint8_t> section_dispatcher::payload () const { return s_.payload (); }
+
 
     } // end namespace repo
 } // end namespace pstore
@@ -58,6 +58,9 @@ namespace pstore {
                 result = "too many members in a compilation";
                 break;
             case error_code::bss_section_too_large: result = "bss section too large"; break;
+            case error_code::payload_is_shared:
+                result = "section payload is shared and must be loaded from the store";
+                break;
             }
             return result;
         }
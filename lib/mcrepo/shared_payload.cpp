@@ -0,0 +1,79 @@
+//*      _                        _                     _                 _  *
+//*  ___| |__   __ _ _ __ ___  __| |  _ __   __ _ _   _| | ___   __ _  __| | *
+//* / __| '_ \ / _` | '__/ _ \/ _` | | '_ \ / _` | | | | |/ _ \ / _` |/ _` | *
+//* \__ \ | | | (_| | | |  __/ (_| | | |_) | (_| | |_| | | (_) | (_| | (_| | *
+//* |___/_| |_|\__,_|_|  \___|\__,_| | .__/ \__,_|\__, |_|\___/ \__,_|\__,_| *
+//*                                  |_|          |___/                      *
+//===- lib/mcrepo/shared_payload.cpp --------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/mcrepo/shared_payload.hpp"
+
+#include "pstore/core/database.hpp"
+#include "pstore/support/fnv.hpp"
+
+namespace pstore {
+    namespace repo {
+
+        // payload_digest
+        // ~~~~~~~~~~~~~~
+        index::digest payload_digest (gsl::span<std::uint8_t const> const data) noexcept {
+            auto const size = static_cast<std::uint64_t> (data.size ());
+            auto const high = fnv_64a_buf (data.data (), static_cast<std::size_t> (size));
+            // The low half of the digest is produced by a second pass whose initial basis is
+            // derived from the payload length.
+            auto const low = fnv_64a_buf (data.data (), static_cast<std::size_t> (size),
+                                          fnv_64a_buf (&size, sizeof (size)));
+            return {high, low};
+        }
+
+        // load_payload
+        // ~~~~~~~~~~~~
+        container<std::uint8_t> load_payload (database const & db, generic_section const & s,
+                                              gsl::not_null<std::shared_ptr<void const> *> owner) {
+            if (!s.has_shared_payload ()) {
+                return s.payload ();
+            }
+            extent<std::uint8_t> const & ex = s.shared_payload ();
+            std::shared_ptr<std::uint8_t const> data = db.getro (ex);
+            std::uint8_t const * const first = data.get ();
+            *owner = std::move (data);
+            return {first, first + ex.size};
+        }
+
+    } // end namespace repo
+} // end namespace pstore
@@ -68,6 +68,22 @@ namespace pstore {
         this->read_only_impl (addr, len);
     }
 
+    void memory_mapper_base::map () {}
+
+    void memory_mapper_base::advise (void * const addr, std::size_t const len,
+                                     access_pattern const pattern) {
+#ifndef NDEBUG
+        {
+            auto * const addr8 = static_cast<std::uint8_t *> (addr);
+            auto * const data8 = static_cast<std::uint8_t *> (this->data ().get ());
+            assert (addr8 >= data8 && addr8 + len <= data8 + this->size ());
+        }
+#endif
+        if (len > 0U) {
+            this->advise_impl (addr, len, pattern);
+        }
+    }
+
 
     // (dtor)
     // ~~~~~~
@@ -142,6 +142,41 @@ namespace pstore {
     }
 
 
+    // advise
+    // ~~~~~~
+    void memory_mapper_base::advise_impl (void * const addr, std::size_t const len,
+                                          access_pattern const pattern) {
+        int advice = MADV_NORMAL;
+        switch (pattern) {
+        case access_pattern::normal: advice = MADV_NORMAL; break;
+        case access_pattern::sequential: advice = MADV_SEQUENTIAL; break;
+        case access_pattern::random: advice = MADV_RANDOM; break;
+        case access_pattern::willneed: advice = MADV_WILLNEED; break;
+        case access_pattern::hugepage:
+#    ifdef MADV_HUGEPAGE
+            advice = MADV_HUGEPAGE;
+            break;
+#    else
+            return;
+#    endif
+        }
+
+        // madvise() requires that the start address is page-aligned.
+        auto const page_size = std::uintptr_t{system_page_size ().get ()};
+        auto const first = reinterpret_cast<std::uintptr_t> (addr);
+        auto const aligned = first & ~(page_size - 1U);
+        if (::madvise (reinterpret_cast<void *> (aligned), len + (first - aligned), advice) == -1) {
+            int const last_error = errno;
+            // Not all mappings can be backed by huge pages (a file-backed mapping may not be, for
+            // example). This is a hint, so quietly ignore the failure.
+            if (pattern == access_pattern::hugepage && last_error == EINVAL) {
+                return;
+            }
+            raise (errno_erc{last_error}, "madvise");
+        }
+    }
+
+
     //*   _ __ ___   ___ _ __ ___   ___  _ __ _   _    _ __ ___   __ _ _ __  _ __   ___ _ __   *
     //*  | '_ ` _ \ / _ \ '_ ` _ \ / _ \| '__| | | |  | '_ ` _ \ / _` | '_ \| '_ \ / _ \ '__|  *
     //*  | | | | | |  __/ | | | | | (_) | |  | |_| |  | | | | | | (_| | |_) | |_) |  __/ |     *
@@ -158,6 +158,29 @@ namespace pstore {
         }
     }
 
+    // advise_impl
+    // ~~~~~~~~~~~
+    void memory_mapper_base::advise_impl (void * addr, std::size_t len, access_pattern pattern) {
+        // Windows has no equivalent of madvise(): the cache manager's read-ahead behavior is fixed
+        // when the file is opened. The only hint that we can usefully pass on is a request to
+        // prefetch pages that will be needed soon.
+#    if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602 // Windows 8 or later
+        if (pattern == access_pattern::willneed) {
+            WIN32_MEMORY_RANGE_ENTRY range;
+            range.VirtualAddress = addr;
+            range.NumberOfBytes = len;
+            if (::PrefetchVirtualMemory (::GetCurrentProcess (), 1, &range, 0) == 0) {
+                DWORD const last_error = ::GetLastError ();
+                raise (win32_erc{last_error}, "PrefetchVirtualMemory");
+            }
+        }
+#    else
+        (void) addr;
+        (void) len;
+        (void) pattern;
+#    endif
+    }
+
     // (ctor)
     // ~~~~~~
     memory_mapper::memory_mapper (file::file_handle & file, bool write_enabled,
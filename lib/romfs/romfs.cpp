@@ -308,6 +308,13 @@ namespace pstore {
                    [](dirent_ptr const de) { return error_or<struct stat>{de->stat ()}; };
         }
 
+        // find
+        // ~~~~
+        auto romfs::find (gsl::czstring PSTORE_NONNULL const path) const
+            -> error_or<dirent const * PSTORE_NONNULL> {
+            return this->parse_path (path);
+        }
+
         // getcwd
         // ~~~~~~
         error_or<std::string> romfs::getcwd () const { return dir_to_string (cwd_); }
@@ -57,6 +57,9 @@
 
 #include "pstore/support/fnv.hpp"
 
+#include <algorithm>
+#include <array>
+
 namespace {
 
 #ifdef NO_FNV_GCC_OPTIMIZATION
@@ -95,6 +98,39 @@ namespace pstore {
     }
 
 
+    void fnv_64a_bufs (std::size_t const count, void const * const * const bufs,
+                       std::size_t const * const lens, std::uint64_t * const out) noexcept {
+        // Each octet's multiply depends on the result of the previous one, so hashing a single
+        // buffer is bound by the latency of that operation. Hashing four buffers in lock-step
+        // gives the processor four independent chains to overlap.
+        constexpr std::size_t lanes = 4;
+        std::size_t n = 0;
+        for (; n + lanes <= count; n += lanes) {
+            std::array<std::uint8_t const *, lanes> it;
+            std::array<std::uint64_t, lanes> h;
+            std::size_t common = lens[n];
+            for (std::size_t l = 0; l < lanes; ++l) {
+                it[l] = static_cast<std::uint8_t const *> (bufs[n + l]);
+                h[l] = fnv1a_64_init;
+                common = std::min (common, lens[n + l]);
+            }
+            for (std::size_t pos = 0; pos < common; ++pos) {
+                h[0] = append (it[0][pos], h[0]);
+                h[1] = append (it[1][pos], h[1]);
+                h[2] = append (it[2][pos], h[2]);
+                h[3] = append (it[3][pos], h[3]);
+            }
+            // Finish the tail of each of the longer buffers on its own.
+            for (std::size_t l = 0; l < lanes; ++l) {
+                out[n + l] = fnv_64a_buf (it[l] + common, lens[n + l] - common, h[l]);
+            }
+        }
+        for (; n < count; ++n) {
+            out[n] = fnv_64a_buf (bufs[n], lens[n]);
+        }
+    }
+
+
     std::uint64_t fnv_64a_str (gsl::czstring const str, std::uint64_t const hval) noexcept {
         // FNV-1a hash each octet of the string
         auto result = hval;
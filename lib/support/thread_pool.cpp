@@ -0,0 +1,254 @@
+//*  _   _                        _                     _  *
+//* | |_| |__  _ __ ___  __ _  __| |  _ __   ___   ___ | | *
+//* | __| '_ \| '__/ _ \/ _` |/ _` | | '_ \ / _ \ / _ \| | *
+//* | |_| | | | | |  __/ (_| | (_| | | |_) | (_) | (_) | | *
+//*  \__|_| |_|_|  \___|\__,_|\__,_| | .__/ \___/ \___/|_| *
+//*                                  |_|                   *
+//===- lib/support/thread_pool.cpp ----------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file thread_pool.cpp
+/// \brief Implements the persistent, work-stealing pool of worker threads.
+
+#include "pstore/support/thread_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+
+#include "pstore/support/portab.hpp"
+
+namespace {
+
+    /// The pool, if any, of which the current thread is a worker and the number of its queue.
+    thread_local pstore::thread_pool const * current_pool = nullptr;
+    thread_local std::size_t current_queue = 0U;
+
+    /// The state shared by the threads taking part in a call to thread_pool::run_chunks(). It is
+    /// owned jointly by those threads so that a worker which starts late, after every chunk has
+    /// been claimed, may still safely discover that there is nothing left to do.
+    class chunked_loop {
+    public:
+        chunked_loop (std::size_t const num_chunks,
+                      std::function<void (std::size_t)> const & body) noexcept
+                : num_chunks_{num_chunks}
+                , body_{&body} {}
+
+        /// Claims and runs chunks until none remain.
+        void run () noexcept;
+        /// Waits until every chunk has been run and rethrows the first exception, if any, that was
+        /// raised by the loop body.
+        void wait ();
+
+    private:
+        std::size_t const num_chunks_;
+        /// The loop body. It is only called once a chunk has been claimed; at that point the
+        /// thread which called run_chunks() is waiting for the chunk to complete.
+        std::function<void (std::size_t)> const * const body_;
+        /// The number of the next chunk to be claimed.
+        std::atomic<std::size_t> next_{0U};
+        /// Set if the body has thrown: any remaining chunks are skipped.
+        std::atomic<bool> failed_{false};
+
+        /// Guards completed_ and error_.
+        std::mutex mut_;
+        std::condition_variable cv_;
+        std::size_t completed_ = 0U;
+        std::exception_ptr error_;
+    };
+
+    // run
+    // ~~~
+    void chunked_loop::run () noexcept {
+        for (std::size_t chunk = next_++; chunk < num_chunks_; chunk = next_++) {
+            if (!failed_.load (std::memory_order_relaxed)) {
+                PSTORE_TRY { (*body_) (chunk); }
+                // clang-format off
+                PSTORE_CATCH (..., { // clang-format on
+                    std::lock_guard<std::mutex> const lock{mut_};
+                    if (!error_) {
+                        error_ = std::current_exception ();
+                    }
+                    failed_.store (true, std::memory_order_relaxed);
+                })
+            }
+            std::lock_guard<std::mutex> const lock{mut_};
+            if (++completed_ == num_chunks_) {
+                cv_.notify_all ();
+            }
+        }
+    }
+
+    // wait
+    // ~~~~
+    void chunked_loop::wait () {
+        std::unique_lock<std::mutex> lock{mut_};
+        cv_.wait (lock, [this] () { return completed_ == num_chunks_; });
+#ifdef PSTORE_EXCEPTIONS
+        if (error_) {
+            std::rethrow_exception (error_);
+        }
+#endif
+    }
+
+} // end anonymous namespace
+
+namespace pstore {
+
+    // (ctor)
+    // ~~~~~~
+    thread_pool::thread_pool (unsigned const num_workers) {
+        queues_.reserve (num_workers);
+        for (auto ctr = 0U; ctr < num_workers; ++ctr) {
+            queues_.emplace_back (new queue);
+        }
+        threads_.reserve (num_workers);
+        for (auto ctr = 0U; ctr < num_workers; ++ctr) {
+            threads_.emplace_back (&thread_pool::worker, this, std::size_t{ctr});
+        }
+    }
+
+    // (dtor)
+    // ~~~~~~
+    thread_pool::~thread_pool () noexcept {
+        {
+            std::lock_guard<std::mutex> const lock{mut_};
+            done_ = true;
+        }
+        cv_.notify_all ();
+        for (std::thread & th : threads_) {
+            th.join ();
+        }
+    }
+
+    // get
+    // ~~~
+    thread_pool & thread_pool::get () {
+        static thread_pool pool{std::max (std::thread::hardware_concurrency (), 1U) - 1U};
+        return pool;
+    }
+
+    // submit
+    // ~~~~~~
+    void thread_pool::submit (task t) {
+        assert (!queues_.empty ());
+        std::size_t const index =
+            current_pool == this
+                ? current_queue
+                : next_queue_.fetch_add (1U, std::memory_order_relaxed) % queues_.size ();
+        {
+            queue & q = *queues_[index];
+            std::lock_guard<std::mutex> const lock{q.mut};
+            q.tasks.push_back (std::move (t));
+        }
+        {
+            std::lock_guard<std::mutex> const lock{mut_};
+            ++pending_;
+        }
+        cv_.notify_one ();
+    }
+
+    // try_pop
+    // ~~~~~~~
+    bool thread_pool::try_pop (std::size_t const home, task * const t) {
+        auto const take = [t] (queue & q, bool const own) {
+            std::lock_guard<std::mutex> const lock{q.mut};
+            if (q.tasks.empty ()) {
+                return false;
+            }
+            // A worker runs its own most recently queued task first since that is the one most
+            // likely to find its data in the cache. Thieves take the oldest.
+            if (own) {
+                *t = std::move (q.tasks.back ());
+                q.tasks.pop_back ();
+            } else {
+                *t = std::move (q.tasks.front ());
+                q.tasks.pop_front ();
+            }
+            return true;
+        };
+
+        auto const size = queues_.size ();
+        bool found = take (*queues_[home], true);
+        for (auto ctr = std::size_t{1}; !found && ctr < size; ++ctr) {
+            found = take (*queues_[(home + ctr) % size], false);
+        }
+        if (found) {
+            std::lock_guard<std::mutex> const lock{mut_};
+            --pending_;
+        }
+        return found;
+    }
+
+    // worker
+    // ~~~~~~
+    void thread_pool::worker (std::size_t const index) {
+        current_pool = this;
+        current_queue = index;
+        task t;
+        for (;;) {
+            if (this->try_pop (index, &t)) {
+                t ();
+                t = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock{mut_};
+            cv_.wait (lock, [this] () { return done_ || pending_ > 0; });
+            if (done_ && pending_ <= 0) {
+                return;
+            }
+        }
+    }
+
+    // run_chunks
+    // ~~~~~~~~~~
+    void thread_pool::run_chunks (std::size_t const num_chunks,
+                                  std::function<void (std::size_t)> const & body) {
+        if (num_chunks == 0U) {
+            return;
+        }
+        auto const loop = std::make_shared<chunked_loop> (num_chunks, body);
+        // The calling thread takes a share of the chunks so one fewer helper is needed.
+        auto const helpers = std::min (std::size_t{this->num_workers ()}, num_chunks - 1U);
+        for (auto ctr = std::size_t{0}; ctr < helpers; ++ctr) {
+            this->submit ([loop] () { loop->run (); });
+        }
+        loop->run ();
+        loop->wait ();
+    }
+
+} // end namespace pstore
@@ -0,0 +1,563 @@
+//*            _ _           _              *
+//*   ___ ___ | | | ___  ___| |_ ___  _ __  *
+//*  / __/ _ \| | |/ _ \/ __| __/ _ \| '__| *
+//* | (_| (_) | | |  __/ (__| || (_) | |    *
+//*  \___\___/|_|_|\___|\___|\__\___/|_|    *
+//*                                         *
+//===- lib/vacuum/collector.cpp -------------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file collector.cpp
+/// \brief Implements the incremental copying of a store's live contents.
+
+#include "pstore/vacuum/collector.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "pstore/core/database.hpp"
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/hamt_set.hpp"
+#include "pstore/core/indirect_string.hpp"
+#include "pstore/core/transaction.hpp"
+#include "pstore/diff/diff.hpp"
+#include "pstore/mcrepo/compilation.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+#include "pstore/mcrepo/shared_payload.hpp"
+#include "pstore/support/parallel_for_each.hpp"
+#include "pstore/support/pointee_adaptor.hpp"
+#include "pstore/support/scope_guard.hpp"
+
+namespace {
+
+    /// The maximum number of leaves that are loaded at a time by for_each_new_leaf().
+    constexpr std::size_t leaf_window_size = 4096U;
+
+    /// Calls \p f for each leaf of the index \p Index which was added to \p db after
+    /// \p revision. The leaves are loaded concurrently, a window at a time, but \p f is called
+    /// sequentially and in index order. Stops early and returns false if \p cancelled returns
+    /// true.
+    template <pstore::trailer::indices Index, typename Predicate, typename Function>
+    bool for_each_new_leaf (pstore::database & db, unsigned const revision,
+                            Predicate const & cancelled, Function f) {
+        auto const index = pstore::index::get_index<Index> (db, false /*create*/);
+        if (index == nullptr) {
+            return true;
+        }
+        using value_type = typename pstore::index::enum_to_index<Index>::type::value_type;
+        pstore::diff::result_type const addresses = pstore::diff::diff (db, *index, revision);
+        std::vector<std::unique_ptr<value_type>> leaves;
+        std::vector<std::size_t> indices;
+        for (auto first = std::begin (addresses); first != std::end (addresses);) {
+            auto const window = std::min (
+                leaf_window_size, static_cast<std::size_t> (std::end (addresses) - first));
+            leaves.clear ();
+            leaves.resize (window);
+            indices.resize (window);
+            std::iota (std::begin (indices), std::end (indices), std::size_t{0});
+            pstore::cmd_util::parallel_for_each (
+                std::begin (indices), std::end (indices), [&] (std::size_t const i) {
+                    leaves[i] = std::make_unique<value_type> (
+                        index->load_leaf_node (db, first[static_cast<std::ptrdiff_t> (i)]));
+                });
+            for (std::size_t i = 0; i < window; ++i, ++first) {
+                if (cancelled ()) {
+                    return false;
+                }
+                f (*first, *leaves[i]);
+            }
+        }
+        return true;
+    }
+
+
+    //*   __                                      _     _           _ _     _            *
+    //*  / _|_ __ __ _  __ _ _ __ ___   ___ _ __ | |_  | |__  _   _(_) | __| | ___ _ __  *
+    //* | |_| '__/ _` |/ _` | '_ ` _ \ / _ \ '_ \| __| | '_ \| | | | | |/ _` |/ _ \ '__| *
+    //* |  _| | | (_| | (_| | | | | | |  __/ | | | |_  | |_) | |_| | | | (_| |  __/ |    *
+    //* |_| |_|  \__,_|\__, |_| |_| |_|\___|_| |_|\__| |_.__/ \__,_|_|_|\__,_|\___|_|    *
+    //*                |___/                                                             *
+    /// Gathers the sections of a source fragment, relocating the store addresses that they
+    /// contain, so that an equivalent fragment can be allocated in the destination store.
+    ///
+    /// The compilation member addresses held by a dependents section are copied unchanged: the
+    /// compilations that they refer to may not yet have been copied. The caller must patch them.
+    template <typename NameFunction, typename HeaderFunction, typename PayloadFunction>
+    class fragment_builder {
+    public:
+        fragment_builder (NameFunction relocate_name, HeaderFunction relocate_header,
+                          PayloadFunction relocate_payload)
+                : relocate_name_{relocate_name}
+                , relocate_header_{relocate_header}
+                , relocate_payload_{relocate_payload} {}
+
+        void add (pstore::repo::section_kind kind, pstore::repo::generic_section const & s);
+        void add (pstore::repo::section_kind kind, pstore::repo::bss_section const & s);
+        void add (pstore::repo::section_kind kind, pstore::repo::debug_line_section const & s);
+        void add (pstore::repo::section_kind kind, pstore::repo::dependents const & d);
+
+        template <typename Transaction>
+        pstore::extent<pstore::repo::fragment> alloc (Transaction & transaction) {
+            return pstore::repo::fragment::alloc (
+                transaction, pstore::make_pointee_adaptor (dispatchers_.begin ()),
+                pstore::make_pointee_adaptor (dispatchers_.end ()));
+        }
+
+    private:
+        template <typename Section>
+        pstore::repo::section_content & copy_fixups (pstore::repo::section_kind kind,
+                                                     Section const & s);
+        template <typename Section>
+        pstore::repo::section_content const * copy_content (pstore::repo::section_kind kind,
+                                                             Section const & s);
+
+        NameFunction relocate_name_;
+        HeaderFunction relocate_header_;
+        PayloadFunction relocate_payload_;
+        /// The creation dispatchers hold pointers to these objects so their addresses must be
+        /// stable.
+        std::deque<pstore::repo::section_content> contents_;
+        std::vector<pstore::typed_address<pstore::repo::compilation_member>> dependents_;
+        std::vector<std::unique_ptr<pstore::repo::section_creation_dispatcher>> dispatchers_;
+    };
+
+    template <typename NameFunction, typename HeaderFunction, typename PayloadFunction>
+    auto make_fragment_builder (NameFunction relocate_name, HeaderFunction relocate_header,
+                                PayloadFunction relocate_payload)
+        -> fragment_builder<NameFunction, HeaderFunction, PayloadFunction> {
+        return {relocate_name, relocate_header, relocate_payload};
+    }
+
+    // copy_fixups
+    // ~~~~~~~~~~~
+    template <typename NameFunction, typename HeaderFunction, typename PayloadFunction>
+    template <typename Section>
+    pstore::repo::section_content &
+    fragment_builder<NameFunction, HeaderFunction, PayloadFunction>::copy_fixups (
+        pstore::repo::section_kind const kind, Section const & s) {
+        contents_.emplace_back (kind, static_cast<std::uint8_t> (s.align ()));
+        pstore::repo::section_content & content = contents_.back ();
+
+        auto const ifixups = s.ifixups ();
+        content.ifixups.assign (ifixups.begin (), ifixups.end ());
+        auto const xfixups = s.xfixups ();
+        content.xfixups.reserve (xfixups.size ());
+        for (pstore::repo::external_fixup const & x : xfixups) {
+            content.xfixups.push_back (x);
+            content.xfixups.back ().name = relocate_name_ (x.name);
+        }
+        return content;
+    }
+
+    // copy_content
+    // ~~~~~~~~~~~~
+    template <typename NameFunction, typename HeaderFunction, typename PayloadFunction>
+    template <typename Section>
+    pstore::repo::section_content const *
+    fragment_builder<NameFunction, HeaderFunction, PayloadFunction>::copy_content (
+        pstore::repo::section_kind const kind, Section const & s) {
+        pstore::repo::section_content & content = this->copy_fixups (kind, s);
+        auto const payload = s.payload ();
+        content.data.assign (payload.begin (), payload.end ());
+        return &content;
+    }
+
+    // add
+    // ~~~
+    template <typename NameFunction, typename HeaderFunction, typename PayloadFunction>
+    void fragment_builder<NameFunction, HeaderFunction, PayloadFunction>::add (
+        pstore::repo::section_kind const kind, pstore::repo::generic_section const & s) {
+        if (s.has_shared_payload ()) {
+            // The payload is not copied: the new section shares the relocated payload.
+            dispatchers_.emplace_back (new pstore::repo::generic_section_creation_dispatcher (
+                kind, &this->copy_fixups (kind, s), relocate_payload_ (s.shared_payload ())));
+            return;
+        }
+        dispatchers_.emplace_back (new pstore::repo::generic_section_creation_dispatcher (
+            kind, this->copy_content (kind, s)));
+    }
+
+    template <typename NameFunction, typename HeaderFunction, typename PayloadFunction>
+    void fragment_builder<NameFunction, HeaderFunction, PayloadFunction>::add (
+        pstore::repo::section_kind const kind, pstore::repo::bss_section const & s) {
+        contents_.emplace_back (kind, static_cast<std::uint8_t> (s.align ()));
+        pstore::repo::section_content & content = contents_.back ();
+        // A BSS section's size is given by the size of its (otherwise unused) data.
+        content.data.resize (s.size ());
+        dispatchers_.emplace_back (new pstore::repo::bss_section_creation_dispatcher (&content));
+    }
+
+    template <typename NameFunction, typename HeaderFunction, typename PayloadFunction>
+    void fragment_builder<NameFunction, HeaderFunction, PayloadFunction>::add (
+        pstore::repo::section_kind const kind, pstore::repo::debug_line_section const & s) {
+        dispatchers_.emplace_back (new pstore::repo::debug_line_section_creation_dispatcher (
+            relocate_header_ (s.header_extent ()), this->copy_content (kind, s)));
+    }
+
+    template <typename NameFunction, typename HeaderFunction, typename PayloadFunction>
+    void fragment_builder<NameFunction, HeaderFunction, PayloadFunction>::add (
+        pstore::repo::section_kind const /*kind*/, pstore::repo::dependents const & d) {
+        dependents_.assign (d.begin (), d.end ());
+        dispatchers_.emplace_back (new pstore::repo::dependents_creation_dispatcher (
+            dependents_.data (), dependents_.data () + dependents_.size ()));
+    }
+
+} // end anonymous namespace
+
+namespace vacuum {
+
+    //*                            _        _        *
+    //*  _ __   __ _ ___ ___   ___| |_ __ _| |_ ___  *
+    //* | '_ \ / _` / __/ __| / __| __/ _` | __/ _ \ *
+    //* | |_) | (_| \__ \__ \ \__ \ || (_| | ||  __/ *
+    //* | .__/ \__,_|___/___/ |___/\__\__,_|\__\___| *
+    //* |_|                                          *
+    struct collector::pass_state {
+        explicit pass_state (pstore::database & destination)
+                : transaction{pstore::begin (destination)} {}
+
+        pstore::transaction<pstore::transaction_lock> transaction;
+        pstore::indirect_string_adder adder;
+        /// The names waiting to be written by the adder. Their addresses must be stable until it
+        /// is flushed.
+        std::deque<pstore::shared_sstring_view> owners;
+        std::deque<pstore::raw_sstring_view> views;
+        /// Destination fragments whose dependents sections must be relocated once all of the
+        /// pass's compilations have been copied.
+        std::vector<pstore::extent<pstore::repo::fragment>> fragments_with_dependents;
+
+        /// The keys of the collector's relocation map entries which were added by this pass.
+        std::vector<std::uint64_t> new_names;
+        std::vector<std::uint64_t> new_debug_line_headers;
+        std::vector<std::uint64_t> new_payloads;
+        std::vector<std::uint64_t> new_compilations;
+    };
+
+
+    //*            _ _           _              *
+    //*   ___ ___ | | | ___  ___| |_ ___  _ __  *
+    //*  / __/ _ \| | |/ _ \/ __| __/ _ \| '__| *
+    //* | (_| (_) | | |  __/ (__| || (_) | |    *
+    //*  \___\___/|_|_|\___|\___|\__\___/|_|    *
+    //*                                         *
+    // (ctor)
+    // ~~~~~~
+    collector::collector (pstore::database & source, pstore::database & destination)
+            : source_{source}
+            , destination_{destination} {}
+
+    // pass
+    // ~~~~
+    bool collector::pass (std::atomic<bool> const & cancel) {
+        return this->pass ([&cancel] () { return cancel.load (); });
+    }
+
+    bool collector::pass (cancel_predicate const & cancelled) {
+        unsigned const revision = source_.get_current_revision ();
+        if (revision <= collected_) {
+            return true;
+        }
+
+        pass_state ps{destination_};
+        // Unless the pass is committed, the records that it copies are discarded along with its
+        // transaction. The relocation maps must not continue to refer to them.
+        auto forget = pstore::make_scope_guard ([this, &ps] () { this->forget (ps); });
+        // Fragments are copied before compilations so that compilation members can refer to
+        // their destination extents. Dependents sections, which point back at compilation
+        // members, are patched once both have been copied.
+        bool const complete = this->copy_names (ps, cancelled) &&
+                              this->copy_write (ps, cancelled) &&
+                              this->copy_debug_line_headers (ps, cancelled) &&
+                              this->copy_fragments (ps, cancelled) &&
+                              this->copy_compilations (ps, cancelled);
+        if (!complete) {
+            ps.transaction.rollback ();
+            return false;
+        }
+        this->patch_dependents (ps);
+        ps.adder.flush (ps.transaction);
+        ps.transaction.commit ();
+        forget.release ();
+        collected_ = revision;
+        return true;
+    }
+
+    // forget
+    // ~~~~~~
+    void collector::forget (pass_state const & ps) noexcept {
+        for (std::uint64_t const key : ps.new_names) {
+            names_.erase (key);
+        }
+        for (std::uint64_t const key : ps.new_debug_line_headers) {
+            debug_line_headers_.erase (key);
+        }
+        for (std::uint64_t const key : ps.new_payloads) {
+            payloads_.erase (key);
+        }
+        for (std::uint64_t const key : ps.new_compilations) {
+            compilations_.erase (key);
+        }
+    }
+
+    // copy_names
+    // ~~~~~~~~~~
+    bool collector::copy_names (pass_state & ps, cancel_predicate const & cancelled) {
+        return for_each_new_leaf<pstore::trailer::indices::name> (
+            source_, collected_, cancelled,
+            [this, &ps] (pstore::address const addr, pstore::indirect_string const &) {
+                this->relocate_name (ps, pstore::typed_address<pstore::indirect_string> (addr));
+            });
+    }
+
+    // copy_write
+    // ~~~~~~~~~~
+    bool collector::copy_write (pass_state & ps, cancel_predicate const & cancelled) {
+        auto const index = pstore::index::get_index<pstore::trailer::indices::write> (destination_);
+        return for_each_new_leaf<pstore::trailer::indices::write> (
+            source_, collected_, cancelled,
+            [this, &ps, &index] (pstore::address,
+                                 pstore::index::write_index::value_type const & kvp) {
+                pstore::extent<char> const & extent = kvp.second;
+                pstore::address const addr = ps.transaction.allocate (extent.size, 1 /*align*/);
+                // Copy from the source file to the data store.
+                std::memcpy (ps.transaction.getrw (addr, extent.size).get (),
+                             source_.getro (extent).get (), extent.size);
+                index->insert_or_assign (
+                    ps.transaction, kvp.first,
+                    make_extent (pstore::typed_address<char> (addr), extent.size));
+            });
+    }
+
+    // copy_debug_line_headers
+    // ~~~~~~~~~~~~~~~~~~~~~~~
+    bool collector::copy_debug_line_headers (pass_state & ps,
+                                             cancel_predicate const & cancelled) {
+        auto const index =
+            pstore::index::get_index<pstore::trailer::indices::debug_line_header> (destination_);
+        return for_each_new_leaf<pstore::trailer::indices::debug_line_header> (
+            source_, collected_, cancelled,
+            [this, &ps, &index] (pstore::address,
+                                 pstore::index::debug_line_header_index::value_type const & kvp) {
+                index->insert_or_assign (ps.transaction, kvp.first,
+                                         this->relocate_debug_line_header (ps, kvp.second));
+            });
+    }
+
+    // copy_fragments
+    // ~~~~~~~~~~~~~~
+    bool collector::copy_fragments (pass_state & ps, cancel_predicate const & cancelled) {
+        using pstore::repo::section_kind;
+        auto const index = pstore::index::get_index<pstore::trailer::indices::fragment> (destination_);
+        return for_each_new_leaf<pstore::trailer::indices::fragment> (
+            source_, collected_, cancelled,
+            [this, &ps, &index] (pstore::address,
+                                 pstore::index::fragment_index::value_type const & kvp) {
+                auto const fragment = pstore::repo::fragment::load (source_, kvp.second);
+                auto builder = make_fragment_builder (
+                    [this, &ps] (pstore::typed_address<pstore::indirect_string> const name) {
+                        return this->relocate_name (ps, name);
+                    },
+                    [this, &ps] (pstore::extent<std::uint8_t> const & header) {
+                        return this->relocate_debug_line_header (ps, header);
+                    },
+                    [this, &ps] (pstore::extent<std::uint8_t> const & payload) {
+                        return this->relocate_payload (ps, payload);
+                    });
+
+#define X(k)                                                                                       \
+    case section_kind::k: builder.add (kind, fragment->at<section_kind::k> ()); break;
+
+                for (section_kind const kind : *fragment) {
+                    switch (kind) {
+                        PSTORE_MCREPO_SECTION_KINDS
+                    case section_kind::last: assert (false); break;
+                    }
+                }
+#undef X
+
+                pstore::extent<pstore::repo::fragment> const fext = builder.alloc (ps.transaction);
+                index->insert_or_assign (ps.transaction, kvp.first, fext);
+                if (fragment->has_section (section_kind::dependent)) {
+                    ps.fragments_with_dependents.push_back (fext);
+                }
+            });
+    }
+
+    // copy_compilations
+    // ~~~~~~~~~~~~~~~~~
+    bool collector::copy_compilations (pass_state & ps, cancel_predicate const & cancelled) {
+        auto const index =
+            pstore::index::get_index<pstore::trailer::indices::compilation> (destination_);
+        return for_each_new_leaf<pstore::trailer::indices::compilation> (
+            source_, collected_, cancelled,
+            [this, &ps, &index] (pstore::address,
+                                 pstore::index::compilation_index::value_type const & kvp) {
+                auto const compilation = pstore::repo::compilation::load (source_, kvp.second);
+
+                std::vector<pstore::repo::compilation_member> members;
+                members.reserve (compilation->size ());
+                for (pstore::repo::compilation_member const & m : *compilation) {
+                    members.emplace_back (m.digest, this->relocate_fragment (m.digest),
+                                          this->relocate_name (ps, m.name), m.linkage (),
+                                          m.visibility ());
+                }
+
+                pstore::extent<pstore::repo::compilation> const cext =
+                    pstore::repo::compilation::alloc (
+                        ps.transaction, this->relocate_name (ps, compilation->path ()),
+                        this->relocate_name (ps, compilation->triple ()), std::begin (members),
+                        std::end (members));
+                index->insert_or_assign (ps.transaction, kvp.first, cext);
+                compilations_[kvp.second.addr.absolute ()] = cext;
+                ps.new_compilations.push_back (kvp.second.addr.absolute ());
+            });
+    }
+
+    // patch_dependents
+    // ~~~~~~~~~~~~~~~~
+    void collector::patch_dependents (pass_state & ps) {
+        for (pstore::extent<pstore::repo::fragment> const & fext : ps.fragments_with_dependents) {
+            auto const fragment = pstore::repo::fragment::load (ps.transaction, fext);
+            for (auto & member : fragment->at<pstore::repo::section_kind::dependent> ()) {
+                member = this->relocate_member (member);
+            }
+        }
+    }
+
+    // relocate_name
+    // ~~~~~~~~~~~~~
+    pstore::typed_address<pstore::indirect_string>
+    collector::relocate_name (pass_state & ps,
+                              pstore::typed_address<pstore::indirect_string> const addr) {
+        auto const pos = names_.find (addr.to_address ().absolute ());
+        if (pos != names_.end ()) {
+            return pos->second;
+        }
+
+        ps.owners.emplace_back ();
+        ps.views.push_back (
+            pstore::indirect_string::read (source_, addr).as_db_string_view (&ps.owners.back ()));
+        auto const it = ps.adder
+                            .add (ps.transaction,
+                                  pstore::index::get_index<pstore::trailer::indices::name> (
+                                      destination_),
+                                  &ps.views.back ())
+                            .first;
+        auto const result = pstore::typed_address<pstore::indirect_string> (it.get_address ());
+        names_.emplace (addr.to_address ().absolute (), result);
+        ps.new_names.push_back (addr.to_address ().absolute ());
+        return result;
+    }
+
+    // relocate_debug_line_header
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~
+    pstore::extent<std::uint8_t>
+    collector::relocate_debug_line_header (pass_state & ps,
+                                           pstore::extent<std::uint8_t> const ext) {
+        auto const pos = debug_line_headers_.find (ext.addr.to_address ().absolute ());
+        if (pos != debug_line_headers_.end ()) {
+            return pos->second;
+        }
+
+        std::shared_ptr<std::uint8_t> ptr;
+        auto addr = pstore::typed_address<std::uint8_t>::null ();
+        std::tie (ptr, addr) = ps.transaction.alloc_rw<std::uint8_t> (ext.size);
+        auto const src = source_.getro (ext);
+        std::copy (src.get (), src.get () + ext.size, ptr.get ());
+
+        auto const result = pstore::make_extent (addr, ext.size);
+        debug_line_headers_.emplace (ext.addr.to_address ().absolute (), result);
+        ps.new_debug_line_headers.push_back (ext.addr.to_address ().absolute ());
+        return result;
+    }
+
+    // relocate_payload
+    // ~~~~~~~~~~~~~~~~
+    pstore::extent<std::uint8_t>
+    collector::relocate_payload (pass_state & ps, pstore::extent<std::uint8_t> const ext) {
+        auto const pos = payloads_.find (ext.addr.to_address ().absolute ());
+        if (pos != payloads_.end ()) {
+            return pos->second;
+        }
+
+        auto const src = source_.getro (ext);
+        auto const result = pstore::repo::intern_payload (
+            ps.transaction,
+            pstore::index::get_index<pstore::trailer::indices::payload> (destination_),
+            pstore::gsl::make_span (src.get (), static_cast<std::ptrdiff_t> (ext.size)));
+        payloads_.emplace (ext.addr.to_address ().absolute (), result);
+        ps.new_payloads.push_back (ext.addr.to_address ().absolute ());
+        return result;
+    }
+
+    // relocate_fragment
+    // ~~~~~~~~~~~~~~~~~
+    pstore::extent<pstore::repo::fragment>
+    collector::relocate_fragment (pstore::index::digest const digest) {
+        auto const index = pstore::index::get_index<pstore::trailer::indices::fragment> (destination_);
+        auto const pos = index->find (destination_, digest);
+        if (pos == index->cend (destination_)) {
+            // A compilation referenced a fragment which is not present in the fragment index.
+            pstore::raise (pstore::error_code::index_corrupt);
+        }
+        return pos->second;
+    }
+
+    // relocate_member
+    // ~~~~~~~~~~~~~~~
+    pstore::typed_address<pstore::repo::compilation_member> collector::relocate_member (
+        pstore::typed_address<pstore::repo::compilation_member> const addr) const {
+        // Find the compilation which contains this member. Its members occupy the same offsets
+        // in both the source and destination copies.
+        std::uint64_t const a = addr.to_address ().absolute ();
+        auto pos = compilations_.upper_bound (a);
+        if (pos == compilations_.begin ()) {
+            pstore::raise (pstore::error_code::index_corrupt);
+        }
+        --pos;
+        std::uint64_t const offset = a - pos->first;
+        if (offset >= pos->second.size) {
+            pstore::raise (pstore::error_code::index_corrupt);
+        }
+        return pstore::typed_address<pstore::repo::compilation_member>::make (
+            pos->second.addr.to_address () + offset);
+    }
+
+} // end namespace vacuum
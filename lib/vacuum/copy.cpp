@@ -51,12 +51,10 @@
 #include <thread>
 
 #include "pstore/core/database.hpp"
-#include "pstore/core/hamt_map.hpp"
-#include "pstore/core/index_types.hpp"
-#include "pstore/core/transaction.hpp"
 #include "pstore/os/logging.hpp"
 #include "pstore/os/thread.hpp"
 #include "pstore/support/portab.hpp"
+#include "pstore/vacuum/collector.hpp"
 #include "pstore/vacuum/status.hpp"
 #include "pstore/vacuum/user_options.hpp"
 #include "pstore/vacuum/watch.hpp"
@@ -113,6 +111,11 @@ namespace vacuum {
 
         PSTORE_TRY {
             log (pstore::logging::priority::notice, "Copy thread started");
+
+            // The destination and the collector persist between passes so that each pass only
+            // copies the data added to the source since the previous one.
+            std::unique_ptr<pstore::database> destination;
+            std::unique_ptr<vacuum::collector> collector;
             while (!st->done) {
                 log (pstore::logging::priority::notice, "Waiting before beginning to vacuum...");
 
@@ -123,84 +126,58 @@ namespace vacuum {
                     return;
                 }
 
-                log (pstore::logging::priority::notice, "Collecting...");
-
                 // Tell the "watch" thread to start monitoring the store for changes.
                 start_watching (source, st);
 
-                bool copy_aborted = false;
-                // TODO: a new constructor to make a uniquely named file in the same directory as
-                // 'from'
-                auto destination = std::make_unique<pstore::database> (
-                    source->path () + ".gc", pstore::database::access_mode::writable);
-
-                // We don't want our pristine new store to be vacuumed; it doesn't need it.
-                destination->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
-
-                std::shared_ptr<pstore::index::write_index const> const source_names =
-                    pstore::index::get_index<pstore::trailer::indices::write> (*source);
-                if (source_names == nullptr) {
-                    log (pstore::logging::priority::error,
-                         "Names index was not found in source store");
-                    stop (st);
-                    return;
+                if (collector == nullptr) {
+                    // TODO: a new constructor to make a uniquely named file in the same directory
+                    // as 'from'
+                    std::string const path = source->path () + ".gc";
+                    // Any existing file is left over from an earlier run and we have no record of
+                    // the revision that it holds.
+                    pstore::file::unlink (path, true /*allow_noent*/);
+                    destination = std::make_unique<pstore::database> (
+                        path, pstore::database::access_mode::writable);
+                    // We don't want our pristine new store to be vacuumed; it doesn't need it.
+                    destination->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+                    collector = std::make_unique<vacuum::collector> (*source, *destination);
                 }
 
-                std::shared_ptr<pstore::index::write_index> const destination_names =
-                    pstore::index::get_index<pstore::trailer::indices::write> (*destination);
-
-                if (!st->done) {
-                    auto transaction = pstore::begin (*destination);
-
-                    for (auto const & kvp : source_names->make_range (*source)) {
-                        std::string const & key = kvp.first;
-                        pstore::extent<char> const & extent = kvp.second;
-
-                        pstore::address const addr =
-                            transaction.allocate (extent.size, 1 /*align*/);
-                        // Copy from the source file to the data store.
-                        std::memcpy (transaction.getrw (addr, extent.size).get (),
-                                     source->getro (extent).get (), extent.size);
-
-                        destination_names->insert_or_assign (
-                            transaction, key,
-                            make_extent (pstore::typed_address<char> (addr), extent.size));
-
-                        // Has the watch thread asked us to abort the copy?
-                        if (st->modified) {
-                            copy_aborted = true;
-                            log (pstore::logging::priority::notice,
-                                 "Store was modified during vacuuming: aborted.");
-                            break;
-                        }
-                    }
+                log (pstore::logging::priority::notice, "Collecting up to revision ",
+                     source->get_current_revision ());
+                if (!collector->pass (st->done)) {
+                    break;
+                }
 
-                    if (copy_aborted) {
-                        transaction.rollback ();
-                    } else {
-                        transaction.commit ();
+                // Has the watch thread seen the store change while we were copying? If so, there's
+                // more to collect: the next pass picks up from the revision that we reached.
+                if (st->modified) {
+                    log (pstore::logging::priority::notice,
+                         "Store was modified during vacuuming: resuming from revision ",
+                         collector->collected_revision ());
+                    if (!opt.daemon_mode) {
+                        std::this_thread::sleep_for (vacuum::watch_interval);
                     }
-
-                    destination->close ();
+                    continue;
                 }
 
-                if (!copy_aborted) {
-                    log (pstore::logging::priority::notice, "Vacuuming complete");
-                    stop (st);
-                    while (st->watch_running) {
-                        std::this_thread::sleep_for (std::chrono::microseconds (10));
-                    }
+                log (pstore::logging::priority::notice, "Vacuuming complete");
+                stop (st);
+                while (st->watch_running) {
+                    std::this_thread::sleep_for (std::chrono::microseconds (10));
+                }
 
-                    // TODO: wait for the watch thread to close its connection to the source store.
+                // TODO: wait for the watch thread to close its connection to the source store.
 
-                    pstore::file::file_handle destination_file {destination->path ()};
-                    std::string const source_path = source->path ();
-                    destination.reset (); // Close the target data store
-                    // assert that there's a single reference to the source pointer.
-                    source.reset ();
+                collector.reset ();
+                destination->close ();
+                pstore::file::file_handle destination_file{destination->path ()};
+                std::string const source_path = source->path ();
+                destination.reset (); // Close the target data store
+                // assert that there's a single reference to the source pointer.
+                source.reset ();
 
-                    destination_file.rename (source_path);
-                }
+                destination_file.rename (source_path);
             }
         }
         // clang-format off
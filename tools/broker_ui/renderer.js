@@ -73,10 +73,15 @@ function message_received (msg) {
         commits = obj.commits;
         document.getElementById ('commits').textContent = obj.commits;
     }
+    if (obj.hasOwnProperty('queue')) {
+        document.getElementById ('queue_backpressure').textContent = obj.queue.backpressure;
+        document.getElementById ('queue_wakeups').textContent = obj.queue.wakeups;
+    }
 }
 
 new_ws ('uptime', message_received);
 new_ws ('commits', message_received);
+new_ws ('queue', message_received);
 
 function series (pull) {
     const n = 20; // The number of data points shown.
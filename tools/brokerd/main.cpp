@@ -67,12 +67,14 @@
 #include "pstore/broker/uptime.hpp"
 #include "pstore/broker_intf/descriptor.hpp"
 #include "pstore/broker_intf/fifo_path.hpp"
+#include "pstore/broker_intf/message_ring.hpp"
 #include "pstore/broker_intf/message_type.hpp"
 #include "pstore/broker_intf/wsa_startup.hpp"
 #include "pstore/config/config.hpp"
 #include "pstore/http/server.hpp"
 #include "pstore/http/server_status.hpp"
 #include "pstore/os/logging.hpp"
+#include "pstore/os/shared_memory.hpp"
 #include "pstore/os/thread.hpp"
 #include "pstore/support/utf.hpp"
 
@@ -145,6 +147,9 @@ namespace {
                     {"commits",
                      pstore::httpd::channel_container_entry{&pstore::broker::commits_channel,
                                                             &pstore::broker::commits_cv}},
+                    {"queue",
+                     pstore::httpd::channel_container_entry{&pstore::broker::queue_channel,
+                                                            &pstore::broker::queue_cv}},
                     {"uptime",
                      pstore::httpd::channel_container_entry{&pstore::broker::uptime_channel,
                                                             &pstore::broker::uptime_cv}},
@@ -204,6 +209,10 @@ int main (int argc, char * argv[]) {
         logging::log (logging::priority::notice, "opening pipe");
 
         broker::fifo_path fifo{opt.pipe_path ? opt.pipe_path->c_str () : nullptr};
+        // The ring through which clients send messages which are too large for a single FIFO
+        // write. Any slots left in use by a previous broker instance are recovered.
+        shared_memory<broker::message_ring> ring{broker::message_ring_name (fifo)};
+        ring->reset ();
 
         std::vector<std::future<void>> futures;
         std::thread quit;
@@ -218,6 +227,7 @@ int main (int argc, char * argv[]) {
                 opt.num_read_threads, http_status.get (), &uptime_done, opt.scavenge_time);
             auto scav = std::make_shared<broker::scavenger> (commands);
             commands->attach_scavenger (scav);
+            commands->attach_message_ring (ring.get ());
 
 
             logging::log (logging::priority::notice, "starting threads");
@@ -0,0 +1,158 @@
+//*                _________    _                     _      *
+//*   ___ _ __ ___|___ /___ \  | |__   ___ _ __   ___| |__   *
+//*  / __| '__/ __| |_ \ __) | | '_ \ / _ \ '_ \ / __| '_ \  *
+//* | (__| | | (__ ___) / __/  | |_) |  __/ | | | (__| | | | *
+//*  \___|_|  \___|____/_____| |_.__/ \___|_| |_|\___|_| |_| *
+//*                                                          *
+//===- tools/crc32_bench/crc32_bench.cpp ----------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file crc32_bench.cpp
+/// \brief A micro-benchmark for the CRC32 implementations used to validate the pstore header and
+/// trailer records.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "pstore/cmd_util/command_line.hpp"
+#include "pstore/cmd_util/tchar.hpp"
+#include "pstore/core/crc32.hpp"
+
+using pstore::cmd_util::error_stream;
+using pstore::cmd_util::out_stream;
+
+namespace {
+
+    pstore::cmd_util::cl::opt<unsigned>
+        total_mib ("total", pstore::cmd_util::cl::desc ("Number of MiB to checksum per test"),
+                   pstore::cmd_util::cl::init (256U));
+
+    /// Returns the throughput of \p fn in MiB/s when applied repeatedly to buffers of \p size
+    /// bytes.
+    double throughput (pstore::details::crc32_function const fn,
+                       std::vector<std::uint8_t> const & data, std::size_t const size,
+                       std::uint32_t * const result) {
+        using clock = std::chrono::steady_clock;
+        auto const total = std::uint64_t{total_mib.get ()} * 1024U * 1024U;
+        auto const iterations = std::max (total / size, std::uint64_t{1});
+
+        std::uint32_t crc = 0;
+        auto const start = clock::now ();
+        for (auto ctr = std::uint64_t{0}; ctr < iterations; ++ctr) {
+            crc = fn (crc, data.data (), size);
+        }
+        std::chrono::duration<double> const elapsed = clock::now () - start;
+        *result = crc; // Prevent the loop from being optimized away.
+        auto const mib = static_cast<double> (iterations * size) / (1024.0 * 1024.0);
+        return elapsed.count () > 0.0 ? mib / elapsed.count () : 0.0;
+    }
+
+} // end anonymous namespace
+
+#ifdef _WIN32
+int _tmain (int argc, TCHAR * argv[]) {
+#else
+int main (int argc, char * argv[]) {
+#endif
+    int exit_code = EXIT_SUCCESS;
+    PSTORE_TRY {
+        pstore::cmd_util::cl::ParseCommandLineOptions (
+            argc, argv, "pstore crc32 bench: Measures the throughput of the CRC32 kernels.\n");
+
+        struct kernel {
+            char const * name;
+            pstore::details::crc32_function fn;
+        };
+        std::vector<kernel> kernels{{"bytewise", pstore::details::crc32_bytewise},
+                                    {"slice8", pstore::details::crc32_slice8}};
+        if (pstore::details::crc32_function const hw = pstore::details::crc32_hardware ()) {
+            kernels.push_back ({"hardware", hw});
+        }
+
+        // The sizes of the header and trailer records, a typical index node, and larger blocks.
+        static constexpr std::size_t sizes[] = {32U, 64U, 256U, 4096U, 65536U};
+        std::vector<std::uint8_t> data (sizes[std::extent<decltype (sizes)>::value - 1U]);
+        std::mt19937 gen;
+        std::uniform_int_distribution<unsigned> dist{0U, 255U};
+        for (auto & b : data) {
+            b = static_cast<std::uint8_t> (dist (gen));
+        }
+
+        out_stream << std::setw (10) << "size";
+        for (kernel const & k : kernels) {
+            out_stream << std::setw (12) << k.name;
+        }
+        out_stream << "  (MiB/s)\n";
+
+        for (std::size_t const size : sizes) {
+            out_stream << std::setw (10) << size;
+            std::uint32_t expected = 0;
+            for (kernel const & k : kernels) {
+                std::uint32_t crc = 0;
+                double const mibs = throughput (k.fn, data, size, &crc);
+                if (&k == &kernels.front ()) {
+                    expected = crc;
+                } else if (crc != expected) {
+                    error_stream << NATIVE_TEXT ("Error: ") << k.name
+                                 << NATIVE_TEXT (" produced a different result\n");
+                    exit_code = EXIT_FAILURE;
+                }
+                out_stream << std::setw (12) << std::fixed << std::setprecision (1) << mibs;
+            }
+            out_stream << '\n';
+        }
+    }
+    // clang-format off
+    PSTORE_CATCH (std::exception const & ex, { // clang-format on
+        error_stream << NATIVE_TEXT ("Error: ") << pstore::utf::to_native_string (ex.what ())
+                     << std::endl;
+        exit_code = EXIT_FAILURE;
+    })
+    // clang-format off
+    PSTORE_CATCH (..., { // clang-format on
+        error_stream << NATIVE_TEXT ("Unknown exception.\n");
+        exit_code = EXIT_FAILURE;
+    })
+    return exit_code;
+}
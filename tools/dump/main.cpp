@@ -138,22 +138,18 @@ namespace std {
 
 namespace {
 
-    template <typename Index>
-    auto make_index (char const * name, pstore::database const & db, Index const & index)
+    template <typename Index, typename MakeValueFn>
+    auto make_index (char const * name, pstore::database const & db,
+                     std::shared_ptr<Index const> const & index, MakeValueFn mk)
         -> pstore::dump::value_ptr {
         using namespace pstore::dump;
-        array::container members;
-        auto r = index.make_range (db);
-        typename Index::const_iterator b = r.begin ();
-        typename Index::const_iterator e = r.end ();
-        for (auto const & kvp : index.make_range (db)) {
-            members.push_back (make_value (object::container{{"key", make_value (kvp.first)},
-                                                             {"value", make_value (kvp.second)}}));
-        }
-
+        // The index members are produced as the output is written.
+        auto members = make_lazy_array ([&db, index, mk] (lazy_array::sink const & sink) {
+            details::emit_members (index->begin (db), index->end (db), mk, sink);
+        });
         return make_value (object::container{
             {"name", make_value (name)},
-            {"members", make_value (members)},
+            {"members", members},
         });
     }
 
@@ -163,14 +159,20 @@ namespace {
         array::container result;
         if (std::shared_ptr<pstore::index::write_index const> const write =
                 pstore::index::get_index<pstore::trailer::indices::write> (db, false /* create*/)) {
-            result.push_back (make_index ("write", db, *write));
+            result.push_back (
+                make_index ("write", db, write,
+                            [] (pstore::index::write_index::value_type const & kvp) {
+                                return make_value (object::container{
+                                    {"key", make_value (kvp.first)},
+                                    {"value", make_value (kvp.second)},
+                                });
+                            }));
         }
         if (std::shared_ptr<pstore::index::name_index const> const name =
                 pstore::index::get_index<pstore::trailer::indices::name> (db, false /* create */)) {
-            result.push_back (make_value (object::container{
-                {"name", make_value ("name")},
-                {"members", make_value (name->begin (db), name->end (db))},
-            }));
+            result.push_back (make_index (
+                "name", db, name,
+                [] (pstore::index::name_index::value_type const & v) { return make_value (v); }));
         }
         return make_value (result);
     }
@@ -367,9 +369,13 @@ int main (int argc, char * argv[]) {
         using pstore::dump::make_value;
         using pstore::dump::object;
 
-        pstore::dump::array::container output;
-        for (std::string const & path : opt.paths) {
+        // Each file is dumped in turn and the output for each is produced as it is written so
+        // that the dump of a large store does not need to be held in memory.
+        auto const dump_file = [&] (std::string const & path,
+                                    pstore::dump::lazy_array::sink const & sink) {
             pstore::database db (path, pstore::database::access_mode::read_only);
+            // The dump reads most of the store: encourage aggressive read-ahead.
+            db.set_access_pattern (pstore::access_pattern::sequential);
 
             db.sync (opt.revision);
 
@@ -419,10 +425,14 @@ int main (int argc, char * argv[]) {
                 file.emplace_back ("shared_memory", make_shared_memory (db, no_times));
             }
 
-            output.push_back (make_value (file));
-        }
-
-        pstore::dump::value_ptr v = make_value (output);
+            sink (make_value (file));
+        };
+        pstore::dump::value_ptr v =
+            pstore::dump::make_lazy_array ([&] (pstore::dump::lazy_array::sink const & sink) {
+                for (std::string const & path : opt.paths) {
+                    dump_file (path, sink);
+                }
+            });
         pstore::cmd_util::out_stream << NATIVE_TEXT ("---\n") << *v << NATIVE_TEXT ("\n...\n");
     }
     // clang-format off
@@ -53,6 +53,7 @@
 // pstore includes
 #include "pstore/support/array_elements.hpp"
 #include "pstore/support/error.hpp"
+#include "pstore/support/fnv.hpp"
 #include "pstore/support/portab.hpp"
 #include "pstore/support/quoted.hpp"
 #include "pstore/support/utf.hpp"
@@ -104,7 +105,7 @@ namespace {
 
 } // end anonymous namespace
 
-void copy (std::string const & path, unsigned file_no) {
+file_summary copy (std::string const & path, unsigned file_no) {
     static constexpr auto indent_size = pstore::array_elements (indent) - 1U;
     static constexpr auto crindent_size = pstore::array_elements (crindent) - 1U;
     static constexpr auto line_width = std::size_t{80} - indent_size;
@@ -128,12 +129,15 @@ void copy (std::string const & path, unsigned file_no) {
     std::size_t width = indent_size;
     char const * separator = "";
     auto num_read = std::size_t{0};
+    file_summary result{0, pstore::fnv1a_64_init};
     do {
         num_read = std::fread (&buffer[0], sizeof (buffer[0]), buffer_size, file.get ());
         num_read = std::min (buffer_size, num_read);
         if (std::ferror (file.get ())) {
             read_failed (path);
         }
+        result.size += num_read;
+        result.digest = pstore::fnv_64a_buf (&buffer[0], num_read, result.digest);
         for (auto n = std::size_t{0}; n < num_read; ++n) {
             char const * cr;
             std::tie (width, cr) = getcr (width);
@@ -156,4 +160,5 @@ void copy (std::string const & path, unsigned file_no) {
         }
     } while (num_read >= buffer_size);
     os << "\n};\n";
+    return result;
 }
@@ -44,8 +44,16 @@
 #ifndef PSTORE_GENROMFS_COPY_HPP
 #define PSTORE_GENROMFS_COPY_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
-void copy (std::string const & path, unsigned file_no);
+struct file_summary {
+    std::size_t size;     ///< The number of bytes copied.
+    std::uint64_t digest; ///< The FNV-1a hash of the bytes copied.
+};
+
+/// Writes the contents of the file at \p path as the definition of an array of bytes.
+file_summary copy (std::string const & path, unsigned file_no);
 
 #endif // PSTORE_GENROMFS_COPY_HPP
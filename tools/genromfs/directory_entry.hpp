@@ -44,6 +44,7 @@
 #ifndef PSTORE_GENROMFS_DIRECTORY_ENTRY_HPP
 #define PSTORE_GENROMFS_DIRECTORY_ENTRY_HPP
 
+#include <cstdint>
 #include <ctime>
 #include <memory>
 #include <string>
@@ -68,6 +69,10 @@ struct directory_entry {
     std::string name;
     unsigned contents;
     std::time_t modtime;
+    /// The size of a file's contents in bytes.
+    std::size_t size = 0;
+    /// The FNV-1a hash of a file's contents.
+    std::uint64_t digest = 0;
     std::unique_ptr<directory_container> children;
 };
 
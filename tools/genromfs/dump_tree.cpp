@@ -44,7 +44,14 @@
 #include "dump_tree.hpp"
 
 // Standard Library includes
+#include <iomanip>
 #include <ostream>
+#include <sstream>
+#include <string>
+
+// pstore includes
+#include "pstore/http/http_date.hpp"
+#include "pstore/http/media_type.hpp"
 
 // Local includes
 #include "copy.hpp"
@@ -61,15 +68,41 @@ namespace {
         }
     }
 
+    // write_http_header
+    // ~~~~~~~~~~~~~~~~~
+    /// Writes the HTTP response header for a file as a string literal. The Date field and the
+    /// blank line which ends the header are omitted: the date must be that at which the response
+    /// is sent so they are appended by the server.
+    void write_http_header (std::ostream & os, directory_entry const & de) {
+        std::ostringstream etag;
+        etag << std::hex << std::setw (16) << std::setfill ('0') << de.digest;
+
+        auto const field = [&os] (char const * const name, std::string const & value) {
+            os << '\n' << indent << '"' << name << ": " << value << "\\r\\n\"";
+        };
+        os << "char const " << header_var (de.contents) << "[] =\n"
+           << indent << "\"HTTP/1.0 200 OK\\r\\n\"";
+        field ("Server", "pstore-httpd");
+        field ("Content-length", std::to_string (de.size));
+        field ("Content-type", pstore::httpd::media_type_from_filename (de.name));
+        field ("Connection", "close");
+        field ("ETag", "\\\"" + etag.str () + "\\\"");
+        field ("Last-Modified", pstore::httpd::http_date (de.modtime));
+        os << ";\n";
+    }
+
 } // end anonymous namespace
 
 
 void dump_tree (std::ostream & os, std::unordered_set<unsigned> & forwards,
-                directory_container const & dir, unsigned id, unsigned parent_id) {
+                directory_container const & dir, unsigned id, unsigned parent_id,
+                bool const http_headers) {
 
     for (directory_entry const & de : dir) {
         if (de.children) {
-            dump_tree (os, forwards, *de.children, de.contents, id);
+            dump_tree (os, forwards, *de.children, de.contents, id, http_headers);
+        } else if (http_headers) {
+            write_http_header (os, de);
         }
     }
     std::string const dir_name = directory_var (id).as_string ();
@@ -95,6 +128,9 @@ void dump_tree (std::ostream & os, std::unordered_set<unsigned> & forwards,
             os << indent << "{\"" << de.name << "\", " << contents_name
                << ", pstore::romfs::stat{sizeof (" << contents_name << "), " << de.modtime
                << ", pstore::romfs::mode_t::file}";
+            if (http_headers) {
+                os << ", " << header_var (de.contents);
+            }
         }
         os << "},\n";
     }
@@ -49,7 +49,17 @@
 
 #include "./directory_entry.hpp"
 
+/// Writes the definitions of the directories and directory entries of a romfs tree.
+///
+/// \param os  The stream to which the definitions are written.
+/// \param forwards  The directories which have been forward-declared.
+/// \param dir  The directory to be written.
+/// \param id  The number of the directory to be written.
+/// \param parent_id  The number of the directory's parent.
+/// \param http_headers  If true, the HTTP response header for each file is precomputed and
+///   recorded in its directory entry.
 void dump_tree (std::ostream & os, std::unordered_set<unsigned> & forwards,
-                directory_container const & dir, unsigned id, unsigned parent_id);
+                directory_container const & dir, unsigned id, unsigned parent_id,
+                bool http_headers);
 
 #endif // PSTORE_GENROMFS_DUMP_TREE_HPP
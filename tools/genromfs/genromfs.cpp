@@ -123,6 +123,11 @@ namespace {
                   "')"),
         cl::init (DEFAULT_VAR));
 
+    cl::opt<bool> http_headers (
+        "http-headers",
+        cl::desc ("Precompute the HTTP response header for each file (Default: false)"),
+        cl::init (false));
+
 } // end anonymous namespace
 
 #undef DEFAULT_VAR
@@ -191,7 +196,7 @@ int main (int argc, char * argv[]) {
         auto root = std::make_unique<directory_container> ();
         auto root_id = scan (*root, src_path.get (), 0);
         std::unordered_set<unsigned> forwards;
-        dump_tree (os, forwards, *root, root_id, root_id);
+        dump_tree (os, forwards, *root, root_id, root_id, http_headers.get ());
 
         os << "\n"
               "} // end anonymous namespace\n"
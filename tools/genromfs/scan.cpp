@@ -75,7 +75,10 @@ namespace {
     unsigned add_file (directory_container & directory, std::string const & path,
                        std::string const & file_name, unsigned count, std::time_t modtime) {
         directory.emplace_back (file_name, count, modtime);
-        copy (path + '/' + file_name, directory.back ().contents);
+        directory_entry & de = directory.back ();
+        file_summary const summary = copy (path + '/' + file_name, de.contents);
+        de.size = summary.size;
+        de.digest = summary.digest;
         return count + 1U;
     }
 
@@ -45,3 +45,4 @@
 
 std::string const directory_var_policy::name_ = "d";
 std::string const file_var_policy::name_ = "f";
+std::string const header_var_policy::name_ = "h";
@@ -100,7 +100,16 @@ private:
     static std::string const name_;
 };
 
+class header_var_policy {
+public:
+    static std::string const & name () noexcept { return name_; }
+
+private:
+    static std::string const name_;
+};
+
 using directory_var = variable_name<directory_var_policy>;
 using file_var = variable_name<file_var_policy>;
+using header_var = variable_name<header_var_policy>;
 
 #endif // PSTORE_GENROMFS_VARS_HPP
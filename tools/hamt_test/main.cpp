@@ -45,7 +45,7 @@
 /// \brief A small utility which can be used to check the HAMT index.
 
 #include <cmath>
-#include <future>
+#include <functional>
 #include <vector>
 
 #include "pstore/cmd_util/command_line.hpp"
@@ -191,21 +191,22 @@ namespace {
     template <typename Map>
     bool find (pstore::database const & db, pstore::index::fragment_index const & index,
                Map const & expected_results, std::string const & test_name) {
-        std::atomic<bool> is_found (true);
-        auto check_key = [&db, &index, &test_name, &is_found](typename Map::value_type value) {
+        auto check_key = [&db, &index, &test_name](typename Map::value_type const & value) {
             auto it = index.find (db, value.first);
             if (it == index.cend (db)) {
                 print_cerr ("Test name:", test_name, " Error: ", value.first, ": not found");
-                is_found = false;
-            } else if (it->second.addr.to_address () != value.second) {
+                return false;
+            }
+            if (it->second.addr.to_address () != value.second) {
                 print_cerr ("Test name:", test_name, " Error: The address of ", value.first,
                             " is not correct, the expected address: ", value.second);
-                is_found = false;
+                return false;
             }
+            return true;
         };
-        pstore::cmd_util::parallel_for_each (std::begin (expected_results),
-                                             std::end (expected_results), check_key);
-        return is_found.load ();
+        return pstore::cmd_util::parallel_reduce (std::begin (expected_results),
+                                                  std::end (expected_results), true,
+                                                  std::logical_and<bool> (), check_key);
     }
 
 } // end anonymous namespace
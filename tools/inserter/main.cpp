@@ -54,6 +54,7 @@
 #include <memory>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "pstore/cmd_util/command_line.hpp"
 #include "pstore/cmd_util/tchar.hpp"
@@ -204,6 +205,9 @@ int main (int argc, char * argv[]) {
         cl::ParseCommandLineOptions (argc, argv, "Exerices the pstore index code");
 
         pstore::database database (data_file.get (), pstore::database::access_mode::writable);
+        database.set_flush_mode (pstore::database::flush_mode::parallel);
+        database.set_index_filter_mode (pstore::database::index_filter_mode::enabled);
+        database.set_index_fragments_mode (pstore::database::index_fragments_mode::enabled);
 
         auto index = pstore::index::get_index<pstore::trailer::indices::fragment> (database);
 
@@ -242,6 +246,9 @@ int main (int argc, char * argv[]) {
             // Start a transaction...
             auto transaction = pstore::begin (database);
 
+            std::vector<std::pair<pstore::index::digest, pstore::extent<pstore::repo::fragment>>>
+                members;
+            members.reserve (keys.size ());
             for (auto & k : keys) {
                 // Allocate space in the transaction for the value block
                 auto addr = pstore::typed_address<std::uint8_t>::null ();
@@ -251,13 +258,15 @@ int main (int argc, char * argv[]) {
                 // Copy the value to the store.
                 std::copy (std::begin (value), std::end (value), ptr.get ());
 
-                // Add the key/value pair to the index.
-                index->insert_or_assign (
-                    transaction, k,
-                    make_extent (pstore::typed_address<pstore::repo::fragment> (addr.to_address ()),
-                                 value.size ()));
+                members.emplace_back (
+                    k, make_extent (
+                           pstore::typed_address<pstore::repo::fragment> (addr.to_address ()),
+                           value.size ()));
             }
 
+            // Add the key/value pairs to the index.
+            index->insert_or_assign_range (transaction, std::begin (members), std::end (members));
+
             transaction.commit ();
         }
 
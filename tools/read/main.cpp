@@ -163,7 +163,9 @@ int main (int argc, char * argv[]) {
             return exit_code;
         }
 
-        pstore::database db{opt.db_path, pstore::database::access_mode::read_only};
+        // A single lookup touches very little of the store so map its regions only as needed.
+        pstore::database db{opt.db_path, pstore::database::access_mode::read_only,
+                            pstore::database::mapping_mode::lazy};
         db.sync (opt.revision);
 
         bool const ok =
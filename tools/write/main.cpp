@@ -47,6 +47,7 @@
 #include <ctime>
 #include <exception>
 #include <iostream>
+#include <iterator>
 #include <memory>
 
 // pstore includes.
@@ -180,12 +181,13 @@ int main (int argc, char * argv[]) {
             // Scan through the string arguments from the command line.
             std::vector<pstore::raw_sstring_view> strings;
             strings.reserve (opt.strings.size ());
-            pstore::indirect_string_adder adder;
             for (std::string const & str : opt.strings) {
                 strings.emplace_back (pstore::make_sstring_view (str));
-                auto & s = strings.back ();
-                adder.add (transaction, name, &s);
             }
+            pstore::indirect_string_adder adder{strings.size ()};
+            std::vector<pstore::typed_address<pstore::indirect_string>> addresses;
+            adder.add_range (transaction, name, std::begin (strings), std::end (strings),
+                             std::back_inserter (addresses));
             adder.flush (transaction);
 
             transaction.commit ();
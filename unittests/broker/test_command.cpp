@@ -46,10 +46,15 @@
 
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <string>
 
 #include "gmock/gmock.h"
 
+#include "pstore/broker/globals.hpp"
+#include "pstore/broker/message_queue.hpp"
 #include "pstore/broker_intf/fifo_path.hpp"
+#include "pstore/broker_intf/message_ring.hpp"
 #include "pstore/http/server_status.hpp"
 
 using namespace std::chrono_literals;
@@ -83,6 +88,26 @@ namespace {
         virtual void log (pstore::gsl::czstring) const {}
     };
 
+    /// A command processor which uses the real implementation of the SUICIDE command.
+    class counting_cp : public pstore::broker::command_processor {
+    public:
+        counting_cp (pstore::httpd::server_status * const status,
+                     std::atomic<bool> * const uptime_done)
+                : command_processor (0U, status, uptime_done, 4h) {}
+
+        unsigned nops () const noexcept { return nops_; }
+
+    private:
+        void nop (pstore::broker::fifo_path const &,
+                  pstore::broker::broker_command const &) override {
+            ++nops_;
+        }
+        void log (pstore::broker::broker_command const &) const override {}
+        void log (pstore::gsl::czstring) const override {}
+
+        unsigned nops_ = 0U;
+    };
+
     class Command : public ::testing::Test {
     public:
         Command ()
@@ -133,3 +158,59 @@ TEST_F (Command, Bad) {
     pstore::broker::message_type msg{message_id, part_no, num_parts, "bad command"};
     cp ().process_command (fifo (), msg);
 }
+
+TEST_F (Command, RingDoorbell) {
+    using ::testing::_;
+    using pstore::broker::message_ring;
+
+    auto ring = std::make_unique<message_ring> ();
+    ring->reset ();
+    cp ().attach_message_ring (ring.get ());
+
+    std::string const path (message_ring::slot_size / 2U, 'p');
+    std::string const text = "GC " + path;
+    pstore::maybe<message_ring::ticket> const t = ring->put (pstore::gsl::make_span (text));
+    ASSERT_TRUE (t.has_value ());
+
+    EXPECT_CALL (cp (), gc (_, pstore::broker::broker_command{"GC", path})).Times (1);
+    std::string const doorbell =
+        std::string{pstore::broker::message_ring_doorbell_command} + " " +
+        pstore::broker::doorbell_path (*t);
+    cp ().process_command (fifo (),
+                           pstore::broker::message_type{message_id, part_no, num_parts, doorbell});
+
+    // The slot was freed so a second doorbell for the same ticket is ignored.
+    EXPECT_FALSE (ring->take (*t).has_value ());
+}
+
+TEST (CommandQueue, SuicideWithAFullQueue) {
+    pstore::httpd::server_status http_status{8080};
+    std::atomic<bool> uptime_done{false};
+    counting_cp cp{&http_status, &uptime_done};
+    pstore::broker::fifo_path fifo{nullptr};
+
+    // Fill the command queue.
+    constexpr auto capacity =
+        pstore::broker::message_queue<pstore::broker::message_ptr>::default_capacity;
+    for (auto ctr = std::size_t{0}; ctr < capacity; ++ctr) {
+        cp.push_command (std::make_unique<pstore::broker::message_type> (
+                             static_cast<std::uint32_t> (ctr), std::uint16_t{0}, std::uint16_t{1},
+                             "NOP"),
+                         nullptr);
+    }
+    ASSERT_EQ (cp.queue_status ().size, capacity);
+
+    // Process SUICIDE as the command thread would. This must not wait for space in the queue: if
+    // it did, nothing would ever make any.
+    cp.process_command (fifo, pstore::broker::message_type{0U, std::uint16_t{0},
+                                                           std::uint16_t{1}, "SUICIDE"});
+    EXPECT_TRUE (pstore::broker::done);
+    EXPECT_TRUE (uptime_done);
+
+    // The command thread's quit request is handled ahead of the queued commands.
+    cp.thread_entry (fifo);
+    EXPECT_EQ (cp.nops (), 0U);
+    EXPECT_EQ (cp.queue_status ().size, capacity);
+
+    pstore::broker::done = false;
+}
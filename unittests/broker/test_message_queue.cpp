@@ -0,0 +1,144 @@
+//*                                                                          *
+//*  _ __ ___   ___  ___ ___  __ _  __ _  ___    __ _ _   _  ___ _   _  ___  *
+//* | '_ ` _ \ / _ \/ __/ __|/ _` |/ _` |/ _ \  / _` | | | |/ _ \ | | |/ _ \ *
+//* | | | | | |  __/\__ \__ \ (_| | (_| |  __/ | (_| | |_| |  __/ |_| |  __/ *
+//* |_| |_| |_|\___||___/___/\__,_|\__, |\___|  \__, |\__,_|\___|\__,_|\___| *
+//*                                |___/           |_|                       *
+//===- unittests/broker/test_message_queue.cpp ----------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/broker/message_queue.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include <gmock/gmock.h>
+
+using pstore::broker::message_queue;
+using pstore::broker::message_queue_status;
+
+TEST (MessageQueue, PushPop) {
+    message_queue<int> queue{4U};
+    queue.push (1);
+    queue.push (2);
+    EXPECT_EQ (queue.status ().size, 2U);
+    EXPECT_EQ (queue.pop (), 1);
+    EXPECT_EQ (queue.pop (), 2);
+
+    message_queue_status const status = queue.status ();
+    EXPECT_EQ (status.size, 0U);
+    EXPECT_EQ (status.backpressure, 0U);
+    EXPECT_EQ (status.wakeups, 0U);
+}
+
+TEST (MessageQueue, Clear) {
+    message_queue<int> queue{4U};
+    queue.push (1);
+    queue.push (2);
+    queue.clear ();
+    EXPECT_EQ (queue.status ().size, 0U);
+    queue.push (3);
+    EXPECT_EQ (queue.pop (), 3);
+}
+
+TEST (MessageQueue, PopWaitsForPush) {
+    message_queue<int> queue{4U};
+    int popped = 0;
+    std::thread consumer ([&queue, &popped] () { popped = queue.pop (); });
+    // Give the consumer a chance to go to sleep. The test is correct whether or not it does.
+    std::this_thread::sleep_for (std::chrono::milliseconds{10});
+    queue.push (7);
+    consumer.join ();
+    EXPECT_EQ (popped, 7);
+}
+
+TEST (MessageQueue, PushWaitsWhenFull) {
+    constexpr auto count = 1000;
+    message_queue<int> queue{2U};
+    std::thread producer ([&queue] () {
+        for (auto ctr = 0; ctr < count; ++ctr) {
+            queue.push (int{ctr});
+        }
+    });
+    // Wait until the producer has filled the queue.
+    while (queue.status ().backpressure == 0U) {
+        std::this_thread::yield ();
+    }
+    for (auto ctr = 0; ctr < count; ++ctr) {
+        EXPECT_EQ (queue.pop (), ctr);
+    }
+    producer.join ();
+    EXPECT_GT (queue.status ().backpressure, 0U);
+}
+
+TEST (MessageQueue, ControlPushOnAFullQueue) {
+    message_queue<int> queue{2U};
+    queue.push (1);
+    queue.push (2);
+    // The queue is full but a control message must still be accepted immediately.
+    queue.push_control (3);
+    EXPECT_EQ (queue.status ().size, 3U);
+    EXPECT_EQ (queue.status ().backpressure, 0U);
+    EXPECT_EQ (queue.pop (), 3);
+    EXPECT_EQ (queue.pop (), 1);
+    EXPECT_EQ (queue.pop (), 2);
+}
+
+TEST (MessageQueue, ControlPushWakesConsumer) {
+    message_queue<int> queue{2U};
+    int popped = 0;
+    std::thread consumer ([&queue, &popped] () { popped = queue.pop (); });
+    std::this_thread::sleep_for (std::chrono::milliseconds{10});
+    queue.push_control (5);
+    consumer.join ();
+    EXPECT_EQ (popped, 5);
+}
+
+TEST (MessageQueue, CloseReleasesBlockedProducer) {
+    message_queue<int> queue{2U};
+    queue.push (1);
+    queue.push (2);
+    std::thread producer ([&queue] () { queue.push (3); });
+    // Wait until the producer has found the queue full.
+    while (queue.status ().backpressure == 0U) {
+        std::this_thread::yield ();
+    }
+    queue.close ();
+    producer.join ();
+    // The blocked message was discarded.
+    EXPECT_EQ (queue.status ().size, 2U);
+}
@@ -0,0 +1,148 @@
+//*                                                  _              *
+//*  _ __ ___   ___  ___ ___  __ _  __ _  ___   _ __(_)_ __   __ _  *
+//* | '_ ` _ \ / _ \/ __/ __|/ _` |/ _` |/ _ \ | '__| | '_ \ / _` | *
+//* | | | | | |  __/\__ \__ \ (_| | (_| |  __/ | |  | | | | | (_| | *
+//* |_| |_| |_|\___||___/___/\__,_|\__, |\___| |_|  |_|_| |_|\__, | *
+//*                                |___/                     |___/  *
+//===- unittests/core/broker_intf/test_message_ring.cpp -------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/broker_intf/message_ring.hpp"
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+
+using pstore::broker::message_ring;
+
+namespace {
+
+    class MessageRing : public ::testing::Test {
+    protected:
+        MessageRing ()
+                : ring_{std::make_unique<message_ring> ()} {
+            ring_->reset ();
+        }
+        std::unique_ptr<message_ring> ring_;
+    };
+
+} // end anonymous namespace
+
+TEST_F (MessageRing, PutTake) {
+    std::string const text = "GC /a/path";
+    pstore::maybe<message_ring::ticket> const t = ring_->put (pstore::gsl::make_span (text));
+    ASSERT_TRUE (t.has_value ());
+    pstore::maybe<std::string> const message = ring_->take (*t);
+    ASSERT_TRUE (message.has_value ());
+    EXPECT_EQ (*message, text);
+    // A message can only be taken once.
+    EXPECT_FALSE (ring_->take (*t).has_value ());
+}
+
+TEST_F (MessageRing, StaleTicket) {
+    std::string const text = "text";
+    pstore::maybe<message_ring::ticket> const t = ring_->put (pstore::gsl::make_span (text));
+    ASSERT_TRUE (t.has_value ());
+    message_ring::ticket stale = *t;
+    --stale.sequence;
+    EXPECT_FALSE (ring_->take (stale).has_value ());
+    // The message is still available to the holder of the correct ticket.
+    EXPECT_TRUE (ring_->take (*t).has_value ());
+
+    ring_->reset ();
+    EXPECT_FALSE (ring_->take (message_ring::ticket{message_ring::num_slots, 0U}).has_value ());
+}
+
+TEST_F (MessageRing, Full) {
+    std::string const text = "text";
+    for (auto ctr = 0U; ctr < message_ring::num_slots; ++ctr) {
+        EXPECT_TRUE (ring_->put (pstore::gsl::make_span (text)).has_value ());
+    }
+    EXPECT_FALSE (ring_->put (pstore::gsl::make_span (text)).has_value ());
+}
+
+TEST_F (MessageRing, TooLarge) {
+    std::string const text (message_ring::slot_size + 1U, 'x');
+    EXPECT_FALSE (message_ring::wanted (text.length ()));
+    EXPECT_FALSE (ring_->put (pstore::gsl::make_span (text)).has_value ());
+}
+
+TEST_F (MessageRing, BadLengthIsRejected) {
+    std::string const text = "text";
+    pstore::maybe<message_ring::ticket> const t = ring_->put (pstore::gsl::make_span (text));
+    ASSERT_TRUE (t.has_value ());
+    ASSERT_EQ (t->slot, 0U);
+
+    // Simulate a client which writes a bad length to the shared ring. The length of slot 0
+    // follows the ring's next-slot counter and the slot's state and sequence number.
+    auto const bad_length = static_cast<std::uint32_t> (message_ring::slot_size + 1U);
+    std::memcpy (reinterpret_cast<std::uint8_t *> (ring_.get ()) + 3U * sizeof (std::uint32_t),
+                 &bad_length, sizeof (bad_length));
+    EXPECT_FALSE (ring_->take (*t).has_value ());
+
+    // The slot was freed: the ring can hold num_slots new messages.
+    for (auto ctr = 0U; ctr < message_ring::num_slots; ++ctr) {
+        EXPECT_TRUE (ring_->put (pstore::gsl::make_span (text)).has_value ());
+    }
+}
+
+TEST_F (MessageRing, Cancel) {
+    std::string const text = "text";
+    pstore::maybe<message_ring::ticket> const t = ring_->put (pstore::gsl::make_span (text));
+    ASSERT_TRUE (t.has_value ());
+    EXPECT_TRUE (ring_->cancel (*t));
+    EXPECT_FALSE (ring_->take (*t).has_value ());
+    EXPECT_FALSE (ring_->cancel (*t));
+    for (auto ctr = 0U; ctr < message_ring::num_slots; ++ctr) {
+        EXPECT_TRUE (ring_->put (pstore::gsl::make_span (text)).has_value ());
+    }
+}
+
+TEST (MessageRingDoorbell, RoundTrip) {
+    message_ring::ticket const t{3U, 42U};
+    pstore::maybe<message_ring::ticket> const parsed =
+        pstore::broker::parse_doorbell (pstore::broker::doorbell_path (t));
+    ASSERT_TRUE (parsed.has_value ());
+    EXPECT_EQ (parsed->slot, 3U);
+    EXPECT_EQ (parsed->sequence, 42U);
+
+    EXPECT_FALSE (pstore::broker::parse_doorbell ("").has_value ());
+    EXPECT_FALSE (pstore::broker::parse_doorbell ("1").has_value ());
+    EXPECT_FALSE (pstore::broker::parse_doorbell ("1 2 3").has_value ());
+}
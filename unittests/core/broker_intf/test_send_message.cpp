@@ -49,6 +49,7 @@
 #include "gmock/gmock.h"
 
 #include "pstore/broker_intf/descriptor.hpp"
+#include "pstore/broker_intf/message_ring.hpp"
 #include "pstore/broker_intf/message_type.hpp"
 #include "pstore/broker_intf/writer.hpp"
 
@@ -110,3 +111,55 @@ TEST_F (BrokerSendMessage, TwoParts) {
 
     pstore::broker::send_message (wr, true /*error on timeout*/, verb.c_str (), path.c_str ());
 }
+
+TEST_F (BrokerSendMessage, RingDoorbell) {
+    using ::testing::Eq;
+    using ::testing::Return;
+
+    auto ring = std::make_unique<pstore::broker::message_ring> ();
+    ring->reset ();
+
+    // A message too long for a single part is placed in the ring and a doorbell is written.
+    std::string const path (pstore::broker::message_type::payload_chars, 'p');
+    mock_writer wr;
+    EXPECT_CALL (wr, write_impl (::testing::_)).WillOnce (Return (true));
+    pstore::broker::send_message (wr, true /*error on timeout*/, "verb", path.c_str (),
+                                  ring.get ());
+    ::testing::Mock::VerifyAndClearExpectations (&wr);
+
+    // The message is in slot 0. Its sequence number was incremented by reset() and put().
+    pstore::broker::message_ring::ticket const t{0U, 2U};
+    pstore::maybe<std::string> const message = ring->take (t);
+    ASSERT_TRUE (message.has_value ());
+    EXPECT_EQ (*message, "verb " + path);
+}
+
+TEST_F (BrokerSendMessage, UnsentDoorbellFreesSlot) {
+    using ::testing::Return;
+
+    auto ring = std::make_unique<pstore::broker::message_ring> ();
+    ring->reset ();
+
+    // The doorbell write times out so the message must not be left in the ring.
+    std::string const path (pstore::broker::message_type::payload_chars, 'p');
+    mock_writer wr;
+    EXPECT_CALL (wr, write_impl (::testing::_)).WillOnce (Return (false));
+    EXPECT_FALSE (pstore::broker::send_message (wr, false /*error on timeout*/, "verb",
+                                                path.c_str (), ring.get ()));
+
+    pstore::broker::message_ring::ticket const t{0U, 2U};
+    EXPECT_FALSE (ring->take (t).has_value ());
+    EXPECT_FALSE (ring->cancel (t));
+}
+
+TEST_F (BrokerSendMessage, SmallMessageBypassesRing) {
+    using ::testing::Eq;
+    using ::testing::Return;
+
+    auto ring = std::make_unique<pstore::broker::message_ring> ();
+    ring->reset ();
+    mock_writer wr;
+    pstore::broker::message_type const expected{message_id_, 0, 1, "hello world"};
+    EXPECT_CALL (wr, write_impl (Eq (expected))).WillOnce (Return (true));
+    pstore::broker::send_message (wr, true /*error on timeout*/, "hello", "world", ring.get ());
+}
@@ -0,0 +1,191 @@
+//*                                                 _                   _ _             *
+//*   ___ ___  _ __   ___ _   _ _ __ _ __ ___ _ __ | |_  __      ___ __(_) |_ ___ _ __  *
+//*  / __/ _ \| '_ \ / __| | | | '__| '__/ _ \ '_ \| __| \ \ /\ / / '__| | __/ _ \ '__| *
+//* | (_| (_) | | | | (__| |_| | |  | | |  __/ | | | |_   \ V  V /| |  | | ||  __/ |    *
+//*  \___\___/|_| |_|\___|\__,_|_|  |_|  \___|_| |_|\__|   \_/\_/ |_|  |_|\__\___|_|    *
+//*                                                                                     *
+//===- unittests/core/test_concurrent_writer.cpp --------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file test_concurrent_writer.cpp
+
+#include "pstore/core/concurrent_writer.hpp"
+
+// Standard includes
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+// pstore includes
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/index_types.hpp"
+
+// Local test includes
+#include "empty_store.hpp"
+#include "mock_mutex.hpp"
+
+namespace {
+
+    class ConcurrentWriter : public EmptyStore {
+    public:
+        ConcurrentWriter ()
+                : db_{new pstore::database (this->file ())} {
+            db_->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+        }
+
+    protected:
+        using lock_guard = std::unique_lock<mock_mutex>;
+
+        // Copies a string into storage allocated from an arena.
+        static pstore::extent<char> store_string (pstore::transaction_arena & arena,
+                                                  std::string const & str);
+
+        mock_mutex mutex_;
+        std::unique_ptr<pstore::database> db_;
+    };
+
+    pstore::extent<char> ConcurrentWriter::store_string (pstore::transaction_arena & arena,
+                                                         std::string const & str) {
+        std::shared_ptr<char> ptr;
+        pstore::typed_address<char> addr;
+        std::tie (ptr, addr) = arena.alloc_rw<char> (str.length ());
+        std::memcpy (ptr.get (), str.data (), str.length ());
+        return {addr, str.length ()};
+    }
+
+} // end anonymous namespace
+
+TEST_F (ConcurrentWriter, ArenaAllocations) {
+    auto t = pstore::begin (*db_, lock_guard{mutex_});
+    pstore::concurrent_writer writer{t, 256U};
+    pstore::transaction_arena & arena = writer.arena ();
+    EXPECT_EQ (&arena, &writer.arena ()) << "Expected the same arena for the same thread";
+
+    std::vector<pstore::typed_address<std::uint64_t>> addrs;
+    for (auto ctr = std::uint64_t{0}; ctr < 100U; ++ctr) {
+        std::shared_ptr<std::uint64_t> ptr;
+        pstore::typed_address<std::uint64_t> addr;
+        std::tie (ptr, addr) = arena.alloc_rw<std::uint64_t> ();
+        EXPECT_EQ (addr.to_address ().absolute () % alignof (std::uint64_t), 0U);
+        *ptr = ctr;
+        addrs.push_back (addr);
+    }
+    // A request which is larger than a block.
+    pstore::extent<char> const big = store_string (arena, std::string (1024, 'x'));
+
+    writer.merge ();
+    t.commit ();
+
+    // Check that none of the allocations overlap and that the data was written correctly.
+    std::sort (std::begin (addrs), std::end (addrs));
+    for (auto it = std::begin (addrs); it != std::end (addrs); ++it) {
+        if (it != std::begin (addrs)) {
+            EXPECT_GE (it->to_address ().absolute (),
+                       std::prev (it)->to_address ().absolute () + sizeof (std::uint64_t));
+        }
+    }
+    for (auto ctr = std::uint64_t{0}; ctr < 100U; ++ctr) {
+        EXPECT_EQ (*db_->getro (addrs[ctr]), ctr);
+    }
+    std::shared_ptr<char const> const big_data = db_->getro (big);
+    EXPECT_EQ (std::string (big_data.get (), big.size), std::string (1024, 'x'));
+}
+
+TEST_F (ConcurrentWriter, AlignmentLargerThanBlock) {
+    auto t = pstore::begin (*db_, lock_guard{mutex_});
+    constexpr auto block_size = 32U;
+    constexpr auto align = 64U;
+    pstore::concurrent_writer writer{t, block_size};
+    std::shared_ptr<void> ptr;
+    pstore::address addr;
+    std::tie (ptr, addr) = writer.arena ().alloc_rw (8U, align);
+    EXPECT_NE (ptr, nullptr);
+    EXPECT_EQ (addr.absolute () % align, 0U);
+    writer.merge ();
+    t.commit ();
+}
+
+TEST_F (ConcurrentWriter, ParallelWritersMergeIndexUpdates) {
+    constexpr auto num_threads = 4U;
+    constexpr auto strings_per_thread = 256U;
+
+    auto make_key = [] (unsigned thread, unsigned ctr) {
+        return "t" + std::to_string (thread) + "-" + std::to_string (ctr);
+    };
+
+    {
+        auto t = pstore::begin (*db_, lock_guard{mutex_});
+        auto const index = pstore::index::get_index<pstore::trailer::indices::write> (*db_);
+        pstore::concurrent_writer writer{t, 1024U};
+
+        std::vector<std::thread> threads;
+        for (auto th = 0U; th < num_threads; ++th) {
+            threads.emplace_back ([&writer, &index, &make_key, th] () {
+                pstore::transaction_arena & arena = writer.arena ();
+                for (auto ctr = 0U; ctr < strings_per_thread; ++ctr) {
+                    auto const key = make_key (th, ctr);
+                    arena.insert_or_assign (index, key, store_string (arena, "value " + key));
+                }
+            });
+        }
+        for (std::thread & th : threads) {
+            th.join ();
+        }
+        EXPECT_EQ (index->size (), 0U) << "Index updates should be deferred until merge()";
+        writer.merge ();
+        EXPECT_EQ (index->size (), num_threads * strings_per_thread);
+        t.commit ();
+    }
+
+    auto const index = pstore::index::get_index<pstore::trailer::indices::write> (*db_);
+    ASSERT_EQ (index->size (), num_threads * strings_per_thread);
+    for (auto th = 0U; th < num_threads; ++th) {
+        for (auto ctr = 0U; ctr < strings_per_thread; ++ctr) {
+            auto const key = make_key (th, ctr);
+            auto const pos = index->find (*db_, key);
+            ASSERT_NE (pos, index->cend (*db_)) << "Key " << key << " was not found";
+            pstore::extent<char> const ex = pos->second;
+            std::shared_ptr<char const> const data = db_->getro (ex);
+            EXPECT_EQ (std::string (data.get (), ex.size), "value " + key);
+        }
+    }
+}
@@ -42,7 +42,11 @@
 // SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
 //===----------------------------------------------------------------------===//
 #include "pstore/core/crc32.hpp"
+
 #include <cstring>
+#include <random>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "pstore/support/gsl.hpp"
 
@@ -60,3 +64,68 @@ TEST (Crc32, Sequence) {
     auto span = pstore::gsl::make_span (str, length);
     EXPECT_EQ (pstore::crc32 (span), 0x0fcdae64U);
 }
+
+namespace {
+
+    class Crc32Kernels : public ::testing::Test {
+    protected:
+        Crc32Kernels ();
+
+        std::uint32_t reference (std::size_t offset, std::size_t size) const noexcept {
+            return pstore::details::crc32_bytewise (0U, data_.data () + offset, size);
+        }
+        std::uint8_t const * data () const noexcept { return data_.data (); }
+
+        /// The offsets used to exercise unaligned buffers.
+        static constexpr std::size_t max_offset = 15U;
+
+    private:
+        std::vector<std::uint8_t> data_;
+    };
+
+    constexpr std::size_t Crc32Kernels::max_offset;
+
+    Crc32Kernels::Crc32Kernels ()
+            : data_ (4096U + max_offset) {
+        std::mt19937 gen{42U};
+        std::uniform_int_distribution<unsigned> dist{0U, 255U};
+        for (auto & b : data_) {
+            b = static_cast<std::uint8_t> (dist (gen));
+        }
+    }
+
+} // end anonymous namespace
+
+TEST_F (Crc32Kernels, Slice8MatchesBytewise) {
+    for (auto offset = std::size_t{0}; offset <= max_offset; ++offset) {
+        for (auto size = std::size_t{0}; size <= 300U; ++size) {
+            EXPECT_EQ (pstore::details::crc32_slice8 (0U, this->data () + offset, size),
+                       this->reference (offset, size))
+                << "offset=" << offset << " size=" << size;
+        }
+    }
+    EXPECT_EQ (pstore::details::crc32_slice8 (0U, this->data (), 4096U),
+               this->reference (0U, 4096U));
+}
+
+TEST_F (Crc32Kernels, HardwareMatchesBytewise) {
+    pstore::details::crc32_function const hw = pstore::details::crc32_hardware ();
+    if (hw == nullptr) {
+        return; // No hardware support on this host.
+    }
+    for (auto offset = std::size_t{0}; offset <= max_offset; ++offset) {
+        for (auto size = std::size_t{0}; size <= 300U; ++size) {
+            EXPECT_EQ (hw (0U, this->data () + offset, size), this->reference (offset, size))
+                << "offset=" << offset << " size=" << size;
+        }
+    }
+    EXPECT_EQ (hw (0U, this->data (), 4096U), this->reference (0U, 4096U));
+}
+
+TEST_F (Crc32Kernels, Incremental) {
+    // Feeding the data in pieces must give the same result as a single call.
+    auto const split = std::size_t{77};
+    std::uint32_t const first = pstore::details::crc32_update (0U, this->data (), split);
+    EXPECT_EQ (pstore::details::crc32_update (first, this->data () + split, 4096U - split),
+               this->reference (0U, 4096U));
+}
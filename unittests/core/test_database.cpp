@@ -52,6 +52,9 @@
 
 #include "gmock/gmock.h"
 
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/index_types.hpp"
+#include "pstore/core/transaction.hpp"
 #include "pstore/support/portab.hpp"
 
 #include "check_for_error.hpp"
@@ -156,6 +159,22 @@ TEST_F (OpenCorruptStore, HeaderBadMinorVersion) {
     this->check_database_open (pstore::error_code::header_version_mismatch);
 }
 
+TEST_F (OpenCorruptStore, HeaderOldestMinorVersion) {
+    auto * const h = this->get_header ();
+    h->a.version[1] = pstore::header::oldest_minor_version;
+    h->crc = h->get_crc ();
+    pstore::database db{this->file ()};
+    EXPECT_EQ (db.minor_version (), pstore::header::oldest_minor_version);
+}
+
+TEST_F (OpenCorruptStore, HeaderMinorVersionTooOld) {
+    PSTORE_STATIC_ASSERT (pstore::header::oldest_minor_version > 0U);
+    auto * const h = this->get_header ();
+    h->a.version[1] = pstore::header::oldest_minor_version - 1U;
+    h->crc = h->get_crc ();
+    this->check_database_open (pstore::error_code::header_version_mismatch);
+}
+
 TEST_F (OpenCorruptStore, HeaderUUID) {
     // This test is only valid if CRC checking is enabled.
     if (pstore::database::crc_checks_enabled ()) {
@@ -284,3 +303,80 @@ TEST_F (Database, Allocate16BytesAligned1024) {
     pstore::address addr2 = db.allocate (size, align);
     EXPECT_EQ (addr.absolute () + align, addr2.absolute ());
 }
+
+namespace {
+
+    class TrailerExtension : public EmptyStore {
+    protected:
+        using lock_guard = std::unique_lock<mock_mutex>;
+
+        /// Adds an entry to the payload index, which has no slot in the trailer body, and
+        /// commits.
+        static void add_payload (pstore::database & db, mock_mutex & mutex);
+    };
+
+    void TrailerExtension::add_payload (pstore::database & db, mock_mutex & mutex) {
+        auto t = pstore::begin (db, lock_guard{mutex});
+        auto const addr = pstore::typed_address<std::uint8_t> (t.allocate (1U, 1U));
+        pstore::index::get_index<pstore::trailer::indices::payload> (db)->insert (
+            t, std::make_pair (pstore::index::digest{1U}, pstore::make_extent (addr, 1U)));
+        t.commit ();
+    }
+
+} // end anonymous namespace
+
+TEST_F (TrailerExtension, RecordsIndexWithoutATrailerSlot) {
+    PSTORE_STATIC_ASSERT (static_cast<unsigned> (pstore::trailer::indices::payload) >=
+                          pstore::trailer::num_trailer_indices);
+    mock_mutex mutex;
+    {
+        pstore::database db{this->file ()};
+        db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+        add_payload (db, mutex);
+
+        auto const footer = db.get_footer ();
+        EXPECT_NE (footer->a.extension_offset, 0U);
+        auto const records = pstore::trailer::get_index_records (db, db.footer_pos ());
+        EXPECT_NE (records[static_cast<unsigned> (pstore::trailer::indices::payload)],
+                   pstore::typed_address<pstore::index::header_block>::null ());
+        for (auto const & record : footer->a.index_records) {
+            EXPECT_EQ (record, pstore::typed_address<pstore::index::header_block>::null ());
+        }
+    }
+    {
+        // Re-open the store and check that the index is found.
+        pstore::database db{this->file ()};
+        db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+        auto const index =
+            pstore::index::get_index<pstore::trailer::indices::payload> (db, false /*create*/);
+        ASSERT_NE (index, nullptr);
+        EXPECT_NE (index->find (db, pstore::index::digest{1U}), index->cend (db));
+    }
+}
+
+TEST_F (TrailerExtension, CorruptExtensionIsDetected) {
+    mock_mutex mutex;
+    pstore::database db{this->file ()};
+    db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    add_payload (db, mutex);
+
+    auto const footer_pos = db.footer_pos ();
+    auto const offset = db.get_footer ()->a.extension_offset;
+    auto * const extension = reinterpret_cast<pstore::trailer::extension *> (
+        this->buffer ().get () + footer_pos.absolute () - offset);
+    extension->a.signature[0] = !extension->a.signature[0];
+    check_for_error ([&db, footer_pos] () { pstore::trailer::get_index_records (db, footer_pos); },
+                     pstore::error_code::footer_corrupt);
+}
+
+TEST_F (TrailerExtension, NotWrittenToAnOlderStore) {
+    auto * const h = reinterpret_cast<pstore::header *> (this->buffer ().get ());
+    h->a.version[1] = pstore::header::shared_payload_version - 1U;
+    h->crc = h->get_crc ();
+
+    mock_mutex mutex;
+    pstore::database db{this->file ()};
+    db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    check_for_error ([&db, &mutex] () { add_payload (db, mutex); },
+                     pstore::error_code::header_version_mismatch);
+}
@@ -49,11 +49,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "pstore/core/generation_iterator.hpp"
+// Standard includes
+#include <vector>
 // 3rd party includes
 #include <gtest/gtest.h>
 // pstore includes
 #include "pstore/core/transaction.hpp"
 // Local includes
+#include "check_for_error.hpp"
 #include "empty_store.hpp"
 
 using pstore::generation_container;
@@ -130,3 +133,54 @@ TEST_F (GenerationIterator, PostIncrement) {
     EXPECT_EQ (begin, old);
     EXPECT_EQ (end, it);
 }
+
+TEST_F (GenerationIterator, SkipGenerationNumberIsOlder) {
+    for (auto generation = 1U; generation < 1000U; ++generation) {
+        EXPECT_LT (pstore::trailer::skip_generation_number (generation), generation);
+    }
+}
+
+TEST_F (GenerationIterator, SkipPointersTargetSkipGeneration) {
+    for (auto ctr = 0; ctr < 40; ++ctr) {
+        this->add_transaction ();
+    }
+    auto & d = this->db ();
+    for (trailer_address const pos : generation_container{d}) {
+        auto const t = d.getro (pos);
+        trailer_address const skip = t->a.skip_generation;
+        if (t->a.generation == 0U) {
+            EXPECT_EQ (trailer_address::null (), skip);
+        } else {
+            EXPECT_EQ (pstore::trailer::skip_generation_number (t->a.generation),
+                       d.getro (skip)->a.generation);
+        }
+    }
+}
+
+TEST_F (GenerationIterator, SeekMatchesLinearWalk) {
+    constexpr auto num_transactions = 100U;
+    for (auto ctr = 0U; ctr < num_transactions; ++ctr) {
+        this->add_transaction ();
+    }
+    auto & d = this->db ();
+
+    // Record the footer position of every revision by walking the complete list.
+    std::vector<trailer_address> expected (num_transactions + 1U);
+    for (trailer_address const pos : generation_container{d}) {
+        expected.at (d.getro (pos)->a.generation) = pos;
+    }
+
+    for (auto revision = 0U; revision <= num_transactions; ++revision) {
+        generation_iterator it = generation_container{d}.begin ();
+        EXPECT_EQ (expected[revision], *it.seek (revision)) << "revision " << revision;
+        EXPECT_EQ (expected[revision], d.older_revision_footer_pos (revision));
+    }
+}
+
+TEST_F (GenerationIterator, SeekToLaterRevisionFails) {
+    this->add_transaction ();
+    this->add_transaction ();
+    auto & d = this->db ();
+    generation_iterator it = generation_container{d}.find (1U);
+    check_for_error ([&it] () { it.seek (2U); }, pstore::error_code::unknown_revision);
+}
@@ -0,0 +1,322 @@
+//*  _                     _      __ _ _ _             *
+//* | |__   __ _ _ __ ___ | |_   / _(_) | |_ ___ _ __  *
+//* | '_ \ / _` | '_ ` _ \| __| | |_| | | __/ _ \ '__| *
+//* | | | | (_| | | | | | | |_  |  _| | | ||  __/ |    *
+//* |_| |_|\__,_|_| |_| |_|\__| |_| |_|_|\__\___|_|    *
+//*                                                    *
+//===- unittests/core/test_hamt_filter.cpp --------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file test_hamt_filter.cpp
+
+#include "pstore/core/hamt_filter.hpp"
+
+// Standard includes
+#include <string>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+// pstore includes
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/transaction.hpp"
+#include "pstore/support/bit_count.hpp"
+
+// Local test includes
+#include "empty_store.hpp"
+#include "mock_mutex.hpp"
+
+using pstore::index::details::membership_filter;
+
+TEST (MembershipFilterBlock, InsertThenContains) {
+    membership_filter::block b{{0}};
+    EXPECT_FALSE (membership_filter::contains (b, 1U));
+    membership_filter::insert (b, 1U);
+    EXPECT_TRUE (membership_filter::contains (b, 1U));
+    // Each key sets one bit in each word of the block.
+    for (auto const word : b) {
+        EXPECT_EQ (pstore::bit_count::pop_count (word), 1U);
+    }
+}
+
+TEST (MembershipFilterBlock, BlocksFor) {
+    EXPECT_EQ (membership_filter::blocks_for (0U), 1U);
+    EXPECT_EQ (membership_filter::blocks_for (1U), 1U);
+    EXPECT_EQ (membership_filter::blocks_for (16U), 1U);
+    EXPECT_EQ (membership_filter::blocks_for (17U), 2U);
+    EXPECT_EQ (membership_filter::blocks_for (1000U), 64U);
+}
+
+namespace {
+
+    class HamtFilter : public EmptyStore {
+    public:
+        HamtFilter ()
+                : db_{new pstore::database (this->file ())} {
+            db_->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+            db_->set_index_filter_mode (pstore::database::index_filter_mode::enabled);
+        }
+
+    protected:
+        using index_type = pstore::index::hamt_map<std::string, std::string>;
+        using header_address = pstore::typed_address<pstore::index::header_block>;
+
+        /// Adds the keys [first, last) to the index and commits them.
+        header_address add_keys (index_type & index, unsigned first, unsigned last);
+
+        /// Returns the number of the keys [first, last) which the index's filter accepts.
+        unsigned count_accepted (index_type const & index, unsigned first, unsigned last) const;
+
+        static std::string key (unsigned const k) { return "key " + std::to_string (k); }
+        /// Returns the signature of the index header at \p addr.
+        std::string signature (header_address addr) const;
+
+        mock_mutex mutex_;
+        std::unique_ptr<pstore::database> db_;
+    };
+
+    // add_keys
+    // ~~~~~~~~
+    auto HamtFilter::add_keys (index_type & index, unsigned first, unsigned const last)
+        -> header_address {
+        auto t1 = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+        for (; first < last; ++first) {
+            index.insert (t1, std::make_pair (key (first), std::string{"value"}));
+        }
+        auto const addr = index.flush (t1, db_->get_current_revision () + 1U);
+        t1.commit ();
+        return addr;
+    }
+
+    // count_accepted
+    // ~~~~~~~~~~~~~~
+    unsigned HamtFilter::count_accepted (index_type const & index, unsigned first,
+                                         unsigned const last) const {
+        auto result = 0U;
+        for (; first < last; ++first) {
+            if (index.filter ().may_contain (*db_, std::hash<std::string>{}(key (first)))) {
+                ++result;
+            }
+        }
+        return result;
+    }
+
+    // signature
+    // ~~~~~~~~~
+    std::string HamtFilter::signature (header_address const addr) const {
+        std::shared_ptr<pstore::index::header_block const> const hb = db_->getro (addr);
+        return {std::begin (hb->signature), std::end (hb->signature)};
+    }
+
+} // end anonymous namespace
+
+TEST_F (HamtFilter, WrittenWithIndex) {
+    index_type index1{*db_};
+    header_address const addr = this->add_keys (index1, 0U, 100U);
+
+    index_type const index2{*db_, addr};
+    auto const & filter = index2.filter ();
+    ASSERT_NE (filter.location (), pstore::typed_address<pstore::index::filter_header>::null ());
+    EXPECT_EQ (filter.num_blocks (), membership_filter::blocks_for (100U));
+
+    // There are no false negatives.
+    EXPECT_EQ (this->count_accepted (index2, 0U, 100U), 100U);
+    for (auto k = 0U; k < 100U; ++k) {
+        EXPECT_NE (index2.find (*db_, key (k)), index2.cend (*db_));
+    }
+    // Almost all of the keys which are not present are rejected.
+    EXPECT_LT (this->count_accepted (index2, 100U, 10100U), 100U);
+    EXPECT_EQ (index2.find (*db_, key (100U)), index2.cend (*db_));
+}
+
+TEST_F (HamtFilter, Disabled) {
+    db_->set_index_filter_mode (pstore::database::index_filter_mode::disabled);
+    index_type index1{*db_};
+    header_address const addr = this->add_keys (index1, 0U, 10U);
+
+    index_type const index2{*db_, addr};
+    EXPECT_EQ (index2.filter ().location (),
+               pstore::typed_address<pstore::index::filter_header>::null ());
+    EXPECT_EQ (this->count_accepted (index2, 0U, 20U), 20U);
+}
+
+TEST_F (HamtFilter, ExtendedIncrementally) {
+    index_type index{*db_};
+    this->add_keys (index, 0U, 10U);
+    auto const first_location = index.filter ().location ();
+    auto const num_blocks = index.filter ().num_blocks ();
+
+    // The keys added in the second generation are copied into a new filter of the same size.
+    this->add_keys (index, 10U, 20U);
+    EXPECT_NE (index.filter ().location (), first_location);
+    EXPECT_EQ (index.filter ().num_blocks (), num_blocks);
+    EXPECT_EQ (this->count_accepted (index, 0U, 20U), 20U);
+
+    // Flushing without adding keys leaves the filter where it was.
+    auto const second_location = index.filter ().location ();
+    this->add_keys (index, 0U, 0U);
+    EXPECT_EQ (index.filter ().location (), second_location);
+}
+
+TEST_F (HamtFilter, RebuiltWhenFull) {
+    index_type index{*db_};
+    this->add_keys (index, 0U, 10U);
+    auto const num_blocks = index.filter ().num_blocks ();
+    auto const capacity =
+        static_cast<unsigned> (num_blocks * membership_filter::max_keys_per_block);
+
+    this->add_keys (index, 10U, capacity + 1U);
+    EXPECT_GT (index.filter ().num_blocks (), num_blocks);
+    EXPECT_EQ (this->count_accepted (index, 0U, capacity + 1U), capacity + 1U);
+}
+
+TEST_F (HamtFilter, OverlayHoldsOnlyChangedBlocks) {
+    index_type index1{*db_};
+    this->add_keys (index1, 0U, 1000U);
+    auto const base = index1.filter ().location ();
+    auto const num_blocks = index1.filter ().num_blocks ();
+    ASSERT_EQ (num_blocks, 64U);
+    EXPECT_EQ (index1.filter ().num_overlay_blocks (), 0U);
+
+    // A handful of new keys touch only a handful of blocks so the rest are not copied.
+    header_address const addr = this->add_keys (index1, 1000U, 1003U);
+    index_type const index2{*db_, addr};
+    auto const & filter = index2.filter ();
+    EXPECT_NE (filter.location (), base);
+    EXPECT_EQ (filter.base (), base);
+    EXPECT_EQ (filter.num_blocks (), num_blocks);
+    EXPECT_GE (filter.num_overlay_blocks (), 1U);
+    EXPECT_LE (filter.num_overlay_blocks (), 3U);
+
+    EXPECT_EQ (this->count_accepted (index2, 0U, 1003U), 1003U);
+    for (auto k = 0U; k < 1003U; ++k) {
+        EXPECT_NE (index2.find (*db_, key (k)), index2.cend (*db_));
+    }
+    EXPECT_LT (this->count_accepted (index2, 1003U, 11003U), 200U);
+}
+
+TEST_F (HamtFilter, OverlayReplacedByFullCopyWhenLarge) {
+    index_type index1{*db_};
+    this->add_keys (index1, 0U, 1000U);
+    this->add_keys (index1, 1000U, 1001U);
+    auto const base = index1.filter ().base ();
+    ASSERT_EQ (index1.filter ().num_overlay_blocks (), 1U);
+
+    // Enough new keys to dirty more than an eighth of the blocks: the filter is written in full
+    // and becomes the base for later overlays.
+    header_address const addr = this->add_keys (index1, 1001U, 1100U);
+    index_type const index2{*db_, addr};
+    auto const & filter = index2.filter ();
+    EXPECT_NE (filter.base (), base);
+    EXPECT_EQ (filter.location (), filter.base ());
+    EXPECT_EQ (filter.num_overlay_blocks (), 0U);
+    EXPECT_EQ (this->count_accepted (index2, 0U, 1100U), 1100U);
+}
+
+TEST_F (HamtFilter, HashesRecordedOnlyWithAFilter) {
+    db_->set_index_filter_mode (pstore::database::index_filter_mode::disabled);
+    index_type index{*db_};
+    {
+        // An index without a filter does not accumulate the hashes of new keys.
+        auto t1 = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+        index.insert (t1, std::make_pair (key (0U), std::string{"value"}));
+        index.insert (t1, std::make_pair (key (1U), std::string{"value"}));
+        EXPECT_EQ (index.filter ().num_pending (), 0U);
+        index.flush (t1, db_->get_current_revision () + 1U);
+        t1.commit ();
+    }
+
+    db_->set_index_filter_mode (pstore::database::index_filter_mode::enabled);
+    this->add_keys (index, 2U, 10U);
+    ASSERT_NE (index.filter ().location (),
+               pstore::typed_address<pstore::index::filter_header>::null ());
+    // The keys written before the filter was enabled are part of it.
+    EXPECT_EQ (this->count_accepted (index, 0U, 10U), 10U);
+
+    // Once there is a filter, new keys are recorded until it is next written.
+    auto t2 = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+    index.insert (t2, std::make_pair (key (10U), std::string{"value"}));
+    EXPECT_EQ (index.filter ().num_pending (), 1U);
+    index.flush (t2, db_->get_current_revision () + 1U);
+    EXPECT_EQ (index.filter ().num_pending (), 0U);
+    t2.commit ();
+}
+
+TEST_F (HamtFilter, UnflushedKeysAreFound) {
+    index_type index{*db_};
+    this->add_keys (index, 0U, 10U);
+
+    auto t1 = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+    index.insert (t1, std::make_pair (key (10U), std::string{"value"}));
+    // The in-store filter doesn't know about the new key so it must not be used.
+    EXPECT_NE (index.find (*db_, key (10U)), index.cend (*db_));
+    t1.commit ();
+}
+
+TEST_F (HamtFilter, HeaderSignatures) {
+    {
+        // An index without a filter has the original 24-byte header.
+        db_->set_index_filter_mode (pstore::database::index_filter_mode::disabled);
+        index_type index{*db_};
+        EXPECT_EQ (this->signature (this->add_keys (index, 0U, 10U)), "IndxHedr");
+    }
+    {
+        db_->set_index_filter_mode (pstore::database::index_filter_mode::enabled);
+        index_type index{*db_};
+        EXPECT_EQ (this->signature (this->add_keys (index, 0U, 10U)), "IndxHdrF");
+    }
+}
+
+TEST_F (HamtFilter, NotWrittenToAnOlderStore) {
+    db_.reset ();
+    auto * const h = reinterpret_cast<pstore::header *> (this->buffer ().get ());
+    h->a.version[1] = pstore::header::index_filter_version - 1U;
+    h->crc = h->get_crc ();
+    db_.reset (new pstore::database (this->file ()));
+    db_->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    db_->set_index_filter_mode (pstore::database::index_filter_mode::enabled);
+    EXPECT_FALSE (db_->writes_index_filter ());
+
+    index_type index1{*db_};
+    header_address const addr = this->add_keys (index1, 0U, 10U);
+    EXPECT_EQ (this->signature (addr), "IndxHedr");
+
+    index_type const index2{*db_, addr};
+    EXPECT_EQ (index2.filter ().location (),
+               pstore::typed_address<pstore::index::filter_header>::null ());
+    EXPECT_EQ (index2.size (), 10U);
+}
@@ -53,6 +53,7 @@
 // pstore includes
 #include "pstore/core/index_types.hpp"
 #include "pstore/core/transaction.hpp"
+#include "pstore/support/fnv.hpp"
 
 // local includes
 #include "check_for_error.hpp"
@@ -109,9 +110,43 @@ TEST_F (IndexFixture, InitPointer) {
 
 // Test initial pointer index pointer.
 TEST_F (IndexFixture, InternalSizeBytes) {
-    EXPECT_EQ (24U, pstore::index::details::internal_node::size_bytes (1));
-    EXPECT_EQ (32U, pstore::index::details::internal_node::size_bytes (2));
-    EXPECT_EQ (528U, pstore::index::details::internal_node::size_bytes (64));
+    // The child array is followed by an array of hash fragments padded to 8 bytes.
+    EXPECT_EQ (32U, pstore::index::details::internal_node::size_bytes (1));
+    EXPECT_EQ (40U, pstore::index::details::internal_node::size_bytes (2));
+    EXPECT_EQ (104U, pstore::index::details::internal_node::size_bytes (9));
+    EXPECT_EQ (592U, pstore::index::details::internal_node::size_bytes (64));
+
+    EXPECT_EQ (24U, pstore::index::details::internal_node::legacy_size_bytes (1));
+    EXPECT_EQ (32U, pstore::index::details::internal_node::legacy_size_bytes (2));
+    EXPECT_EQ (528U, pstore::index::details::internal_node::legacy_size_bytes (64));
+}
+
+TEST_F (IndexFixture, InternalFragments) {
+    using pstore::index::details::hash_type;
+    // Two leaves which occupy slots 1 and 2 of the node. The bits above the slot index differ in
+    // their fragment.
+    constexpr auto hash_a = hash_type{(0x15 << 6) | 1};
+    constexpr auto hash_b = hash_type{(0x2A << 6) | 2};
+    std::unique_ptr<internal_node> internal = internal_node::allocate (
+        index_pointer{pstore::address{8}}, index_pointer{pstore::address{16}}, hash_a, hash_b);
+    ASSERT_TRUE (internal->has_fragments ());
+    ASSERT_EQ (internal->size (), 2U);
+
+    EXPECT_TRUE (internal->may_match (0U, hash_a));
+    EXPECT_TRUE (internal->may_match (1U, hash_b));
+    // A key which selects the same slot but has different bits in the fragment is rejected.
+    EXPECT_FALSE (internal->may_match (0U, hash_type{(0x16 << 6) | 1}));
+    EXPECT_FALSE (internal->may_match (1U, hash_a));
+
+    // Inserting a child moves the fragments along with the children.
+    pstore::index::details::parent_stack parents;
+    constexpr auto hash_c = hash_type{(0x7F << 6) | 0};
+    internal->insert_child (hash_c, index_pointer{pstore::address{24}}, &parents);
+    ASSERT_EQ (internal->size (), 3U);
+    EXPECT_TRUE (internal->may_match (0U, hash_c));
+    EXPECT_TRUE (internal->may_match (1U, hash_a));
+    EXPECT_TRUE (internal->may_match (2U, hash_b));
+    EXPECT_FALSE (internal->may_match (0U, hash_a));
 }
 
 namespace {
@@ -441,6 +476,150 @@ TEST_F (HamtRoundTrip, LeafMember) {
     EXPECT_EQ (actual, expected);
 }
 
+TEST_F (HamtRoundTrip, FindStoredKeys) {
+    // Use a hash function which accepts both std::string and sstring_view keys.
+    using fnv_index_type =
+        pstore::index::hamt_map<std::string, std::string, pstore::fnv_64a_hash>;
+    pstore::typed_address<pstore::index::header_block> addr;
+    fnv_index_type index1{*db_, pstore::typed_address<pstore::index::header_block>::null ()};
+    {
+        auto t1 = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+        index1.insert_or_assign (t1, fnv_index_type::value_type{"a", "1"});
+        index1.insert_or_assign (t1, fnv_index_type::value_type{"ab", "2"});
+        index1.insert_or_assign (t1, fnv_index_type::value_type{"abc", "3"});
+        addr = index1.flush (t1, db_->get_current_revision () + 1U);
+        t1.commit ();
+    }
+
+    fnv_index_type index2{*db_, addr};
+    auto const end = index2.cend (*db_);
+    {
+        auto const pos = index2.find (*db_, std::string{"ab"});
+        ASSERT_NE (pos, end);
+        EXPECT_EQ (pos->second, "2");
+    }
+    {
+        std::string const key{"abc"};
+        auto const pos = index2.find (*db_, pstore::make_sstring_view (key));
+        ASSERT_NE (pos, end);
+        EXPECT_EQ (pos->second, "3");
+    }
+    {
+        pstore::pinned_view view{*db_};
+        auto const pos = index2.find (view, std::string{"a"});
+        ASSERT_NE (pos, end);
+        EXPECT_EQ (pos->second, "1");
+        EXPECT_EQ (index2.find (view, std::string{"abcd"}), end);
+    }
+    // Keys which share a prefix with, or are a prefix of, a stored key must not match.
+    EXPECT_EQ (index2.find (*db_, std::string{"abcd"}), end);
+    EXPECT_EQ (index2.find (*db_, std::string{"b"}), end);
+    EXPECT_EQ (index2.find (*db_, std::string{}), end);
+}
+
+namespace {
+
+    class ParallelFlush : public HamtRoundTrip {
+    protected:
+        // Builds an index containing a large number of keys, flushes it in the given mode, and
+        // checks that the result can be read back. It then adds more keys to the index read from
+        // the store and checks that the result of flushing it again can also be read back.
+        void round_trip (pstore::database::flush_mode mode);
+
+        // Returns true if the stored root of the index at addr has a fragment array.
+        bool root_has_fragments (pstore::typed_address<pstore::index::header_block> addr) const;
+    };
+
+    // root_has_fragments
+    // ~~~~~~~~~~~~~~~~~~
+    bool ParallelFlush::root_has_fragments (
+        pstore::typed_address<pstore::index::header_block> const addr) const {
+        index_type const index{*db_, addr};
+        EXPECT_TRUE (index.root ().is_internal ());
+        return internal_node::get_node (*db_, index.root ()).second->has_fragments ();
+    }
+
+    // round_trip
+    // ~~~~~~~~~~
+    void ParallelFlush::round_trip (pstore::database::flush_mode const mode) {
+        // Enough keys that the tree has many internal nodes (and plenty of work for each thread).
+        constexpr auto num_keys = 4096U;
+
+        db_->set_flush_mode (mode);
+        auto const insert_keys = [this] (index_type & index, unsigned const first,
+                                         unsigned const last) {
+            auto t1 = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+            for (auto ctr = first; ctr < last; ++ctr) {
+                auto const key = std::to_string (ctr);
+                index.insert_or_assign (t1, key, "value " + key);
+            }
+            auto const result = index.flush (t1, db_->get_current_revision () + 1U);
+            EXPECT_TRUE (index.root ().is_address ());
+            t1.commit ();
+            return result;
+        };
+        auto const check_keys = [this] (pstore::typed_address<pstore::index::header_block> addr,
+                                        unsigned const last) {
+            index_type index{*db_, addr};
+            ASSERT_EQ (index.size (), last);
+            for (auto ctr = 0U; ctr < last; ++ctr) {
+                auto const key = std::to_string (ctr);
+                auto const pos = index.find (*db_, key);
+                ASSERT_NE (pos, index.cend (*db_)) << "key: " << key;
+                EXPECT_EQ (pos->second, "value " + key);
+            }
+            EXPECT_EQ (index.find (*db_, std::string{"absent"}), index.cend (*db_));
+        };
+
+        pstore::typed_address<pstore::index::header_block> addr;
+        {
+            index_type index1{*db_, pstore::typed_address<pstore::index::header_block>::null ()};
+            addr = insert_keys (index1, 0U, num_keys);
+        }
+        check_keys (addr, num_keys);
+        EXPECT_EQ (root_has_fragments (addr), db_->writes_index_fragments ());
+        {
+            index_type index2{*db_, addr};
+            addr = insert_keys (index2, num_keys, num_keys * 2U);
+        }
+        check_keys (addr, num_keys * 2U);
+        EXPECT_EQ (root_has_fragments (addr), db_->writes_index_fragments ());
+    }
+
+} // end anonymous namespace
+
+TEST_F (ParallelFlush, Serial) {
+    this->round_trip (pstore::database::flush_mode::serial);
+}
+
+TEST_F (ParallelFlush, Parallel) {
+    this->round_trip (pstore::database::flush_mode::parallel);
+}
+
+TEST_F (ParallelFlush, SerialWithFragments) {
+    db_->set_index_fragments_mode (pstore::database::index_fragments_mode::enabled);
+    ASSERT_TRUE (db_->writes_index_fragments ());
+    this->round_trip (pstore::database::flush_mode::serial);
+}
+
+TEST_F (ParallelFlush, ParallelWithFragments) {
+    db_->set_index_fragments_mode (pstore::database::index_fragments_mode::enabled);
+    ASSERT_TRUE (db_->writes_index_fragments ());
+    this->round_trip (pstore::database::flush_mode::parallel);
+}
+
+TEST_F (ParallelFlush, FragmentsNotWrittenToAnOlderStore) {
+    db_.reset ();
+    auto * const h = reinterpret_cast<pstore::header *> (this->buffer ().get ());
+    h->a.version[1] = pstore::header::index_fragments_version - 1U;
+    h->crc = h->get_crc ();
+    db_.reset (new pstore::database (this->file ()));
+
+    db_->set_index_fragments_mode (pstore::database::index_fragments_mode::enabled);
+    EXPECT_FALSE (db_->writes_index_fragments ());
+    this->round_trip (pstore::database::flush_mode::parallel);
+}
+
 // ****************
 // *              *
 // *   OneLevel   *
@@ -1818,6 +1997,137 @@ TEST_F (CorruptInternalNodes, MatchingChildPointers) {
     this->find ();
 }
 
+// *******************************************
+// *                                         *
+// *               InsertRange               *
+// *                                         *
+// *******************************************
+
+namespace {
+
+    class InsertRange : public GenericIndexFixture {
+    protected:
+        InsertRange ()
+                : hash_{hashes_}
+                , index_{new test_trie (
+                      *db_, pstore::typed_address<pstore::index::header_block>::null (), hash_)} {}
+
+        // Returns the contents of the index as a sorted vector.
+        std::vector<std::pair<std::string, std::string>> contents () const;
+
+        static std::map<std::string, std::uint64_t> const hashes_;
+
+        hash_function hash_;
+        std::unique_ptr<test_trie> index_;
+    };
+
+    // Keys "a", "b", and "c" share their first level hash bits; "c" and "d" have an identical
+    // hash and must be placed in a linear node.
+    std::map<std::string, std::uint64_t> const InsertRange::hashes_{
+        {"a", UINT64_C (0b000001000001)}, {"b", UINT64_C (0b000010000001)},
+        {"c", UINT64_C (0xFFFFFFFFFFFFFF81)}, {"d", UINT64_C (0xFFFFFFFFFFFFFF81)},
+        {"e", UINT64_C (0b000011)},         {"f", UINT64_C (0b000100)},
+    };
+
+    // contents
+    // ~~~~~~~~
+    std::vector<std::pair<std::string, std::string>> InsertRange::contents () const {
+        std::vector<std::pair<std::string, std::string>> result;
+        for (auto const & kvp : index_->make_range (*db_)) {
+            result.emplace_back (kvp.first, kvp.second);
+        }
+        std::sort (std::begin (result), std::end (result));
+        return result;
+    }
+
+} // end anonymous namespace
+
+TEST_F (InsertRange, Empty) {
+    transaction_type t1 = pstore::begin (*db_, lock_guard{mutex_});
+    std::vector<std::pair<std::string, std::string>> const values;
+    EXPECT_EQ (index_->insert_range (t1, std::begin (values), std::end (values)), 0U);
+    EXPECT_TRUE (index_->empty ());
+}
+
+TEST_F (InsertRange, IntoEmptyIndex) {
+    transaction_type t1 = pstore::begin (*db_, lock_guard{mutex_});
+    std::vector<std::pair<std::string, std::string>> const values{
+        {"f", "f1"}, {"d", "d1"}, {"a", "a1"}, {"c", "c1"}, {"b", "b1"}, {"e", "e1"}};
+    EXPECT_EQ (index_->insert_range (t1, std::begin (values), std::end (values)), 6U);
+    EXPECT_EQ (index_->size (), 6U);
+
+    auto expected = values;
+    std::sort (std::begin (expected), std::end (expected));
+    EXPECT_EQ (this->contents (), expected);
+    for (auto const & kvp : values) {
+        EXPECT_TRUE (this->is_found (*index_, kvp.first)) << "key: " << kvp.first;
+    }
+}
+
+TEST_F (InsertRange, DuplicateKeys) {
+    transaction_type t1 = pstore::begin (*db_, lock_guard{mutex_});
+    std::vector<std::pair<std::string, std::string>> const values{
+        {"c", "c1"}, {"a", "a1"}, {"c", "c2"}, {"a", "a2"}, {"d", "d1"}};
+    EXPECT_EQ (index_->insert_range (t1, std::begin (values), std::end (values)), 3U);
+    EXPECT_EQ (index_->size (), 3U);
+    // As for insert(), the first of a duplicated key wins.
+    std::vector<std::pair<std::string, std::string>> const expected{
+        {"a", "a1"}, {"c", "c1"}, {"d", "d1"}};
+    EXPECT_EQ (this->contents (), expected);
+}
+
+TEST_F (InsertRange, UpsertDuplicateKeys) {
+    transaction_type t1 = pstore::begin (*db_, lock_guard{mutex_});
+    std::vector<std::pair<std::string, std::string>> const values{
+        {"c", "c1"}, {"a", "a1"}, {"c", "c2"}, {"a", "a2"}, {"d", "d1"}};
+    EXPECT_EQ (index_->insert_or_assign_range (t1, std::begin (values), std::end (values)), 3U);
+    EXPECT_EQ (index_->size (), 3U);
+    // As for insert_or_assign(), the last of a duplicated key wins.
+    std::vector<std::pair<std::string, std::string>> const expected{
+        {"a", "a2"}, {"c", "c2"}, {"d", "d1"}};
+    EXPECT_EQ (this->contents (), expected);
+}
+
+TEST_F (InsertRange, IntoStoreIndex) {
+    {
+        transaction_type t1 = pstore::begin (*db_, lock_guard{mutex_});
+        this->insert_or_assign (*index_, t1, "a", "a1");
+        this->insert_or_assign (*index_, t1, "c", "c1");
+        this->insert_or_assign (*index_, t1, "e", "e1");
+        index_->flush (t1, db_->get_current_revision () + 1U);
+        t1.commit ();
+    }
+    this->check_is_store_internal_node (index_->root ());
+
+    transaction_type t2 = pstore::begin (*db_, lock_guard{mutex_});
+    std::vector<std::pair<std::string, std::string>> const values{
+        {"b", "b2"}, {"c", "c2"}, {"d", "d2"}, {"f", "f2"}};
+    EXPECT_EQ (index_->insert_or_assign_range (t2, std::begin (values), std::end (values)), 3U);
+    EXPECT_EQ (index_->size (), 6U);
+    this->check_is_heap_internal_node (index_->root ());
+
+    std::vector<std::pair<std::string, std::string>> const expected{
+        {"a", "a1"}, {"b", "b2"}, {"c", "c2"}, {"d", "d2"}, {"e", "e1"}, {"f", "f2"}};
+    EXPECT_EQ (this->contents (), expected);
+}
+
+TEST_F (InsertRange, ExistingKeysDoNotModifyStoreIndex) {
+    {
+        transaction_type t1 = pstore::begin (*db_, lock_guard{mutex_});
+        this->insert_or_assign (*index_, t1, "a", "a1");
+        this->insert_or_assign (*index_, t1, "b", "b1");
+        index_->flush (t1, db_->get_current_revision () + 1U);
+        t1.commit ();
+    }
+    index_pointer const root = index_->root ();
+    this->check_is_store_internal_node (root);
+
+    transaction_type t2 = pstore::begin (*db_, lock_guard{mutex_});
+    std::vector<std::pair<std::string, std::string>> const values{{"b", "b2"}, {"a", "a2"}};
+    EXPECT_EQ (index_->insert_range (t2, std::begin (values), std::end (values)), 0U);
+    EXPECT_EQ (index_->root (), root);
+}
+
 // *******************************************
 // *                                         *
 // *              InvalidIndex               *
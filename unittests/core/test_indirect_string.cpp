@@ -43,6 +43,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "pstore/core/indirect_string.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "pstore/core/hamt_set.hpp"
@@ -142,6 +148,60 @@ TEST_F (IndirectString, StoreRoundTrip) {
                pstore::make_sstring_view (str));
 }
 
+TEST_F (IndirectString, HashedStoreRoundTrip) {
+    constexpr auto str = "string";
+    auto const sstring = pstore::make_sstring_view (str);
+    auto const hash = pstore::fnv_64a_hash () (sstring);
+
+    auto const pointer_addr = [this, &sstring, hash]() -> pstore::address {
+        mock_mutex mutex;
+        auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+
+        // The hash is written immediately after the string address.
+        auto const indirect_addr =
+            pstore::serialize::write (pstore::serialize::archive::make_writer (transaction),
+                                      pstore::indirect_string{db_, &sstring, hash});
+        EXPECT_EQ (transaction.size (), sizeof (pstore::address) + sizeof (std::uint64_t));
+
+        pstore::indirect_string::write_body_and_patch_address (
+            transaction, sstring, pstore::typed_address<pstore::address> (indirect_addr));
+        transaction.commit ();
+        return indirect_addr;
+    }();
+
+    auto const ind2 = pstore::indirect_string::read (
+        db_, pstore::typed_address<pstore::indirect_string> (pointer_addr));
+    EXPECT_TRUE (ind2.is_in_store ());
+    ASSERT_TRUE (ind2.cached_hash ().has_value ());
+    EXPECT_EQ (ind2.cached_hash ().value (), hash);
+
+    pstore::shared_sstring_view owner;
+    EXPECT_EQ (ind2.as_db_string_view (&owner), sstring);
+}
+
+TEST_F (IndirectString, CachedHashAvoidsBody) {
+    auto const sstring = pstore::make_sstring_view ("string");
+    mock_mutex mutex;
+    auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+
+    // Write a record whose hash deliberately doesn't match its string. The hash function and the
+    // inequality test must both use the stored value rather than loading the body.
+    auto const indirect_addr = pstore::serialize::write (
+        pstore::serialize::archive::make_writer (transaction),
+        pstore::indirect_string{db_, &sstring, UINT64_C (0x0123456789ABCDEF)});
+    pstore::indirect_string::write_body_and_patch_address (
+        transaction, sstring, pstore::typed_address<pstore::address> (indirect_addr));
+
+    auto const stored = pstore::indirect_string::read (
+        db_, pstore::typed_address<pstore::indirect_string> (indirect_addr));
+    EXPECT_EQ (pstore::index::fnv_64a_hash_indirect_string () (stored),
+               UINT64_C (0x0123456789ABCDEF));
+    EXPECT_NE (stored, (pstore::indirect_string{db_, &sstring, pstore::fnv_64a_hash () (sstring)}));
+    // Without a hash on both sides, the string bodies are compared.
+    EXPECT_EQ (stored, (pstore::indirect_string{db_, &sstring}));
+    transaction.commit ();
+}
+
 namespace {
 
     // Construct the string and the indirect string. Write the indirect pointer to the store.
@@ -257,3 +317,198 @@ TEST_F (IndirectStringAdder, NewString) {
         EXPECT_EQ (pos->as_string_view (&owner), pstore::make_sstring_view (str));
     }
 }
+
+TEST_F (IndirectStringAdder, AddRange) {
+    std::array<pstore::raw_sstring_view, 5> const strings{
+        {pstore::make_sstring_view ("b"), pstore::make_sstring_view ("a"),
+         pstore::make_sstring_view ("b"), pstore::make_sstring_view ("c"),
+         pstore::make_sstring_view ("a")}};
+    std::vector<pstore::typed_address<pstore::indirect_string>> addresses;
+    {
+        mock_mutex mutex;
+        auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+        auto const name_index = pstore::index::get_index<pstore::trailer::indices::name> (db_);
+
+        pstore::indirect_string_adder adder;
+        adder.add_range (transaction, name_index, std::begin (strings), std::end (strings),
+                         std::back_inserter (addresses));
+        // Duplicates are removed before the index is touched: one record per distinct string.
+        EXPECT_EQ (name_index->size (), 3U);
+        EXPECT_EQ (transaction.size (), 3U * sizeof (pstore::address));
+        adder.flush (transaction);
+        transaction.commit ();
+    }
+
+    ASSERT_EQ (addresses.size (), strings.size ());
+    EXPECT_EQ (addresses[0], addresses[2]);
+    EXPECT_EQ (addresses[1], addresses[4]);
+    EXPECT_NE (addresses[0], addresses[1]);
+    EXPECT_NE (addresses[0], addresses[3]);
+    for (auto ctr = std::size_t{0}; ctr < strings.size (); ++ctr) {
+        EXPECT_EQ (pstore::indirect_string::read (db_, addresses[ctr]).to_string (),
+                   strings[ctr].to_string ());
+    }
+}
+
+TEST_F (IndirectStringAdder, AddRangeFindsExistingStrings) {
+    auto const existing = pstore::make_sstring_view ("existing");
+    pstore::address existing_addr;
+    {
+        mock_mutex mutex;
+        auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+        auto const name_index = pstore::index::get_index<pstore::trailer::indices::name> (db_);
+        pstore::indirect_string_adder adder;
+        existing_addr = adder.add (transaction, name_index, &existing).first.get_address ();
+        adder.flush (transaction);
+        transaction.commit ();
+    }
+
+    std::array<pstore::raw_sstring_view, 2> const strings{
+        {pstore::make_sstring_view ("new"), pstore::make_sstring_view ("existing")}};
+    std::vector<pstore::typed_address<pstore::indirect_string>> addresses;
+    {
+        mock_mutex mutex;
+        auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+        auto const name_index = pstore::index::get_index<pstore::trailer::indices::name> (db_);
+        pstore::indirect_string_adder adder;
+        adder.add_range (transaction, name_index, std::begin (strings), std::end (strings),
+                         std::back_inserter (addresses));
+        EXPECT_EQ (name_index->size (), 2U);
+        adder.flush (transaction);
+        transaction.commit ();
+    }
+    ASSERT_EQ (addresses.size (), 2U);
+    EXPECT_EQ (addresses[1].to_address (), existing_addr);
+    EXPECT_EQ (pstore::indirect_string::read (db_, addresses[0]).to_string (), "new");
+}
+
+TEST_F (IndirectStringAdder, FlushWritesContiguousBodies) {
+    std::array<pstore::raw_sstring_view, 3> const strings{
+        {pstore::make_sstring_view ("one"), pstore::make_sstring_view ("two"),
+         pstore::make_sstring_view ("six")}};
+    std::vector<pstore::typed_address<pstore::indirect_string>> addresses;
+    mock_mutex mutex;
+    auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+    auto const name_index = pstore::index::get_index<pstore::trailer::indices::name> (db_);
+    pstore::indirect_string_adder adder;
+    adder.add_range (transaction, name_index, std::begin (strings), std::end (strings),
+                     std::back_inserter (addresses));
+    auto const records_end = transaction.size ();
+    adder.flush (transaction);
+
+    // Each body is a two byte length followed by three characters, padded to an even address.
+    std::vector<std::uint64_t> bodies;
+    for (auto const & addr : addresses) {
+        auto const body =
+            *db_.getro (pstore::typed_address<pstore::address>::make (addr.to_address ()));
+        EXPECT_EQ (body.absolute () % 2U, 0U);
+        bodies.push_back (body.absolute ());
+    }
+    std::sort (std::begin (bodies), std::end (bodies));
+    EXPECT_EQ (bodies[1] - bodies[0], 6U);
+    EXPECT_EQ (bodies[2] - bodies[1], 6U);
+    EXPECT_LE (transaction.size () - records_end, 6U + 6U + 5U + 1U);
+    transaction.commit ();
+}
+
+
+TEST_F (IndirectStringAdder, StoreHashes) {
+    std::array<pstore::raw_sstring_view, 3> const strings{
+        {pstore::make_sstring_view ("one"), pstore::make_sstring_view ("two"),
+         pstore::make_sstring_view ("one")}};
+    auto const three = pstore::make_sstring_view ("three");
+    std::vector<pstore::typed_address<pstore::indirect_string>> addresses;
+    {
+        mock_mutex mutex;
+        auto transaction = begin (db_, std::unique_lock<mock_mutex>{mutex});
+        auto const name_index = pstore::index::get_index<pstore::trailer::indices::name> (db_);
+        pstore::indirect_string_adder adder{strings.size () + 1U, true};
+        adder.add_range (transaction, name_index, std::begin (strings), std::end (strings),
+                         std::back_inserter (addresses));
+        addresses.push_back (pstore::typed_address<pstore::indirect_string>::make (
+            adder.add (transaction, name_index, &three).first.get_address ()));
+        adder.flush (transaction);
+        transaction.commit ();
+    }
+
+    auto const check = [this] (pstore::typed_address<pstore::indirect_string> const addr,
+                               pstore::raw_sstring_view const & expected) {
+        auto const str = pstore::indirect_string::read (db_, addr);
+        ASSERT_TRUE (str.cached_hash ().has_value ());
+        EXPECT_EQ (str.cached_hash ().value (), pstore::fnv_64a_hash () (expected));
+        EXPECT_EQ (str.to_string (), expected.to_string ());
+    };
+    ASSERT_EQ (addresses.size (), 4U);
+    check (addresses[0], strings[0]);
+    check (addresses[1], strings[1]);
+    check (addresses[3], three);
+    EXPECT_EQ (addresses[0], addresses[2]);
+
+    // Strings written with hashes are found by a search which doesn't supply one.
+    auto const name_index = pstore::index::get_index<pstore::trailer::indices::name> (db_);
+    EXPECT_NE (name_index->find (db_, pstore::indirect_string{db_, &three}),
+               name_index->cend (db_));
+}
+
+namespace {
+
+    /// Adds \p strings to the name index of \p db with an adder asked to store their hashes and
+    /// commits the transaction. Returns the addresses of the indirect_string records.
+    template <std::size_t Size>
+    std::vector<pstore::typed_address<pstore::indirect_string>>
+    add_with_hashes (pstore::database & db,
+                     std::array<pstore::raw_sstring_view, Size> const & strings) {
+        std::vector<pstore::typed_address<pstore::indirect_string>> addresses;
+        mock_mutex mutex;
+        auto transaction = begin (db, std::unique_lock<mock_mutex>{mutex});
+        auto const name_index = pstore::index::get_index<pstore::trailer::indices::name> (db);
+        pstore::indirect_string_adder adder{strings.size (), true};
+        adder.add_range (transaction, name_index, std::begin (strings), std::end (strings),
+                         std::back_inserter (addresses));
+        adder.flush (transaction);
+        transaction.commit ();
+        return addresses;
+    }
+
+} // end anonymous namespace
+
+TEST_F (IndirectStringAdder, StoredHashesSurviveReopen) {
+    std::array<pstore::raw_sstring_view, 2> const strings{
+        {pstore::make_sstring_view ("alpha"), pstore::make_sstring_view ("beta")}};
+    add_with_hashes (db_, strings);
+
+    // Open the store afresh and find the strings through the committed name index.
+    pstore::database db2{this->file ()};
+    db2.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    auto const name_index = pstore::index::get_index<pstore::trailer::indices::name> (db2);
+    ASSERT_NE (name_index, nullptr);
+    for (pstore::raw_sstring_view const & expected : strings) {
+        auto const pos = name_index->find (db2, pstore::indirect_string{db2, &expected});
+        ASSERT_NE (pos, name_index->cend (db2));
+        auto const str = pstore::indirect_string::read (
+            db2, pstore::typed_address<pstore::indirect_string>::make (pos.get_address ()));
+        ASSERT_TRUE (str.cached_hash ().has_value ());
+        EXPECT_EQ (str.cached_hash ().value (), pstore::fnv_64a_hash () (expected));
+        EXPECT_EQ (str.to_string (), expected.to_string ());
+    }
+}
+
+TEST_F (IndirectStringAdder, HashesNotWrittenToAnOlderStore) {
+    auto * const h = reinterpret_cast<pstore::header *> (this->buffer ().get ());
+    h->a.version[1] = pstore::header::indirect_string_hash_version - 1U;
+    h->crc = h->get_crc ();
+    pstore::database db{this->file ()};
+    db.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+
+    std::array<pstore::raw_sstring_view, 1> const strings{{pstore::make_sstring_view ("alpha")}};
+    auto const addresses = add_with_hashes (db, strings);
+    ASSERT_EQ (addresses.size (), 1U);
+    auto const record =
+        *db.getro (pstore::typed_address<pstore::address>::make (addresses[0].to_address ()));
+    // The most significant bit of the record's address marks a record followed by a hash.
+    EXPECT_EQ (record.absolute () >> 63U, 0U);
+
+    auto const str = pstore::indirect_string::read (db, addresses[0]);
+    EXPECT_FALSE (str.cached_hash ().has_value ());
+    EXPECT_EQ (str.to_string (), "alpha");
+}
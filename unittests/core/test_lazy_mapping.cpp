@@ -0,0 +1,148 @@
+//*  _                                              _               *
+//* | | __ _ _____   _   _ __ ___   __ _ _ __  _ __ (_)_ __   __ _  *
+//* | |/ _` |_  / | | | | '_ ` _ \ / _` | '_ \| '_ \| | '_ \ / _` | *
+//* | | (_| |/ /| |_| | | | | | | | (_| | |_) | |_) | | | | | (_| | *
+//* |_|\__,_/___|\__, | |_| |_| |_|\__,_| .__/| .__/|_|_| |_|\__, | *
+//*             |___/                  |_|   |_|            |___/   *
+//===- unittests/core/test_lazy_mapping.cpp -------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/core/database.hpp"
+
+// Standard includes
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+// pstore includes
+#include "pstore/core/transaction.hpp"
+
+// Local test includes
+#include "empty_store.hpp"
+#include "mock_mutex.hpp"
+
+namespace {
+
+    class LazyMapping : public EmptyStore {
+    public:
+        LazyMapping ()
+                : db_{this->file (), std::make_unique<pstore::system_page_size> (),
+                      make_factory (this->file ())} {
+            db_.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+        }
+
+    protected:
+        pstore::database db_;
+
+        static std::unique_ptr<pstore::region::factory>
+        make_factory (std::shared_ptr<pstore::file::in_memory> const & file) {
+            // Use the smallest possible regions so that the store is made up of more than one.
+            auto factory = pstore::region::get_factory (file, pstore::address::segment_size,
+                                                        pstore::address::segment_size);
+            factory->set_deferred (true);
+            return factory;
+        }
+
+        bool is_mapped (std::size_t const index) const {
+            return db_.storage ().regions ().at (index)->is_mapped ();
+        }
+    };
+
+} // end anonymous namespace
+
+TEST_F (LazyMapping, IsLazy) {
+    EXPECT_TRUE (db_.storage ().is_lazy ());
+    ASSERT_EQ (1U, db_.storage ().regions ().size ());
+    // The first region holds the file header so it is mapped when the store is opened.
+    EXPECT_TRUE (this->is_mapped (0));
+}
+
+TEST_F (LazyMapping, RegionIsMappedOnFirstAccess) {
+    char const value[] = "lazy";
+    auto const addr = pstore::typed_address<char>::make (pstore::address::segment_size);
+    {
+        mock_mutex mutex;
+        auto transaction = pstore::begin (db_, std::unique_lock<mock_mutex>{mutex});
+        // Allocate space which extends into the second region.
+        pstore::address const first = transaction.allocate (
+            pstore::address::segment_size - transaction.db ().size () + sizeof (value), 1U);
+        EXPECT_LE (first, addr.to_address ());
+        EXPECT_FALSE (this->is_mapped (1));
+
+        std::shared_ptr<char> const ptr = transaction.getrw (addr, sizeof (value));
+        EXPECT_TRUE (this->is_mapped (1));
+        std::memcpy (ptr.get (), value, sizeof (value));
+        transaction.commit ();
+    }
+    std::shared_ptr<char const> const ptr = db_.getro (addr, sizeof (value));
+    EXPECT_STREQ (value, ptr.get ());
+}
+
+TEST_F (LazyMapping, ConcurrentFirstAccess) {
+    // Build a storage instance directly so that none of its regions is touched before the test
+    // threads run.
+    pstore::storage storage{this->file (), std::make_unique<pstore::system_page_size> (),
+                            make_factory (this->file ())};
+    storage.update_master_pointers (0);
+    storage.map_bytes (2U * pstore::address::segment_size);
+    ASSERT_EQ (2U, storage.regions ().size ());
+    ASSERT_FALSE (storage.regions ().at (1)->is_mapped ());
+
+    auto const addr = pstore::address{pstore::address::segment_size};
+    std::vector<std::thread> threads;
+    std::vector<void const *> results (4U, nullptr);
+    for (void const *& r : results) {
+        threads.emplace_back ([&storage, &r, addr] () {
+            storage.ensure_mapped (addr, 1U);
+            r = storage.address_to_raw_pointer (addr);
+        });
+    }
+    for (auto & t : threads) {
+        t.join ();
+    }
+
+    EXPECT_TRUE (storage.regions ().at (1)->is_mapped ());
+    EXPECT_FALSE (storage.regions ().at (0)->is_mapped ());
+    auto const * const expected =
+        static_cast<std::uint8_t const *> (this->file ()->data ().get ()) + addr.absolute ();
+    for (void const * const r : results) {
+        EXPECT_EQ (expected, r);
+    }
+}
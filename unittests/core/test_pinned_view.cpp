@@ -0,0 +1,256 @@
+//*        _                      _         _                *
+//*  _ __ (_)_ __  _ __   ___  __| | __   _(_) _____      __ *
+//* | '_ \| | '_ \| '_ \ / _ \/ _` | \ \ / / |/ _ \ \ /\ / / *
+//* | |_) | | | | | | | |  __/ (_| |  \ V /| |  __/\ V  V /  *
+//* | .__/|_|_| |_|_| |_|\___|\__,_|   \_/ |_|\___| \_/\_/   *
+//* |_|                                                      *
+//===- unittests/core/test_pinned_view.cpp --------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file test_pinned_view.cpp
+
+#include "pstore/core/pinned_view.hpp"
+
+// Standard includes
+#include <cstring>
+#include <string>
+
+// 3rd party includes
+#include <gtest/gtest.h>
+
+// pstore includes
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/transaction.hpp"
+
+// Local test includes
+#include "check_for_error.hpp"
+#include "empty_store.hpp"
+#include "mock_mutex.hpp"
+
+namespace {
+
+    class PinnedView : public EmptyStore {
+    public:
+        PinnedView ()
+                : db_{new pstore::database (this->file ())} {
+            db_->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+        }
+
+    protected:
+        using index_type = pstore::index::hamt_map<std::string, std::string>;
+
+        // Writes a string to the store and commits the transaction. Returns the extent of the
+        // string data.
+        pstore::extent<char> store_string (std::string const & str);
+
+        mock_mutex mutex_;
+        std::unique_ptr<pstore::database> db_;
+    };
+
+    pstore::extent<char> PinnedView::store_string (std::string const & str) {
+        auto t = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+        std::shared_ptr<char> ptr;
+        pstore::typed_address<char> addr;
+        std::tie (ptr, addr) = t.alloc_rw<char> (str.length ());
+        std::memcpy (ptr.get (), str.data (), str.length ());
+        t.commit ();
+        return {addr, str.length ()};
+    }
+
+} // end anonymous namespace
+
+TEST_F (PinnedView, Revision) {
+    pstore::pinned_view view{*db_};
+    EXPECT_EQ (&view.db (), db_.get ());
+    EXPECT_EQ (view.revision (), db_->get_current_revision ());
+}
+
+TEST_F (PinnedView, GetroMatchesDatabase) {
+    std::string const str = "hello world";
+    pstore::extent<char> const ex = this->store_string (str);
+
+    pstore::pinned_view view{*db_};
+    char const * const ptr = view.getro (ex);
+    EXPECT_EQ (ptr, db_->getro (ex).get ());
+    EXPECT_EQ (std::string (ptr, ex.size), str);
+}
+
+TEST_F (PinnedView, LaterCommitIsNotVisible) {
+    std::string const str1 = "hello";
+    pstore::extent<char> const ex1 = this->store_string (str1);
+    pstore::pinned_view view{*db_};
+    EXPECT_EQ (view.limit (), (db_->footer_pos () + 1U).to_address ());
+
+    // Data committed after the view was created lies beyond the pinned revision.
+    pstore::extent<char> const ex2 = this->store_string ("world");
+    ASSERT_GE (ex2.addr.to_address (), view.limit ());
+    check_for_error ([&view, &ex2]() { view.getro (ex2); }, pstore::error_code::bad_address);
+
+    // Data belonging to the pinned revision is still accessible.
+    char const * const ptr = view.getro (ex1);
+    EXPECT_EQ (std::string (ptr, ex1.size), str1);
+    EXPECT_EQ (view.num_copies (), 0U);
+}
+
+TEST_F (PinnedView, SpanningCopiesOutliveLaterReads) {
+    // Write a string which straddles the boundary between the first two regions.
+    constexpr auto region_size = pstore::storage::min_region_size;
+    std::string str;
+    for (auto ctr = 0U; str.length () < region_size + 4096U; ++ctr) {
+        str += std::to_string (ctr) + ' ';
+    }
+    pstore::extent<char> ex;
+    {
+        auto t = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+        {
+            // The writable pointer is released before the commit so that a copy spanning the
+            // regions is written back to the store.
+            std::shared_ptr<char> ptr;
+            pstore::typed_address<char> addr;
+            std::tie (ptr, addr) = t.alloc_rw<char> (str.length ());
+            std::memcpy (ptr.get (), str.data (), str.length ());
+            ex = {addr, str.length ()};
+        }
+        t.commit ();
+    }
+    auto const boundary = pstore::address{region_size};
+    ASSERT_LT (ex.addr.to_address (), boundary - 512U);
+
+    pstore::pinned_view view{*db_};
+    auto const offset = [&ex](pstore::address const a) {
+        return static_cast<std::size_t> (a.absolute () - ex.addr.to_address ().absolute ());
+    };
+
+    // Hold a pointer to the first spanning block while many more are read.
+    constexpr auto size = std::size_t{16};
+    auto const first_addr = boundary - 8U;
+    ASSERT_TRUE (db_->storage ().request_spans_regions (first_addr, size));
+    auto const * const first = static_cast<char const *> (view.getro (first_addr, size));
+    for (auto ctr = 1U; ctr <= 256U; ++ctr) {
+        auto const a = boundary - (8U + ctr);
+        auto const * const ptr = static_cast<char const *> (view.getro (a, size + ctr));
+        EXPECT_EQ (std::string (ptr, size + ctr), str.substr (offset (a), size + ctr));
+    }
+    EXPECT_EQ (view.num_copies (), 257U);
+    EXPECT_EQ (std::string (first, size), str.substr (offset (first_addr), size));
+
+    // A repeated request shares the existing copy.
+    EXPECT_EQ (view.getro (first_addr, size), first);
+    EXPECT_EQ (view.num_copies (), 257U);
+
+    view.release ();
+    EXPECT_EQ (view.num_copies (), 0U);
+}
+
+TEST_F (PinnedView, GetEndPastLogicalEOF) {
+    pstore::pinned_view view{*db_};
+    auto const addr = pstore::address::null ();
+    std::size_t const size = db_->size () + 1;
+    check_for_error ([&view, addr, size]() { view.getro (addr, size); },
+                     pstore::error_code::bad_address);
+}
+
+TEST_F (PinnedView, GetStartPastLogicalEOF) {
+    pstore::pinned_view view{*db_};
+    auto const addr = pstore::address{db_->size () + 1};
+    constexpr std::size_t size = 1;
+    check_for_error ([&view, addr, size]() { view.getro (addr, size); },
+                     pstore::error_code::bad_address);
+}
+
+TEST_F (PinnedView, BadAlignment) {
+    pstore::pinned_view view{*db_};
+    auto const addr = pstore::typed_address<std::uint32_t>::make (pstore::address{1});
+    check_for_error ([&view, addr]() { view.getro (addr); }, pstore::error_code::bad_alignment);
+}
+
+TEST_F (PinnedView, IndexFind) {
+    constexpr auto num_keys = 1024U;
+    pstore::typed_address<pstore::index::header_block> addr;
+    {
+        index_type index{*db_, pstore::typed_address<pstore::index::header_block>::null ()};
+        auto t = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+        for (auto ctr = 0U; ctr < num_keys; ++ctr) {
+            auto const key = std::to_string (ctr);
+            index.insert (t, index_type::value_type{key, "value " + key});
+        }
+        addr = index.flush (t, db_->get_current_revision ());
+        t.commit ();
+    }
+
+    index_type const index{*db_, addr};
+    pstore::pinned_view view{*db_};
+    for (auto ctr = 0U; ctr < num_keys; ++ctr) {
+        auto const key = std::to_string (ctr);
+        auto const it = index.find (view, key);
+        ASSERT_NE (it, index.cend (*db_)) << "Key " << key << " was not found";
+        EXPECT_EQ (it.get_address (), index.find (*db_, key).get_address ());
+        EXPECT_EQ (index.load_leaf_node (view, it.get_address ()),
+                   (index_type::value_type{key, "value " + key}));
+    }
+    EXPECT_EQ (index.find (view, std::string{"missing"}), index.cend (*db_));
+}
+
+namespace {
+
+    class CollidingHash {
+    public:
+        std::uint64_t operator() (std::string const &) const noexcept { return 0; }
+    };
+
+} // end anonymous namespace
+
+TEST_F (PinnedView, IndexFindLinearNode) {
+    using colliding_index = pstore::index::hamt_map<std::string, int, CollidingHash>;
+    pstore::typed_address<pstore::index::header_block> addr;
+    {
+        colliding_index index{*db_, pstore::typed_address<pstore::index::header_block>::null ()};
+        auto t = pstore::begin (*db_, std::unique_lock<mock_mutex>{mutex_});
+        index.insert (t, colliding_index::value_type{"a", 1});
+        index.insert (t, colliding_index::value_type{"b", 2});
+        index.insert (t, colliding_index::value_type{"c", 3});
+        addr = index.flush (t, db_->get_current_revision ());
+        t.commit ();
+    }
+
+    colliding_index const index{*db_, addr};
+    pstore::pinned_view view{*db_};
+    auto const it = index.find (view, std::string{"b"});
+    ASSERT_NE (it, index.cend (*db_));
+    EXPECT_EQ (index.load_leaf_node (view, it.get_address ()).second, 2);
+    EXPECT_EQ (index.find (view, std::string{"d"}), index.cend (*db_));
+}
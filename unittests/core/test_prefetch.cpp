@@ -0,0 +1,201 @@
+//*                  __      _       _      *
+//*  _ __  _ __ ___ / _| ___| |_ ___| |__   *
+//* | '_ \| '__/ _ \ |_ / _ \ __/ __| '_ \  *
+//* | |_) | | |  __/  _|  __/ || (__| | | | *
+//* | .__/|_|  \___|_|  \___|\__\___|_| |_| *
+//* |_|                                     *
+//===- unittests/core/test_prefetch.cpp -----------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/core/database.hpp"
+
+// Standard includes
+#include <vector>
+
+// 3rd party includes
+#include "gmock/gmock.h"
+
+// pstore includes
+#include "pstore/core/transaction.hpp"
+#include "pstore/os/memory_mapper.hpp"
+
+// Local private includes
+#include "check_for_error.hpp"
+#include "empty_store.hpp"
+#include "mock_mutex.hpp"
+
+namespace {
+
+    /// A memory mapper which records the advice that it is given rather than passing it to the
+    /// OS.
+    class recording_mapper : public pstore::in_memory_mapper {
+    public:
+        recording_mapper (pstore::file::in_memory & file, bool write_enabled, std::uint64_t offset,
+                          std::uint64_t length)
+                : pstore::in_memory_mapper (file, write_enabled, offset, length) {}
+
+        struct advice {
+            void * addr;
+            std::size_t len;
+            pstore::access_pattern pattern;
+        };
+
+        void advise (void * const addr, std::size_t const len,
+                     pstore::access_pattern const pattern) override {
+            advice_.push_back ({addr, len, pattern});
+        }
+
+        std::vector<advice> const & get_advice () const noexcept { return advice_; }
+
+    private:
+        std::vector<advice> advice_;
+    };
+
+    class recording_region_factory final : public pstore::region::factory {
+    public:
+        recording_region_factory (std::shared_ptr<pstore::file::in_memory> file,
+                                  std::uint64_t const full_size, std::uint64_t const min_size)
+                : pstore::region::factory (full_size, min_size)
+                , file_ (std::move (file)) {}
+
+        auto init () -> std::vector<pstore::region::memory_mapper_ptr> override {
+            return this->create<pstore::file::in_memory, recording_mapper> (file_);
+        }
+
+        void add (pstore::gsl::not_null<std::vector<pstore::region::memory_mapper_ptr> *> regions,
+                  std::uint64_t original_size, std::uint64_t new_size) override {
+            this->append<pstore::file::in_memory, recording_mapper> (file_, regions, original_size,
+                                                                     new_size);
+        }
+
+        std::shared_ptr<pstore::file::file_base> file () override { return file_; }
+
+    private:
+        std::shared_ptr<pstore::file::in_memory> file_;
+    };
+
+    class Prefetch : public EmptyStore {
+    public:
+        Prefetch ()
+                : db_{this->file (), std::make_unique<pstore::system_page_size> (),
+                      std::make_unique<recording_region_factory> (
+                          this->file (), pstore::address::segment_size,
+                          pstore::address::segment_size)} {
+            db_.set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+        }
+
+    protected:
+        pstore::database db_;
+
+        std::shared_ptr<recording_mapper> region (std::size_t const index) const {
+            return std::static_pointer_cast<recording_mapper> (
+                db_.storage ().regions ().at (index));
+        }
+        std::uint8_t * file_base () const {
+            return reinterpret_cast<std::uint8_t *> (this->file ()->data ().get ());
+        }
+
+        /// Commits a transaction which extends the store into a second region.
+        void grow () {
+            mock_mutex mutex;
+            auto transaction = pstore::begin (db_, std::unique_lock<mock_mutex>{mutex});
+            transaction.allocate (pstore::address::segment_size, 1 /*align*/);
+            transaction.commit ();
+        }
+    };
+
+} // end anonymous namespace
+
+TEST_F (Prefetch, WithinOneRegion) {
+    db_.prefetch (pstore::address{pstore::leader_size}, 16U);
+
+    auto const & advice = this->region (0)->get_advice ();
+    ASSERT_EQ (1U, advice.size ());
+    EXPECT_EQ (this->file_base () + pstore::leader_size, advice[0].addr);
+    EXPECT_EQ (16U, advice[0].len);
+    EXPECT_EQ (pstore::access_pattern::willneed, advice[0].pattern);
+}
+
+TEST_F (Prefetch, Extent) {
+    auto const addr = pstore::typed_address<std::uint64_t>::make (pstore::leader_size);
+    db_.prefetch (pstore::extent<std::uint64_t>{addr, 8U});
+
+    auto const & advice = this->region (0)->get_advice ();
+    ASSERT_EQ (1U, advice.size ());
+    EXPECT_EQ (8U, advice[0].len);
+}
+
+TEST_F (Prefetch, SpanningTwoRegions) {
+    this->grow ();
+    ASSERT_EQ (2U, db_.storage ().regions ().size ());
+
+    auto const first = pstore::address{pstore::address::segment_size - 16U};
+    db_.prefetch (first, 32U);
+
+    auto const & advice0 = this->region (0)->get_advice ();
+    ASSERT_EQ (1U, advice0.size ());
+    EXPECT_EQ (this->file_base () + first.absolute (), advice0[0].addr);
+    EXPECT_EQ (16U, advice0[0].len);
+
+    auto const & advice1 = this->region (1)->get_advice ();
+    ASSERT_EQ (1U, advice1.size ());
+    EXPECT_EQ (this->file_base () + pstore::address::segment_size, advice1[0].addr);
+    EXPECT_EQ (16U, advice1[0].len);
+}
+
+TEST_F (Prefetch, BeyondLogicalEnd) {
+    check_for_error ([this] () { db_.prefetch (pstore::address{db_.size ()}, 1U); },
+                     pstore::error_code::bad_address);
+}
+
+TEST_F (Prefetch, AccessPatternAppliesToNewRegions) {
+    db_.set_access_pattern (pstore::access_pattern::random);
+    EXPECT_EQ (pstore::access_pattern::random, db_.get_access_pattern ());
+    {
+        auto const & advice = this->region (0)->get_advice ();
+        ASSERT_EQ (1U, advice.size ());
+        EXPECT_EQ (this->region (0)->data ().get (), advice[0].addr);
+        EXPECT_EQ (this->region (0)->size (), advice[0].len);
+        EXPECT_EQ (pstore::access_pattern::random, advice[0].pattern);
+    }
+
+    this->grow ();
+    ASSERT_EQ (2U, db_.storage ().regions ().size ());
+    auto const & advice = this->region (1)->get_advice ();
+    ASSERT_EQ (1U, advice.size ());
+    EXPECT_EQ (pstore::access_pattern::random, advice[0].pattern);
+}
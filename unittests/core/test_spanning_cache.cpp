@@ -0,0 +1,129 @@
+//*                              _                              _           *
+//*  ___ _ __   __ _ _ __  _ __ (_)_ __   __ _    ___ __ _  ___| |__   ___  *
+//* / __| '_ \ / _` | '_ \| '_ \| | '_ \ / _` |  / __/ _` |/ __| '_ \ / _ \ *
+//* \__ \ |_) | (_| | | | | | | | | | | | (_| | | (_| (_| | (__| | | |  __/ *
+//* |___/ .__/ \__,_|_| |_|_| |_|_|_| |_|\__, |  \___\__,_|\___|_| |_|\___| *
+//*     |_|                              |___/                              *
+//===- unittests/core/test_spanning_cache.cpp -----------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+/// \file test_spanning_cache.cpp
+
+#include "pstore/core/spanning_cache.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+    std::shared_ptr<void const> make_block (std::size_t const size) {
+        return std::shared_ptr<std::uint8_t const> (new std::uint8_t[size],
+                                                    [](std::uint8_t const * p) { delete[] p; });
+    }
+
+} // end anonymous namespace
+
+TEST (SpanningCache, InitialState) {
+    pstore::spanning_cache cache;
+    EXPECT_EQ (cache.capacity (), pstore::spanning_cache::default_capacity);
+    EXPECT_EQ (cache.size_bytes (), 0U);
+    pstore::spanning_cache::statistics const stats = cache.stats ();
+    EXPECT_EQ (stats.hits, 0U);
+    EXPECT_EQ (stats.misses, 0U);
+}
+
+TEST (SpanningCache, MissThenHit) {
+    pstore::spanning_cache cache;
+    auto const addr = pstore::address{4096};
+    EXPECT_EQ (cache.find (addr, 32), nullptr);
+
+    auto const block = make_block (32);
+    cache.insert (addr, 32, block);
+    EXPECT_EQ (cache.size_bytes (), 32U);
+    EXPECT_EQ (cache.find (addr, 32), block);
+    // The size is part of the key.
+    EXPECT_EQ (cache.find (addr, 16), nullptr);
+
+    pstore::spanning_cache::statistics const stats = cache.stats ();
+    EXPECT_EQ (stats.hits, 1U);
+    EXPECT_EQ (stats.misses, 2U);
+}
+
+TEST (SpanningCache, InsertExistingKeyKeepsOriginal) {
+    pstore::spanning_cache cache;
+    auto const addr = pstore::address{4096};
+    auto const block1 = make_block (32);
+    auto const block2 = make_block (32);
+    cache.insert (addr, 32, block1);
+    cache.insert (addr, 32, block2);
+    EXPECT_EQ (cache.size_bytes (), 32U);
+    EXPECT_EQ (cache.find (addr, 32), block1);
+}
+
+TEST (SpanningCache, OversizeBlockIsNotCached) {
+    constexpr auto capacity = pstore::spanning_cache::num_shards * 64U;
+    pstore::spanning_cache cache{capacity};
+    auto const addr = pstore::address{4096};
+    cache.insert (addr, 65, make_block (65));
+    EXPECT_EQ (cache.size_bytes (), 0U);
+    EXPECT_EQ (cache.find (addr, 65), nullptr);
+}
+
+TEST (SpanningCache, EvictsLeastRecentlyUsed) {
+    // A capacity which allows each shard to hold two 64 byte blocks.
+    constexpr auto capacity = pstore::spanning_cache::num_shards * 128U;
+    pstore::spanning_cache cache{capacity};
+
+    // Insert many more blocks than the cache can hold. Keep touching the first block so that it
+    // is always the most recently used member of its shard.
+    auto const first_addr = pstore::address{0};
+    auto const first_block = make_block (64);
+    cache.insert (first_addr, 64, first_block);
+    for (auto ctr = 1U; ctr < 256U; ++ctr) {
+        cache.insert (pstore::address{ctr * 64U}, 64, make_block (64));
+        EXPECT_EQ (cache.find (first_addr, 64), first_block);
+        EXPECT_LE (cache.size_bytes (), capacity);
+    }
+}
+
+TEST (SpanningCache, Clear) {
+    pstore::spanning_cache cache;
+    auto const addr = pstore::address{4096};
+    cache.insert (addr, 32, make_block (32));
+    cache.clear ();
+    EXPECT_EQ (cache.size_bytes (), 0U);
+    EXPECT_EQ (cache.find (addr, 32), nullptr);
+}
@@ -46,6 +46,9 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 
@@ -224,3 +227,47 @@ TEST_F (Diff, UncomittedTransaction) {
 
     t2.commit ();
 }
+
+TEST_F (Diff, ManyKeys) {
+    using value_type = pstore::index::write_index::value_type;
+    constexpr auto num_keys = 2000U;
+    // Enough keys that the index root is an internal node with many children, each of which is
+    // visited separately.
+    {
+        transaction_type t1 = pstore::begin (*db_, lock_guard{mutex_});
+        for (auto ctr = 0U; ctr < num_keys; ++ctr) {
+            this->add (t1, "old" + std::to_string (ctr), "value");
+        }
+        t1.commit ();
+    }
+    std::set<std::string> expected;
+    {
+        transaction_type t2 = pstore::begin (*db_, lock_guard{mutex_});
+        for (auto ctr = 0U; ctr < num_keys; ++ctr) {
+            std::string const key = "new" + std::to_string (ctr);
+            this->add (t2, key, "value");
+            expected.insert (key);
+        }
+        t2.commit ();
+    }
+
+    auto index = pstore::index::get_index<pstore::trailer::indices::write> (*db_);
+    ASSERT_NE (index, nullptr);
+    pstore::diff::result_type const actual = pstore::diff::diff (*db_, *index, 1U);
+    std::vector<value_type> const actual_values =
+        addresses_to_values (*db_, *index, std::begin (actual), std::end (actual));
+
+    // The results must be in index order: the same order as a sequential traversal.
+    std::vector<std::string> expected_order;
+    std::for_each (index->begin (*db_), index->end (*db_), [&] (value_type const & kvp) {
+        if (expected.find (kvp.first) != expected.end ()) {
+            expected_order.push_back (kvp.first);
+        }
+    });
+    std::vector<std::string> actual_keys;
+    std::transform (std::begin (actual_values), std::end (actual_values),
+                    std::back_inserter (actual_keys),
+                    [] (value_type const & kvp) { return kvp.first; });
+    EXPECT_EQ (expected_order.size (), expected.size ());
+    EXPECT_THAT (actual_keys, ::testing::ContainerEq (expected_order));
+}
@@ -100,3 +100,30 @@ TYPED_TEST (Array, TwoStrings) {
 
     EXPECT_EQ (expected, actual);
 }
+
+TYPED_TEST (Array, LazyEmpty) {
+    using namespace ::pstore::dump;
+    lazy_array arr ([] (lazy_array::sink const &) {});
+    arr.write (this->out);
+    auto const & actual = this->out.str ();
+    auto const & expected = convert<TypeParam> ("[ ]");
+    EXPECT_EQ (expected, actual);
+}
+
+TYPED_TEST (Array, LazyTwoStrings) {
+    using namespace ::pstore::dump;
+    auto calls = 0U;
+    lazy_array arr ([&calls] (lazy_array::sink const & sink) {
+        ++calls;
+        sink (make_value ("Hello"));
+        sink (make_value ("World"));
+    });
+    EXPECT_EQ (calls, 0U) << "Members should not be generated until the array is written";
+    arr.write (this->out);
+    EXPECT_EQ (calls, 1U);
+    auto const & actual = this->out.str ();
+    auto const & expected = convert<TypeParam> ("\n"
+                                                "- Hello\n"
+                                                "- World");
+    EXPECT_EQ (expected, actual);
+}
@@ -91,3 +91,10 @@ TEST (Headers, ExampleWSCaseInsensitive) {
     expected.connection_upgrade = true;
     EXPECT_EQ (hi, expected);
 }
+
+TEST (Headers, IfNoneMatch) {
+    header_info const hi = header_info ().handler ("if-none-match", "\"0123\", W/\"4567\"");
+    header_info expected;
+    expected.if_none_match = just ("\"0123\", W/\"4567\""s);
+    EXPECT_EQ (hi, expected);
+}
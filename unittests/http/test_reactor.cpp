@@ -0,0 +1,133 @@
+//*                      _              *
+//*  _ __ ___  __ _  ___| |_ ___  _ __  *
+//* | '__/ _ \/ _` |/ __| __/ _ \| '__| *
+//* | | |  __/ (_| | (__| || (_) | |    *
+//* |_|  \___|\__,_|\___|\__\___/|_|    *
+//*                                     *
+//===- unittests/http/test_reactor.cpp ------------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/http/reactor.hpp"
+
+#ifdef PSTORE_HAVE_SYS_EPOLL_H
+
+#    include <array>
+#    include <chrono>
+
+#    include <sys/socket.h>
+#    include <unistd.h>
+
+#    include <gtest/gtest.h>
+
+#    include "pstore/broker_intf/descriptor.hpp"
+
+using pstore::httpd::reactor;
+
+namespace {
+
+    class Reactor : public ::testing::Test {
+    protected:
+        Reactor ();
+
+        void send_byte ();
+        std::size_t wait ();
+
+        static constexpr std::uint64_t token = 42U;
+        reactor reactor_;
+        pstore::broker::socket_descriptor left_;
+        pstore::broker::socket_descriptor right_;
+        std::array<reactor::event, 4> events_;
+    };
+
+    constexpr std::uint64_t Reactor::token;
+
+    Reactor::Reactor () {
+        std::array<int, 2> fds{{-1, -1}};
+        EXPECT_EQ (::socketpair (AF_UNIX, SOCK_STREAM, 0, fds.data ()), 0);
+        left_.reset (fds[0]);
+        right_.reset (fds[1]);
+    }
+
+    void Reactor::send_byte () {
+        char const c = 'x';
+        EXPECT_EQ (::send (right_.native_handle (), &c, sizeof (c), 0), 1);
+    }
+
+    std::size_t Reactor::wait () {
+        return reactor_.wait (pstore::gsl::make_span (events_), std::chrono::milliseconds{0});
+    }
+
+} // end anonymous namespace
+
+TEST_F (Reactor, Readable) {
+    reactor_.add (left_.native_handle (), token, reactor::readable, false);
+    EXPECT_EQ (this->wait (), 0U);
+
+    this->send_byte ();
+    ASSERT_EQ (this->wait (), 1U);
+    EXPECT_EQ (events_[0].token, token);
+    EXPECT_TRUE (events_[0].readable);
+    EXPECT_FALSE (events_[0].writable);
+    EXPECT_FALSE (events_[0].hangup);
+
+    // The descriptor is level-triggered so it is reported until the data is consumed.
+    EXPECT_EQ (this->wait (), 1U);
+    reactor_.remove (left_.native_handle ());
+    EXPECT_EQ (this->wait (), 0U);
+}
+
+TEST_F (Reactor, OneShot) {
+    reactor_.add (left_.native_handle (), token, reactor::readable, true);
+    this->send_byte ();
+    EXPECT_EQ (this->wait (), 1U);
+    // The descriptor is disabled until it is rearmed.
+    EXPECT_EQ (this->wait (), 0U);
+
+    reactor_.rearm (left_.native_handle (), token, reactor::readable | reactor::writable);
+    ASSERT_EQ (this->wait (), 1U);
+    EXPECT_TRUE (events_[0].readable);
+    EXPECT_TRUE (events_[0].writable);
+}
+
+TEST_F (Reactor, HangUp) {
+    reactor_.add (left_.native_handle (), token, reactor::readable, false);
+    right_.reset ();
+    ASSERT_EQ (this->wait (), 1U);
+    EXPECT_TRUE (events_[0].hangup);
+}
+
+#endif // PSTORE_HAVE_SYS_EPOLL_H
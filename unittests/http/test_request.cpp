@@ -138,3 +138,30 @@ TEST (ReadHeaders, Common) {
     EXPECT_EQ (std::get<0> (*res), 1) << "Reader state is incorrect";
     EXPECT_EQ (std::get<1> (*res), 3) << "Handler state is incorrect";
 }
+
+namespace {
+
+    pstore::maybe<std::size_t> request_length (std::string const & str) {
+        return pstore::httpd::details::request_length (
+            pstore::gsl::make_span (reinterpret_cast<std::uint8_t const *> (str.data ()),
+                                    static_cast<std::ptrdiff_t> (str.length ())));
+    }
+
+} // end anonymous namespace
+
+TEST (RequestLength, Incomplete) {
+    EXPECT_FALSE (request_length ("").has_value ());
+    EXPECT_FALSE (request_length ("GET / HTTP/1.1").has_value ());
+    EXPECT_FALSE (request_length ("GET / HTTP/1.1\r\nHost: localhost\r\n").has_value ());
+    EXPECT_FALSE (request_length ("GET / HTTP/1.1\r\nHost: localhost\r\n\r").has_value ());
+}
+
+TEST (RequestLength, Complete) {
+    std::string const request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    EXPECT_EQ (request_length (request), pstore::just (request.length ()));
+    // Bytes which follow the request are not included.
+    EXPECT_EQ (request_length (request + "\x81\x80"), pstore::just (request.length ()));
+    // A bare LF is accepted as a line ending.
+    EXPECT_EQ (request_length ("GET / HTTP/1.1\nHost: localhost\n\n"),
+               pstore::just (std::size_t{32}));
+}
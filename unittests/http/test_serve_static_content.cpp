@@ -53,6 +53,8 @@
 #include <array>
 #include <cstring>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "pstore/support/array_elements.hpp"
 #include "pstore/support/maybe.hpp"
@@ -66,11 +68,20 @@ namespace {
     char const index_html[] = "<!DOCTYPE html><html></html>";
     static constexpr std::size_t index_size = pstore::array_elements (index_html) - 1U;
 
+    char const header_html[] = "<p>";
+    static constexpr std::size_t header_size = pstore::array_elements (header_html) - 1U;
+    char const header_html_header[] = "HTTP/1.0 200 OK\r\n"
+                                      "Content-length: 3\r\n"
+                                      "ETag: \"0123456789abcdef\"\r\n";
+
     extern pstore::romfs::directory const root_dir;
     constexpr std::time_t index_mtime = 1556010627;
-    std::array<pstore::romfs::dirent, 3> const root_dir_membs = {{
+    std::array<pstore::romfs::dirent, 4> const root_dir_membs = {{
         {".", &root_dir},
         {"..", &root_dir},
+        {"header.html", reinterpret_cast<std::uint8_t const *> (header_html),
+         pstore::romfs::stat{header_size, index_mtime, pstore::romfs::mode_t::file},
+         header_html_header},
         {"index.html", reinterpret_cast<std::uint8_t const *> (index_html),
          pstore::romfs::stat{index_size, index_mtime, pstore::romfs::mode_t::file}},
     }};
@@ -88,13 +99,18 @@ namespace {
 
     protected:
         pstore::romfs::romfs const & fs () const noexcept { return fs_; }
-        pstore::error_or<std::string> serve_path (std::string const & path) const;
+        pstore::error_or<std::string>
+        serve_path (std::string const & path,
+                    pstore::maybe<std::string> const & if_none_match =
+                        pstore::nothing<std::string> ()) const;
 
     private:
         pstore::romfs::romfs fs_;
     };
 
-    pstore::error_or<std::string> ServeStaticContent::serve_path (std::string const & path) const {
+    pstore::error_or<std::string>
+    ServeStaticContent::serve_path (std::string const & path,
+                                    pstore::maybe<std::string> const & if_none_match) const {
         std::string actual;
 
         using eoint = pstore::error_or<int>;
@@ -104,9 +120,10 @@ namespace {
             return eoint (io + 1);
         };
 
-        return pstore::httpd::serve_static_content (sender, 0, path, fs ()) >>= [&actual](int) {
-            return pstore::error_or<std::string>{pstore::in_place, actual};
-        };
+        return pstore::httpd::serve_static_content (sender, 0, path, fs (), if_none_match) >>=
+               [&actual](int) {
+                   return pstore::error_or<std::string>{pstore::in_place, actual};
+               };
     }
 
 
@@ -133,6 +150,36 @@ namespace {
         std::string const & src_;
     };
 
+    using string_pair = std::pair<std::string, std::string>;
+
+    /// Parses the header of an HTTP response.
+    ///
+    /// \param response  The response to be parsed.
+    /// \param body  On return, the offset of the body within \p response.
+    /// \returns The header fields in the order in which they appear.
+    std::vector<string_pair> get_headers (std::string const & response,
+                                          std::string::size_type * const body) {
+        std::vector<string_pair> headers;
+        reader r{response};
+        auto const record_headers = [&r, &headers] (reader::state_type io,
+                                                    pstore::httpd::request_info const &) {
+            auto record_header = [&headers] (int io2, std::string const & key,
+                                             std::string const & value) {
+                // The date value will change according to when the test is run so we preserve
+                // its presence but drop its value.
+                headers.emplace_back (key, (key == "date") ? "" : value);
+                return io2 + 1;
+            };
+            return pstore::httpd::read_headers (r, io, record_header, 0);
+        };
+
+        pstore::error_or_n<std::string::size_type, int> const eo =
+            pstore::httpd::read_request (r, std::string::size_type{0}) >>= record_headers;
+        EXPECT_TRUE (static_cast<bool> (eo));
+        *body = eo ? std::get<0> (eo) : response.length ();
+        return headers;
+    }
+
 } // end anonymous namespace
 
 
@@ -140,37 +187,91 @@ TEST_F (ServeStaticContent, Simple) {
     pstore::error_or<std::string> const actual = serve_path ("/index.html");
     ASSERT_TRUE (static_cast<bool> (actual));
 
-    using string_pair = std::pair<std::string, std::string>;
-    std::vector<string_pair> headers;
-
-    reader r{*actual};
-    auto const record_headers = [&r, &headers](reader::state_type io,
-                                               pstore::httpd::request_info const &) {
-        auto record_header = [&headers](int io2, std::string const & key,
-                                        std::string const & value) {
-            // The date value will change according to when the test is run so we preserve its
-            // presence but drop its value.
-            headers.emplace_back (key, (key == "date") ? "" : value);
-            return io2 + 1;
-        };
-
-        return pstore::httpd::read_headers (r, io, record_header, 0);
-    };
-
-    pstore::error_or_n<std::string::size_type, int> const eo =
-        pstore::httpd::read_request (r, std::string::size_type{0}) >>= record_headers;
-
-    ASSERT_TRUE (static_cast<bool> (eo));
-    EXPECT_THAT (headers,
+    auto body = std::string::size_type{0};
+    EXPECT_THAT (get_headers (*actual, &body),
                  ::testing::UnorderedElementsAre (
                      string_pair{"content-length", "28"}, string_pair{"content-type", "text/html"},
                      string_pair{"date", ""}, string_pair{"connection", "close"},
                      string_pair{"last-modified", "Tue, 23 Apr 2019 09:10:27 GMT"},
                      string_pair{"server", "pstore-httpd"}));
-    EXPECT_EQ ((std::string{*actual, std::get<0> (eo)}), index_html);
+    EXPECT_EQ ((std::string{*actual, body}), index_html);
 }
 
 TEST_F (ServeStaticContent, MissingFile) {
     pstore::error_or<std::string> const actual = serve_path ("/foo.html");
     EXPECT_EQ (actual.get_error (), make_error_code (pstore::romfs::error_code::enoent));
 }
+
+TEST_F (ServeStaticContent, PrecomputedHeader) {
+    pstore::error_or<std::string> const actual = serve_path ("/header.html");
+    ASSERT_TRUE (static_cast<bool> (actual));
+
+    auto body = std::string::size_type{0};
+    EXPECT_THAT (get_headers (*actual, &body),
+                 ::testing::ElementsAre (string_pair{"content-length", "3"},
+                                         string_pair{"etag", "\"0123456789abcdef\""},
+                                         string_pair{"date", ""}));
+    EXPECT_EQ ((std::string{*actual, body}), header_html);
+}
+
+TEST_F (ServeStaticContent, IfNoneMatchHit) {
+    pstore::error_or<std::string> const actual =
+        serve_path ("/header.html", pstore::just (std::string{"\"0\", W/\"0123456789abcdef\""}));
+    ASSERT_TRUE (static_cast<bool> (actual));
+
+    EXPECT_EQ (actual->compare (0, 26U, "HTTP/1.0 304 Not Modified\r"), 0);
+    auto body = std::string::size_type{0};
+    EXPECT_THAT (get_headers (*actual, &body),
+                 ::testing::UnorderedElementsAre (
+                     string_pair{"server", "pstore-httpd"}, string_pair{"connection", "close"},
+                     string_pair{"etag", "\"0123456789abcdef\""}, string_pair{"date", ""}));
+    EXPECT_EQ (body, actual->length ()) << "A 304 response must not have a body";
+}
+
+TEST_F (ServeStaticContent, IfNoneMatchMiss) {
+    pstore::error_or<std::string> const actual =
+        serve_path ("/header.html", pstore::just (std::string{"\"fedcba9876543210\""}));
+    ASSERT_TRUE (static_cast<bool> (actual));
+    auto body = std::string::size_type{0};
+    get_headers (*actual, &body);
+    EXPECT_EQ ((std::string{*actual, body}), header_html);
+}
+
+TEST_F (ServeStaticContent, IfNoneMatchWithoutAnEntityTag) {
+    // Files without a precomputed header have no entity tag so are always sent...
+    pstore::error_or<std::string> const actual =
+        serve_path ("/index.html", pstore::just (std::string{"\"0123456789abcdef\""}));
+    ASSERT_TRUE (static_cast<bool> (actual));
+    auto body = std::string::size_type{0};
+    get_headers (*actual, &body);
+    EXPECT_EQ ((std::string{*actual, body}), index_html);
+
+    // ...unless the client asks for any version of the file.
+    pstore::error_or<std::string> const any =
+        serve_path ("/index.html", pstore::just (std::string{"*"}));
+    ASSERT_TRUE (static_cast<bool> (any));
+    EXPECT_THAT (get_headers (*any, &body),
+                 ::testing::UnorderedElementsAre (string_pair{"server", "pstore-httpd"},
+                                                  string_pair{"connection", "close"},
+                                                  string_pair{"date", ""}));
+    EXPECT_EQ (body, any->length ());
+}
+
+TEST_F (ServeStaticContent, ContentIsSentInPlace) {
+    std::vector<std::uint8_t const *> sent;
+    auto sender = [&sent] (int io, pstore::gsl::span<std::uint8_t const> const & sp) {
+        sent.push_back (sp.data ());
+        return pstore::error_or<int> (io + 1);
+    };
+    ASSERT_TRUE (static_cast<bool> (
+        pstore::httpd::serve_static_content (sender, 0, "/index.html", fs ())));
+    // The file's contents are passed to the sender directly from the file system rather than
+    // being copied.
+    ASSERT_EQ (sent.size (), 2U);
+    EXPECT_EQ (sent.back (), reinterpret_cast<std::uint8_t const *> (index_html));
+}
+
+TEST_F (ServeStaticContent, Directory) {
+    pstore::error_or<std::string> const actual = serve_path ("/.");
+    EXPECT_EQ (actual.get_error (), make_error_code (pstore::romfs::error_code::enoent));
+}
@@ -175,3 +175,42 @@ TEST (WsServer, Ping) {
     EXPECT_THAT (pstore::gsl::make_span (output),
                  ::testing::ContainerEq (make_span (expected_frames)));
 }
+
+namespace {
+
+    pstore::maybe<std::uint64_t> frame_length (std::vector<std::uint8_t> const & bytes) {
+        return pstore::httpd::details::frame_length (pstore::gsl::make_span (bytes));
+    }
+
+} // end anonymous namespace
+
+TEST (WsServerFrameLength, Incomplete) {
+    EXPECT_FALSE (frame_length ({}).has_value ());
+    EXPECT_FALSE (frame_length ({0x81}).has_value ());
+    // A 16-bit extended payload length of which only one byte has been received.
+    EXPECT_FALSE (frame_length ({0x81, 0x80 | 126, 0x01}).has_value ());
+    // A 64-bit extended payload length of which only seven bytes have been received.
+    EXPECT_FALSE (frame_length ({0x81, 0x80 | 127, 0, 0, 0, 0, 0, 0, 1}).has_value ());
+}
+
+TEST (WsServerFrameLength, Short) {
+    // A masked frame with a 5 byte payload: 2 bytes of header, 4 bytes of mask.
+    EXPECT_EQ (frame_length ({0x81, 0x80 | 5}), pstore::just (std::uint64_t{2 + 4 + 5}));
+    // An unmasked frame with no payload.
+    EXPECT_EQ (frame_length ({0x81, 0}), pstore::just (std::uint64_t{2}));
+}
+
+TEST (WsServerFrameLength, Extended) {
+    // A 16-bit extended payload length (0x0102 bytes).
+    EXPECT_EQ (frame_length ({0x82, 0x80 | 126, 0x01, 0x02}),
+               pstore::just (std::uint64_t{2 + 2 + 4 + 0x0102}));
+    // A 64-bit extended payload length (0x010203 bytes).
+    EXPECT_EQ (frame_length ({0x82, 0x80 | 127, 0, 0, 0, 0, 0, 0x01, 0x02, 0x03}),
+               pstore::just (std::uint64_t{2 + 8 + 4 + 0x010203}));
+}
+
+TEST (WsServerFrameLength, Overflow) {
+    // A (malicious) length which would overflow is clamped.
+    EXPECT_EQ (frame_length ({0x82, 0x80 | 127, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}),
+               pstore::just (std::numeric_limits<std::uint64_t>::max ()));
+}
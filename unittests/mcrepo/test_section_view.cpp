@@ -0,0 +1,192 @@
+//*                _   _                     _                *
+//*  ___  ___  ___| |_(_) ___  _ __   __   _(_) _____      __ *
+//* / __|/ _ \/ __| __| |/ _ \| '_ \  \ \ / / |/ _ \ \ /\ / / *
+//* \__ \  __/ (__| |_| | (_) | | | |  \ V /| |  __/\ V  V /  *
+//* |___/\___|\___|\__|_|\___/|_| |_|   \_/ |_|\___| \_/\_/   *
+//*                                                           *
+//===- unittests/mcrepo/test_section_view.cpp -----------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/mcrepo/section_view.hpp"
+
+// Standard library includes
+#include <array>
+#include <memory>
+#include <vector>
+
+// 3rd party
+#include <gmock/gmock.h>
+
+// Local includes
+#include "transaction.hpp"
+
+using namespace pstore::repo;
+
+namespace {
+
+    class SectionView : public ::testing::Test {
+    protected:
+        SectionView ();
+
+        transaction transaction_;
+        std::vector<section_content> contents_;
+        std::array<pstore::typed_address<compilation_member>, 1> members_{
+            {pstore::typed_address<compilation_member>::make (128)}};
+        fragment const * fragment_ = nullptr;
+
+        using string_address = pstore::typed_address<pstore::indirect_string>;
+        static constexpr string_address indirect_string_address (std::uint64_t x) {
+            return string_address{pstore::address{x}};
+        }
+    };
+
+    constexpr unsigned kind_value (section_kind const kind) noexcept {
+        return static_cast<unsigned> (kind);
+    }
+
+    SectionView::SectionView () {
+        contents_.emplace_back (section_kind::text, std::uint8_t{16} /*alignment*/);
+        {
+            section_content & text = contents_.back ();
+            text.data.assign ({'t', 'e', 'x', 't'});
+            text.ifixups.emplace_back (internal_fixup{section_kind::data, 1, 1, 1});
+            text.xfixups.emplace_back (external_fixup{indirect_string_address (2), 2, 2, 2});
+            text.xfixups.emplace_back (external_fixup{indirect_string_address (3), 3, 3, 3});
+        }
+        contents_.emplace_back (section_kind::bss, std::uint8_t{8} /*alignment*/);
+        contents_.back ().data.resize (32U);
+        contents_.emplace_back (section_kind::read_only, std::uint8_t{4} /*alignment*/);
+        contents_.back ().data.assign ({'r', 'o'});
+
+        std::vector<std::unique_ptr<section_creation_dispatcher>> dispatchers;
+        dispatchers.emplace_back (
+            new generic_section_creation_dispatcher (section_kind::text, &contents_[0]));
+        dispatchers.emplace_back (new bss_section_creation_dispatcher (&contents_[1]));
+        dispatchers.emplace_back (
+            new generic_section_creation_dispatcher (section_kind::read_only, &contents_[2]));
+        dispatchers.emplace_back (
+            new dependents_creation_dispatcher (members_.data (), members_.data () + 1));
+
+        auto const extent =
+            fragment::alloc (transaction_, pstore::make_pointee_adaptor (dispatchers.begin ()),
+                             pstore::make_pointee_adaptor (dispatchers.end ()));
+        fragment_ = reinterpret_cast<fragment const *> (extent.addr.absolute ());
+    }
+
+} // end anonymous namespace
+
+TEST_F (SectionView, Generic) {
+    using ::testing::ElementsAre;
+    using ::testing::ElementsAreArray;
+
+    section_view const view = make_section_view (*fragment_, section_kind::text);
+    EXPECT_EQ (kind_value (view.kind), kind_value (section_kind::text));
+    EXPECT_EQ (view.align, 16U);
+    EXPECT_EQ (view.size, 4U);
+    EXPECT_THAT (view.payload, ElementsAre ('t', 'e', 'x', 't'));
+    EXPECT_THAT (view.ifixups, ElementsAreArray (contents_[0].ifixups));
+    EXPECT_THAT (view.xfixups, ElementsAreArray (contents_[0].xfixups));
+
+    // The spans refer directly to the fragment's storage.
+    generic_section const & text = fragment_->at<section_kind::text> ();
+    EXPECT_EQ (view.payload.data (), text.payload ().data ());
+    EXPECT_EQ (view.ifixups.data (), text.ifixups ().data ());
+    EXPECT_EQ (view.xfixups.data (), text.xfixups ().data ());
+}
+
+TEST_F (SectionView, Bss) {
+    section_view const view = make_section_view (*fragment_, section_kind::bss);
+    EXPECT_EQ (kind_value (view.kind), kind_value (section_kind::bss));
+    EXPECT_EQ (view.align, 8U);
+    EXPECT_EQ (view.size, 32U);
+    EXPECT_EQ (view.payload.size (), 0U);
+    EXPECT_EQ (view.ifixups.size (), 0U);
+    EXPECT_EQ (view.xfixups.size (), 0U);
+}
+
+TEST_F (SectionView, DependentsIsNotATargetSection) {
+#if PSTORE_EXCEPTIONS
+    EXPECT_THROW (make_section_view (*fragment_, section_kind::dependent), std::system_error);
+#endif // PSTORE_EXCEPTIONS
+}
+
+TEST_F (SectionView, FragmentSections) {
+    std::vector<unsigned> kinds;
+    std::vector<std::uint64_t> sizes;
+    for_each_section (*fragment_, [&kinds, &sizes] (section_view const & view) {
+        kinds.push_back (kind_value (view.kind));
+        sizes.push_back (view.size);
+    });
+    // The dependents section is skipped.
+    EXPECT_THAT (kinds, ::testing::ElementsAre (kind_value (section_kind::text),
+                                                kind_value (section_kind::bss),
+                                                kind_value (section_kind::read_only)));
+    EXPECT_THAT (sizes, ::testing::ElementsAre (4U, 32U, 2U));
+}
+
+TEST_F (SectionView, SharedPayload) {
+    section_content content{section_kind::read_only, std::uint8_t{8} /*alignment*/};
+    content.ifixups.emplace_back (internal_fixup{section_kind::text, 4, 4, 4});
+    auto const shared = pstore::make_extent (pstore::typed_address<std::uint8_t>::make (4096),
+                                             std::uint64_t{100});
+    generic_section_creation_dispatcher dispatcher{section_kind::read_only, &content, shared};
+    std::array<section_creation_dispatcher *, 1> d{{&dispatcher}};
+    auto const extent = fragment::alloc (transaction_, pstore::make_pointee_adaptor (d.begin ()),
+                                         pstore::make_pointee_adaptor (d.end ()));
+    auto const & f = *reinterpret_cast<fragment const *> (extent.addr.absolute ());
+
+    generic_section const & ro = f.at<section_kind::read_only> ();
+    ASSERT_TRUE (ro.has_shared_payload ());
+    EXPECT_EQ (ro.shared_payload (), shared);
+    EXPECT_EQ (ro.size (), 100U);
+    EXPECT_THAT (ro.ifixups (), ::testing::ElementsAreArray (content.ifixups));
+    EXPECT_EQ (ro.xfixups ().size (), 0U);
+    EXPECT_EQ (ro.size_bytes (), dispatcher.size_bytes ());
+
+    // The alignment, size, and fixups are available without loading the payload.
+    EXPECT_EQ (section_align (f, section_kind::read_only), 8U);
+    EXPECT_EQ (section_size (f, section_kind::read_only), 100U);
+    EXPECT_EQ (section_ifixups (f, section_kind::read_only).size (), 1U);
+#if PSTORE_EXCEPTIONS
+    // The payload can only be reached through a pinned view.
+    EXPECT_THROW (make_section_view (f, section_kind::read_only), std::system_error);
+    // Nor can the section itself or the virtual dispatcher interface return it.
+    EXPECT_THROW (ro.payload (), std::system_error);
+    section_dispatcher const sd{ro};
+    EXPECT_THROW (sd.payload (), std::system_error);
+#endif // PSTORE_EXCEPTIONS
+}
@@ -95,3 +95,22 @@ TEST (MemoryMapper, MemoryMapThenCheckFileContents) {
     std::iota (expected.begin (), expected.end (), std::uint8_t{0});
     EXPECT_THAT (expected, ContainerEq (contents));
 }
+
+TEST (MemoryMapper, Advise) {
+    pstore::file::file_handle file;
+    file.open (pstore::file::file_handle::temporary ());
+
+    std::size_t const size = pstore::system_page_size ().get () * 4U;
+    file.seek (size - 1U);
+    file.write (0);
+
+    pstore::memory_mapper mm{file, false /*writable?*/, 0U /*offset*/, size};
+    auto * const ptr = static_cast<std::uint8_t *> (mm.data ().get ());
+    for (auto const pattern :
+         {pstore::access_pattern::sequential, pstore::access_pattern::random,
+          pstore::access_pattern::willneed, pstore::access_pattern::hugepage,
+          pstore::access_pattern::normal}) {
+        // Unaligned ranges are extended to page boundaries.
+        EXPECT_NO_THROW (mm.advise (ptr + 1, size - 1U, pattern));
+    }
+}
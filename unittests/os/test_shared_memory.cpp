@@ -49,11 +49,57 @@
 #include <algorithm>
 #include <array>
 #include <limits>
+#include <string>
 // 3rd party
 #include <gmock/gmock.h>
 // pstore
 #include "pstore/support/gsl.hpp"
 
+#ifndef _WIN32
+#    include <unistd.h>
+#endif
+
+namespace {
+
+    std::string shared_memory_test_name () {
+#ifdef _WIN32
+        return "pstore-shared-memory-test";
+#else
+        return "pstore-shared-memory-test-" + std::to_string (::getpid ());
+#endif
+    }
+
+    struct shared_counter {
+        int value = 0;
+    };
+
+} // end anonymous namespace
+
+TEST (SharedMemory, NeverCreateMissingObject) {
+    std::string const name = shared_memory_test_name ();
+    {
+        pstore::shared_memory<shared_counter> const shm{name, pstore::shared_memory_unlink::never,
+                                                        pstore::shared_memory_create::never};
+        EXPECT_EQ (shm.get (), nullptr);
+    }
+    // The object was not created as a side effect: a second attempt still finds nothing.
+    pstore::shared_memory<shared_counter> const shm{name, pstore::shared_memory_unlink::never,
+                                                    pstore::shared_memory_create::never};
+    EXPECT_EQ (shm.get (), nullptr);
+}
+
+TEST (SharedMemory, NeverCreateExistingObject) {
+    std::string const name = shared_memory_test_name ();
+    pstore::shared_memory<shared_counter> owner{name};
+    ASSERT_NE (owner.get (), nullptr);
+    owner->value = 42;
+
+    pstore::shared_memory<shared_counter> const shm{name, pstore::shared_memory_unlink::never,
+                                                    pstore::shared_memory_create::never};
+    ASSERT_NE (shm.get (), nullptr);
+    EXPECT_EQ (shm->value, 42);
+}
+
 TEST (PosixMutexName, LargeOutputBuffer) {
     std::array<char, 256> arr;
 
@@ -128,6 +128,20 @@ TEST_F (RomFs, OpenFile) {
     this->check_for_error (fs ().open ("missing"), pstore::romfs::error_code::enoent);
 }
 
+TEST_F (RomFs, Find) {
+    pstore::error_or<dirent const *> const hello = fs ().find ("/hello");
+    ASSERT_TRUE (static_cast<bool> (hello));
+    EXPECT_STREQ ((*hello)->name (), "hello");
+    EXPECT_EQ ((*hello)->contents (), file2);
+    EXPECT_EQ ((*hello)->header (), nullptr);
+
+    pstore::error_or<dirent const *> const dir = fs ().find ("dir");
+    ASSERT_TRUE (static_cast<bool> (dir));
+    EXPECT_TRUE ((*dir)->is_directory ());
+
+    this->check_for_error (fs ().find ("missing"), pstore::romfs::error_code::enoent);
+}
+
 TEST_F (RomFs, OpenAndReadFile) {
     pstore::error_or<descriptor> eod = fs ().open ("./hello");
     ASSERT_TRUE (static_cast<bool> (eod));
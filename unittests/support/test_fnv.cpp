@@ -51,6 +51,7 @@
  */
 
 #include "pstore/support/fnv.hpp"
+#include <vector>
 #include <gtest/gtest.h>
 
 // FNVTEST macro does not include trailing NUL byte in the test vector
@@ -542,4 +543,18 @@ TEST (Fnv, StandardVectors) {
         EXPECT_EQ (hval, fnv1a_64_vector[test_num - 1].fnv1a_64) << "failed test # " << test_num;
     }
 }
+
+TEST (Fnv, MultipleBuffersMatchStandardVectors) {
+    std::vector<void const *> bufs;
+    std::vector<std::size_t> lens;
+    for (test_vector const * t = fnv_test_str; t->buf != nullptr; ++t) {
+        bufs.push_back (t->buf);
+        lens.push_back (t->len);
+    }
+    std::vector<std::uint64_t> hashes (bufs.size ());
+    pstore::fnv_64a_bufs (bufs.size (), bufs.data (), lens.data (), hashes.data ());
+    for (auto ctr = std::size_t{0}; ctr < hashes.size (); ++ctr) {
+        EXPECT_EQ (hashes[ctr], fnv1a_64_vector[ctr].fnv1a_64) << "failed test # " << ctr + 1;
+    }
+}
 // eof: unittests/pstore/test_fnv.cpp
@@ -0,0 +1,138 @@
+//*                                        _              *
+//*  _ __ ___  _ __  _ __ ___   ___   _ __(_)_ __   __ _  *
+//* | '_ ` _ \| '_ \| '_ ` _ \ / __| | '__| | '_ \ / _` | *
+//* | | | | | | |_) | | | | | | (__  | |  | | | | | (_| | *
+//* |_| |_| |_| .__/|_| |_| |_|\___| |_|  |_|_| |_|\__, | *
+//*           |_|                                  |___/  *
+//===- unittests/support/test_mpmc_ring.cpp -------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+#include "pstore/support/mpmc_ring.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+TEST (MpmcRing, Empty) {
+    pstore::mpmc_ring<int> ring{4U};
+    EXPECT_EQ (ring.capacity (), 4U);
+    EXPECT_EQ (ring.size (), 0U);
+    int v = 0;
+    EXPECT_FALSE (ring.try_pop (v));
+}
+
+TEST (MpmcRing, Fifo) {
+    pstore::mpmc_ring<int> ring{4U};
+    EXPECT_TRUE (ring.try_push (1));
+    EXPECT_TRUE (ring.try_push (2));
+    EXPECT_EQ (ring.size (), 2U);
+    int v = 0;
+    EXPECT_TRUE (ring.try_pop (v));
+    EXPECT_EQ (v, 1);
+    EXPECT_TRUE (ring.try_pop (v));
+    EXPECT_EQ (v, 2);
+    EXPECT_FALSE (ring.try_pop (v));
+}
+
+TEST (MpmcRing, Full) {
+    pstore::mpmc_ring<std::unique_ptr<int>> ring{2U};
+    EXPECT_TRUE (ring.try_push (std::make_unique<int> (1)));
+    EXPECT_TRUE (ring.try_push (std::make_unique<int> (2)));
+
+    // A failed push leaves its argument intact.
+    auto three = std::make_unique<int> (3);
+    EXPECT_FALSE (ring.try_push (std::move (three)));
+    ASSERT_NE (three, nullptr);
+
+    std::unique_ptr<int> v;
+    EXPECT_TRUE (ring.try_pop (v));
+    EXPECT_EQ (*v, 1);
+    EXPECT_TRUE (ring.try_push (std::move (three)));
+    EXPECT_TRUE (ring.try_pop (v));
+    EXPECT_EQ (*v, 2);
+    EXPECT_TRUE (ring.try_pop (v));
+    EXPECT_EQ (*v, 3);
+}
+
+TEST (MpmcRing, ManyProducersAndConsumers) {
+    constexpr auto num_threads = 4U;
+    constexpr auto per_producer = 10000U;
+    pstore::mpmc_ring<unsigned> ring{64U};
+
+    std::vector<std::thread> threads;
+    for (auto p = 0U; p < num_threads; ++p) {
+        threads.emplace_back ([&ring, p] () {
+            for (auto ctr = 0U; ctr < per_producer; ++ctr) {
+                auto v = p * per_producer + ctr;
+                while (!ring.try_push (std::move (v))) {
+                    std::this_thread::yield ();
+                }
+            }
+        });
+    }
+    std::vector<std::vector<unsigned>> received (num_threads);
+    for (auto c = 0U; c < num_threads; ++c) {
+        threads.emplace_back ([&ring, &received, c] () {
+            auto & r = received[c];
+            while (r.size () < per_producer) {
+                unsigned v = 0;
+                if (ring.try_pop (v)) {
+                    r.push_back (v);
+                } else {
+                    std::this_thread::yield ();
+                }
+            }
+        });
+    }
+    for (std::thread & t : threads) {
+        t.join ();
+    }
+
+    // Every value was received exactly once.
+    std::vector<unsigned> all;
+    for (auto const & r : received) {
+        all.insert (all.end (), r.begin (), r.end ());
+    }
+    std::sort (all.begin (), all.end ());
+    std::vector<unsigned> expected (num_threads * per_producer);
+    std::iota (expected.begin (), expected.end (), 0U);
+    EXPECT_EQ (all, expected);
+}
@@ -46,7 +46,11 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <functional>
 #include <mutex>
+#include <numeric>
+#include <string>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -149,3 +153,66 @@ TEST (ParallelForEachException, WorkerExceptionPropogates) {
     EXPECT_THROW (op (), custom_exception);
 #endif // PSTORE_EXCEPTIONS
 }
+
+TEST_F (ParallelForEach, ManyElements) {
+    // Many more elements than threads so that each thread claims several chunks.
+    auto num = concurrency () * 1000U + 7U;
+    auto const src = make_input (num);
+    auto const expected = make_expected (num);
+    auto const out = run_for_each (src);
+    EXPECT_THAT (out, ::testing::ContainerEq (expected));
+}
+
+TEST (ParallelForEachNested, InnerLoopsComplete) {
+    // A loop body which itself runs a parallel loop must not deadlock even if every worker is
+    // busy with the outer loop.
+    std::atomic<unsigned> count{0U};
+    std::vector<int> const outer (64U, 0);
+    std::vector<int> const inner (64U, 0);
+    pstore::cmd_util::parallel_for_each (std::begin (outer), std::end (outer), [&] (int) {
+        pstore::cmd_util::parallel_for_each (std::begin (inner), std::end (inner),
+                                             [&count] (int) { ++count; });
+    });
+    EXPECT_EQ (count.load (), outer.size () * inner.size ());
+}
+
+TEST (ParallelReduce, Empty) {
+    std::vector<int> const src;
+    auto const sum = pstore::cmd_util::parallel_reduce (
+        std::begin (src), std::end (src), 7, std::plus<int> (), [] (int v) { return v; });
+    EXPECT_EQ (sum, 7);
+}
+
+TEST (ParallelReduce, Sum) {
+    std::vector<unsigned> src (10000U);
+    std::iota (std::begin (src), std::end (src), 1U);
+    auto const sum = pstore::cmd_util::parallel_reduce (std::begin (src), std::end (src), 0U,
+                                                        std::plus<unsigned> (),
+                                                        [] (unsigned v) { return v * 2U; });
+    EXPECT_EQ (sum, 10000U * 10001U);
+}
+
+TEST (ParallelReduce, ResultsAreCombinedInOrder) {
+    // String concatenation is not commutative: the result shows that the per-chunk results are
+    // combined in the order of the input.
+    std::vector<char> src (1000U);
+    std::generate (std::begin (src), std::end (src),
+                   [c = 0U] () mutable { return static_cast<char> ('a' + c++ % 26U); });
+    auto const actual = pstore::cmd_util::parallel_reduce (
+        std::begin (src), std::end (src), std::string{}, std::plus<std::string> (),
+        [] (char c) { return std::string (1U, c); });
+    EXPECT_EQ (actual, std::string (std::begin (src), std::end (src)));
+}
+
+TEST (ParallelReduce, Bool) {
+    std::vector<int> src (1000U, 1);
+    src[573] = 0;
+    auto const all_set = [&src] () {
+        return pstore::cmd_util::parallel_reduce (std::begin (src), std::end (src), true,
+                                                  std::logical_and<bool> (),
+                                                  [] (int v) { return v != 0; });
+    };
+    EXPECT_FALSE (all_set ());
+    src[573] = 1;
+    EXPECT_TRUE (all_set ());
+}
@@ -113,9 +113,9 @@ TEST (PubSub, PubSub) {
 
     std::thread thread{[&]() {
         listening_counter.increment ();
-        while (pstore::maybe<std::string> const message = sub->listen ()) {
+        while (pstore::maybe<pstore::message_pointer> const message = sub->listen ()) {
             received_counter.increment ();
-            received.call (*message);
+            received.call (**message);
         }
     }};
 
@@ -130,3 +130,61 @@ TEST (PubSub, PubSub) {
     sub->cancel ();
     thread.join ();
 }
+
+TEST (PubSub, MessageIsShared) {
+    std::condition_variable cv;
+    pstore::channel<decltype (cv)> chan{&cv};
+    auto sub1 = chan.new_subscriber ();
+    auto sub2 = chan.new_subscriber ();
+
+    chan.publish ("message");
+    pstore::maybe<pstore::message_pointer> const m1 = sub1->pop ();
+    pstore::maybe<pstore::message_pointer> const m2 = sub2->pop ();
+    ASSERT_TRUE (m1.has_value () && m2.has_value ());
+    EXPECT_EQ (**m1, "message");
+    // Both subscribers receive the same instance of the message.
+    EXPECT_EQ (*m1, *m2);
+    EXPECT_FALSE (sub1->pop ().has_value ());
+}
+
+TEST (PubSub, NewSubscriberSkipsEarlierMessages) {
+    std::condition_variable cv;
+    pstore::channel<decltype (cv)> chan{&cv};
+    auto sub1 = chan.new_subscriber ();
+    chan.publish ("message 1");
+    auto sub2 = chan.new_subscriber ();
+    chan.publish ("message 2");
+
+    EXPECT_EQ (**sub1->pop (), "message 1");
+    EXPECT_EQ (**sub1->pop (), "message 2");
+    EXPECT_EQ (**sub2->pop (), "message 2");
+    EXPECT_FALSE (sub2->pop ().has_value ());
+}
+
+TEST (PubSub, SlowSubscriberDrops) {
+    std::condition_variable cv;
+    pstore::channel<decltype (cv)> chan{&cv, 2U};
+    auto sub = chan.new_subscriber ();
+    chan.publish ("message 1");
+    chan.publish ("message 2");
+    chan.publish ("message 3");
+    chan.publish ("message 4");
+
+    // The first two messages were overwritten before they could be received.
+    EXPECT_EQ (**sub->pop (), "message 3");
+    EXPECT_EQ (**sub->pop (), "message 4");
+    EXPECT_FALSE (sub->pop ().has_value ());
+    EXPECT_EQ (sub->dropped (), 2U);
+}
+
+TEST (PubSub, Coalesce) {
+    std::condition_variable cv;
+    pstore::channel<decltype (cv)> chan{&cv, 1U};
+    auto sub = chan.new_subscriber ();
+    chan.publish ("message 1");
+    chan.publish ("message 2");
+
+    EXPECT_EQ (**sub->pop (), "message 2");
+    EXPECT_FALSE (sub->pop ().has_value ());
+    EXPECT_EQ (sub->dropped (), 1U);
+}
@@ -0,0 +1,137 @@
+//*  _   _                        _                     _  *
+//* | |_| |__  _ __ ___  __ _  __| |  _ __   ___   ___ | | *
+//* | __| '_ \| '__/ _ \/ _` |/ _` | | '_ \ / _ \ / _ \| | *
+//* | |_| | | | | |  __/ (_| | (_| | | |_) | (_) | (_) | | *
+//*  \__|_| |_|_|  \___|\__,_|\__,_| | .__/ \___/ \___/|_| *
+//*                                  |_|                   *
+//===- unittests/support/test_thread_pool.cpp -----------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include "pstore/support/thread_pool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+namespace {
+
+    std::vector<unsigned> run_counts (pstore::thread_pool & pool, std::size_t num_chunks) {
+        std::vector<std::atomic<unsigned>> counts (num_chunks);
+        for (auto & c : counts) {
+            c = 0U;
+        }
+        pool.run_chunks (num_chunks, [&counts] (std::size_t const chunk) { ++counts[chunk]; });
+        std::vector<unsigned> result;
+        for (auto const & c : counts) {
+            result.push_back (c.load ());
+        }
+        return result;
+    }
+
+} // end anonymous namespace
+
+TEST (ThreadPool, ZeroChunks) {
+    pstore::thread_pool pool{2U};
+    EXPECT_THAT (run_counts (pool, 0U), ::testing::IsEmpty ());
+}
+
+TEST (ThreadPool, EachChunkRunsOnce) {
+    pstore::thread_pool pool{3U};
+    EXPECT_EQ (pool.num_workers (), 3U);
+    EXPECT_EQ (pool.concurrency (), 4U);
+    EXPECT_THAT (run_counts (pool, 1000U), ::testing::Each (1U));
+}
+
+TEST (ThreadPool, NoWorkers) {
+    // With no workers, all of the chunks are run by the calling thread.
+    pstore::thread_pool pool{0U};
+    EXPECT_EQ (pool.concurrency (), 1U);
+    EXPECT_THAT (run_counts (pool, 10U), ::testing::Each (1U));
+}
+
+TEST (ThreadPool, Submit) {
+    pstore::thread_pool pool{2U};
+    std::mutex mut;
+    std::condition_variable cv;
+    unsigned count = 0U;
+    constexpr auto num_tasks = 100U;
+    for (auto ctr = 0U; ctr < num_tasks; ++ctr) {
+        pool.submit ([&] () {
+            std::lock_guard<std::mutex> const lock{mut};
+            ++count;
+            cv.notify_one ();
+        });
+    }
+    std::unique_lock<std::mutex> lock{mut};
+    cv.wait (lock, [&count] () { return count == num_tasks; });
+    EXPECT_EQ (count, num_tasks);
+}
+
+TEST (ThreadPool, NestedRunChunks) {
+    // Every worker is busy with the outer loop when the inner loops start. These must still
+    // complete.
+    pstore::thread_pool pool{2U};
+    std::atomic<unsigned> count{0U};
+    pool.run_chunks (16U, [&] (std::size_t) {
+        pool.run_chunks (16U, [&count] (std::size_t) { ++count; });
+    });
+    EXPECT_EQ (count.load (), 16U * 16U);
+}
+
+TEST (ThreadPool, ExceptionPropagates) {
+#if PSTORE_EXCEPTIONS
+    class custom_exception : public std::exception {};
+    pstore::thread_pool pool{2U};
+    std::atomic<unsigned> count{0U};
+    EXPECT_THROW (pool.run_chunks (100U,
+                                   [&count] (std::size_t const chunk) {
+                                       ++count;
+                                       if (chunk == 0U) {
+                                           throw custom_exception{};
+                                       }
+                                   }),
+                  custom_exception);
+    EXPECT_LE (count.load (), 100U);
+    // The pool remains usable.
+    EXPECT_THAT (run_counts (pool, 10U), ::testing::Each (1U));
+#endif // PSTORE_EXCEPTIONS
+}
@@ -0,0 +1,418 @@
+//*            _ _           _              *
+//*   ___ ___ | | | ___  ___| |_ ___  _ __  *
+//*  / __/ _ \| | |/ _ \/ __| __/ _ \| '__| *
+//* | (_| (_) | | |  __/ (__| || (_) | |    *
+//*  \___\___/|_|_|\___|\___|\__\___/|_|    *
+//*                                         *
+//===- unittests/vacuum/test_collector.cpp --------------------------------===//
+// Copyright (c) 2017-2020 by Sony Interactive Entertainment, Inc.
+// All rights reserved.
+//
+// Developed by:
+//   Toolchain Team
+//   SN Systems, Ltd.
+//   www.snsystems.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal with the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// - Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimers.
+//
+// - Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimers in the
+//   documentation and/or other materials provided with the distribution.
+//
+// - Neither the names of SN Systems Ltd., Sony Interactive Entertainment,
+//   Inc. nor the names of its contributors may be used to endorse or
+//   promote products derived from this Software without specific prior
+//   written permission.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+// ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS WITH THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include "pstore/vacuum/collector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "pstore/core/hamt_map.hpp"
+#include "pstore/core/hamt_set.hpp"
+#include "pstore/core/indirect_string.hpp"
+#include "pstore/core/transaction.hpp"
+#include "pstore/mcrepo/compilation.hpp"
+#include "pstore/mcrepo/fragment.hpp"
+#include "pstore/mcrepo/shared_payload.hpp"
+#include "pstore/support/pointee_adaptor.hpp"
+
+#include "empty_store.hpp"
+#include "mock_mutex.hpp"
+
+namespace {
+
+    class Collector : public EmptyStore {
+    public:
+        Collector ();
+
+    protected:
+        using lock_guard = std::unique_lock<mock_mutex>;
+        using transaction_type = pstore::transaction<lock_guard>;
+
+        pstore::typed_address<pstore::indirect_string> add_name (transaction_type & transaction,
+                                                                 std::string const & str);
+        void add_write (std::string const & key, std::string const & value);
+        std::string read_write (pstore::database & db, std::string const & key);
+
+        mock_mutex mutex_;
+        std::unique_ptr<pstore::database> source_;
+
+        std::shared_ptr<std::uint8_t> destination_buffer_;
+        std::shared_ptr<pstore::file::in_memory> destination_file_;
+        std::unique_ptr<pstore::database> destination_;
+    };
+
+    // (ctor)
+    // ~~~~~~
+    Collector::Collector ()
+            : destination_buffer_{pstore::aligned_valloc (file_size, 4096)}
+            , destination_file_{
+                  std::make_shared<pstore::file::in_memory> (destination_buffer_, file_size)} {
+        pstore::database::build_new_store (*destination_file_);
+        source_ = std::make_unique<pstore::database> (this->file ());
+        source_->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+        destination_ = std::make_unique<pstore::database> (destination_file_);
+        destination_->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+    }
+
+    // add_name
+    // ~~~~~~~~
+    pstore::typed_address<pstore::indirect_string>
+    Collector::add_name (transaction_type & transaction, std::string const & str) {
+        pstore::raw_sstring_view const sstring = pstore::make_sstring_view (str);
+        pstore::indirect_string_adder adder;
+        auto const pos =
+            adder
+                .add (transaction,
+                      pstore::index::get_index<pstore::trailer::indices::name> (*source_),
+                      &sstring)
+                .first;
+        adder.flush (transaction);
+        return pstore::typed_address<pstore::indirect_string> (pos.get_address ());
+    }
+
+    // add_write
+    // ~~~~~~~~~
+    void Collector::add_write (std::string const & key, std::string const & value) {
+        transaction_type transaction = pstore::begin (*source_, lock_guard{mutex_});
+        auto const addr = transaction.allocate (value.size (), 1 /*align*/);
+        std::copy (std::begin (value), std::end (value),
+                   transaction.getrw (pstore::make_extent (pstore::typed_address<char> (addr),
+                                                           value.size ()))
+                       .get ());
+        pstore::index::get_index<pstore::trailer::indices::write> (*source_)->insert_or_assign (
+            transaction, key, pstore::make_extent (pstore::typed_address<char> (addr), value.size ()));
+        transaction.commit ();
+    }
+
+    // read_write
+    // ~~~~~~~~~~
+    std::string Collector::read_write (pstore::database & db, std::string const & key) {
+        auto const index = pstore::index::get_index<pstore::trailer::indices::write> (db);
+        auto const pos = index->find (db, key);
+        if (pos == index->cend (db)) {
+            return "";
+        }
+        pstore::extent<char> const & ext = pos->second;
+        auto const ptr = db.getro (ext);
+        return {ptr.get (), ext.size};
+    }
+
+} // end anonymous namespace
+
+TEST_F (Collector, NothingToCopy) {
+    std::atomic<bool> cancel{false};
+    vacuum::collector c{*source_, *destination_};
+    EXPECT_TRUE (c.pass (cancel));
+    EXPECT_EQ (c.collected_revision (), 0U);
+    EXPECT_EQ (destination_->get_current_revision (), 0U);
+}
+
+TEST_F (Collector, SecondPassCopiesOnlyTheDelta) {
+    std::atomic<bool> cancel{false};
+    vacuum::collector c{*source_, *destination_};
+
+    this->add_write ("first", "one");
+    ASSERT_TRUE (c.pass (cancel));
+    EXPECT_EQ (c.collected_revision (), 1U);
+    EXPECT_EQ (this->read_write (*destination_, "first"), "one");
+
+    auto const first_leaf = [this] () {
+        return pstore::index::get_index<pstore::trailer::indices::write> (*destination_)
+            ->find (*destination_, std::string{"first"})
+            .get_address ();
+    };
+    pstore::address const before = first_leaf ();
+
+    this->add_write ("second", "two");
+    ASSERT_TRUE (c.pass (cancel));
+    EXPECT_EQ (c.collected_revision (), 2U);
+    EXPECT_EQ (destination_->get_current_revision (), 2U);
+    EXPECT_EQ (this->read_write (*destination_, "first"), "one");
+    EXPECT_EQ (this->read_write (*destination_, "second"), "two");
+    // The entry copied by the first pass must not have been copied again.
+    EXPECT_EQ (first_leaf (), before);
+}
+
+TEST_F (Collector, CancelledPassIsRolledBack) {
+    this->add_write ("key", "value");
+
+    vacuum::collector c{*source_, *destination_};
+    std::atomic<bool> cancel{true};
+    EXPECT_FALSE (c.pass (cancel));
+    EXPECT_EQ (c.collected_revision (), 0U);
+    EXPECT_EQ (destination_->get_current_revision (), 0U);
+
+    cancel = false;
+    EXPECT_TRUE (c.pass (cancel));
+    EXPECT_EQ (c.collected_revision (), 1U);
+    EXPECT_EQ (this->read_write (*destination_, "key"), "value");
+}
+
+TEST_F (Collector, PassCancelledMidCopy) {
+    using namespace pstore::repo;
+    pstore::index::digest const compilation_digest{1U};
+    {
+        transaction_type transaction = pstore::begin (*source_, lock_guard{mutex_});
+        auto const path = this->add_name (transaction, "path");
+        auto const triple = this->add_name (transaction, "triple");
+        std::vector<compilation_member> const members;
+        auto const cext = compilation::alloc (transaction, path, triple, std::begin (members),
+                                              std::end (members));
+        pstore::index::get_index<pstore::trailer::indices::compilation> (*source_)
+            ->insert_or_assign (transaction, compilation_digest, cext);
+        transaction.commit ();
+    }
+    this->add_write ("key", "value");
+
+    vacuum::collector c{*source_, *destination_};
+    // Cancel the pass once the first name has been copied.
+    auto polls = 0U;
+    EXPECT_FALSE (c.pass ([&polls] () { return ++polls > 1U; }));
+    EXPECT_EQ (polls, 2U);
+    EXPECT_EQ (c.collected_revision (), 0U);
+    EXPECT_EQ (destination_->get_current_revision (), 0U);
+
+    std::atomic<bool> cancel{false};
+    ASSERT_TRUE (c.pass (cancel));
+    EXPECT_EQ (c.collected_revision (), 2U);
+    EXPECT_EQ (this->read_write (*destination_, "key"), "value");
+
+    pstore::database & db = *destination_;
+    EXPECT_EQ (pstore::index::get_index<pstore::trailer::indices::name> (db)->size (), 2U);
+    auto const compilations = pstore::index::get_index<pstore::trailer::indices::compilation> (db);
+    auto const pos = compilations->find (db, compilation_digest);
+    ASSERT_NE (pos, compilations->cend (db));
+    auto const comp = compilation::load (db, pos->second);
+    EXPECT_EQ (pstore::indirect_string::read (db, comp->path ()).to_string (), "path");
+    EXPECT_EQ (pstore::indirect_string::read (db, comp->triple ()).to_string (), "triple");
+}
+
+TEST_F (Collector, RelocatesRepoRecords) {
+    using namespace pstore::repo;
+    pstore::index::digest const fragment_digest{1U};
+    pstore::index::digest const dependent_digest{2U};
+    pstore::index::digest const compilation_digest{3U};
+    pstore::index::digest const header_digest{4U};
+    std::array<std::uint8_t, 3> const header_bytes{{7, 8, 9}};
+
+    {
+        transaction_type transaction = pstore::begin (*source_, lock_guard{mutex_});
+        auto const name = this->add_name (transaction, "name");
+        auto const path = this->add_name (transaction, "path");
+        auto const triple = this->add_name (transaction, "triple");
+
+        std::shared_ptr<std::uint8_t> ptr;
+        auto header_addr = pstore::typed_address<std::uint8_t>::null ();
+        std::tie (ptr, header_addr) = transaction.alloc_rw<std::uint8_t> (header_bytes.size ());
+        std::copy (std::begin (header_bytes), std::end (header_bytes), ptr.get ());
+        auto const header = pstore::make_extent (header_addr, header_bytes.size ());
+        pstore::index::get_index<pstore::trailer::indices::debug_line_header> (*source_)
+            ->insert_or_assign (transaction, header_digest, header);
+
+        // A fragment with a data section carrying an external fixup and a debug line section.
+        section_content data{section_kind::data, std::uint8_t{8}};
+        data.data.assign ({'d', 'a', 't', 'a'});
+        data.xfixups.emplace_back (name, relocation_type{1}, 2U, 3U);
+        section_content line{section_kind::debug_line, std::uint8_t{1}};
+        line.data.assign ({'l'});
+        std::vector<std::unique_ptr<section_creation_dispatcher>> dispatchers;
+        dispatchers.emplace_back (new generic_section_creation_dispatcher (data.kind, &data));
+        dispatchers.emplace_back (new debug_line_section_creation_dispatcher (header, &line));
+        auto const fext = fragment::alloc (transaction,
+                                           pstore::make_pointee_adaptor (dispatchers.begin ()),
+                                           pstore::make_pointee_adaptor (dispatchers.end ()));
+        auto const fragments =
+            pstore::index::get_index<pstore::trailer::indices::fragment> (*source_);
+        fragments->insert_or_assign (transaction, fragment_digest, fext);
+
+        std::array<compilation_member, 1> const members{
+            {compilation_member{fragment_digest, fext, name, linkage::external}}};
+        auto const cext = compilation::alloc (transaction, path, triple, std::begin (members),
+                                              std::end (members));
+        pstore::index::get_index<pstore::trailer::indices::compilation> (*source_)
+            ->insert_or_assign (transaction, compilation_digest, cext);
+
+        // A fragment whose dependents section refers back to the compilation's member.
+        std::array<pstore::typed_address<compilation_member>, 1> const dependents{
+            {pstore::typed_address<compilation_member>::make (
+                cext.addr.to_address () + (cext.size - sizeof (compilation_member)))}};
+        dependents_creation_dispatcher dependents_dispatcher{dependents.data (),
+                                                             dependents.data () + 1};
+        std::array<section_creation_dispatcher *, 1> d{{&dependents_dispatcher}};
+        fragments->insert_or_assign (
+            transaction, dependent_digest,
+            fragment::alloc (transaction, pstore::make_pointee_adaptor (d.begin ()),
+                             pstore::make_pointee_adaptor (d.end ())));
+        transaction.commit ();
+    }
+
+    std::atomic<bool> cancel{false};
+    vacuum::collector c{*source_, *destination_};
+    ASSERT_TRUE (c.pass (cancel));
+
+    pstore::database & db = *destination_;
+    auto const name_of = [&db] (pstore::typed_address<pstore::indirect_string> const addr) {
+        return pstore::indirect_string::read (db, addr).to_string ();
+    };
+
+    auto const fragments = pstore::index::get_index<pstore::trailer::indices::fragment> (db);
+    auto const fpos = fragments->find (db, fragment_digest);
+    ASSERT_NE (fpos, fragments->cend (db));
+    auto const f = fragment::load (db, fpos->second);
+    auto const & data = f->at<section_kind::data> ();
+    ASSERT_EQ (data.xfixups ().size (), 1U);
+    EXPECT_EQ (name_of (data.xfixups ().begin ()->name), "name");
+    auto const & line = f->at<section_kind::debug_line> ();
+    auto const header = db.getro (line.header_extent ());
+    EXPECT_TRUE (std::equal (std::begin (header_bytes), std::end (header_bytes), header.get ()));
+
+    auto const compilations = pstore::index::get_index<pstore::trailer::indices::compilation> (db);
+    auto const cpos = compilations->find (db, compilation_digest);
+    ASSERT_NE (cpos, compilations->cend (db));
+    auto const comp = compilation::load (db, cpos->second);
+    EXPECT_EQ (name_of (comp->path ()), "path");
+    EXPECT_EQ (name_of (comp->triple ()), "triple");
+    ASSERT_EQ (comp->size (), 1U);
+    EXPECT_EQ ((*comp)[0].fext, fpos->second);
+    EXPECT_EQ (name_of ((*comp)[0].name), "name");
+
+    auto const dpos = fragments->find (db, dependent_digest);
+    ASSERT_NE (dpos, fragments->cend (db));
+    auto const & dependents = fragment::load (db, dpos->second)->at<section_kind::dependent> ();
+    ASSERT_EQ (dependents.size (), 1U);
+    EXPECT_EQ (compilation_member::load (db, dependents[0])->digest, fragment_digest);
+}
+
+TEST_F (Collector, SharesPayloads) {
+    using namespace pstore::repo;
+    pstore::index::digest const digests[] = {pstore::index::digest{1U},
+                                             pstore::index::digest{2U}};
+    std::vector<std::uint8_t> payload (shared_payload_threshold);
+    std::iota (std::begin (payload), std::end (payload), std::uint8_t{0});
+
+    {
+        // Two fragments whose read-only sections have identical contents but different fixups.
+        transaction_type transaction = pstore::begin (*source_, lock_guard{mutex_});
+        auto const payloads =
+            pstore::index::get_index<pstore::trailer::indices::payload> (*source_);
+        auto const fragments =
+            pstore::index::get_index<pstore::trailer::indices::fragment> (*source_);
+        for (auto ctr = 0U; ctr < 2U; ++ctr) {
+            section_content content{section_kind::read_only, std::uint8_t{16}};
+            content.data.assign (std::begin (payload), std::end (payload));
+            content.ifixups.emplace_back (section_kind::text, relocation_type{1}, ctr, ctr);
+            auto const dispatcher = make_shared_payload_dispatcher (
+                transaction, payloads, content.kind, &content);
+            std::array<section_creation_dispatcher *, 1> d{{dispatcher.get ()}};
+            fragments->insert_or_assign (
+                transaction, digests[ctr],
+                fragment::alloc (transaction, pstore::make_pointee_adaptor (d.begin ()),
+                                 pstore::make_pointee_adaptor (d.end ())));
+        }
+        transaction.commit ();
+    }
+
+    std::atomic<bool> cancel{false};
+    vacuum::collector c{*source_, *destination_};
+    ASSERT_TRUE (c.pass (cancel));
+
+    pstore::database & db = *destination_;
+    auto const fragments = pstore::index::get_index<pstore::trailer::indices::fragment> (db);
+    std::vector<pstore::extent<std::uint8_t>> extents;
+    for (auto ctr = 0U; ctr < 2U; ++ctr) {
+        auto const pos = fragments->find (db, digests[ctr]);
+        ASSERT_NE (pos, fragments->cend (db));
+        auto const f = fragment::load (db, pos->second);
+        auto const & ro = f->at<section_kind::read_only> ();
+        ASSERT_TRUE (ro.has_shared_payload ());
+        EXPECT_EQ (ro.align (), 16U);
+        ASSERT_EQ (ro.ifixups ().size (), 1U);
+        EXPECT_EQ (ro.ifixups ().begin ()->offset, ctr);
+        extents.push_back (ro.shared_payload ());
+
+        std::shared_ptr<void const> owner;
+        auto const data = load_payload (db, ro, &owner);
+        EXPECT_TRUE (std::equal (std::begin (payload), std::end (payload), data.begin (),
+                                 data.end ()));
+    }
+    // Both sections refer to a single copy of the payload which is recorded in the payload index.
+    EXPECT_EQ (extents[0], extents[1]);
+    auto const payloads = pstore::index::get_index<pstore::trailer::indices::payload> (db);
+    auto const pos = payloads->find (db, payload_digest (pstore::gsl::make_span (payload)));
+    ASSERT_NE (pos, payloads->cend (db));
+    EXPECT_EQ (pos->second, extents[0]);
+}
+
+TEST_F (Collector, OlderStoreKeepsPayloadsInline) {
+    using namespace pstore::repo;
+    // Mark the source as a store written before shared payloads were introduced.
+    auto * const h = reinterpret_cast<pstore::header *> (this->buffer ().get ());
+    h->a.version[1] = pstore::header::shared_payload_version - 1U;
+    h->crc = h->get_crc ();
+    source_ = std::make_unique<pstore::database> (this->file ());
+    source_->set_vacuum_mode (pstore::database::vacuum_mode::disabled);
+
+    transaction_type transaction = pstore::begin (*source_, lock_guard{mutex_});
+    section_content content{section_kind::read_only, std::uint8_t{16}};
+    std::vector<std::uint8_t> const payload (shared_payload_threshold, std::uint8_t{1});
+    content.data.assign (std::begin (payload), std::end (payload));
+    auto const dispatcher = make_shared_payload_dispatcher (
+        transaction, pstore::index::get_index<pstore::trailer::indices::payload> (*source_),
+        content.kind, &content);
+    std::array<section_creation_dispatcher *, 1> d{{dispatcher.get ()}};
+    auto const fext = fragment::alloc (transaction, pstore::make_pointee_adaptor (d.begin ()),
+                                       pstore::make_pointee_adaptor (d.end ()));
+    transaction.commit ();
+
+    auto const f = fragment::load (*source_, fext);
+    EXPECT_FALSE (f->at<section_kind::read_only> ().has_shared_payload ());
+    EXPECT_EQ (source_->get_footer ()->a.extension_offset, 0U);
+}